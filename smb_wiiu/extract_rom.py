@@ -21,6 +21,7 @@ import re
 import sys
 import subprocess
 import shutil
+import struct
 from pathlib import Path
 
 from PIL import Image
@@ -696,9 +697,93 @@ def copy_particle_assets(output_dir: Path) -> None:
             Image.open(p).convert("RGBA").save(dst_dir / name)
 
 
+# Sheets the runtime always keys on pure green, whatever their alpha channel.
+# Keep in sync with chromaKeyByName() in src/main.cpp.
+CHROMA_KEY_NAMES = [
+    "tilesets/Deco/",
+    "sprites/ui/TitleSMB1.png",
+    "sprites/ui/CoinIcon.png",
+    "FlagPole.png",
+    "QuestionBlock.png",
+    "FireFlower.png",
+    "Fireball.png",
+    "SpinningCoin.png",
+    "Platform.png",
+]
+
+COOKED_MAGIC = b"RGBA"
+COOKED_PREMULTIPLIED = 1
+
+
+def has_alpha_channel(img: Image.Image) -> bool:
+    """Whether SDL_image would hand the runtime a surface with an alpha mask."""
+    if img.mode in ("RGBA", "LA", "PA", "RGBa", "La"):
+        return True
+    # Paletted PNGs with a per-entry tRNS table are expanded to RGBA; a single
+    # transparent index (or RGB tRNS) only becomes a color key.
+    return img.mode == "P" and isinstance(img.info.get("transparency"), bytes)
+
+
+def cook_image(img: Image.Image, rel: str, premultiply: bool) -> tuple[bytes, int]:
+    """Resolves the runtime chroma-key rules into real alpha (see applyChromaKey)."""
+    alpha = has_alpha_channel(img)
+    rgba = img.convert("RGBA")
+    if alpha:
+        key = rgba.getpixel((0, 0)) == OPAQUE_GREEN or any(n in rel for n in CHROMA_KEY_NAMES)
+    else:
+        key = True
+        # Color-key inputs carry no alpha: everything but green is opaque.
+        rgba.putalpha(255)
+    if key:
+        px = rgba.load()
+        w, h = rgba.size
+        for y in range(h):
+            for x in range(w):
+                if px[x, y] == OPAQUE_GREEN:
+                    px[x, y] = (0, 0, 0, 0)
+    flags = 0
+    if premultiply:
+        rgba = rgba.convert("RGBa")
+        flags |= COOKED_PREMULTIPLIED
+    return rgba.tobytes(), flags
+
+
+def cook_content(content_dir: Path, premultiply: bool) -> int:
+    """Writes `<name>.rgba` next to every `<name>.png` under `content_dir`.
+
+    The runtime prefers these over the PNGs: a 12-byte header (magic, u16
+    width, u16 height, u32 flags, little endian) and then RGBA8 pixels in
+    R, G, B, A byte order, which it uploads without decoding or keying. It
+    never checks them against the PNGs, so every `.rgba` that no longer has a
+    cookable PNG beside it is deleted here; re-run after replacing any PNG.
+    """
+    count = 0
+    cooked = set()
+    for png in sorted(content_dir.rglob("*.png")):
+        rel = png.relative_to(content_dir).as_posix()
+        with Image.open(png) as img:
+            pixels, flags = cook_image(img, rel, premultiply)
+            w, h = img.size
+        if w > 0xFFFF or h > 0xFFFF:
+            print(f"Skipping {rel}: {w}x{h} is too large to cook")
+            continue
+        header = COOKED_MAGIC + struct.pack("<HHI", w, h, flags)
+        out = png.with_suffix(".rgba")
+        out.write_bytes(header + pixels)
+        cooked.add(out)
+        count += 1
+    removed = 0
+    for stale in sorted(content_dir.rglob("*.rgba")):
+        if stale not in cooked:
+            stale.unlink()
+            removed += 1
+    print(f"Cooked {count} images under {content_dir}, removed {removed} stale")
+    return count
+
+
 def main(argv: list[str]) -> int:
     parser = argparse.ArgumentParser(add_help=True)
-    parser.add_argument("rom", help="Path to SMB1 NES ROM (.nes)")
+    parser.add_argument("rom", nargs="?", help="Path to SMB1 NES ROM (.nes)")
     parser.add_argument(
         "output_dir",
         nargs="?",
@@ -710,8 +795,34 @@ def main(argv: list[str]) -> int:
         action="store_true",
         help="Only render Tilesets/*.png into <output_dir>/tilesets",
     )
+    parser.add_argument(
+        "--cook",
+        action="store_true",
+        help="After extracting, write a pre-keyed .rgba next to every PNG in <output_dir>",
+    )
+    parser.add_argument(
+        "--cook-only",
+        metavar="DIR",
+        help="Cook the PNGs already under DIR and exit (no ROM needed)",
+    )
+    parser.add_argument(
+        "--premultiply",
+        action="store_true",
+        help="Cook with premultiplied alpha",
+    )
     args = parser.parse_args(argv[1:])
 
+    if args.cook_only:
+        cook_dir = Path(args.cook_only)
+        if not cook_dir.is_dir():
+            print(f"Error: content folder not found: {cook_dir}")
+            return 1
+        cook_content(cook_dir, args.premultiply)
+        return 0
+
+    if not args.rom:
+        parser.error("the ROM path is required unless --cook-only is given")
+
     rom_path = Path(args.rom)
     output_dir = Path(args.output_dir)
 
@@ -727,6 +838,8 @@ def main(argv: list[str]) -> int:
         extract_tilesets(rom_path, output_dir)
     else:
         extract_smb_assets(rom_path, output_dir)
+    if args.cook:
+        cook_content(output_dir, args.premultiply)
     return 0
 
 
@@ -0,0 +1,71 @@
+#include "content_index.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+
+static const char *const kContentRoots[] = {"content", "../content",
+                                            "fs:/vol/content"};
+constexpr int CONTENT_ROOT_COUNT =
+    (int)(sizeof(kContentRoots) / sizeof(kContentRoots[0]));
+
+// Content-relative path ("sprites/ui/Cursor.png") -> index into kContentRoots.
+static std::unordered_map<std::string, int> g_contentFiles;
+static bool g_contentIndexed = false;
+
+static void scanContentDir(int root, const std::string &rel) {
+  std::string dirPath = kContentRoots[root];
+  if (!rel.empty())
+    dirPath += "/" + rel;
+  DIR *dir = opendir(dirPath.c_str());
+  if (!dir)
+    return;
+  while (dirent *ent = readdir(dir)) {
+    const char *name = ent->d_name;
+    if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+      continue;
+    std::string child = rel.empty() ? std::string(name) : rel + "/" + name;
+    bool isDir = false;
+#ifdef DT_DIR
+    if (ent->d_type != DT_UNKNOWN) {
+      isDir = ent->d_type == DT_DIR;
+    } else
+#endif
+    {
+      struct stat st;
+      std::string full = dirPath + "/" + name;
+      isDir = stat(full.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+    }
+    if (isDir)
+      scanContentDir(root, child);
+    else
+      g_contentFiles.emplace(child, root);
+  }
+  closedir(dir);
+}
+
+void contentIndexInit() {
+  if (g_contentIndexed)
+    return;
+  g_contentIndexed = true;
+  // emplace() keeps the first root's entry for files present in several.
+  for (int root = 0; root < CONTENT_ROOT_COUNT; root++)
+    scanContentDir(root, std::string());
+}
+
+int contentIndexSize() {
+  contentIndexInit();
+  return (int)g_contentFiles.size();
+}
+
+bool resolveContentPath(const char *rel, char *out, size_t outSize) {
+  contentIndexInit();
+  auto it = g_contentFiles.find(rel);
+  if (it == g_contentFiles.end())
+    return false;
+  int n = std::snprintf(out, outSize, "%s/%s", kContentRoots[it->second], rel);
+  return n > 0 && (size_t)n < outSize;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+// Every file under the content roots ("content/", "../content/",
+// "fs:/vol/content/"), scanned once at startup so loads resolve with a hash
+// lookup instead of probing each root with a failed open. A file present in
+// several roots resolves to the first one, like the old probing order.
+void contentIndexInit();
+int contentIndexSize();
+
+// Writes the full path of content-relative `rel` into `out`. Returns false
+// when the file is in none of the roots.
+bool resolveContentPath(const char *rel, char *out, size_t outSize);
@@ -0,0 +1,630 @@
+#pragma once
+
+// Headless stand-ins for the SDL2 / SDL_image / SDL_mixer / WUT APIs used by
+// the game, so the simulation can be built and benchmarked on a Linux host
+// (`make host`, `make bench`). Nothing here draws, plays or reads real pads:
+//  - IMG_Load parses the PNG header and returns a blank surface of the right
+//    size, so texture-dependent code paths (sprite sizes, atlases, castle
+//    placement) behave like on hardware.
+//  - The renderer counts submitted draw calls so render passes can be
+//    compared between builds.
+//  - SDL_GetTicks follows a virtual clock driven by the bench loop, keeping
+//    runs deterministic.
+//  - VPADRead returns whatever the bench scripted into g_hostVpad.
+//  - Threads, mutexes and condition variables are real (std::thread).
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+typedef uint8_t Uint8;
+typedef uint16_t Uint16;
+typedef uint32_t Uint32;
+typedef uint64_t Uint64;
+typedef int16_t Sint16;
+typedef int32_t Sint32;
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+//------------------------------------------------------------------------------
+// SDL core
+//------------------------------------------------------------------------------
+
+#define SDL_INIT_AUDIO 0x00000010u
+#define SDL_INIT_VIDEO 0x00000020u
+#define SDL_WINDOW_FULLSCREEN 0x00000001u
+#define SDL_RENDERER_ACCELERATED 0x00000002u
+#define SDL_RENDERER_PRESENTVSYNC 0x00000004u
+#define SDL_QUIT 0x100
+#define SDL_RENDER_TARGETS_RESET 0x2000
+#define SDL_RENDER_DEVICE_RESET 0x2001
+#define SDL_TEXTUREACCESS_STATIC 0
+#define SDL_TEXTUREACCESS_STREAMING 1
+#define SDL_TEXTUREACCESS_TARGET 2
+#define SDL_LIL_ENDIAN 1234
+#define SDL_BIG_ENDIAN 4321
+#define SDL_BYTEORDER SDL_LIL_ENDIAN
+
+typedef enum { SDL_FALSE = 0, SDL_TRUE = 1 } SDL_bool;
+typedef enum {
+  SDL_BLENDMODE_NONE = 0,
+  SDL_BLENDMODE_BLEND = 1,
+  SDL_BLENDMODE_ADD = 2,
+  SDL_BLENDMODE_MOD = 4
+} SDL_BlendMode;
+typedef enum {
+  SDL_BLENDOPERATION_ADD = 1
+} SDL_BlendOperation;
+typedef enum {
+  SDL_BLENDFACTOR_ZERO = 1,
+  SDL_BLENDFACTOR_ONE = 2,
+  SDL_BLENDFACTOR_SRC_ALPHA = 5,
+  SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA = 6
+} SDL_BlendFactor;
+typedef enum {
+  SDL_FLIP_NONE = 0,
+  SDL_FLIP_HORIZONTAL = 1,
+  SDL_FLIP_VERTICAL = 2
+} SDL_RendererFlip;
+
+// Byte order R,G,B,A in memory (SDL_PIXELFORMAT_RGBA32 on little endian).
+#define SDL_PIXELFORMAT_ABGR8888 0x16762004u
+#define SDL_PIXELFORMAT_RGBA32 SDL_PIXELFORMAT_ABGR8888
+#define SDL_PIXELFORMAT_RGBA8888 0x16462004u
+
+struct SDL_Point {
+  int x, y;
+};
+struct SDL_FPoint {
+  float x, y;
+};
+struct SDL_Rect {
+  int x, y, w, h;
+};
+struct SDL_FRect {
+  float x, y, w, h;
+};
+struct SDL_Color {
+  Uint8 r, g, b, a;
+};
+
+struct SDL_Vertex {
+  SDL_FPoint position;
+  SDL_Color color;
+  SDL_FPoint tex_coord;
+};
+
+struct SDL_PixelFormat {
+  Uint32 format;
+  Uint8 BitsPerPixel;
+  Uint8 BytesPerPixel;
+  Uint32 Rmask, Gmask, Bmask, Amask;
+};
+
+struct SDL_Surface {
+  Uint32 flags;
+  SDL_PixelFormat *format;
+  int w, h;
+  int pitch;
+  void *pixels;
+  bool hasColorKey;
+  Uint32 colorKey;
+  SDL_BlendMode blendMode;
+};
+
+struct SDL_Texture {
+  int w, h;
+  Uint8 r, g, b, a;
+  SDL_BlendMode blendMode;
+};
+
+struct SDL_Window {
+  int w, h;
+};
+
+struct HostRenderStats {
+  uint64_t presents;
+  uint64_t copies;
+  uint64_t fills;
+  uint64_t textureSwitches;
+  uint64_t targetSwitches;
+};
+
+struct SDL_Renderer {
+  SDL_Texture *lastTexture;
+  SDL_Texture *target;
+  HostRenderStats stats;
+};
+
+struct SDL_Event {
+  Uint32 type;
+};
+
+inline SDL_PixelFormat g_hostRgba32Format = {
+    SDL_PIXELFORMAT_RGBA32, 32, 4, 0x000000FFu, 0x0000FF00u, 0x00FF0000u,
+    0xFF000000u};
+inline Uint32 g_hostTicks = 0;
+
+inline int SDL_Init(Uint32) { return 0; }
+inline void SDL_Quit() {}
+inline Uint32 SDL_GetTicks() { return g_hostTicks; }
+// Real time, unlike SDL_GetTicks(): only the profiler and input timestamps
+// read it on the host.
+inline Uint64 SDL_GetPerformanceFrequency() { return 1000000000u; }
+inline Uint64 SDL_GetPerformanceCounter() {
+  return (Uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+inline int SDL_PollEvent(SDL_Event *) { return 0; }
+inline void SDL_Delay(Uint32 ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+inline SDL_bool SDL_HasIntersection(const SDL_Rect *a, const SDL_Rect *b) {
+  if (!a || !b || a->w <= 0 || a->h <= 0 || b->w <= 0 || b->h <= 0)
+    return SDL_FALSE;
+  return (a->x < b->x + b->w && b->x < a->x + a->w && a->y < b->y + b->h &&
+          b->y < a->y + a->h)
+             ? SDL_TRUE
+             : SDL_FALSE;
+}
+
+inline SDL_Window *SDL_CreateWindow(const char *, int, int, int w, int h,
+                                    Uint32) {
+  return new SDL_Window{w, h};
+}
+inline void SDL_DestroyWindow(SDL_Window *w) { delete w; }
+
+//------------------------------------------------------------------------------
+// Surfaces (always 32-bit RGBA)
+//------------------------------------------------------------------------------
+
+inline SDL_Surface *SDL_CreateRGBSurfaceWithFormat(Uint32, int w, int h, int,
+                                                   Uint32) {
+  if (w <= 0 || h <= 0)
+    return nullptr;
+  SDL_Surface *s = new SDL_Surface();
+  s->format = &g_hostRgba32Format;
+  s->w = w;
+  s->h = h;
+  s->pitch = w * 4;
+  s->pixels = std::calloc((size_t)w * h, 4);
+  s->blendMode = SDL_BLENDMODE_BLEND;
+  return s;
+}
+inline void SDL_FreeSurface(SDL_Surface *s) {
+  if (!s)
+    return;
+  std::free(s->pixels);
+  delete s;
+}
+inline int SDL_LockSurface(SDL_Surface *) { return 0; }
+inline void SDL_UnlockSurface(SDL_Surface *) {}
+inline Uint32 SDL_MapRGB(const SDL_PixelFormat *, Uint8 r, Uint8 g, Uint8 b) {
+  return (Uint32)r | ((Uint32)g << 8) | ((Uint32)b << 16) | 0xFF000000u;
+}
+inline Uint32 SDL_MapRGBA(const SDL_PixelFormat *, Uint8 r, Uint8 g, Uint8 b,
+                          Uint8 a) {
+  return (Uint32)r | ((Uint32)g << 8) | ((Uint32)b << 16) | ((Uint32)a << 24);
+}
+inline void SDL_GetRGBA(Uint32 px, const SDL_PixelFormat *, Uint8 *r, Uint8 *g,
+                        Uint8 *b, Uint8 *a) {
+  *r = (Uint8)(px & 0xFF);
+  *g = (Uint8)((px >> 8) & 0xFF);
+  *b = (Uint8)((px >> 16) & 0xFF);
+  *a = (Uint8)(px >> 24);
+}
+inline int SDL_SetColorKey(SDL_Surface *s, int flag, Uint32 key) {
+  s->hasColorKey = flag != 0;
+  s->colorKey = key;
+  return 0;
+}
+inline int SDL_SetSurfaceBlendMode(SDL_Surface *s, SDL_BlendMode mode) {
+  s->blendMode = mode;
+  return 0;
+}
+inline int SDL_GetSurfaceBlendMode(SDL_Surface *s, SDL_BlendMode *mode) {
+  if (mode)
+    *mode = s->blendMode;
+  return 0;
+}
+// Same packing as SDL: one nibble per factor/operation.
+inline SDL_BlendMode SDL_ComposeCustomBlendMode(
+    SDL_BlendFactor srcColor, SDL_BlendFactor dstColor,
+    SDL_BlendOperation colorOp, SDL_BlendFactor srcAlpha,
+    SDL_BlendFactor dstAlpha, SDL_BlendOperation alphaOp) {
+  return (SDL_BlendMode)((Uint32)colorOp | ((Uint32)srcColor << 4) |
+                         ((Uint32)dstColor << 8) | ((Uint32)alphaOp << 16) |
+                         ((Uint32)srcAlpha << 20) | ((Uint32)dstAlpha << 24));
+}
+inline int SDL_BlitSurface(SDL_Surface *src, const SDL_Rect *, SDL_Surface *dst,
+                           SDL_Rect *) {
+  return (src && dst) ? 0 : -1;
+}
+inline int SDL_BlitScaled(SDL_Surface *src, const SDL_Rect *, SDL_Surface *dst,
+                          SDL_Rect *) {
+  return (src && dst) ? 0 : -1;
+}
+
+//------------------------------------------------------------------------------
+// Renderer
+//------------------------------------------------------------------------------
+
+inline SDL_Renderer *SDL_CreateRenderer(SDL_Window *, int, Uint32) {
+  return new SDL_Renderer();
+}
+inline void SDL_DestroyRenderer(SDL_Renderer *r) { delete r; }
+inline int SDL_RenderSetLogicalSize(SDL_Renderer *, int, int) { return 0; }
+inline int SDL_SetRenderDrawColor(SDL_Renderer *, Uint8, Uint8, Uint8, Uint8) {
+  return 0;
+}
+inline int SDL_SetRenderDrawBlendMode(SDL_Renderer *, SDL_BlendMode) {
+  return 0;
+}
+inline int SDL_RenderClear(SDL_Renderer *r) {
+  r->stats.fills++;
+  return 0;
+}
+inline int SDL_RenderFillRect(SDL_Renderer *r, const SDL_Rect *) {
+  r->stats.fills++;
+  return 0;
+}
+inline int SDL_RenderDrawRect(SDL_Renderer *r, const SDL_Rect *) {
+  r->stats.fills++;
+  return 0;
+}
+inline void SDL_RenderPresent(SDL_Renderer *r) { r->stats.presents++; }
+
+inline SDL_Texture *SDL_CreateTextureFromSurface(SDL_Renderer *,
+                                                 SDL_Surface *s) {
+  if (!s)
+    return nullptr;
+  return new SDL_Texture{s->w, s->h, 255, 255, 255, 255, SDL_BLENDMODE_NONE};
+}
+inline SDL_Texture *SDL_CreateTexture(SDL_Renderer *, Uint32, int, int w,
+                                      int h) {
+  if (w <= 0 || h <= 0)
+    return nullptr;
+  return new SDL_Texture{w, h, 255, 255, 255, 255, SDL_BLENDMODE_NONE};
+}
+inline void SDL_DestroyTexture(SDL_Texture *t) { delete t; }
+inline SDL_bool SDL_RenderTargetSupported(SDL_Renderer *) { return SDL_TRUE; }
+inline SDL_Texture *SDL_GetRenderTarget(SDL_Renderer *r) { return r->target; }
+inline int SDL_SetRenderTarget(SDL_Renderer *r, SDL_Texture *t) {
+  if (t != r->target)
+    r->stats.targetSwitches++;
+  r->target = t;
+  return 0;
+}
+inline int SDL_QueryTexture(SDL_Texture *t, Uint32 *format, int *access,
+                            int *w, int *h) {
+  if (!t)
+    return -1;
+  if (format)
+    *format = SDL_PIXELFORMAT_RGBA32;
+  if (access)
+    *access = 0;
+  if (w)
+    *w = t->w;
+  if (h)
+    *h = t->h;
+  return 0;
+}
+inline int SDL_SetTextureBlendMode(SDL_Texture *t, SDL_BlendMode mode) {
+  if (!t)
+    return -1;
+  t->blendMode = mode;
+  return 0;
+}
+inline int SDL_GetTextureBlendMode(SDL_Texture *t, SDL_BlendMode *mode) {
+  if (!t)
+    return -1;
+  *mode = t->blendMode;
+  return 0;
+}
+inline int SDL_SetTextureColorMod(SDL_Texture *t, Uint8 r, Uint8 g, Uint8 b) {
+  if (!t)
+    return -1;
+  t->r = r;
+  t->g = g;
+  t->b = b;
+  return 0;
+}
+inline int SDL_GetTextureColorMod(SDL_Texture *t, Uint8 *r, Uint8 *g,
+                                  Uint8 *b) {
+  if (!t)
+    return -1;
+  *r = t->r;
+  *g = t->g;
+  *b = t->b;
+  return 0;
+}
+inline int SDL_SetTextureAlphaMod(SDL_Texture *t, Uint8 a) {
+  if (!t)
+    return -1;
+  t->a = a;
+  return 0;
+}
+inline int SDL_GetTextureAlphaMod(SDL_Texture *t, Uint8 *a) {
+  if (!t)
+    return -1;
+  *a = t->a;
+  return 0;
+}
+
+inline void hostCountCopy(SDL_Renderer *r, SDL_Texture *t) {
+  r->stats.copies++;
+  if (t != r->lastTexture) {
+    r->stats.textureSwitches++;
+    r->lastTexture = t;
+  }
+}
+inline int SDL_RenderCopy(SDL_Renderer *r, SDL_Texture *t, const SDL_Rect *,
+                          const SDL_Rect *) {
+  if (!t)
+    return -1;
+  hostCountCopy(r, t);
+  return 0;
+}
+inline int SDL_RenderCopyEx(SDL_Renderer *r, SDL_Texture *t, const SDL_Rect *,
+                            const SDL_Rect *, double, const SDL_Point *,
+                            SDL_RendererFlip) {
+  if (!t)
+    return -1;
+  hostCountCopy(r, t);
+  return 0;
+}
+
+// One geometry submission counts as one draw call (copies), like RenderCopy.
+inline int SDL_RenderGeometry(SDL_Renderer *r, SDL_Texture *t,
+                              const SDL_Vertex *, int numVertices,
+                              const int *, int) {
+  if (numVertices <= 0)
+    return -1;
+  if (t)
+    hostCountCopy(r, t);
+  else
+    r->stats.fills++;
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Threads
+//------------------------------------------------------------------------------
+
+typedef int (*SDL_ThreadFunction)(void *data);
+struct SDL_Thread {
+  std::thread thread;
+  int status = 0;
+};
+struct SDL_mutex {
+  std::mutex m;
+};
+struct SDL_cond {
+  std::condition_variable_any cv;
+};
+
+inline SDL_Thread *SDL_CreateThread(SDL_ThreadFunction fn, const char *,
+                                    void *data) {
+  SDL_Thread *t = new SDL_Thread;
+  t->thread = std::thread([t, fn, data] { t->status = fn(data); });
+  return t;
+}
+inline void SDL_WaitThread(SDL_Thread *t, int *status) {
+  if (!t)
+    return;
+  t->thread.join();
+  if (status)
+    *status = t->status;
+  delete t;
+}
+inline SDL_mutex *SDL_CreateMutex() { return new SDL_mutex; }
+inline void SDL_DestroyMutex(SDL_mutex *m) { delete m; }
+inline int SDL_LockMutex(SDL_mutex *m) {
+  m->m.lock();
+  return 0;
+}
+inline int SDL_UnlockMutex(SDL_mutex *m) {
+  m->m.unlock();
+  return 0;
+}
+inline SDL_cond *SDL_CreateCond() { return new SDL_cond; }
+inline void SDL_DestroyCond(SDL_cond *c) { delete c; }
+inline int SDL_CondWait(SDL_cond *c, SDL_mutex *m) {
+  c->cv.wait(m->m);
+  return 0;
+}
+inline int SDL_CondSignal(SDL_cond *c) {
+  c->cv.notify_one();
+  return 0;
+}
+inline int SDL_CondBroadcast(SDL_cond *c) {
+  c->cv.notify_all();
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// SDL_image
+//------------------------------------------------------------------------------
+
+#define IMG_INIT_PNG 0x00000002
+inline int IMG_Init(int flags) { return flags; }
+inline void IMG_Quit() {}
+
+// Reads only the PNG IHDR so the returned surface has the real dimensions.
+inline SDL_Surface *IMG_Load(const char *path) {
+  FILE *f = std::fopen(path, "rb");
+  if (!f)
+    return nullptr;
+  unsigned char hdr[24];
+  size_t n = std::fread(hdr, 1, sizeof(hdr), f);
+  std::fclose(f);
+  if (n != sizeof(hdr) || std::memcmp(hdr + 1, "PNG", 3) != 0)
+    return nullptr;
+  int w = (hdr[16] << 24) | (hdr[17] << 16) | (hdr[18] << 8) | hdr[19];
+  int h = (hdr[20] << 24) | (hdr[21] << 16) | (hdr[22] << 8) | hdr[23];
+  return SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_RGBA32);
+}
+
+//------------------------------------------------------------------------------
+// SDL_mixer (silent)
+//------------------------------------------------------------------------------
+
+#define MIX_DEFAULT_FORMAT 0x8010
+#define MIX_MAX_VOLUME 128
+
+struct Mix_Chunk {
+  int volume;
+};
+struct Mix_Music {
+  int unused;
+};
+
+inline bool hostFileExists(const char *path) {
+  FILE *f = std::fopen(path, "rb");
+  if (!f)
+    return false;
+  std::fclose(f);
+  return true;
+}
+inline int Mix_OpenAudio(int, Uint16, int, int) { return 0; }
+inline void Mix_CloseAudio() {}
+inline int Mix_AllocateChannels(int n) { return n; }
+inline int Mix_ReserveChannels(int n) { return n; }
+inline Mix_Chunk *Mix_LoadWAV(const char *path) {
+  return hostFileExists(path) ? new Mix_Chunk{MIX_MAX_VOLUME} : nullptr;
+}
+inline Mix_Music *Mix_LoadMUS(const char *path) {
+  return hostFileExists(path) ? new Mix_Music{0} : nullptr;
+}
+inline void Mix_FreeMusic(Mix_Music *m) { delete m; }
+inline int Mix_VolumeChunk(Mix_Chunk *c, int v) {
+  if (c && v >= 0)
+    c->volume = v;
+  return c ? c->volume : 0;
+}
+inline int Mix_VolumeMusic(int v) { return v; }
+inline int Mix_PlayChannel(int ch, Mix_Chunk *, int) { return ch < 0 ? 0 : ch; }
+inline int Mix_Playing(int) { return 0; }
+inline int Mix_PlayMusic(Mix_Music *, int) { return 0; }
+inline int Mix_HaltMusic() { return 0; }
+inline int Mix_PlayingMusic() { return 0; }
+enum Mix_Fading { MIX_NO_FADING, MIX_FADING_OUT, MIX_FADING_IN };
+inline int Mix_FadeInMusic(Mix_Music *, int, int) { return 0; }
+inline int Mix_FadeOutMusic(int) { return 1; }
+inline Mix_Fading Mix_FadingMusic() { return MIX_NO_FADING; }
+
+//------------------------------------------------------------------------------
+// WUT: GamePad, Wii Remotes, ProcUI
+//------------------------------------------------------------------------------
+
+enum VPADButtons : uint32_t {
+  VPAD_BUTTON_SYNC = 0x0001,
+  VPAD_BUTTON_HOME = 0x0002,
+  VPAD_BUTTON_MINUS = 0x0004,
+  VPAD_BUTTON_PLUS = 0x0008,
+  VPAD_BUTTON_R = 0x0010,
+  VPAD_BUTTON_L = 0x0020,
+  VPAD_BUTTON_ZR = 0x0040,
+  VPAD_BUTTON_ZL = 0x0080,
+  VPAD_BUTTON_DOWN = 0x0100,
+  VPAD_BUTTON_UP = 0x0200,
+  VPAD_BUTTON_RIGHT = 0x0400,
+  VPAD_BUTTON_LEFT = 0x0800,
+  VPAD_BUTTON_Y = 0x1000,
+  VPAD_BUTTON_X = 0x2000,
+  VPAD_BUTTON_B = 0x4000,
+  VPAD_BUTTON_A = 0x8000,
+  VPAD_BUTTON_TV = 0x10000,
+  VPAD_BUTTON_STICK_R = 0x20000,
+  VPAD_BUTTON_STICK_L = 0x40000
+};
+enum VPADChan { VPAD_CHAN_0 = 0 };
+enum VPADReadError {
+  VPAD_READ_SUCCESS = 0,
+  VPAD_READ_NO_SAMPLES = -1,
+  VPAD_READ_INVALID_CONTROLLER = -2
+};
+struct VPADVec2D {
+  float x, y;
+};
+struct VPADStatus {
+  uint32_t hold;
+  uint32_t trigger;
+  uint32_t release;
+  VPADVec2D leftStick;
+  VPADVec2D rightStick;
+};
+
+// Scripted GamePad state for the bench loop.
+inline VPADStatus g_hostVpad = {};
+
+inline void VPADInit() {}
+inline int32_t VPADRead(VPADChan, VPADStatus *buf, uint32_t count,
+                        VPADReadError *err) {
+  if (count == 0) {
+    if (err)
+      *err = VPAD_READ_NO_SAMPLES;
+    return 0;
+  }
+  *buf = g_hostVpad;
+  if (err)
+    *err = VPAD_READ_SUCCESS;
+  return 1;
+}
+
+enum WPADButton : uint32_t {
+  WPAD_BUTTON_LEFT = 0x0001,
+  WPAD_BUTTON_RIGHT = 0x0002,
+  WPAD_BUTTON_DOWN = 0x0004,
+  WPAD_BUTTON_UP = 0x0008,
+  WPAD_BUTTON_PLUS = 0x0010,
+  WPAD_BUTTON_2 = 0x0100,
+  WPAD_BUTTON_1 = 0x0200,
+  WPAD_BUTTON_B = 0x0400,
+  WPAD_BUTTON_A = 0x0800,
+  WPAD_BUTTON_MINUS = 0x1000,
+  WPAD_BUTTON_HOME = 0x8000
+};
+enum WPADChan { WPAD_CHAN_0 = 0, WPAD_CHAN_1, WPAD_CHAN_2, WPAD_CHAN_3 };
+typedef WPADChan KPADChan;
+enum WPADExtensionType { WPAD_EXT_CORE = 0, WPAD_EXT_DEV_NOT_FOUND = 253 };
+enum WPADError { WPAD_ERROR_NONE = 0, WPAD_ERROR_NO_CONTROLLER = -1 };
+enum KPADError {
+  KPAD_ERROR_OK = 0,
+  KPAD_ERROR_NO_SAMPLES = -1,
+  KPAD_ERROR_INVALID_CONTROLLER = -2
+};
+struct KPADStatus {
+  uint32_t hold;
+  uint32_t trigger;
+  uint32_t release;
+};
+
+inline void KPADInit() {}
+inline void KPADShutdown() {}
+inline void WPADEnableURCC(int) {}
+inline WPADError WPADProbe(WPADChan, WPADExtensionType *ext) {
+  if (ext)
+    *ext = WPAD_EXT_DEV_NOT_FOUND;
+  return WPAD_ERROR_NO_CONTROLLER;
+}
+inline uint32_t KPADReadEx(KPADChan, KPADStatus *, uint32_t, KPADError *err) {
+  if (err)
+    *err = KPAD_ERROR_NO_SAMPLES;
+  return 0;
+}
+
+inline bool g_hostProcRunning = true;
+inline void WHBProcInit() {}
+inline void WHBProcShutdown() {}
+inline bool WHBProcIsRunning() { return g_hostProcRunning; }
+inline void WHBProcStopRunning() { g_hostProcRunning = false; }
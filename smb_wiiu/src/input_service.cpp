@@ -0,0 +1,176 @@
+#include "input_service.h"
+
+#ifndef SMB_HOST
+#include <coreinit/thread.h>
+#include <padscore/kpad.h>
+#include <padscore/wpad.h>
+#include <vpad/input.h>
+#endif
+
+#include <atomic>
+
+// 250 Hz, a little above the GamePad's own sampling rate, so every sample is
+// seen at least once.
+constexpr Uint32 INPUT_POLL_MS = 4;
+constexpr int INPUT_QUEUE_SIZE = 256; // power of two
+constexpr float STICK_DEADZONE = 0.3f;
+
+struct SourceState {
+  bool connected = false;
+  uint32_t hold = 0;
+  uint32_t raw = 0;     // buttons only, for edges; hold adds stick directions
+  uint32_t pressed = 0; // not yet published
+  bool dirty = false;   // changed since the last published event
+  Uint64 nextProbe = 0; // remotes: when a disconnected channel is re-probed
+};
+
+static SourceState g_sources[INPUT_SOURCE_COUNT];
+
+// Single producer (the polling thread, or the game thread when it polls
+// itself), single consumer (the game thread). g_inputHead is written only by
+// the producer, g_inputTail only by the consumer.
+static InputEvent g_inputQueue[INPUT_QUEUE_SIZE];
+static std::atomic<uint32_t> g_inputHead{0};
+static std::atomic<uint32_t> g_inputTail{0};
+
+static SDL_Thread *g_inputThread = nullptr;
+static std::atomic<bool> g_inputQuit{false};
+
+static bool pushEvent(const InputEvent &e) {
+  uint32_t head = g_inputHead.load(std::memory_order_relaxed);
+  uint32_t tail = g_inputTail.load(std::memory_order_acquire);
+  if (head - tail >= (uint32_t)INPUT_QUEUE_SIZE)
+    return false;
+  g_inputQueue[head & (INPUT_QUEUE_SIZE - 1)] = e;
+  g_inputHead.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+static void setHold(SourceState &s, uint32_t hold, uint32_t raw) {
+  s.pressed |= raw & ~s.raw;
+  s.raw = raw;
+  if (hold != s.hold)
+    s.dirty = true;
+  s.hold = hold;
+}
+
+// A full queue leaves the source dirty with its presses accumulated, so they
+// go out with the next event instead of being lost.
+static void publish(int source, Uint64 now) {
+  SourceState &s = g_sources[source];
+  if (!s.dirty && !s.pressed)
+    return;
+  InputEvent e;
+  e.time = now;
+  e.source = (uint8_t)source;
+  e.connected = s.connected;
+  e.hold = s.hold;
+  e.pressed = s.pressed;
+  if (pushEvent(e)) {
+    s.pressed = 0;
+    s.dirty = false;
+  }
+}
+
+static void pollGamePad(Uint64 now) {
+  SourceState &s = g_sources[INPUT_GAMEPAD];
+  VPADStatus vpad;
+  VPADReadError err;
+  VPADRead(VPAD_CHAN_0, &vpad, 1, &err);
+  if (err == VPAD_READ_SUCCESS) {
+    uint32_t hold = vpad.hold;
+    if (vpad.leftStick.x > STICK_DEADZONE)
+      hold |= VPAD_BUTTON_RIGHT;
+    else if (vpad.leftStick.x < -STICK_DEADZONE)
+      hold |= VPAD_BUTTON_LEFT;
+    // The stick drives movement but never counts as a press, as before.
+    setHold(s, hold, vpad.hold);
+  } else if (err != VPAD_READ_NO_SAMPLES) {
+    // Polling faster than the pad samples is normal; anything else means the
+    // pad is gone, so release everything rather than leave buttons stuck.
+    setHold(s, 0, 0);
+  }
+  publish(INPUT_GAMEPAD, now);
+}
+
+static void pollRemote(int chan, Uint64 now, Uint64 freq) {
+  int source = INPUT_REMOTE_FIRST + chan;
+  SourceState &s = g_sources[source];
+  if (!s.connected) {
+    if (now < s.nextProbe)
+      return;
+    WPADExtensionType ext = WPAD_EXT_DEV_NOT_FOUND;
+    if (WPADProbe((WPADChan)chan, &ext) == WPAD_ERROR_NO_CONTROLLER) {
+      s.nextProbe = now + freq;
+      return;
+    }
+    s.connected = true;
+    s.dirty = true;
+  }
+
+  KPADStatus st;
+  KPADError kerr = KPAD_ERROR_OK;
+  uint32_t n = KPADReadEx((KPADChan)chan, &st, 1, &kerr);
+  if (n > 0 && kerr == KPAD_ERROR_OK) {
+    setHold(s, st.hold, st.hold);
+  } else if (kerr == KPAD_ERROR_INVALID_CONTROLLER) {
+    setHold(s, 0, 0);
+    s.connected = false;
+    s.dirty = true;
+    s.nextProbe = now + freq;
+  }
+  publish(source, now);
+}
+
+static void pollAll() {
+  Uint64 now = SDL_GetPerformanceCounter();
+  Uint64 freq = SDL_GetPerformanceFrequency();
+  pollGamePad(now);
+  for (int chan = 0; chan < 4; chan++)
+    pollRemote(chan, now, freq);
+}
+
+static int inputThreadMain(void *) {
+#ifndef SMB_HOST
+  // The game thread keeps the main core and rendering has CPU2.
+  OSSetThreadAffinity(OSGetCurrentThread(), OS_THREAD_ATTRIB_AFFINITY_CPU0);
+#endif
+  while (!g_inputQuit.load(std::memory_order_acquire)) {
+    pollAll();
+    SDL_Delay(INPUT_POLL_MS);
+  }
+  return 0;
+}
+
+void inputServiceStart() {
+  if (g_inputThread)
+    return;
+  g_sources[INPUT_GAMEPAD].connected = true;
+  g_inputQuit.store(false, std::memory_order_relaxed);
+  g_inputThread = SDL_CreateThread(inputThreadMain, "smb_input", nullptr);
+}
+
+void inputServiceStop() {
+  if (!g_inputThread)
+    return;
+  g_inputQuit.store(true, std::memory_order_release);
+  SDL_WaitThread(g_inputThread, nullptr);
+  g_inputThread = nullptr;
+}
+
+bool inputServiceRunning() { return g_inputThread != nullptr; }
+
+void inputServicePoll() {
+  g_sources[INPUT_GAMEPAD].connected = true;
+  pollAll();
+}
+
+bool inputServicePop(InputEvent *out) {
+  uint32_t tail = g_inputTail.load(std::memory_order_relaxed);
+  uint32_t head = g_inputHead.load(std::memory_order_acquire);
+  if (tail == head)
+    return false;
+  *out = g_inputQueue[tail & (INPUT_QUEUE_SIZE - 1)];
+  g_inputTail.store(tail + 1, std::memory_order_release);
+  return true;
+}
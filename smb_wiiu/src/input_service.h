@@ -0,0 +1,42 @@
+#pragma once
+
+#ifdef SMB_HOST
+#include "host_platform.h"
+#else
+#include <SDL2/SDL.h>
+#endif
+
+#include <cstdint>
+
+// Controller polling. A polling thread reads the GamePad and the connected Wii
+// Remotes several times per rendered frame and pushes a timestamped event for
+// every change into a single-producer/single-consumer queue, so a press and
+// release that both land between two frames still arrive as a press.
+// Disconnected remote channels are only re-probed about once a second.
+//
+// Without the thread (the host bench), inputServicePoll() takes one sample on
+// the caller's thread instead.
+enum InputSource {
+  INPUT_GAMEPAD,
+  INPUT_REMOTE_FIRST, // remote channel c is INPUT_REMOTE_FIRST + c
+  INPUT_SOURCE_COUNT = INPUT_REMOTE_FIRST + 4
+};
+
+struct InputEvent {
+  Uint64 time;       // SDL_GetPerformanceCounter() at the poll
+  uint8_t source;    // InputSource
+  bool connected;    // remotes: false once the channel stops answering
+  uint32_t hold;     // held after this event; raw WPAD bits for remotes
+  uint32_t pressed;  // went down since the source's previous event
+};
+
+void inputServiceStart();
+void inputServiceStop();
+bool inputServiceRunning();
+
+// Samples every source once and queues the changes. Only for use while the
+// thread is not running.
+void inputServicePoll();
+
+// Pops the oldest queued event. Game thread only.
+bool inputServicePop(InputEvent *out);
@@ -1,47 +1,316 @@
 #include "levels.h"
 
+#include "content_index.h"
+
+#include <cstddef>
+#include <cstdio>
 #include <cstring>
+#include <vector>
+
+// Pack layout and RLE scheme: see write_level_pack() in
+// tools/godot_levels_to_cpp.py. Everything is little-endian and read byte by
+// byte, so the same pack works on the Wii U and on the host build.
+static const char LEVEL_PACK_MAGIC[4] = {'S', 'M', 'B', 'L'};
+constexpr uint32_t LEVEL_PACK_VERSION = 1;
+constexpr int LEVEL_PACK_HEADER_SIZE = 16;
+constexpr int LEVEL_PACK_LEVEL_SIZE = 24;
+constexpr int LEVEL_PACK_ENTRY_SIZE = 8;
+constexpr int LEVEL_PACK_SECTION_SIZE = 36;
+constexpr int LEVEL_PACK_PIPE_SIZE = 28;
+constexpr int LEVEL_PACK_ENEMY_SIZE = 24;
+constexpr int LEVEL_PACK_PLANES = 6;
+
+struct PackLevel {
+  char name[8];
+  int world;
+  int stage;
+  uint32_t firstSection;
+  uint32_t sectionCount;
+};
+
+struct PackEntry {
+  uint32_t offset;
+  uint32_t size;
+};
+
+static std::vector<PackLevel> g_packLevels;
+static std::vector<PackEntry> g_packSections;
+static bool g_packIndexRead = false;
+
+// Decoded planes of the current section: map goes straight into the caller's
+// buffer, the other five live here and back LevelSectionRuntime.
+static uint8_t g_sectionPlanes[LEVEL_PACK_PLANES - 1][MAP_H][MAP_W];
+static std::vector<PipeLink> g_sectionPipes;
+static std::vector<EnemySpawn> g_sectionEnemies;
+static std::vector<uint8_t> g_sectionBlob;
+static std::vector<uint8_t> g_planeScratch;
+
+static uint32_t rd16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+static uint32_t rd32(const uint8_t *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+static int rdI32(const uint8_t *p) { return (int)rd32(p); }
+static float rdF32(const uint8_t *p) {
+  uint32_t u = rd32(p);
+  float f;
+  std::memcpy(&f, &u, sizeof(f));
+  return f;
+}
 
-extern const LevelData g_levels[];
-extern const int g_levelCount;
+static FILE *openLevelPack() {
+  char path[512];
+  if (!resolveContentPath("levels.pak", path, sizeof(path)))
+    return nullptr;
+  return std::fopen(path, "rb");
+}
 
-int levelCount() { return g_levelCount; }
+static bool readBytes(FILE *f, std::vector<uint8_t> &buf, size_t n) {
+  buf.resize(n);
+  return n == 0 || std::fread(buf.data(), 1, n, f) == n;
+}
+
+// Reads the header and the level/section tables. On failure the index is left
+// empty so levelCount() reports 0.
+static bool readLevelPackIndex(FILE *f) {
+  g_packIndexRead = true;
+  g_packLevels.clear();
+  g_packSections.clear();
+  std::vector<uint8_t> buf;
+  if (std::fseek(f, 0, SEEK_SET) != 0 ||
+      !readBytes(f, buf, LEVEL_PACK_HEADER_SIZE))
+    return false;
+  if (std::memcmp(buf.data(), LEVEL_PACK_MAGIC, 4) != 0 ||
+      rd32(&buf[4]) != LEVEL_PACK_VERSION) {
+    std::fprintf(stderr, "levels.pak: bad magic or version\n");
+    return false;
+  }
+  uint32_t levelCount = rd32(&buf[8]);
+  uint32_t sectionCount = rd32(&buf[12]);
+
+  if (!readBytes(f, buf, (size_t)levelCount * LEVEL_PACK_LEVEL_SIZE))
+    return false;
+  std::vector<PackLevel> levels(levelCount);
+  for (uint32_t i = 0; i < levelCount; i++) {
+    const uint8_t *p = &buf[i * LEVEL_PACK_LEVEL_SIZE];
+    PackLevel &l = levels[i];
+    std::memcpy(l.name, p, sizeof(l.name));
+    l.name[sizeof(l.name) - 1] = '\0';
+    l.world = rdI32(p + 8);
+    l.stage = rdI32(p + 12);
+    l.firstSection = rd32(p + 16);
+    l.sectionCount = rd32(p + 20);
+    if (l.firstSection > sectionCount ||
+        l.sectionCount > sectionCount - l.firstSection)
+      return false;
+  }
+
+  if (!readBytes(f, buf, (size_t)sectionCount * LEVEL_PACK_ENTRY_SIZE))
+    return false;
+  std::vector<PackEntry> sections(sectionCount);
+  for (uint32_t i = 0; i < sectionCount; i++) {
+    sections[i].offset = rd32(&buf[i * LEVEL_PACK_ENTRY_SIZE]);
+    sections[i].size = rd32(&buf[i * LEVEL_PACK_ENTRY_SIZE + 4]);
+  }
+  g_packLevels.swap(levels);
+  g_packSections.swap(sections);
+  return true;
+}
+
+// PackBits-style RLE: c < 128 copies c+1 literals, c >= 128 repeats the next
+// byte c-126 times. The output must come out exactly dstLen bytes long.
+static bool rleDecode(const uint8_t *src, size_t srcLen, uint8_t *dst,
+                      size_t dstLen) {
+  size_t si = 0, di = 0;
+  while (si < srcLen) {
+    uint8_t c = src[si++];
+    if (c < 128) {
+      size_t n = (size_t)c + 1;
+      if (si + n > srcLen || di + n > dstLen)
+        return false;
+      std::memcpy(dst + di, src + si, n);
+      si += n;
+      di += n;
+    } else {
+      size_t n = (size_t)c - 126;
+      if (si >= srcLen || di + n > dstLen)
+        return false;
+      std::memset(dst + di, src[si++], n);
+      di += n;
+    }
+  }
+  return di == dstLen;
+}
+
+static bool decodePlane(const uint8_t *&p, const uint8_t *end, int cols,
+                        uint8_t plane[MAP_H][MAP_W]) {
+  if (end - p < 5)
+    return false;
+  uint8_t fill = p[0];
+  uint32_t packed = rd32(p + 1);
+  p += 5;
+  if ((size_t)(end - p) < packed)
+    return false;
+  size_t rawLen = (size_t)MAP_H * cols;
+  g_planeScratch.resize(rawLen);
+  if (!rleDecode(p, packed, g_planeScratch.data(), rawLen))
+    return false;
+  p += packed;
+  for (int y = 0; y < MAP_H; y++) {
+    if (cols > 0)
+      std::memcpy(plane[y], &g_planeScratch[(size_t)y * cols], cols);
+    std::memset(plane[y] + cols, fill, MAP_W - cols);
+  }
+  return true;
+}
+
+// Fixed-size section header: metadata plus the pipe/enemy counts and the
+// stored plane width.
+static bool decodeSectionHeader(const uint8_t *p, LevelSectionRuntime &out,
+                                int &cols, int &pipeCount, int &enemyCount) {
+  cols = (int)rd16(p + 4);
+  uint8_t theme = p[6];
+  uint8_t flags = p[7];
+  if (cols > MAP_W || theme >= THEME_COUNT)
+    return false;
+  out.mapWidth = (int)rd16(p);
+  out.mapHeight = (int)rd16(p + 2);
+  out.theme = (LevelTheme)theme;
+  out.hasFlag = (flags & 1) != 0;
+  out.bgClouds = (flags & 2) != 0;
+  out.flagX = rdI32(p + 8);
+  out.startX = rdI32(p + 12);
+  out.startY = rdI32(p + 16);
+  out.bgPrimary = rdI32(p + 20);
+  out.bgSecondary = rdI32(p + 24);
+  out.bgParticles = rdI32(p + 28);
+  pipeCount = (int)rd16(p + 32);
+  enemyCount = (int)rd16(p + 34);
+  return true;
+}
+
+static bool decodeSection(const uint8_t *p, const uint8_t *end,
+                          uint8_t map[MAP_H][MAP_W],
+                          LevelSectionRuntime &out) {
+  int cols = 0, pipeCount = 0, enemyCount = 0;
+  if (end - p < LEVEL_PACK_SECTION_SIZE ||
+      !decodeSectionHeader(p, out, cols, pipeCount, enemyCount))
+    return false;
+  p += LEVEL_PACK_SECTION_SIZE;
+
+  if (end - p < (ptrdiff_t)pipeCount * LEVEL_PACK_PIPE_SIZE +
+                    (ptrdiff_t)enemyCount * LEVEL_PACK_ENEMY_SIZE)
+    return false;
+  g_sectionPipes.resize(pipeCount);
+  for (PipeLink &pl : g_sectionPipes) {
+    pl.x = rdI32(p);
+    pl.y = rdI32(p + 4);
+    pl.targetLevel = rdI32(p + 8);
+    pl.targetSection = rdI32(p + 12);
+    pl.targetX = rdI32(p + 16);
+    pl.targetY = rdI32(p + 20);
+    pl.enterDir = rdI32(p + 24);
+    p += LEVEL_PACK_PIPE_SIZE;
+  }
+  g_sectionEnemies.resize(enemyCount);
+  for (EnemySpawn &e : g_sectionEnemies) {
+    e.type = (EType)rdI32(p);
+    e.x = rdF32(p + 4);
+    e.y = rdF32(p + 8);
+    e.dir = rdI32(p + 12);
+    e.a = rdI32(p + 16);
+    e.b = rdI32(p + 20);
+    p += LEVEL_PACK_ENEMY_SIZE;
+  }
+  out.pipes = g_sectionPipes.empty() ? nullptr : g_sectionPipes.data();
+  out.pipeCount = pipeCount;
+  out.enemies = g_sectionEnemies.empty() ? nullptr : g_sectionEnemies.data();
+  out.enemyCount = enemyCount;
+
+  if (!decodePlane(p, end, cols, map))
+    return false;
+  for (int i = 0; i < LEVEL_PACK_PLANES - 1; i++) {
+    if (!decodePlane(p, end, cols, g_sectionPlanes[i]))
+      return false;
+  }
+  out.atlasT = g_sectionPlanes[0];
+  out.atlasX = g_sectionPlanes[1];
+  out.atlasY = g_sectionPlanes[2];
+  out.collide = g_sectionPlanes[3];
+  out.qmeta = g_sectionPlanes[4];
+  return true;
+}
+
+int levelCount() {
+  if (!g_packIndexRead) {
+    FILE *f = openLevelPack();
+    if (f) {
+      readLevelPackIndex(f);
+      std::fclose(f);
+    } else {
+      g_packIndexRead = true;
+      std::fprintf(stderr, "levels.pak not found\n");
+    }
+  }
+  return (int)g_packLevels.size();
+}
 
 bool loadLevelSection(int levelIndex, int sectionIndex,
                       uint8_t map[MAP_H][MAP_W], LevelSectionRuntime &out) {
-  if (levelIndex < 0 || levelIndex >= g_levelCount)
+  if (levelIndex < 0 || levelIndex >= levelCount())
+    return false;
+  const PackLevel *level = &g_packLevels[levelIndex];
+  if (sectionIndex < 0 || sectionIndex >= (int)level->sectionCount)
+    return false;
+  const PackEntry &e = g_packSections[level->firstSection + sectionIndex];
+  FILE *f = openLevelPack();
+  if (!f)
     return false;
-  const LevelData &level = g_levels[levelIndex];
-  if (sectionIndex < 0 || sectionIndex >= level.sectionCount)
+  bool ok = std::fseek(f, (long)e.offset, SEEK_SET) == 0 &&
+            readBytes(f, g_sectionBlob, e.size);
+  std::fclose(f);
+  if (!ok)
     return false;
-  const LevelSectionData &section = level.sections[sectionIndex];
 
   std::memset(map, T_EMPTY, MAP_W * MAP_H);
-  if (section.map)
-    std::memcpy(map, section.map, sizeof(uint8_t) * MAP_W * MAP_H);
-
-  out.theme = section.theme;
-  out.flagX = section.flagX;
-  out.hasFlag = section.hasFlag;
-  out.atlasT = section.atlasT;
-  out.atlasX = section.atlasX;
-  out.atlasY = section.atlasY;
-  out.collide = section.collide;
-  out.qmeta = section.qmeta;
-  out.pipes = section.pipes;
-  out.pipeCount = section.pipeCount;
-  out.enemies = section.enemies;
-  out.enemyCount = section.enemyCount;
+  const uint8_t *p = g_sectionBlob.data();
+  if (!decodeSection(p, p + g_sectionBlob.size(), map, out)) {
+    std::fprintf(stderr, "levels.pak: corrupt section %s/%d\n", level->name,
+                 sectionIndex);
+    return false;
+  }
+  out.world = level->world;
+  out.stage = level->stage;
+  std::memcpy(out.name, level->name, sizeof(out.name));
+  return true;
+}
+
+bool peekLevelSection(int levelIndex, int sectionIndex,
+                      LevelSectionRuntime &out) {
+  if (levelIndex < 0 || levelIndex >= levelCount())
+    return false;
+  const PackLevel &level = g_packLevels[levelIndex];
+  if (sectionIndex < 0 || sectionIndex >= (int)level.sectionCount)
+    return false;
+  const PackEntry &e = g_packSections[level.firstSection + sectionIndex];
+  if (e.size < (uint32_t)LEVEL_PACK_SECTION_SIZE)
+    return false;
+  FILE *f = openLevelPack();
+  if (!f)
+    return false;
+  uint8_t hdr[LEVEL_PACK_SECTION_SIZE];
+  bool ok = std::fseek(f, (long)e.offset, SEEK_SET) == 0 &&
+            std::fread(hdr, 1, sizeof(hdr), f) == sizeof(hdr);
+  std::fclose(f);
+  int cols = 0, pipeCount = 0, enemyCount = 0;
+  if (!ok || !decodeSectionHeader(hdr, out, cols, pipeCount, enemyCount))
+    return false;
+  out.atlasT = out.atlasX = out.atlasY = out.collide = out.qmeta = nullptr;
+  out.pipes = nullptr;
+  out.pipeCount = 0;
+  out.enemies = nullptr;
+  out.enemyCount = 0;
   out.world = level.world;
   out.stage = level.stage;
-  out.name = level.name;
-  out.startX = section.startX;
-  out.startY = section.startY;
-  out.mapWidth = section.mapWidth;
-  out.mapHeight = section.mapHeight;
-  out.bgPrimary = section.bgPrimary;
-  out.bgSecondary = section.bgSecondary;
-  out.bgClouds = section.bgClouds;
-  out.bgParticles = section.bgParticles;
+  std::memcpy(out.name, level.name, sizeof(out.name));
   return true;
 }
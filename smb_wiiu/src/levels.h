@@ -36,7 +36,7 @@ struct LevelSectionRuntime {
   int enemyCount;
   int world;
   int stage;
-  const char *name;
+  char name[8];
   int startX;
   int startY;
   int mapWidth;
@@ -47,38 +47,17 @@ struct LevelSectionRuntime {
   int bgParticles;
 };
 
-struct LevelSectionData {
-  const uint8_t (*map)[MAP_W];
-  const uint8_t (*atlasT)[MAP_W];
-  const uint8_t (*atlasX)[MAP_W];
-  const uint8_t (*atlasY)[MAP_W];
-  const uint8_t (*collide)[MAP_W];
-  const uint8_t (*qmeta)[MAP_W];
-  int mapWidth;
-  int mapHeight;
-  LevelTheme theme;
-  int flagX;
-  bool hasFlag;
-  int startX;
-  int startY;
-  int bgPrimary;
-  int bgSecondary;
-  bool bgClouds;
-  int bgParticles;
-  const PipeLink *pipes;
-  int pipeCount;
-  const EnemySpawn *enemies;
-  int enemyCount;
-};
-
-struct LevelData {
-  const char *name;
-  int world;
-  int stage;
-  const LevelSectionData *sections;
-  int sectionCount;
-};
-
+// Levels live in content/levels.pak (written by tools/godot_levels_to_cpp.py).
+// Only the level/section index stays resident; loadLevelSection() streams one
+// section out of the pack and decodes it, and the plane/pipe/enemy pointers in
+// LevelSectionRuntime stay valid until the next call. The index is read once,
+// on first use; restart the game to pick up a regenerated pack.
 bool loadLevelSection(int levelIndex, int sectionIndex,
                       uint8_t map[MAP_H][MAP_W], LevelSectionRuntime &out);
+// Reads only a section's metadata (theme, background, flag, start); the
+// plane/pipe/enemy fields of `out` are cleared. Leaves the loaded section
+// untouched, so it can look ahead at a transition target. Safe to call from a
+// worker thread once levelCount() has been called.
+bool peekLevelSection(int levelIndex, int sectionIndex,
+                      LevelSectionRuntime &out);
 int levelCount();
@@ -1,9 +1,19 @@
 // Super Mario Bros. Wii U Port - Complete Implementation
+#ifdef SMB_HOST
+#include "host_platform.h"
+#else
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_mixer.h>
+#endif
+#include "content_index.h"
 #include "game_types.h"
 #include "levels.h"
+#include "input_service.h"
+#include "profiler.h"
+#include "render_queue.h"
+#include <algorithm>
+#include <functional>
 #include <cmath>
 #include <vector>
 #include <utility>
@@ -11,10 +21,14 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#ifdef SMB_HOST
+#include <chrono>
+#else
 #include <vpad/input.h>
 #include <padscore/kpad.h>
 #include <padscore/wpad.h>
 #include <whb/proc.h>
+#endif
 
 namespace Physics {
 constexpr float JUMP_GRAVITY = 11.0f, FALL_GRAVITY = 25.0f,
@@ -60,6 +74,8 @@ constexpr int SFX_CH_BREAK = 0; // legacy (was reserved for brick breaks)
 struct Rect {
   float x, y, w, h;
 };
+// Slot in the low 16 bits, generation in the high 16 (see entityHandle).
+typedef uint32_t EntityHandle;
 struct Entity {
   bool on;
   EType type;
@@ -70,6 +86,7 @@ struct Entity {
   int a, b;
   float baseX, baseY;
   float prevX, prevY;
+  EntityHandle link; // paired entity (rope platforms), or ENTITY_NONE
 };
 struct Player {
   Rect r;
@@ -84,16 +101,228 @@ struct Player {
   float swimCooldown;
   float swimAnimT;
   bool dead;
+  float prevX, prevY; // position at the previous sim step (render blending)
+};
+// A sprite sheet inside the runtime atlas (see buildSpriteAtlas): the page
+// texture it was packed into and its bounds there. Sheet-local source rects are
+// translated through `rect` at draw time.
+struct Sprite {
+  SDL_Texture *tex = nullptr;
+  SDL_Rect rect = {0, 0, 0, 0};
+  explicit operator bool() const { return tex != nullptr; }
 };
 
 static uint8_t g_map[MAP_H][MAP_W];
-static Entity g_ents[64];
+// Collision grid baked from g_map and the section's collide/atlas planes (see
+// bakeCollisionGrid). One word per column, 2 bits per row, padded with empty
+// cells on every side; out-of-range probes are clamped onto the padding.
+constexpr int COLGRID_PAD_X = 16;
+constexpr int COLGRID_PAD_Y = 8; // rows -8..23 fit in 32 x 2 bits
+constexpr int COLGRID_W = MAP_W + 2 * COLGRID_PAD_X;
+static uint64_t g_colGrid[COLGRID_W];
+// Entities live in per-category pools carved out of g_ents. Each pool owns a
+// fixed slice of slots (kEntityPoolCap), a dense list of the slots in use and a
+// stack of the free ones, so spawning is O(1) and update, collision and draw
+// loops never visit free slots and only see the few types they care about.
+// Clearing `on` retires an entity; its slot stays listed (and is skipped) until
+// compactEntityPools() runs at the end of the step and hands it back.
+//
+// Code that has to remember an entity across steps keeps an EntityHandle, not
+// a slot: the handle carries the slot's generation, which changes every time
+// the slot is freed, so a handle to a recycled slot resolves to nothing.
+enum EntityPoolId {
+  POOL_ENEMIES = 0, // walkers and their shells, swimmers, Lakitu, Bowser
+  POOL_PROJECTILES, // fireballs, hammers, Bullet Bills
+  POOL_ITEMS,       // power-ups and coin popups
+  POOL_PLATFORMS,
+  POOL_GENERATORS, // generators/stoppers, cannons, the castle axe
+  POOL_COUNT
+};
+constexpr int kEntityPoolCap[POOL_COUNT] = {64, 32, 16, 32, 32};
+
+constexpr int entityPoolFirst(int pool) {
+  int first = 0;
+  for (int i = 0; i < pool; i++)
+    first += kEntityPoolCap[i];
+  return first;
+}
+constexpr int ENTITY_CAPACITY = entityPoolFirst(POOL_COUNT);
+
+struct EntityPool {
+  int first; // slice of g_ents / g_entityActive / g_entityFree owned by the pool
+  int cap;
+  int count;     // listed slots, live or retired this step
+  int freeCount; // slots on the free stack
+  // Tuning counters, kept across sections: the most slots listed at once and
+  // the spawns refused because the pool was full.
+  int peak;
+  int failures;
+};
+
+// Generations start at 1 and skip 0 on wrap, so ENTITY_NONE never names a
+// live entity.
+constexpr EntityHandle ENTITY_NONE = 0;
+
+static Entity g_ents[ENTITY_CAPACITY];
+static uint16_t g_entityActive[ENTITY_CAPACITY];
+static uint16_t g_entityFree[ENTITY_CAPACITY];
+static uint16_t g_entityGen[ENTITY_CAPACITY];
+// Index into g_spawnRecords of the level spawn an entity was streamed in from,
+// or -1 (resident spawns and everything spawned during play).
+static int16_t g_entitySpawn[ENTITY_CAPACITY];
+// Listed entities per type, maintained by the spawn/despawn hooks. Retired
+// entities count until compaction.
+static int g_entityTypeCount[E_ENTITY_GENERATOR_STOP + 1];
+// Set when an entity spawns after the broadphase was built (buildBroadphase).
+static bool g_bpStale = true;
+static EntityPool g_entityPools[POOL_COUNT] = {
+    {entityPoolFirst(POOL_ENEMIES), kEntityPoolCap[POOL_ENEMIES]},
+    {entityPoolFirst(POOL_PROJECTILES), kEntityPoolCap[POOL_PROJECTILES]},
+    {entityPoolFirst(POOL_ITEMS), kEntityPoolCap[POOL_ITEMS]},
+    {entityPoolFirst(POOL_PLATFORMS), kEntityPoolCap[POOL_PLATFORMS]},
+    {entityPoolFirst(POOL_GENERATORS), kEntityPoolCap[POOL_GENERATORS]},
+};
+
+static EntityPoolId entityPoolFor(EType type) {
+  switch (type) {
+  case E_FIREBALL:
+  case E_HAMMER:
+  case E_BULLET_BILL:
+    return POOL_PROJECTILES;
+  case E_MUSHROOM:
+  case E_FIRE_FLOWER:
+  case E_COIN_POPUP:
+    return POOL_ITEMS;
+  case E_PLATFORM_SIDEWAYS:
+  case E_PLATFORM_VERTICAL:
+  case E_PLATFORM_ROPE:
+  case E_PLATFORM_FALLING:
+    return POOL_PLATFORMS;
+  case E_ENTITY_GENERATOR:
+  case E_ENTITY_GENERATOR_STOP:
+  case E_BULLET_CANNON:
+  case E_CASTLE_AXE:
+    return POOL_GENERATORS;
+  default:
+    return POOL_ENEMIES;
+  }
+}
+
+// The k-th listed entity of a pool (0 <= k < pool.count).
+static inline Entity &poolEntity(const EntityPool &pool, int k) {
+  return g_ents[g_entityActive[pool.first + k]];
+}
+
+static EntityHandle entityHandle(int slot) {
+  return ((EntityHandle)g_entityGen[slot] << 16) | (EntityHandle)slot;
+}
+
+// The live entity a handle names, or nullptr once it was retired or its slot
+// reused.
+static Entity *entityFromHandle(EntityHandle h) {
+  int slot = (int)(h & 0xFFFF);
+  if (h == ENTITY_NONE || slot >= ENTITY_CAPACITY ||
+      g_entityGen[slot] != (uint16_t)(h >> 16) || !g_ents[slot].on)
+    return nullptr;
+  return &g_ents[slot];
+}
+
+static void bumpEntityGen(int slot) {
+  if (++g_entityGen[slot] == 0)
+    g_entityGen[slot] = 1;
+}
+
+static void spawnRecordEntityGone(int rec, const Entity &e);
+
+// Spawn/despawn hooks. The spawn hook runs when a slot is listed, before the
+// caller fills the entity; the despawn hook runs when compaction frees it,
+// with the entity still intact.
+static void onEntitySpawn(int slot, EType type) {
+  g_entitySpawn[slot] = -1;
+  g_entityTypeCount[type]++;
+  g_bpStale = true;
+}
+
+static void onEntityDespawn(int slot) {
+  const Entity &e = g_ents[slot];
+  g_entityTypeCount[e.type]--;
+  if (g_entitySpawn[slot] >= 0) {
+    spawnRecordEntityGone(g_entitySpawn[slot], e);
+    g_entitySpawn[slot] = -1;
+  }
+  bumpEntityGen(slot);
+}
+
+// Drops every entity without running the despawn hook (section changes).
+// Handles from before stay stale, and the free stacks pop lowest slots first.
+static void clearEntityPools() {
+  for (int i = 0; i < ENTITY_CAPACITY; i++) {
+    g_ents[i].on = false;
+    g_entitySpawn[i] = -1;
+    bumpEntityGen(i);
+  }
+  for (int &n : g_entityTypeCount)
+    n = 0;
+  for (auto &pool : g_entityPools) {
+    pool.count = 0;
+    pool.freeCount = pool.cap;
+    for (int k = 0; k < pool.cap; k++)
+      g_entityFree[pool.first + k] = (uint16_t)(pool.first + pool.cap - 1 - k);
+  }
+}
+
+// Lists a free slot from `type`'s pool and returns its g_ents index, or -1 if
+// the pool is full. The caller fills the entity (including `on`).
+static int allocEntitySlot(EType type) {
+  EntityPool &pool = g_entityPools[entityPoolFor(type)];
+  if (pool.freeCount == 0) {
+    pool.failures++;
+    return -1;
+  }
+  int slot = g_entityFree[pool.first + --pool.freeCount];
+  g_entityActive[pool.first + pool.count++] = (uint16_t)slot;
+  if (pool.count > pool.peak)
+    pool.peak = pool.count;
+  onEntitySpawn(slot, type);
+  return slot;
+}
+
+// Drops retired entities from the active lists, keeping spawn order, and
+// returns their slots to the free stacks.
+static void compactEntityPools() {
+  for (auto &pool : g_entityPools) {
+    uint16_t *active = g_entityActive + pool.first;
+    int kept = 0;
+    for (int k = 0; k < pool.count; k++) {
+      uint16_t slot = active[k];
+      if (g_ents[slot].on) {
+        active[kept++] = slot;
+      } else {
+        onEntityDespawn(slot);
+        g_entityFree[pool.first + pool.freeCount++] = slot;
+      }
+    }
+    pool.count = kept;
+  }
+}
+// Fixed-step simulation. Player accelerations/gravity are applied per step, so
+// the tuning in updateOnePlayer assumes 60 steps per second.
+static int g_simHz = 60;
+constexpr int SIM_MAX_STEPS_PER_FRAME = 5;
+static float g_renderAlpha = 1.0f; // blend between previous and current step
+static float g_camPrevX = 0;
 static Player g_players[4];
 static Player &g_p = g_players[0];
 static float g_camX = 0;
 static GameState g_state = GS_PLAYING;
 static uint32_t g_held = 0, g_pressed = 0;
 static bool g_showDebugOverlay = false;
+static int g_profDumpResult = 0; // last CSV dump: 1 saved, -1 failed
+#ifdef SMB_HOST
+static const char *const PROFILE_CSV_PATH = "smb_profile.csv";
+#else
+static const char *const PROFILE_CSV_PATH = "fs:/vol/external01/smb_profile.csv";
+#endif
 static uint32_t g_playerHeld[4] = {0, 0, 0, 0};
 static uint32_t g_playerPressed[4] = {0, 0, 0, 0};
 static int g_loadedTex = 0;
@@ -115,38 +344,35 @@ static int g_playerRemoteChan[4] = {-1, -1, -1, -1}; // -1=GamePad, else 0..3
 static bool g_remoteConnected[4] = {false, false, false, false};
 static uint32_t g_remoteHeld[4] = {0, 0, 0, 0};
 static uint32_t g_remotePressed[4] = {0, 0, 0, 0};
-static uint32_t g_remoteHoldRaw[4] = {0, 0, 0, 0};
-
-static SDL_Window *g_win = nullptr;
-static SDL_Renderer *g_ren = nullptr;
-static SDL_Texture *g_texPlayerSmall[4] = {nullptr, nullptr, nullptr, nullptr};
-static SDL_Texture *g_texPlayerBig[4] = {nullptr, nullptr, nullptr, nullptr};
-static SDL_Texture *g_texPlayerFire[4] = {nullptr, nullptr, nullptr, nullptr};
-static SDL_Texture *g_texLifeIcon[4] = {nullptr, nullptr, nullptr, nullptr};
-static SDL_Texture *g_texTitle = nullptr;
-static SDL_Texture *g_texCursor = nullptr;
-static SDL_Texture *g_texMenuBG = nullptr;
-static SDL_Texture *g_texCoinIcon = nullptr;
-static SDL_Texture *g_texGoomba = nullptr;
-static SDL_Texture *g_texKoopa = nullptr;
-static SDL_Texture *g_texKoopaSheet = nullptr;
-static SDL_Texture *g_texCheepCheep = nullptr;
-static SDL_Texture *g_texBulletBill = nullptr;
-static SDL_Texture *g_texBlooper = nullptr;
-static SDL_Texture *g_texBuzzy = nullptr;
-static SDL_Texture *g_texLakitu = nullptr;
-static SDL_Texture *g_texLakituCloud = nullptr;
-static SDL_Texture *g_texSpiny = nullptr;
-static SDL_Texture *g_texHammerBro = nullptr;
-static SDL_Texture *g_texHammer = nullptr;
-static SDL_Texture *g_texBowser = nullptr;
-static SDL_Texture *g_texPlatform = nullptr;
-static SDL_Texture *g_texBridgeAxe = nullptr;
-static SDL_Texture *g_texQuestion = nullptr;
-static SDL_Texture *g_texMushroom = nullptr;
-static SDL_Texture *g_texFireFlower = nullptr;
-	static SDL_Texture *g_texFireball = nullptr;
-	static SDL_Texture *g_texCoin = nullptr;
+
+static Sprite g_sprPlayerSmall[4];
+static Sprite g_sprPlayerBig[4];
+static Sprite g_sprPlayerFire[4];
+static Sprite g_sprLifeIcon[4];
+static Sprite g_sprTitle;
+static Sprite g_sprCursor;
+static Sprite g_sprMenuBG;
+static Sprite g_sprCoinIcon;
+static Sprite g_sprGoomba;
+static Sprite g_sprKoopa;
+static Sprite g_sprKoopaSheet;
+static Sprite g_sprCheepCheep;
+static Sprite g_sprBulletBill;
+static Sprite g_sprBlooper;
+static Sprite g_sprBuzzy;
+static Sprite g_sprLakitu;
+static Sprite g_sprLakituCloud;
+static Sprite g_sprSpiny;
+static Sprite g_sprHammerBro;
+static Sprite g_sprHammer;
+static Sprite g_sprBowser;
+static Sprite g_sprPlatform;
+static Sprite g_sprBridgeAxe;
+static Sprite g_sprQuestion;
+static Sprite g_sprMushroom;
+static Sprite g_sprFireFlower;
+static Sprite g_sprFireball;
+static Sprite g_sprCoin;
 	static SDL_Texture *g_texTerrain = nullptr;
 	static SDL_Texture *g_texDeco = nullptr;
 static SDL_Texture *g_texLiquids = nullptr;
@@ -155,12 +381,12 @@ static SDL_Texture *g_texBgBushes = nullptr;
 static SDL_Texture *g_texBgCloudOverlay = nullptr;
 static SDL_Texture *g_texBgSky = nullptr;
 static SDL_Texture *g_texBgSecondary = nullptr; // Trees/Mushrooms layer
-static SDL_Texture *g_texParticleSnow = nullptr;
-static SDL_Texture *g_texParticleLeaves = nullptr;
-static SDL_Texture *g_texParticleAutumnLeaves = nullptr;
-static SDL_Texture *g_texFlagPole = nullptr;
-static SDL_Texture *g_texFlag = nullptr;
-static SDL_Texture *g_texCastle = nullptr;
+static Sprite g_sprParticleSnow;
+static Sprite g_sprParticleLeaves;
+static Sprite g_sprParticleAutumnLeaves;
+static Sprite g_sprFlagPole;
+static Sprite g_sprFlag;
+static Sprite g_sprCastle;
 static int g_flagPoleShaftX = 8; // attachment point within 16px pole column
 static SDL_Rect g_castleDrawDst = {0, 0, 0, 0};
 static SDL_Rect g_castleOverlayDst = {0, 0, 0, 0};
@@ -186,29 +412,31 @@ static bool g_flagSfxPlayed = false;
 static bool g_castleSfxPlayed = false;
 static bool g_randomTheme = false;
 static bool g_nightMode = false;
+static bool g_spriteShadows = true; // sprite and tile drop shadows
 static int g_themeOverride = -1;
 
-static Mix_Chunk *g_sfxJump = nullptr;
-static Mix_Chunk *g_sfxBigJump = nullptr;
-static Mix_Chunk *g_sfxStomp = nullptr;
-static Mix_Chunk *g_sfxCoin = nullptr;
-static Mix_Chunk *g_sfxPowerup = nullptr;
-static Mix_Chunk *g_sfxBump = nullptr;
-static Mix_Chunk *g_sfxBreak = nullptr;
-static Mix_Chunk *g_sfxItemAppear = nullptr;
-static Mix_Chunk *g_sfxDamage = nullptr;
-static Mix_Chunk *g_sfxSkid = nullptr;
-static Mix_Chunk *g_sfxMenuMove = nullptr;
-static Mix_Chunk *g_sfxFlagSlide = nullptr;
-static Mix_Chunk *g_sfxCastleClear = nullptr;
-static Mix_Chunk *g_sfxPipe = nullptr;
-static Mix_Chunk *g_sfxKick = nullptr;
-static Mix_Chunk *g_sfxFireball = nullptr;
-static Mix_Music *g_bgm = nullptr;
-static Mix_Music *g_bgmOverworld = nullptr;
-static Mix_Music *g_bgmUnderground = nullptr;
-static Mix_Music *g_bgmCastle = nullptr;
-static Mix_Music *g_bgmByTheme[(int)THEME_COUNT] = {};
+// Sound effects, loaded once into a resident bank (see loadSfxBank()) and
+// played through playSfx(), which owns voice allocation.
+enum SfxId {
+  SFX_JUMP,
+  SFX_BIG_JUMP,
+  SFX_STOMP,
+  SFX_COIN,
+  SFX_POWERUP,
+  SFX_BUMP,
+  SFX_BREAK,
+  SFX_ITEM_APPEAR,
+  SFX_DAMAGE,
+  SFX_SKID,
+  SFX_MENU_MOVE,
+  SFX_FLAG_SLIDE,
+  SFX_CASTLE_CLEAR,
+  SFX_PIPE,
+  SFX_KICK,
+  SFX_FIREBALL,
+  SFX_COUNT
+};
+static Mix_Chunk *g_sfxBank[SFX_COUNT] = {};
 static float g_skidCooldown = 0.0f;
 
 struct ForegroundDeco {
@@ -227,10 +455,16 @@ struct ForegroundDeco {
 static ForegroundDeco g_fgDecos[192];
 static int g_fgDecoCount = 0;
 
-void renderCopyExWithShadowAngle(SDL_Texture *tex, const SDL_Rect *src,
+void renderCopyExWithShadowAngle(const Sprite &spr, const SDL_Rect *src,
                                  const SDL_Rect *dst, double angle,
                                  SDL_RendererFlip flip,
-                                 const SDL_Point *center);
+                                 const SDL_Point *center, Uint8 alpha = 255);
+void drawSprite(const Sprite &spr, const SDL_Rect *src, const SDL_Rect *dst);
+static void drawSpriteFaded(const Sprite &spr, const SDL_Rect *src,
+                            const SDL_Rect *dst, Uint8 alpha);
+static SDL_BlendMode premultipliedBlendMode();
+static void beginSpriteLayer();
+static void flushSpriteLayer();
 
 // Ambient background particles (Godot LevelBG: Snow, Leaves, Ember).
 // These are screen-space overlay particles (tied to the camera view, not world
@@ -257,6 +491,10 @@ struct TileBump {
 };
 static TileBump g_tileBumps[64];
 
+static void invalidateTileChunkAt(int tx);
+static void invalidateTileCache();
+static void dropTileCacheTextures();
+
 static void addTileBump(int tx, int ty) {
   for (auto &b : g_tileBumps) {
     if (b.t > 0.0f && b.tx == tx && b.ty == ty) {
@@ -266,6 +504,7 @@ static void addTileBump(int tx, int ty) {
   }
   for (auto &b : g_tileBumps) {
     if (b.t <= 0.0f) {
+      invalidateTileChunkAt(tx);
       b.tx = tx;
       b.ty = ty;
       b.t = 0.12f;
@@ -438,35 +677,36 @@ static void renderAmbientParticles() {
     return;
 
   if (g_effectiveParticles == BG_PART_SNOW) {
-    if (!g_texParticleSnow)
+    if (!g_sprParticleSnow)
       return;
     SDL_Rect src = {0, 0, 8, 8};
+    beginSpriteLayer();
     for (auto &p : g_snowParticles) {
-      SDL_SetTextureAlphaMod(g_texParticleSnow, p.a);
       SDL_Rect dst = {(int)p.x, (int)p.y, 8, 8};
-      SDL_RenderCopy(g_ren, g_texParticleSnow, &src, &dst);
+      drawSpriteFaded(g_sprParticleSnow, &src, &dst, p.a);
     }
-    SDL_SetTextureAlphaMod(g_texParticleSnow, 255);
+    flushSpriteLayer();
     return;
   }
 
   if (g_effectiveParticles == BG_PART_LEAVES) {
-    SDL_Texture *tex = (g_theme == THEME_AUTUMN) ? g_texParticleAutumnLeaves : g_texParticleLeaves;
+    const Sprite &tex = (g_theme == THEME_AUTUMN) ? g_sprParticleAutumnLeaves : g_sprParticleLeaves;
     if (!tex)
       return;
+    beginSpriteLayer();
     for (auto &p : g_leafParticles) {
-      SDL_SetTextureAlphaMod(tex, p.a);
       SDL_Rect src = {(int)p.frame * 8, 0, 8, 8};
       SDL_Rect dst = {(int)p.x, (int)p.y, 12, 12};
       SDL_Point c = {dst.w / 2, dst.h / 2};
-      renderCopyExWithShadowAngle(tex, &src, &dst, p.rotDeg, SDL_FLIP_NONE, &c);
+      renderCopyExWithShadowAngle(tex, &src, &dst, p.rotDeg, SDL_FLIP_NONE, &c,
+                                  p.a);
     }
-    SDL_SetTextureAlphaMod(tex, 255);
+    flushSpriteLayer();
     return;
   }
 
   if (g_effectiveParticles == BG_PART_EMBER) {
-    SDL_SetRenderDrawBlendMode(g_ren, SDL_BLENDMODE_BLEND);
+    rqSetDrawBlendMode(SDL_BLENDMODE_BLEND);
     for (auto &p : g_emberParticles) {
       Uint8 r = 0, g = 0, b = 0;
       switch (p.frame % 3) {
@@ -486,9 +726,9 @@ static void renderAmbientParticles() {
         b = 16;
         break;
       }
-      SDL_SetRenderDrawColor(g_ren, r, g, b, p.a);
+      rqSetDrawColor(r, g, b, p.a);
       SDL_Rect dst = {(int)p.x, (int)p.y, 1, 3};
-      SDL_RenderFillRect(g_ren, &dst);
+      rqFillRect(&dst);
     }
     return;
   }
@@ -548,8 +788,103 @@ int fontIndex(char c) {
   return 0;
 }
 
-void drawText(int x, int y, const char *text, int scale, SDL_Color color) {
-  SDL_SetRenderDrawColor(g_ren, color.r, color.g, color.b, color.a);
+// Shared index buffer for quad lists laid out as 4 vertices per quad
+// (top-left, top-right, bottom-left, bottom-right).
+static std::vector<int> g_quadIndices;
+
+static const int *quadIndices(int quads) {
+  for (int q = (int)g_quadIndices.size() / 6; q < quads; q++) {
+    int v = q * 4;
+    int idx[6] = {v, v + 1, v + 2, v + 2, v + 1, v + 3};
+    g_quadIndices.insert(g_quadIndices.end(), idx, idx + 6);
+  }
+  return g_quadIndices.data();
+}
+
+// Text is drawn from glyph textures: kFont5x7 rasterized once per scale
+// (white, on a 6*scale cell grid), with each string submitted as a single
+// SDL_RenderGeometry call whose vertex colors carry the shadow and main
+// colors. Vertex buffers for recently drawn strings are kept in a small
+// direct-mapped cache keyed by text, position, scale and color, so labels that
+// don't change between frames are not laid out again. Scales above
+// GLYPH_MAX_SCALE, or a failed texture upload, fall back to per-pixel rects.
+constexpr int GLYPH_COUNT = 37;
+constexpr int GLYPH_MAX_SCALE = 4;
+constexpr int TEXT_CACHE_SLOTS = 64;
+
+static SDL_Texture *g_glyphTex[GLYPH_MAX_SCALE + 1] = {};
+static bool g_glyphTexFailed[GLYPH_MAX_SCALE + 1] = {};
+
+struct TextLayout {
+  std::string text;
+  int x = 0, y = 0, scale = 0;
+  SDL_Color color = {0, 0, 0, 0};
+  bool shadow = false;
+  std::vector<SDL_Vertex> verts;
+};
+
+static TextLayout g_textCache[TEXT_CACHE_SLOTS];
+
+static SDL_Texture *glyphTexture(int scale) {
+  if (scale < 1 || scale > GLYPH_MAX_SCALE || g_glyphTexFailed[scale])
+    return nullptr;
+  if (g_glyphTex[scale])
+    return g_glyphTex[scale];
+  int cell = 6 * scale;
+  SDL_Surface *s = SDL_CreateRGBSurfaceWithFormat(0, GLYPH_COUNT * cell,
+                                                  7 * scale, 32,
+                                                  SDL_PIXELFORMAT_RGBA32);
+  if (!s) {
+    g_glyphTexFailed[scale] = true;
+    return nullptr;
+  }
+  SDL_LockSurface(s);
+  Uint32 white = SDL_MapRGBA(s->format, 255, 255, 255, 255);
+  for (int g = 0; g < GLYPH_COUNT; g++) {
+    for (int row = 0; row < 7 * scale; row++) {
+      uint8_t bits = kFont5x7[g][row / scale];
+      Uint32 *px = (Uint32 *)((uint8_t *)s->pixels + row * s->pitch) + g * cell;
+      for (int col = 0; col < 5 * scale; col++) {
+        if (bits & (1 << (4 - col / scale)))
+          px[col] = white;
+      }
+    }
+  }
+  SDL_UnlockSurface(s);
+  g_glyphTex[scale] = rqCreateTextureFromSurface(s, SDL_BLENDMODE_BLEND);
+  SDL_FreeSurface(s);
+  if (!g_glyphTex[scale]) {
+    g_glyphTexFailed[scale] = true;
+    return nullptr;
+  }
+  return g_glyphTex[scale];
+}
+
+static void layoutText(std::vector<SDL_Vertex> &out, int x, int y,
+                       const char *text, int scale, SDL_Color c) {
+  float texW = (float)(GLYPH_COUNT * 6 * scale);
+  float gw = (float)(5 * scale), gh = (float)(7 * scale);
+  float cx = (float)x, fy = (float)y;
+  for (const char *p = text; *p; ++p, cx += 6 * scale) {
+    int idx = fontIndex(*p);
+    if (idx == 0)
+      continue;
+    float u0 = (idx * 6 * scale) / texW;
+    float u1 = (idx * 6 * scale + 5 * scale) / texW;
+    out.push_back({{cx, fy}, c, {u0, 0.0f}});
+    out.push_back({{cx + gw, fy}, c, {u1, 0.0f}});
+    out.push_back({{cx, fy + gh}, c, {u0, 1.0f}});
+    out.push_back({{cx + gw, fy + gh}, c, {u1, 1.0f}});
+  }
+}
+
+static bool sameColor(SDL_Color a, SDL_Color b) {
+  return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+static void drawTextPixels(int x, int y, const char *text, int scale,
+                           SDL_Color color) {
+  rqSetDrawColor(color.r, color.g, color.b, color.a);
   int cx = x;
   for (const char *p = text; *p; ++p) {
     int idx = fontIndex(*p);
@@ -558,7 +893,7 @@ void drawText(int x, int y, const char *text, int scale, SDL_Color color) {
       for (int col = 0; col < 5; col++) {
         if (bits & (1 << (4 - col))) {
           SDL_Rect r = {cx + col * scale, y + row * scale, scale, scale};
-          SDL_RenderFillRect(g_ren, &r);
+          rqFillRect(&r);
         }
       }
     }
@@ -566,9 +901,47 @@ void drawText(int x, int y, const char *text, int scale, SDL_Color color) {
   }
 }
 
+static void submitText(int x, int y, const char *text, int scale,
+                       SDL_Color color, bool shadow) {
+  SDL_Texture *tex = glyphTexture(scale);
+  if (!tex) {
+    if (shadow)
+      drawTextPixels(x + 1, y + 1, text, scale, {0, 0, 0, 255});
+    drawTextPixels(x, y, text, scale, color);
+    return;
+  }
+  uint32_t h = 2166136261u;
+  for (const char *p = text; *p; ++p)
+    h = (h ^ (uint8_t)*p) * 16777619u;
+  h = (h ^ (uint32_t)x) * 16777619u;
+  h = (h ^ (uint32_t)y) * 16777619u;
+  h = (h ^ (uint32_t)(scale << 1 | (shadow ? 1 : 0))) * 16777619u;
+  TextLayout &l = g_textCache[h % TEXT_CACHE_SLOTS];
+  if (l.x != x || l.y != y || l.scale != scale || l.shadow != shadow ||
+      !sameColor(l.color, color) || l.text != text) {
+    l.text = text;
+    l.x = x;
+    l.y = y;
+    l.scale = scale;
+    l.shadow = shadow;
+    l.color = color;
+    l.verts.clear();
+    if (shadow)
+      layoutText(l.verts, x + 1, y + 1, text, scale, {0, 0, 0, 255});
+    layoutText(l.verts, x, y, text, scale, color);
+  }
+  int quads = (int)l.verts.size() / 4;
+  if (quads > 0)
+    rqGeometry(tex, l.verts.data(), quads * 4, quadIndices(quads),
+               quads * 6);
+}
+
+void drawText(int x, int y, const char *text, int scale, SDL_Color color) {
+  submitText(x, y, text, scale, color, false);
+}
+
 void drawTextShadow(int x, int y, const char *text, int scale, SDL_Color color) {
-  drawText(x + 1, y + 1, text, scale, {0, 0, 0, 255});
-  drawText(x, y, text, scale, color);
+  submitText(x, y, text, scale, color, true);
 }
 
 int textWidth(const char *text, int scale) {
@@ -581,63 +954,179 @@ int textWidth(const char *text, int scale) {
 constexpr int SPRITE_SHADOW_OFS = 2;
 constexpr uint8_t SPRITE_SHADOW_ALPHA = 90;
 
-struct TextureModGuard {
-  SDL_Texture *t = nullptr;
-  Uint8 r = 255, g = 255, b = 255, a = 255;
-  explicit TextureModGuard(SDL_Texture *tex) : t(tex) {
-    if (!t)
-      return;
-    SDL_GetTextureColorMod(t, &r, &g, &b);
-    SDL_GetTextureAlphaMod(t, &a);
-  }
-  ~TextureModGuard() {
-    if (!t)
-      return;
-    SDL_SetTextureColorMod(t, r, g, b);
-    SDL_SetTextureAlphaMod(t, a);
-  }
+// Resolves a sheet-local source rect (nullptr = whole sheet) to atlas page
+// coordinates. Like SDL does for texture bounds, the source is clipped to the
+// sheet and the destination shrunk to match, so a sloppy rect never samples a
+// neighbouring sheet.
+static bool spriteRects(const Sprite &spr, const SDL_Rect *src,
+                        const SDL_Rect *dst, SDL_Rect &outSrc,
+                        SDL_Rect &outDst) {
+  if (!spr || !dst)
+    return false;
+  SDL_Rect s = src ? *src : SDL_Rect{0, 0, spr.rect.w, spr.rect.h};
+  SDL_Rect d = *dst;
+  if (s.w <= 0 || s.h <= 0)
+    return false;
+  int x0 = s.x < 0 ? 0 : s.x;
+  int y0 = s.y < 0 ? 0 : s.y;
+  int x1 = s.x + s.w > spr.rect.w ? spr.rect.w : s.x + s.w;
+  int y1 = s.y + s.h > spr.rect.h ? spr.rect.h : s.y + s.h;
+  if (x1 <= x0 || y1 <= y0)
+    return false;
+  if (x0 != s.x || y0 != s.y || x1 - x0 != s.w || y1 - y0 != s.h) {
+    d.x += (x0 - s.x) * d.w / s.w;
+    d.y += (y0 - s.y) * d.h / s.h;
+    d.w = (x1 - x0) * d.w / s.w;
+    d.h = (y1 - y0) * d.h / s.h;
+  }
+  outSrc = {spr.rect.x + x0, spr.rect.y + y0, x1 - x0, y1 - y0};
+  outDst = d;
+  return true;
+}
+
+void drawSprite(const Sprite &spr, const SDL_Rect *src, const SDL_Rect *dst) {
+  SDL_Rect s, d;
+  if (spriteRects(spr, src, dst, s, d))
+    rqCopy(spr.tex, &s, &d);
+}
+
+// Sprite layer. Between beginSpriteLayer() and flushSpriteLayer() the
+// *WithShadow helpers only record a quad; the flush draws every shadow first,
+// grouped by texture, then the sprites in submission order with consecutive
+// quads on the same texture merged into one SDL_RenderGeometry call. Shadow
+// tint, per-sprite alpha and fallback fill colors ride on vertex colors, so
+// texture color/alpha mod is never touched. Outside a layer each call is
+// flushed on the spot.
+struct SpriteCmd {
+  SDL_Texture *tex; // nullptr: untextured fallback fill
+  bool shadow;
+  SDL_Vertex v[4]; // TL, TR, BL, BR
 };
 
-void renderCopyExWithShadow(SDL_Texture *tex, const SDL_Rect *src,
-                            const SDL_Rect *dst, SDL_RendererFlip flip) {
-  if (!tex || !dst)
-    return;
+static std::vector<SpriteCmd> g_spriteCmds;
+static std::vector<int> g_spriteShadowOrder;
+static std::vector<SDL_Vertex> g_spriteVerts;
+static bool g_spriteLayerOpen = false;
+
+static void submitSpriteVerts(SDL_Texture *tex) {
+  int quads = (int)g_spriteVerts.size() / 4;
+  if (quads > 0)
+    rqGeometry(tex, g_spriteVerts.data(), quads * 4, quadIndices(quads),
+               quads * 6);
+  g_spriteVerts.clear();
+}
 
-  TextureModGuard guard(tex);
+static void beginSpriteLayer() { g_spriteLayerOpen = true; }
 
-  SDL_Rect shadowDst = *dst;
-  shadowDst.x += SPRITE_SHADOW_OFS;
-  shadowDst.y += SPRITE_SHADOW_OFS;
+static void flushSpriteLayer() {
+  g_spriteLayerOpen = false;
+  if (g_spriteCmds.empty())
+    return;
 
-  SDL_SetTextureColorMod(tex, 0, 0, 0);
-  SDL_SetTextureAlphaMod(tex, SPRITE_SHADOW_ALPHA);
-  SDL_RenderCopyEx(g_ren, tex, src, &shadowDst, 0, nullptr, flip);
+  g_spriteShadowOrder.clear();
+  for (int i = 0; i < (int)g_spriteCmds.size(); i++) {
+    if (g_spriteCmds[i].shadow)
+      g_spriteShadowOrder.push_back(i);
+  }
+  std::stable_sort(g_spriteShadowOrder.begin(), g_spriteShadowOrder.end(),
+                   [](int a, int b) {
+                     return std::less<SDL_Texture *>()(g_spriteCmds[a].tex,
+                                                       g_spriteCmds[b].tex);
+                   });
+  SDL_Texture *runTex = nullptr;
+  for (int i : g_spriteShadowOrder) {
+    const SpriteCmd &c = g_spriteCmds[i];
+    if (c.tex != runTex) {
+      submitSpriteVerts(runTex);
+      runTex = c.tex;
+    }
+    for (SDL_Vertex v : c.v) {
+      v.position.x += SPRITE_SHADOW_OFS;
+      v.position.y += SPRITE_SHADOW_OFS;
+      v.color = {0, 0, 0, (Uint8)(SPRITE_SHADOW_ALPHA * v.color.a / 255)};
+      g_spriteVerts.push_back(v);
+    }
+  }
+  submitSpriteVerts(runTex);
 
-  SDL_SetTextureColorMod(tex, 255, 255, 255);
-  SDL_SetTextureAlphaMod(tex, 255);
-  SDL_RenderCopyEx(g_ren, tex, src, dst, 0, nullptr, flip);
+  runTex = g_spriteCmds[0].tex;
+  for (const SpriteCmd &c : g_spriteCmds) {
+    if (c.tex != runTex) {
+      submitSpriteVerts(runTex);
+      runTex = c.tex;
+    }
+    g_spriteVerts.insert(g_spriteVerts.end(), c.v, c.v + 4);
+  }
+  submitSpriteVerts(runTex);
+  g_spriteCmds.clear();
 }
 
-void renderCopyExWithShadowAngle(SDL_Texture *tex, const SDL_Rect *src,
-                                 const SDL_Rect *dst, double angle,
-                                 SDL_RendererFlip flip,
-                                 const SDL_Point *center) {
-  if (!tex || !dst)
+// Same geometry as SDL_RenderCopyEx: flip first, then rotate clockwise by
+// `angle` degrees around `center` (dst-relative, nullptr = dst center).
+// `alpha` fades the sprite and its shadow; premultiplied textures get it in
+// the color channels too.
+static void queueSpriteCopy(SDL_Texture *tex, const SDL_Rect *src,
+                            const SDL_Rect &dst, double angle,
+                            const SDL_Point *center, SDL_RendererFlip flip,
+                            Uint8 alpha, bool shadow) {
+  int texW = 0, texH = 0;
+  SDL_BlendMode mode = SDL_BLENDMODE_NONE;
+  if (!rqTextureInfo(tex, &texW, &texH, &mode) || texW <= 0 || texH <= 0)
     return;
+  SDL_Rect s = src ? *src : SDL_Rect{0, 0, texW, texH};
+  float u0 = s.x / (float)texW, u1 = (s.x + s.w) / (float)texW;
+  float v0 = s.y / (float)texH, v1 = (s.y + s.h) / (float)texH;
+  if (flip & SDL_FLIP_HORIZONTAL)
+    std::swap(u0, u1);
+  if (flip & SDL_FLIP_VERTICAL)
+    std::swap(v0, v1);
+  float x0 = (float)dst.x, y0 = (float)dst.y;
+  float x1 = (float)(dst.x + dst.w), y1 = (float)(dst.y + dst.h);
+  Uint8 rgb = mode == premultipliedBlendMode() ? alpha : 255;
+  SDL_Color white = {rgb, rgb, rgb, alpha};
+  SpriteCmd c = {tex,
+                 shadow,
+                 {{{x0, y0}, white, {u0, v0}},
+                  {{x1, y0}, white, {u1, v0}},
+                  {{x0, y1}, white, {u0, v1}},
+                  {{x1, y1}, white, {u1, v1}}}};
+  if (angle != 0.0) {
+    float cx = x0 + (center ? (float)center->x : dst.w * 0.5f);
+    float cy = y0 + (center ? (float)center->y : dst.h * 0.5f);
+    float rad = (float)(angle * 3.14159265358979323846 / 180.0);
+    float cs = cosf(rad), sn = sinf(rad);
+    for (SDL_Vertex &v : c.v) {
+      float dx = v.position.x - cx, dy = v.position.y - cy;
+      v.position.x = cx + dx * cs - dy * sn;
+      v.position.y = cy + dx * sn + dy * cs;
+    }
+  }
+  g_spriteCmds.push_back(c);
+  if (!g_spriteLayerOpen)
+    flushSpriteLayer();
+}
 
-  TextureModGuard guard(tex);
-
-  SDL_Rect shadowDst = *dst;
-  shadowDst.x += SPRITE_SHADOW_OFS;
-  shadowDst.y += SPRITE_SHADOW_OFS;
-
-  SDL_SetTextureColorMod(tex, 0, 0, 0);
-  SDL_SetTextureAlphaMod(tex, SPRITE_SHADOW_ALPHA);
-  SDL_RenderCopyEx(g_ren, tex, src, &shadowDst, angle, center, flip);
+// Untextured stand-in for a sprite whose sheet failed to load, kept in the
+// layer so it keeps its place in the draw order.
+static void queueSpriteFill(const SDL_Rect &dst, SDL_Color color) {
+  float x0 = (float)dst.x, y0 = (float)dst.y;
+  float x1 = (float)(dst.x + dst.w), y1 = (float)(dst.y + dst.h);
+  SpriteCmd c = {nullptr,
+                 false,
+                 {{{x0, y0}, color, {0, 0}},
+                  {{x1, y0}, color, {0, 0}},
+                  {{x0, y1}, color, {0, 0}},
+                  {{x1, y1}, color, {0, 0}}}};
+  g_spriteCmds.push_back(c);
+  if (!g_spriteLayerOpen)
+    flushSpriteLayer();
+}
 
-  SDL_SetTextureColorMod(tex, 255, 255, 255);
-  SDL_SetTextureAlphaMod(tex, 255);
-  SDL_RenderCopyEx(g_ren, tex, src, dst, angle, center, flip);
+void renderCopyExWithShadow(SDL_Texture *tex, const SDL_Rect *src,
+                            const SDL_Rect *dst, SDL_RendererFlip flip) {
+  if (tex && dst)
+    queueSpriteCopy(tex, src, *dst, 0.0, nullptr, flip, 255,
+                    g_spriteShadows);
 }
 
 void renderCopyWithShadow(SDL_Texture *tex, const SDL_Rect *src,
@@ -645,13 +1134,42 @@ void renderCopyWithShadow(SDL_Texture *tex, const SDL_Rect *src,
   renderCopyExWithShadow(tex, src, dst, SDL_FLIP_NONE);
 }
 
+void renderCopyExWithShadowAngle(const Sprite &spr, const SDL_Rect *src,
+                                 const SDL_Rect *dst, double angle,
+                                 SDL_RendererFlip flip,
+                                 const SDL_Point *center, Uint8 alpha) {
+  SDL_Rect s, d;
+  if (spriteRects(spr, src, dst, s, d))
+    queueSpriteCopy(spr.tex, &s, d, angle, center, flip, alpha,
+                    g_spriteShadows);
+}
+
+// drawSprite() faded by vertex alpha instead of texture alpha mod, so sprites
+// sharing an atlas page can fade independently. No shadow.
+static void drawSpriteFaded(const Sprite &spr, const SDL_Rect *src,
+                            const SDL_Rect *dst, Uint8 alpha) {
+  SDL_Rect s, d;
+  if (spriteRects(spr, src, dst, s, d))
+    queueSpriteCopy(spr.tex, &s, d, 0.0, nullptr, SDL_FLIP_NONE, alpha, false);
+}
+
+void renderCopyExWithShadow(const Sprite &spr, const SDL_Rect *src,
+                            const SDL_Rect *dst, SDL_RendererFlip flip) {
+  renderCopyExWithShadowAngle(spr, src, dst, 0.0, flip, nullptr);
+}
+
+void renderCopyWithShadow(const Sprite &spr, const SDL_Rect *src,
+                          const SDL_Rect *dst) {
+  renderCopyExWithShadowAngle(spr, src, dst, 0.0, SDL_FLIP_NONE, nullptr);
+}
+
 static void renderTiledBottomSlice(SDL_Texture *tex, float parallaxCamScale,
                                    float camX) {
   if (!tex)
     return;
 
   int texW = 0, texH = 0;
-  SDL_QueryTexture(tex, nullptr, nullptr, &texW, &texH);
+  rqTextureInfo(tex, &texW, &texH);
   // Be robust against backends that don't report size reliably.
   if (texW <= 0)
     texW = 512;
@@ -673,11 +1191,11 @@ static void renderTiledBottomSlice(SDL_Texture *tex, float parallaxCamScale,
   int dstY = GAME_H - sliceH;
   for (int x = startX; x < GAME_W; x += texW) {
     SDL_Rect dst = {x, dstY, texW, sliceH};
-    SDL_RenderCopy(g_ren, tex, &src, &dst);
+    rqCopy(tex, &src, &dst);
   }
 }
 
-void renderTall16x32WithShadow(SDL_Texture *tex, int frameX, const SDL_Rect &dst,
+void renderTall16x32WithShadow(const Sprite &tex, int frameX, const SDL_Rect &dst,
                                SDL_RendererFlip flip) {
   SDL_Rect dstTop = dst;
   dstTop.h = dst.h / 2;
@@ -708,6 +1226,134 @@ static Rect enemyHitRect(const Entity &e) {
   return r;
 }
 
+// Per-step broadphase for entity overlap tests. Levels are only 15 tiles tall,
+// so live enemies/projectiles and players are bucketed by 2-tile (32 px) world
+// column alone. Overlap passes query the columns around a rect instead of
+// scanning whole pools or every player; candidates still go through the exact
+// overlap() test via bpOverlap(), which is what the tested/hit stats count.
+// Buckets are built at the start of updateEntities() and rebuilt before the
+// enemy-vs-enemy pass only if something spawned in between; queries pad the
+// rect by BP_MARGIN so movement within the pass can't drop a contact.
+constexpr int BP_COL_SHIFT = 5;
+constexpr int BP_COLS = (MAP_W * TILE) >> BP_COL_SHIFT;
+constexpr float BP_MARGIN = 16.0f;
+constexpr int BP_MAX_ITEMS = ENTITY_CAPACITY * 4;
+constexpr int BP_MAX_RESULTS = 64;
+
+struct BroadphaseStats {
+  uint32_t tested; // exact overlap tests on broadphase candidates
+  uint32_t hits;
+};
+
+struct BroadphaseItem {
+  uint16_t slot;
+  int16_t next; // next item in the same column, -1 = end
+};
+
+static BroadphaseStats g_bpStats = {0, 0}; // current/last sim step
+static int16_t g_bpHead[BP_COLS];          // first item per column, -1 = empty
+static uint8_t g_bpPlayerCols[BP_COLS]; // bit i = player i touches the column
+static BroadphaseItem g_bpItems[BP_MAX_ITEMS];
+static uint32_t g_bpStamp[ENTITY_CAPACITY];
+static uint32_t g_bpQueryId = 0;
+static int g_bpMinCol = 0, g_bpMaxCol = BP_COLS - 1; // populated column range
+
+static void bpColumnSpan(const Rect &r, float margin, int &c0, int &c1) {
+  float x0 = r.x - margin;
+  float x1 = r.x + r.w + margin;
+  c0 = x0 <= 0.0f ? 0 : ((int)x0 >> BP_COL_SHIFT);
+  c1 = x1 <= 0.0f ? 0 : ((int)x1 >> BP_COL_SHIFT);
+  if (c0 >= BP_COLS)
+    c0 = BP_COLS - 1;
+  if (c1 >= BP_COLS)
+    c1 = BP_COLS - 1;
+}
+
+static void buildBroadphase() {
+  static const EntityPoolId kBucketed[] = {POOL_ENEMIES, POOL_PROJECTILES};
+  // Only the column range populated by the previous build needs clearing.
+  for (int c = g_bpMinCol; c <= g_bpMaxCol; c++) {
+    g_bpHead[c] = -1;
+    g_bpPlayerCols[c] = 0;
+  }
+  int minCol = BP_COLS - 1, maxCol = 0;
+
+  int total = 0;
+  for (EntityPoolId id : kBucketed) {
+    const EntityPool &pool = g_entityPools[id];
+    for (int k = 0; k < pool.count; k++) {
+      const Entity &e = poolEntity(pool, k);
+      if (!e.on)
+        continue;
+      int c0, c1;
+      bpColumnSpan(e.r, 0.0f, c0, c1);
+      minCol = std::min(minCol, c0);
+      maxCol = std::max(maxCol, c1);
+      for (int c = c0; c <= c1 && total < BP_MAX_ITEMS; c++, total++) {
+        g_bpItems[total] = {g_entityActive[pool.first + k], g_bpHead[c]};
+        g_bpHead[c] = (int16_t)total;
+      }
+    }
+  }
+  for (int pi = 0; pi < g_playerCount; pi++) {
+    if (g_players[pi].dead)
+      continue;
+    int c0, c1;
+    bpColumnSpan(g_players[pi].r, 0.0f, c0, c1);
+    minCol = std::min(minCol, c0);
+    maxCol = std::max(maxCol, c1);
+    for (int c = c0; c <= c1; c++)
+      g_bpPlayerCols[c] |= (uint8_t)(1u << pi);
+  }
+  if (minCol > maxCol)
+    minCol = maxCol = 0;
+  g_bpMinCol = minCol;
+  g_bpMaxCol = maxCol;
+  g_bpStale = false;
+}
+
+// Collects each live bucketed entity near `r` once. Returns the number of
+// g_ents indices written to `out`.
+static int bpQueryEntities(const Rect &r, uint16_t *out, int maxOut) {
+  int c0, c1;
+  bpColumnSpan(r, BP_MARGIN, c0, c1);
+  c0 = std::max(c0, g_bpMinCol);
+  c1 = std::min(c1, g_bpMaxCol);
+  uint32_t id = ++g_bpQueryId;
+  int n = 0;
+  for (int c = c0; c <= c1; c++) {
+    for (int i = g_bpHead[c]; i >= 0; i = g_bpItems[i].next) {
+      uint16_t slot = g_bpItems[i].slot;
+      if (g_bpStamp[slot] == id)
+        continue;
+      g_bpStamp[slot] = id;
+      if (g_ents[slot].on && n < maxOut)
+        out[n++] = slot;
+    }
+  }
+  return n;
+}
+
+// Bitmask of players bucketed in the columns near `r`.
+static unsigned bpPlayersNear(const Rect &r) {
+  int c0, c1;
+  bpColumnSpan(r, BP_MARGIN, c0, c1);
+  c0 = std::max(c0, g_bpMinCol);
+  c1 = std::min(c1, g_bpMaxCol);
+  unsigned mask = 0;
+  for (int c = c0; c <= c1; c++)
+    mask |= g_bpPlayerCols[c];
+  return mask;
+}
+
+static bool bpOverlap(const Rect &a, const Rect &b) {
+  g_bpStats.tested++;
+  if (!overlap(a, b))
+    return false;
+  g_bpStats.hits++;
+  return true;
+}
+
 inline bool jumpPressed(uint32_t pressed) {
   return (pressed & (VPAD_BUTTON_A | VPAD_BUTTON_B)) != 0;
 }
@@ -766,15 +1412,18 @@ static int effectiveBgPrimary() {
   return autoPrimaryBgForTheme();
 }
 
-static int effectiveBgSecondary() {
+static int effectiveBgSecondary(int secondary) {
   // Godot enum: 0 None, 1 Mushrooms, 2 Trees.
-  int secondary = g_levelInfo.bgSecondary;
   if (secondary == 1 || secondary == 2)
     return secondary;
   // Default on for richer stages unless explicitly set.
   return 2;
 }
 
+static int effectiveBgSecondary() {
+  return effectiveBgSecondary(g_levelInfo.bgSecondary);
+}
+
 void setPlayerSizePreserveFeet(Player &p, float newW, float newH) {
   float footY = p.r.y + p.r.h;
   p.r.w = newW;
@@ -804,9 +1453,9 @@ bool solidAt(int tx, int ty) {
   return collisionAt(tx, ty) == COL_SOLID;
 }
 
-uint8_t collisionAt(int tx, int ty) {
-  if (tx < 0 || tx >= mapWidth() || ty < 0 || ty >= MAP_H)
-    return COL_NONE;
+// Collision class of one in-map cell, derived from the tile and the section's
+// planes. Only used to (re)bake g_colGrid; gameplay reads collisionAt().
+static uint8_t bakeCollisionCell(int tx, int ty) {
   switch ((Tile)g_map[ty][tx]) {
   case T_GROUND:
   case T_BRICK:
@@ -840,88 +1489,421 @@ uint8_t collisionAt(int tx, int ty) {
   return COL_NONE;
 }
 
-uint8_t questionMetaAt(int tx, int ty) {
-  if (tx < 0 || tx >= mapWidth() || ty < 0 || ty >= MAP_H)
-    return QMETA_COIN;
-  if (!g_levelInfo.qmeta)
-    return QMETA_COIN;
-  return g_levelInfo.qmeta[ty][tx];
+static void bakeCollisionGrid() {
+  memset(g_colGrid, 0, sizeof(g_colGrid));
+  int w = mapWidth();
+  for (int tx = 0; tx < w; tx++) {
+    uint64_t column = 0;
+    for (int ty = 0; ty < MAP_H; ty++)
+      column |= (uint64_t)bakeCollisionCell(tx, ty) << ((ty + COLGRID_PAD_Y) * 2);
+    g_colGrid[tx + COLGRID_PAD_X] = column;
+  }
 }
 
-int questionRowForTheme(LevelTheme t) {
-  switch (t) {
-  case THEME_UNDERGROUND:
-  case THEME_GHOSTHOUSE:
-    return 16;
-  case THEME_CASTLE:
-    return 32;
-  case THEME_SNOW:
-    return 48;
-  case THEME_SPACE:
-    return 64;
-  case THEME_VOLCANO:
-    return 80;
-  case THEME_BONUS:
-    return 96;
-  default:
-    return 0;
-  }
+uint8_t collisionAt(int tx, int ty) {
+  unsigned cx = (unsigned)(tx + COLGRID_PAD_X);
+  unsigned cy = (unsigned)(ty + COLGRID_PAD_Y);
+  cx = cx < (unsigned)COLGRID_W ? cx : (unsigned)COLGRID_W - 1;
+  cy = cy < 32u ? cy : 31u;
+  return (uint8_t)((g_colGrid[cx] >> (cy * 2)) & 3u);
 }
 
-int fireFlowerRowForTheme(LevelTheme t) {
-  switch (t) {
-  case THEME_UNDERGROUND:
-  case THEME_CASTLE:
-  case THEME_GHOSTHOUSE:
-    return 16;
-  case THEME_UNDERWATER:
-  case THEME_CASTLE_WATER:
-    return 32;
-  case THEME_SNOW:
-    return 48;
-  case THEME_SPACE:
-    return 64;
-  case THEME_VOLCANO:
-    return 80;
-  case THEME_BONUS:
-    return 96;
-  default:
-    return 0;
+//------------------------------------------------------------------------------
+// Kinematic bodies
+//------------------------------------------------------------------------------
+// moveBody() moves an AABB by (dx, dy) against the collision grid, X first and
+// then Y. Each axis is swept cell by cell across everything the leading edge
+// passes, so a body cannot tunnel through a tile or a corner however far it
+// moves in one step. SMB rules, no slopes: solid cells block from every side,
+// one-way cells only stop a body that falls onto them from above. Cells the
+// body already overlaps never block it, so an embedded body can move out.
+// BODY_NO_CEILING bodies also ignore walls in any row they already overlap a
+// solid cell in, so a jump up through a brick row keeps its course.
+enum BodyFlags : unsigned {
+  BODY_NO_CEILING = 1u << 0, // rise through solids (Hammer Bros)
+};
+
+enum BodyContact : uint8_t {
+  CONTACT_FLOOR = 1u << 0,
+  CONTACT_WALL = 1u << 1,
+  CONTACT_CEILING = 1u << 2,
+};
+
+struct BodyContacts {
+  uint8_t hits; // BodyContact bits
+  // The first blocking cell on each axis, when the matching bit is set.
+  int wallTx, wallTy;
+  int floorTx, floorTy;
+  int ceilTx, ceilTy;
+};
+
+static inline int cellFirst(float v) { return (int)floorf(v / TILE); }
+// Last cell touched by a span that ends at v (exclusive).
+static inline int cellLast(float v) { return (int)floorf(v / TILE - 1e-4f); }
+
+static BodyContacts moveBody(Rect &r, float dx, float dy, unsigned flags = 0) {
+  BodyContacts c = {};
+
+  if (dx != 0.0f) {
+    int ty1 = cellFirst(r.y);
+    int ty2 = cellLast(r.y + r.h);
+    int step = dx > 0.0f ? 1 : -1;
+    int from = dx > 0.0f ? cellLast(r.x + r.w) + 1 : cellFirst(r.x) - 1;
+    int to = dx > 0.0f ? cellLast(r.x + r.w + dx) : cellFirst(r.x + dx);
+    // Bit (ty - ty1): the body is already embedded in a solid cell there.
+    uint32_t embedded = 0;
+    if (flags & BODY_NO_CEILING) {
+      int tx1 = cellFirst(r.x);
+      int tx2 = cellLast(r.x + r.w);
+      for (int ty = ty1; ty <= ty2 && ty - ty1 < 32; ty++) {
+        for (int tx = tx1; tx <= tx2; tx++) {
+          if (collisionAt(tx, ty) == COL_SOLID) {
+            embedded |= 1u << (ty - ty1);
+            break;
+          }
+        }
+      }
+    }
+    r.x += dx;
+    for (int tx = from; tx * step <= to * step && !c.hits; tx += step) {
+      for (int ty = ty1; ty <= ty2; ty++) {
+        if (collisionAt(tx, ty) != COL_SOLID ||
+            (ty - ty1 < 32 && (embedded >> (ty - ty1)) & 1u))
+          continue;
+        r.x = dx > 0.0f ? tx * TILE - r.w : (tx + 1) * TILE;
+        c.hits |= CONTACT_WALL;
+        c.wallTx = tx;
+        c.wallTy = ty;
+        break;
+      }
+    }
   }
-}
 
-static int flagPolePaletteIndexForTheme(LevelTheme t) {
-  switch (t) {
-  case THEME_UNDERGROUND:
-  case THEME_GHOSTHOUSE:
-    return 1;
-  case THEME_CASTLE:
-  case THEME_CASTLE_WATER:
-    return 2;
-  case THEME_UNDERWATER:
-    return 3;
-  case THEME_SNOW:
-    return 4;
-  case THEME_SPACE:
-    return 5;
-  default:
-    return 0;
+  if (dy > 0.0f) {
+    int tx1 = cellFirst(r.x);
+    int tx2 = cellLast(r.x + r.w);
+    int from = cellLast(r.y + r.h) + 1;
+    int to = cellLast(r.y + r.h + dy);
+    r.y += dy;
+    for (int ty = from; ty <= to; ty++) {
+      for (int tx = tx1; tx <= tx2; tx++) {
+        // The body starts above this row, so one-way cells block too.
+        if (collisionAt(tx, ty) == COL_NONE)
+          continue;
+        r.y = ty * TILE - r.h;
+        c.hits |= CONTACT_FLOOR;
+        c.floorTx = tx;
+        c.floorTy = ty;
+        return c;
+      }
+    }
+  } else if (dy < 0.0f) {
+    int tx1 = cellFirst(r.x);
+    int tx2 = cellLast(r.x + r.w);
+    int from = cellFirst(r.y) - 1;
+    int to = cellFirst(r.y + dy);
+    r.y += dy;
+    if (flags & BODY_NO_CEILING)
+      return c;
+    for (int ty = from; ty >= to; ty--) {
+      for (int tx = tx1; tx <= tx2; tx++) {
+        if (collisionAt(tx, ty) != COL_SOLID)
+          continue;
+        r.y = (ty + 1) * TILE;
+        c.hits |= CONTACT_CEILING;
+        c.ceilTx = tx;
+        c.ceilTy = ty;
+        return c;
+      }
+    }
   }
+  return c;
 }
 
-static int flagPaletteIndexForTheme(LevelTheme t) {
-  // Flag.png palettes: default, Underground, Underwater, Snow, Space, Volcano, Bonus
-  switch (t) {
-  case THEME_UNDERGROUND:
-  case THEME_GHOSTHOUSE:
-    return 1;
-  case THEME_UNDERWATER:
-  case THEME_CASTLE_WATER:
-    return 2;
-  case THEME_SNOW:
-    return 3;
-  case THEME_SPACE:
-    return 4;
+// Ground enemies and items: gravity, then move `speed` px/s along `dir`,
+// turning around at walls and stopping on floors and ceilings.
+static BodyContacts moveWalker(Entity &e, float speed, float dt) {
+  e.vy += 15.0f;
+  BodyContacts c = moveBody(e.r, e.dir * speed * dt, e.vy * dt);
+  if (c.hits & CONTACT_WALL)
+    e.dir = -e.dir;
+  if (c.hits & (CONTACT_FLOOR | CONTACT_CEILING))
+    e.vy = 0;
+  return c;
+}
+
+//------------------------------------------------------------------------------
+// Section bake
+//------------------------------------------------------------------------------
+// Facts derived from the map that used to be rescanned per frame or per
+// entity: the castle placement, each column's liquid surface, standing
+// surface and pipe rows, and the flag pole base. bakeSection() builds them
+// when a section is applied and setMapTile() patches the edited column, so
+// readers are O(1).
+struct SectionBake {
+  int16_t liquidSurfaceY[MAP_W]; // px; near the bottom for dry columns
+  int8_t surfaceTy[MAP_W];       // topmost standable non-castle tile, or -1
+  uint16_t pipeRows[MAP_W];      // bit ty set for T_PIPE tiles
+  // T_CASTLE marker extent, and the castle art placed from it in world space.
+  int castleMinTx;
+  int castleMaxTy;
+  bool castleOn;
+  SDL_Rect castleMain;
+  SDL_Rect castleOverlay;
+  int flagPoleBaseTy;
+};
+static SectionBake g_bake;
+
+static bool isLiquidAt(int tx, int ty) {
+  if (!g_levelInfo.atlasT || !g_levelInfo.atlasX || !g_levelInfo.atlasY)
+    return false;
+  if (tx < 0 || tx >= mapWidth() || ty < 0 || ty >= MAP_H)
+    return false;
+  uint8_t ax = g_levelInfo.atlasX[ty][tx];
+  uint8_t ay = g_levelInfo.atlasY[ty][tx];
+  if (ax == 255 || ay == 255)
+    return false;
+  return g_levelInfo.atlasT[ty][tx] == ATLAS_LIQUID;
+}
+
+static void bakeColumn(int tx) {
+  int liquidTy = -1;
+  int surface = -1;
+  uint16_t pipes = 0;
+  for (int ty = 0; ty < MAP_H; ty++) {
+    uint8_t tile = g_map[ty][tx];
+    if (tile == T_PIPE)
+      pipes |= (uint16_t)(1u << ty);
+    if (liquidTy < 0 && isLiquidAt(tx, ty))
+      liquidTy = ty;
+    if (surface < 0 && tile != T_CASTLE) {
+      uint8_t col = collisionAt(tx, ty);
+      if ((col == COL_SOLID || col == COL_ONEWAY) &&
+          (ty == 0 || collisionAt(tx, ty - 1) == COL_NONE))
+        surface = ty;
+    }
+  }
+  g_bake.liquidSurfaceY[tx] =
+      (int16_t)((liquidTy >= 0 ? liquidTy : MAP_H - 2) * TILE);
+  g_bake.surfaceTy[tx] = (int8_t)surface;
+  g_bake.pipeRows[tx] = pipes;
+}
+
+static void bakeCastleExtent() {
+  int w = mapWidth();
+  g_bake.castleMinTx = w;
+  g_bake.castleMaxTy = -1;
+  for (int y = 0; y < MAP_H; y++) {
+    for (int x = 0; x < w; x++) {
+      if (g_map[y][x] == T_CASTLE) {
+        if (x < g_bake.castleMinTx)
+          g_bake.castleMinTx = x;
+        if (y > g_bake.castleMaxTy)
+          g_bake.castleMaxTy = y;
+      }
+    }
+  }
+}
+
+static int castleTilesW() {
+  return g_sprCastle ? (g_sprCastle.rect.w + TILE - 1) / TILE : 0;
+}
+
+static void bakeCastlePlacement() {
+  g_bake.castleOn = false;
+  int minX = g_bake.castleMinTx;
+  int maxY = g_bake.castleMaxTy;
+  if (!g_sprCastle || maxY < 0 || minX >= mapWidth())
+    return;
+  int texW = g_sprCastle.rect.w;
+  int texH = g_sprCastle.rect.h;
+
+  // The ground line under the castle is the highest standing surface across
+  // its columns (T_CASTLE marker tiles, which may be stamped in the map, are
+  // ignored by surfaceTy).
+  int surfaceTy = -1;
+  for (int x = minX; x < minX + castleTilesW() && x < mapWidth(); x++) {
+    int y = g_bake.surfaceTy[x];
+    if (y >= 0 && (surfaceTy < 0 || y < surfaceTy))
+      surfaceTy = y;
+  }
+  if (surfaceTy < 0)
+    surfaceTy = maxY;
+  // The castle/overlay art is authored to sit *on* the ground tiles. The
+  // surface tile we find here is the first solid tile; align the sprite to the
+  // top of that tile and then lift by one tile to match the reference.
+  int groundY = surfaceTy * TILE;
+  groundY -= TILE;
+  if (groundY < 0)
+    groundY = 0;
+
+  // EndingCastleSprite.png layout:
+  // - Main castle sprite in the top 80px (y=0..79).
+  // - A separate "front overlay" piece in the bottom 40px (y=120..159),
+  //   positioned on the right half of the texture, used to hide the player as
+  //   they enter the door.
+  constexpr int kCastleMainH = 80;
+  constexpr int kOverlayY = 120;
+  constexpr int kOverlayX = 32;
+
+  int mainH = (texH < kCastleMainH) ? texH : kCastleMainH;
+  g_bake.castleMain = {minX * TILE, groundY - mainH, texW, mainH};
+
+  int overlayH = (texH > kOverlayY) ? (texH - kOverlayY) : 0;
+  int overlayW = (texW > kOverlayX) ? (texW - kOverlayX) : 0;
+  g_bake.castleOverlay = {g_bake.castleMain.x + kOverlayX, groundY - overlayH,
+                          overlayW, overlayH};
+  g_bake.castleOn = true;
+}
+
+static void bakeFlagPoleBase() {
+  // Find the local ground under/near the pole. Some level data may place
+  // collision markers in the pole columns, so scan a small range.
+  int groundTy = MAP_H - 1;
+  int foundX = g_flagX;
+  bool found = false;
+  for (int y = MAP_H - 1; y >= 0 && !found; y--) {
+    for (int x = g_flagX - 2; x <= g_flagX + 2; x++) {
+      if (x < 0 || x >= mapWidth())
+        continue;
+      if (collisionAt(x, y) == COL_SOLID || collisionAt(x, y) == COL_ONEWAY) {
+        groundTy = y;
+        foundX = x;
+        found = true;
+        break;
+      }
+    }
+  }
+  // The ground is often 2 tiles thick; align the pole base to the *top*
+  // of that stack so it doesn't sink a tile into the floor.
+  while (groundTy > 0) {
+    uint8_t above = collisionAt(foundX, groundTy - 1);
+    if (above == COL_SOLID || above == COL_ONEWAY)
+      groundTy--;
+    else
+      break;
+  }
+  g_bake.flagPoleBaseTy = groundTy;
+}
+
+// After bakeCollisionGrid(), once g_flagX is known.
+static void bakeSection() {
+  int w = mapWidth();
+  for (int tx = 0; tx < w; tx++)
+    bakeColumn(tx);
+  bakeCastleExtent();
+  bakeCastlePlacement();
+  bakeFlagPoleBase();
+}
+
+static void patchSectionBake(int tx, uint8_t oldTile, uint8_t newTile) {
+  bakeColumn(tx);
+  bool castleColumn = tx >= g_bake.castleMinTx &&
+                      tx < g_bake.castleMinTx + castleTilesW();
+  if (oldTile == T_CASTLE || newTile == T_CASTLE)
+    bakeCastleExtent();
+  if (castleColumn || oldTile == T_CASTLE || newTile == T_CASTLE)
+    bakeCastlePlacement();
+  if (tx >= g_flagX - 2 && tx <= g_flagX + 2)
+    bakeFlagPoleBase();
+}
+
+// All in-game tile edits go through here so the collision grid stays in sync.
+static void setMapTile(int tx, int ty, uint8_t tile) {
+  if (tx < 0 || tx >= mapWidth() || ty < 0 || ty >= MAP_H)
+    return;
+  uint8_t old = g_map[ty][tx];
+  g_map[ty][tx] = tile;
+  invalidateTileChunkAt(tx);
+  uint64_t &column = g_colGrid[tx + COLGRID_PAD_X];
+  int shift = (ty + COLGRID_PAD_Y) * 2;
+  column = (column & ~(3ull << shift)) |
+           ((uint64_t)bakeCollisionCell(tx, ty) << shift);
+  patchSectionBake(tx, old, tile);
+}
+
+uint8_t questionMetaAt(int tx, int ty) {
+  if (tx < 0 || tx >= mapWidth() || ty < 0 || ty >= MAP_H)
+    return QMETA_COIN;
+  if (!g_levelInfo.qmeta)
+    return QMETA_COIN;
+  return g_levelInfo.qmeta[ty][tx];
+}
+
+int questionRowForTheme(LevelTheme t) {
+  switch (t) {
+  case THEME_UNDERGROUND:
+  case THEME_GHOSTHOUSE:
+    return 16;
+  case THEME_CASTLE:
+    return 32;
+  case THEME_SNOW:
+    return 48;
+  case THEME_SPACE:
+    return 64;
+  case THEME_VOLCANO:
+    return 80;
+  case THEME_BONUS:
+    return 96;
+  default:
+    return 0;
+  }
+}
+
+int fireFlowerRowForTheme(LevelTheme t) {
+  switch (t) {
+  case THEME_UNDERGROUND:
+  case THEME_CASTLE:
+  case THEME_GHOSTHOUSE:
+    return 16;
+  case THEME_UNDERWATER:
+  case THEME_CASTLE_WATER:
+    return 32;
+  case THEME_SNOW:
+    return 48;
+  case THEME_SPACE:
+    return 64;
+  case THEME_VOLCANO:
+    return 80;
+  case THEME_BONUS:
+    return 96;
+  default:
+    return 0;
+  }
+}
+
+static int flagPolePaletteIndexForTheme(LevelTheme t) {
+  switch (t) {
+  case THEME_UNDERGROUND:
+  case THEME_GHOSTHOUSE:
+    return 1;
+  case THEME_CASTLE:
+  case THEME_CASTLE_WATER:
+    return 2;
+  case THEME_UNDERWATER:
+    return 3;
+  case THEME_SNOW:
+    return 4;
+  case THEME_SPACE:
+    return 5;
+  default:
+    return 0;
+  }
+}
+
+static int flagPaletteIndexForTheme(LevelTheme t) {
+  // Flag.png palettes: default, Underground, Underwater, Snow, Space, Volcano, Bonus
+  switch (t) {
+  case THEME_UNDERGROUND:
+  case THEME_GHOSTHOUSE:
+    return 1;
+  case THEME_UNDERWATER:
+  case THEME_CASTLE_WATER:
+    return 2;
+  case THEME_SNOW:
+    return 3;
+  case THEME_SPACE:
+    return 4;
   case THEME_VOLCANO:
     return 5;
   case THEME_BONUS:
@@ -933,214 +1915,483 @@ static int flagPaletteIndexForTheme(LevelTheme t) {
 
 bool playerStomp(const Player &p) { return p.vy > 0.0f; }
 
-SDL_Texture *loadTex(const char *file) {
+static SDL_Surface *loadSurface(const char *file) {
   SDL_Surface *s = nullptr;
   if (file[0] == '/' ||
       strstr(file, "Super-Mario-Bros.-Remastered-Public") != nullptr) {
     s = IMG_Load(file);
   } else {
     char path[512];
-    const char *paths[] = {"content/%s", "../content/%s", "fs:/vol/content/%s"};
-    for (int i = 0; i < 3 && !s; i++) {
-      snprintf(path, sizeof(path), paths[i], file);
+    if (resolveContentPath(file, path, sizeof(path)))
       s = IMG_Load(path);
-    }
   }
-  if (!s)
-    return nullptr;
+  return s;
+}
 
-  auto surfaceCornerIsChromaGreen = [](SDL_Surface *surf) -> bool {
-    if (!surf || surf->w <= 0 || surf->h <= 0 || !surf->pixels || !surf->format)
-      return false;
-    const int x = 0;
-    const int y = 0;
-    const int bpp = surf->format->BytesPerPixel;
-    const uint8_t *p = (const uint8_t *)surf->pixels + y * surf->pitch + x * bpp;
-    Uint32 pixel = 0;
-    switch (bpp) {
-    case 1:
-      pixel = *p;
-      break;
-    case 2:
-      pixel = *(const Uint16 *)p;
-      break;
-    case 3:
-      if (SDL_BYTEORDER == SDL_BIG_ENDIAN)
-        pixel = (p[0] << 16) | (p[1] << 8) | p[2];
-      else
-        pixel = p[0] | (p[1] << 8) | (p[2] << 16);
-      break;
-    default:
-      pixel = *(const Uint32 *)p;
-      break;
-    }
-    Uint8 r = 0, g = 0, b = 0, a = 0;
-    SDL_GetRGBA(pixel, surf->format, &r, &g, &b, &a);
-    return (r == 0 && g == 255 && b == 0);
-  };
+static bool surfaceCornerIsChromaGreen(SDL_Surface *surf) {
+  if (!surf || surf->w <= 0 || surf->h <= 0 || !surf->pixels || !surf->format)
+    return false;
+  const int x = 0;
+  const int y = 0;
+  const int bpp = surf->format->BytesPerPixel;
+  const uint8_t *p = (const uint8_t *)surf->pixels + y * surf->pitch + x * bpp;
+  Uint32 pixel = 0;
+  switch (bpp) {
+  case 1:
+    pixel = *p;
+    break;
+  case 2:
+    pixel = *(const Uint16 *)p;
+    break;
+  case 3:
+    if (SDL_BYTEORDER == SDL_BIG_ENDIAN)
+      pixel = (p[0] << 16) | (p[1] << 8) | p[2];
+    else
+      pixel = p[0] | (p[1] << 8) | (p[2] << 16);
+    break;
+  default:
+    pixel = *(const Uint32 *)p;
+    break;
+  }
+  Uint8 r = 0, g = 0, b = 0, a = 0;
+  SDL_GetRGBA(pixel, surf->format, &r, &g, &b, &a);
+  return (r == 0 && g == 255 && b == 0);
+}
 
-  // Prefer PNG alpha when present; fall back to bright-green chroma key for
-  // legacy placeholder sheets. Some Godot-exported PNGs keep an unused alpha
-  // channel while still using bright-green backgrounds; detect that via the
-  // top-left pixel so enemy/FX sheets don't render as solid green.
-  if (s->format->Amask == 0 ||
-      surfaceCornerIsChromaGreen(s) ||
-      (strstr(file, "tilesets/Deco/") != nullptr) ||
-      (strstr(file, "sprites/tilesets/Deco/") != nullptr) ||
-      (strstr(file, "sprites/ui/TitleSMB1.png") != nullptr) ||
-      (strstr(file, "sprites/ui/CoinIcon.png") != nullptr) ||
-      (strstr(file, "FlagPole.png") != nullptr) ||
-      (strstr(file, "QuestionBlock.png") != nullptr) ||
-      (strstr(file, "FireFlower.png") != nullptr) ||
-      (strstr(file, "Fireball.png") != nullptr) ||
-      (strstr(file, "SpinningCoin.png") != nullptr) ||
-      (strstr(file, "Platform.png") != nullptr)) {
+// Prefer PNG alpha when present; fall back to bright-green chroma key for
+// legacy placeholder sheets. Some Godot-exported PNGs keep an unused alpha
+// channel while still using bright-green backgrounds; detect that via the
+// top-left pixel so enemy/FX sheets don't render as solid green.
+// Sheets that are always keyed on pure green, whatever their alpha channel.
+static bool chromaKeyByName(const char *file) {
+  return (strstr(file, "tilesets/Deco/") != nullptr) ||
+         (strstr(file, "sprites/tilesets/Deco/") != nullptr) ||
+         (strstr(file, "sprites/ui/TitleSMB1.png") != nullptr) ||
+         (strstr(file, "sprites/ui/CoinIcon.png") != nullptr) ||
+         (strstr(file, "FlagPole.png") != nullptr) ||
+         (strstr(file, "QuestionBlock.png") != nullptr) ||
+         (strstr(file, "FireFlower.png") != nullptr) ||
+         (strstr(file, "Fireball.png") != nullptr) ||
+         (strstr(file, "SpinningCoin.png") != nullptr) ||
+         (strstr(file, "Platform.png") != nullptr);
+}
+
+static void applyChromaKey(SDL_Surface *s, const char *file) {
+  if (s->format->Amask == 0 || surfaceCornerIsChromaGreen(s) ||
+      chromaKeyByName(file)) {
     Uint32 colorKey = SDL_MapRGB(s->format, 0, 255, 0);
     SDL_SetColorKey(s, SDL_TRUE, colorKey);
   }
+}
 
-  g_loadedTex++;
-  SDL_Texture *t = SDL_CreateTextureFromSurface(g_ren, s);
-  SDL_FreeSurface(s);
-  if (t) {
-    // Ensure alpha blending is enabled consistently (helps with some assets
-    // that rely on partial transparency).
-    SDL_SetTextureBlendMode(t, SDL_BLENDMODE_BLEND);
-  }
-  return t;
+// Blend mode for art cooked with premultiplied alpha.
+static SDL_BlendMode premultipliedBlendMode() {
+  static const SDL_BlendMode mode = SDL_ComposeCustomBlendMode(
+      SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+      SDL_BLENDOPERATION_ADD, SDL_BLENDFACTOR_ONE,
+      SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+  return mode;
 }
 
-void setSfxVolume(Mix_Chunk *sfx) {
-  if (sfx)
-    Mix_VolumeChunk(sfx, MIX_MAX_VOLUME);
+static bool surfaceIsPremultiplied(SDL_Surface *s) {
+  SDL_BlendMode mode = SDL_BLENDMODE_NONE;
+  SDL_GetSurfaceBlendMode(s, &mode);
+  return mode == premultipliedBlendMode();
 }
 
-SDL_Texture *loadTexScaled(const char *file, int outW, int outH) {
+// Cooked art (`extract_rom.py --cook`) sits next to its PNG as `.rgba`: a
+// 12-byte little-endian header ("RGBA", u16 width, u16 height, u32 flags)
+// followed by RGBA8 pixels in memory byte order with the chroma key already
+// resolved into alpha. It loads with one read and needs no keying or format
+// conversion. Premultiplied files come back with premultipliedBlendMode() set
+// on the surface. Nothing here checks it against the PNG: the cook step owns
+// staleness and deletes `.rgba` files whose PNG is gone.
+constexpr uint32_t COOKED_PREMULTIPLIED = 1u;
+
+static SDL_Surface *loadCookedSurface(const char *file) {
+  const char *dot = strrchr(file, '.');
+  if (!dot || strcmp(dot, ".png") != 0)
+    return nullptr;
+  char rel[512], path[512];
+  snprintf(rel, sizeof(rel), "%.*s.rgba", (int)(dot - file), file);
+  if (!resolveContentPath(rel, path, sizeof(path)))
+    return nullptr;
+  FILE *f = fopen(path, "rb");
+  if (!f)
+    return nullptr;
+  uint8_t hdr[12];
   SDL_Surface *s = nullptr;
-  if (file[0] == '/' ||
-      strstr(file, "Super-Mario-Bros.-Remastered-Public") != nullptr) {
-    s = IMG_Load(file);
-  } else {
-    char path[512];
-    const char *paths[] = {"content/%s", "../content/%s", "fs:/vol/content/%s"};
-    for (int i = 0; i < 3 && !s; i++) {
-      snprintf(path, sizeof(path), paths[i], file);
-      s = IMG_Load(path);
+  if (fread(hdr, 1, sizeof(hdr), f) == sizeof(hdr) &&
+      memcmp(hdr, "RGBA", 4) == 0) {
+    int w = hdr[4] | (hdr[5] << 8);
+    int h = hdr[6] | (hdr[7] << 8);
+    uint32_t flags = hdr[8] | (hdr[9] << 8) | (hdr[10] << 16) |
+                     ((uint32_t)hdr[11] << 24);
+    s = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_RGBA32);
+    for (int y = 0; s && y < h; y++) {
+      if (fread((uint8_t *)s->pixels + y * s->pitch, 4, w, f) != (size_t)w) {
+        SDL_FreeSurface(s);
+        s = nullptr;
+      }
     }
+    if (s && (flags & COOKED_PREMULTIPLIED))
+      SDL_SetSurfaceBlendMode(s, premultipliedBlendMode());
   }
+  fclose(f);
+  return s;
+}
+
+// Decode + chroma key only; touches no renderer state, so the section
+// prefetch thread can call it. Prefers the cooked copy of a PNG.
+static SDL_Surface *loadArtSurface(const char *file) {
+  if (SDL_Surface *s = loadCookedSurface(file))
+    return s;
+  SDL_Surface *s = loadSurface(file);
+  if (s)
+    applyChromaKey(s, file);
+  return s;
+}
+
+// Upload half of loadTex(): creates the texture and frees `s`. Game thread
+// only, like every other renderer call.
+static SDL_Texture *uploadSurface(SDL_Surface *s) {
   if (!s)
     return nullptr;
+  g_loadedTex++;
+  // Ensure alpha blending is enabled consistently (helps with some assets
+  // that rely on partial transparency).
+  SDL_Texture *t = rqCreateTextureFromSurface(
+      s, surfaceIsPremultiplied(s) ? premultipliedBlendMode()
+                                   : SDL_BLENDMODE_BLEND);
+  SDL_FreeSurface(s);
+  return t;
+}
 
-  auto surfaceCornerIsChromaGreen = [](SDL_Surface *surf) -> bool {
-    if (!surf || surf->w <= 0 || surf->h <= 0 || !surf->pixels || !surf->format)
-      return false;
-    const int x = 0;
-    const int y = 0;
-    const int bpp = surf->format->BytesPerPixel;
-    const uint8_t *p = (const uint8_t *)surf->pixels + y * surf->pitch + x * bpp;
-    Uint32 pixel = 0;
-    switch (bpp) {
-    case 1:
-      pixel = *p;
-      break;
-    case 2:
-      pixel = *(const Uint16 *)p;
-      break;
-    case 3:
-      if (SDL_BYTEORDER == SDL_BIG_ENDIAN)
-        pixel = (p[0] << 16) | (p[1] << 8) | p[2];
-      else
-        pixel = p[0] | (p[1] << 8) | (p[2] << 16);
-      break;
-    default:
-      pixel = *(const Uint32 *)p;
-      break;
-    }
-    Uint8 r = 0, g = 0, b = 0, a = 0;
-    SDL_GetRGBA(pixel, surf->format, &r, &g, &b, &a);
-    return (r == 0 && g == 255 && b == 0);
-  };
+// Alpha mod for fades. Premultiplied textures need the color scaled by the
+// same factor, or a faded sprite brightens instead of vanishing, so on those
+// this owns the color mod: it replaces any tint with (a, a, a), and
+// setTextureFade(t, 255) clears it. Don't combine it with a color-mod tint on
+// the same texture.
+void setTextureFade(SDL_Texture *t, Uint8 a) {
+  if (!t)
+    return;
+  rqSetTextureAlphaMod(t, a);
+  SDL_BlendMode mode = SDL_BLENDMODE_NONE;
+  if (rqTextureInfo(t, nullptr, nullptr, &mode) &&
+      mode == premultipliedBlendMode())
+    rqSetTextureColorMod(t, a, a, a);
+}
 
-  // Apply the same chroma-key rules as loadTex().
-  if (s->format->Amask == 0 ||
-      surfaceCornerIsChromaGreen(s) ||
-      (strstr(file, "tilesets/Deco/") != nullptr) ||
-      (strstr(file, "sprites/tilesets/Deco/") != nullptr) ||
-      (strstr(file, "sprites/ui/TitleSMB1.png") != nullptr) ||
-      (strstr(file, "sprites/ui/CoinIcon.png") != nullptr) ||
-      (strstr(file, "FlagPole.png") != nullptr) ||
-      (strstr(file, "QuestionBlock.png") != nullptr) ||
-      (strstr(file, "FireFlower.png") != nullptr) ||
-      (strstr(file, "Fireball.png") != nullptr) ||
-      (strstr(file, "SpinningCoin.png") != nullptr) ||
-      (strstr(file, "Platform.png") != nullptr)) {
-    Uint32 colorKey = SDL_MapRGB(s->format, 0, 255, 0);
-    SDL_SetColorKey(s, SDL_TRUE, colorKey);
-  }
+SDL_Texture *loadTex(const char *file) {
+  return uploadSurface(loadArtSurface(file));
+}
+
+SDL_Texture *loadTexScaled(const char *file, int outW, int outH) {
+  // Same cooked/chroma-key path as loadTex().
+  SDL_Surface *s = loadArtSurface(file);
+  if (!s)
+    return nullptr;
 
   SDL_Surface *scaled = SDL_CreateRGBSurfaceWithFormat(0, outW, outH, 32, s->format->format);
   if (!scaled) {
     SDL_FreeSurface(s);
     return nullptr;
   }
+  bool premultiplied = surfaceIsPremultiplied(s);
   SDL_SetSurfaceBlendMode(s, SDL_BLENDMODE_NONE);
   SDL_Rect dst = {0, 0, outW, outH};
   SDL_BlitScaled(s, nullptr, scaled, &dst);
 
   g_loadedTex++;
-  SDL_Texture *t = SDL_CreateTextureFromSurface(g_ren, scaled);
+  SDL_Texture *t = rqCreateTextureFromSurface(
+      scaled, premultiplied ? premultipliedBlendMode() : SDL_BLENDMODE_BLEND);
   SDL_FreeSurface(scaled);
   SDL_FreeSurface(s);
-  if (t) {
-    SDL_SetTextureBlendMode(t, SDL_BLENDMODE_BLEND);
-  }
   return t;
 }
 
-static SDL_Surface *loadSurface(const char *file) {
-  SDL_Surface *s = nullptr;
-  if (file[0] == '/' ||
-      strstr(file, "Super-Mario-Bros.-Remastered-Public") != nullptr) {
-    s = IMG_Load(file);
-  } else {
-    char path[512];
-    const char *paths[] = {"content/%s", "../content/%s", "fs:/vol/content/%s"};
-    for (int i = 0; i < 3 && !s; i++) {
-      snprintf(path, sizeof(path), paths[i], file);
-      s = IMG_Load(path);
-    }
-  }
-  return s;
+//------------------------------------------------------------------------------
+// Texture cache
+//------------------------------------------------------------------------------
+// Per-section art (tilesets and background layers) is shared through a cache
+// keyed by content path plus chroma-key mode. Holders take a reference with
+// acquireTex() and drop it with releaseTex(); unreferenced textures stay
+// resident until TEX_CACHE_BUDGET forces the least recently used out, so a
+// restart or a theme switch back re-uses them without decoding. Paths that
+// failed to load are remembered too, so the fallback chains skip the disk.
+// g_texCacheLock lets the section prefetch thread probe the cache; textures
+// are only created and destroyed on the game thread (through the rq* queue).
+constexpr int TEX_CACHE_MAX = 96;
+constexpr size_t TEX_CACHE_BUDGET = 24u << 20; // bytes kept while unreferenced
+constexpr int TEX_CACHE_PATH = 128;
+
+struct TexCacheEntry {
+  char path[TEX_CACHE_PATH];
+  bool chroma;
+  bool used;
+  SDL_Texture *tex; // nullptr: the file does not exist
+  size_t bytes;
+  int refs;
+  uint32_t lastUse;
+};
+
+struct TexCacheStats {
+  int hits;
+  int misses;
+  int evictions;
+};
+
+static TexCacheEntry g_texCache[TEX_CACHE_MAX];
+static TexCacheStats g_texCacheStats;
+static uint32_t g_texCacheClock = 0;
+static SDL_mutex *g_texCacheLock = nullptr;
+
+static void lockTexCache() {
+  if (g_texCacheLock)
+    SDL_LockMutex(g_texCacheLock);
 }
 
-static int computeFlagPoleShaftX() {
-  SDL_Surface *s = loadSurface("sprites/tilesets/FlagPole.png");
-  if (!s)
-    return 8;
-  // Expect 16px-wide palette columns. Sample a row below the top ball where the
-  // thin shaft begins, and attach the flag to the leftmost opaque pixel.
+static void unlockTexCache() {
+  if (g_texCacheLock)
+    SDL_UnlockMutex(g_texCacheLock);
+}
+
+// Caller holds the lock.
+static TexCacheEntry *findTexCacheEntry(const char *path, bool chroma) {
+  for (TexCacheEntry &e : g_texCache) {
+    if (e.used && e.chroma == chroma && strcmp(e.path, path) == 0)
+      return &e;
+  }
+  return nullptr;
+}
+
+// Caller holds the lock. A free slot, or with `evict` the least recently used
+// unreferenced one (game thread only, since it may destroy a texture).
+static TexCacheEntry *claimTexCacheSlot(bool evict) {
+  TexCacheEntry *victim = nullptr;
+  for (TexCacheEntry &e : g_texCache) {
+    if (!e.used)
+      return &e;
+    if (evict && e.refs == 0 && (!victim || e.lastUse < victim->lastUse))
+      victim = &e;
+  }
+  if (victim) {
+    if (victim->tex) {
+      rqDestroyTexture(victim->tex);
+      g_texCacheStats.evictions++;
+    }
+    victim->used = false;
+  }
+  return victim;
+}
+
+// Game thread: evicts least recently used unreferenced textures until the
+// idle ones fit the budget.
+static void trimTexCache() {
+  lockTexCache();
+  for (;;) {
+    size_t idle = 0;
+    TexCacheEntry *victim = nullptr;
+    for (TexCacheEntry &e : g_texCache) {
+      if (!e.used || e.refs > 0 || !e.tex)
+        continue;
+      idle += e.bytes;
+      if (!victim || e.lastUse < victim->lastUse)
+        victim = &e;
+    }
+    if (idle <= TEX_CACHE_BUDGET || !victim)
+      break;
+    rqDestroyTexture(victim->tex);
+    victim->used = false;
+    g_texCacheStats.evictions++;
+  }
+  unlockTexCache();
+}
+
+// 1 cached, 0 known to be missing, -1 not in the cache. Any thread.
+static int probeTexCache(const char *path) {
+  lockTexCache();
+  const TexCacheEntry *e = findTexCacheEntry(path, chromaKeyByName(path));
+  int state = e ? (e->tex ? 1 : 0) : -1;
+  unlockTexCache();
+  return state;
+}
+
+// Remembers that `path` does not exist. Never evicts, so any thread may call
+// it; the note is simply dropped when the cache is full.
+static void noteMissingTex(const char *path) {
+  if (strlen(path) >= TEX_CACHE_PATH)
+    return;
+  lockTexCache();
+  bool chroma = chromaKeyByName(path);
+  if (!findTexCacheEntry(path, chroma)) {
+    if (TexCacheEntry *e = claimTexCacheSlot(false)) {
+      *e = {};
+      snprintf(e->path, sizeof(e->path), "%s", path);
+      e->chroma = chroma;
+      e->used = true;
+      e->lastUse = g_texCacheClock;
+    }
+  }
+  unlockTexCache();
+}
+
+// Game thread: adds a freshly uploaded `tex` for `path` with one reference.
+// If the path is already cached (or the cache is full of referenced
+// textures) the caller still gets a usable texture back.
+static SDL_Texture *insertTexCache(const char *path, SDL_Texture *tex) {
+  if (!tex || strlen(path) >= TEX_CACHE_PATH)
+    return tex;
+  lockTexCache();
+  bool chroma = chromaKeyByName(path);
+  TexCacheEntry *e = findTexCacheEntry(path, chroma);
+  if (e && e->tex) {
+    rqDestroyTexture(tex);
+    e->refs++;
+    e->lastUse = ++g_texCacheClock;
+    tex = e->tex;
+  } else if (e || (e = claimTexCacheSlot(true))) {
+    int w = 0, h = 0;
+    rqTextureInfo(tex, &w, &h);
+    *e = {};
+    snprintf(e->path, sizeof(e->path), "%s", path);
+    e->chroma = chroma;
+    e->used = true;
+    e->tex = tex;
+    e->bytes = (size_t)w * (size_t)h * 4u;
+    e->refs = 1;
+    e->lastUse = ++g_texCacheClock;
+  }
+  unlockTexCache();
+  return tex;
+}
+
+// Game thread: a referenced texture for `path`, decoding it on a miss.
+static SDL_Texture *acquireTex(const char *path) {
+  lockTexCache();
+  TexCacheEntry *e = findTexCacheEntry(path, chromaKeyByName(path));
+  if (e) {
+    g_texCacheStats.hits++;
+    e->lastUse = ++g_texCacheClock;
+    if (e->tex)
+      e->refs++;
+    SDL_Texture *tex = e->tex;
+    unlockTexCache();
+    return tex;
+  }
+  g_texCacheStats.misses++;
+  unlockTexCache();
+  SDL_Texture *tex = uploadSurface(loadArtSurface(path));
+  if (!tex) {
+    noteMissingTex(path);
+    return nullptr;
+  }
+  return insertTexCache(path, tex);
+}
+
+// Game thread: drops the reference held in `t`. Textures that never made it
+// into the cache are destroyed outright.
+static void releaseTex(SDL_Texture *&t) {
+  if (!t)
+    return;
+  lockTexCache();
+  bool cached = false;
+  for (TexCacheEntry &e : g_texCache) {
+    if (e.used && e.tex == t) {
+      if (e.refs > 0)
+        e.refs--;
+      cached = true;
+      break;
+    }
+  }
+  unlockTexCache();
+  if (!cached)
+    rqDestroyTexture(t);
+  t = nullptr;
+  trimTexCache();
+}
+
+static size_t texCacheBytes(int *entries) {
+  size_t bytes = 0;
+  int n = 0;
+  lockTexCache();
+  for (const TexCacheEntry &e : g_texCache) {
+    if (e.used && e.tex) {
+      bytes += e.bytes;
+      n++;
+    }
+  }
+  unlockTexCache();
+  if (entries)
+    *entries = n;
+  return bytes;
+}
+
+//------------------------------------------------------------------------------
+// Sprite atlas
+//------------------------------------------------------------------------------
+// Entity, item, block and HUD sheets are packed at startup into one or two
+// large pages so consecutive sprite draws share a texture instead of paying a
+// texture switch per sprite. Theme tilesets and backgrounds are swapped per
+// section and stay standalone textures.
+constexpr int ATLAS_PAGE_W = 1024;
+constexpr int ATLAS_PAGE_H = 1024;
+constexpr int ATLAS_MAX_PAGES = 2;
+constexpr int ATLAS_PAD = 2; // transparent gutter between sheets
+constexpr int ATLAS_MAX_SPRITES = 64;
+
+struct AtlasEntry {
+  char name[96];
+  Sprite spr;
+};
+static AtlasEntry g_atlasEntries[ATLAS_MAX_SPRITES];
+static int g_atlasEntryCount = 0;
+static SDL_Texture *g_atlasPages[ATLAS_MAX_PAGES] = {};
+static int g_atlasPageCount = 0;
+
+static Sprite findSprite(const char *name) {
+  for (int i = 0; i < g_atlasEntryCount; i++) {
+    if (strcmp(g_atlasEntries[i].name, name) == 0)
+      return g_atlasEntries[i].spr;
+  }
+  return Sprite{};
+}
+
+static void registerSprite(const char *name, SDL_Texture *tex,
+                           const SDL_Rect &rect) {
+  if (g_atlasEntryCount >= ATLAS_MAX_SPRITES || !tex)
+    return;
+  AtlasEntry &e = g_atlasEntries[g_atlasEntryCount++];
+  snprintf(e.name, sizeof(e.name), "%s", name);
+  e.spr.tex = tex;
+  e.spr.rect = rect;
+}
+
+// Expect 16px-wide palette columns. Sample a row below the top ball where the
+// thin shaft begins, and attach the flag to the leftmost opaque pixel. `page`
+// is the RGBA32 atlas page and `sheet` the FlagPole bounds on it.
+static int computeFlagPoleShaftX(SDL_Surface *page, const SDL_Rect &sheet) {
   int sx = 8;
   int sampleY = 16;
+  if (sampleY >= sheet.h)
+    sampleY = sheet.h - 1;
   if (sampleY < 0)
-    sampleY = 0;
-  if (sampleY >= s->h)
-    sampleY = s->h - 1;
+    return sx;
 
-  SDL_LockSurface(s);
-  Uint32 *pixels = (Uint32 *)s->pixels;
-  int pitch32 = s->pitch / 4;
+  SDL_LockSurface(page);
+  const Uint32 *pixels = (const Uint32 *)page->pixels;
+  int pitch32 = page->pitch / 4;
   Uint8 r, g, b, a;
   int found = -1;
-  for (int x = 0; x < 16 && x < s->w; x++) {
-    Uint32 px = pixels[sampleY * pitch32 + x];
-    SDL_GetRGBA(px, s->format, &r, &g, &b, &a);
+  for (int x = 0; x < 16 && x < sheet.w; x++) {
+    Uint32 px = pixels[(sheet.y + sampleY) * pitch32 + sheet.x + x];
+    SDL_GetRGBA(px, page->format, &r, &g, &b, &a);
     if (a != 0) {
       found = x;
       break;
     }
   }
-  SDL_UnlockSurface(s);
-  SDL_FreeSurface(s);
+  SDL_UnlockSurface(page);
   if (found >= 0)
     sx = found;
   if (sx < 0)
@@ -1150,9 +2401,113 @@ static int computeFlagPoleShaftX() {
   return sx;
 }
 
+// Loads `files` (content-relative), shelf-packs them tallest-first into up to
+// ATLAS_MAX_PAGES pages and registers each sheet under its file name. Sheets
+// that do not fit keep a standalone texture, so lookups never fail just
+// because the atlas is full.
+static void buildSpriteAtlas(const char *const *files, int count) {
+  struct Pending {
+    const char *name;
+    SDL_Surface *surf;
+    bool premultiplied;
+    int page;
+    SDL_Rect rect;
+  };
+  Pending items[ATLAS_MAX_SPRITES];
+  int n = 0;
+  for (int i = 0; i < count && n < ATLAS_MAX_SPRITES; i++) {
+    SDL_Surface *s = loadArtSurface(files[i]);
+    if (!s)
+      continue;
+    bool premultiplied = surfaceIsPremultiplied(s);
+    SDL_SetSurfaceBlendMode(s, SDL_BLENDMODE_NONE);
+    items[n++] = {files[i], s, premultiplied, -1, {0, 0, s->w, s->h}};
+  }
+
+  int order[ATLAS_MAX_SPRITES];
+  for (int i = 0; i < n; i++)
+    order[i] = i;
+  std::sort(order, order + n, [&](int a, int b) {
+    return items[a].rect.h > items[b].rect.h;
+  });
+
+  // Pages share one blend mode, so sheets cooked with the other alpha
+  // convention than the first (tallest) one stay standalone.
+  bool atlasPremultiplied = n > 0 && items[order[0]].premultiplied;
+  int pageUsedH[ATLAS_MAX_PAGES] = {};
+  int page = 0, penX = 0, penY = 0, shelfH = 0;
+  for (int k = 0; k < n; k++) {
+    Pending &it = items[order[k]];
+    int w = it.rect.w, h = it.rect.h;
+    if (w > ATLAS_PAGE_W || h > ATLAS_PAGE_H ||
+        it.premultiplied != atlasPremultiplied)
+      continue;
+    if (penX + w > ATLAS_PAGE_W) {
+      penX = 0;
+      penY += shelfH + ATLAS_PAD;
+      shelfH = 0;
+    }
+    if (penY + h > ATLAS_PAGE_H) {
+      page++;
+      penX = penY = shelfH = 0;
+    }
+    if (page >= ATLAS_MAX_PAGES)
+      break;
+    it.page = page;
+    it.rect.x = penX;
+    it.rect.y = penY;
+    penX += w + ATLAS_PAD;
+    if (h > shelfH)
+      shelfH = h;
+    if (penY + h > pageUsedH[page])
+      pageUsedH[page] = penY + h;
+  }
+
+  for (int p = 0; p < ATLAS_MAX_PAGES && pageUsedH[p] > 0; p++) {
+    SDL_Surface *pageSurf = SDL_CreateRGBSurfaceWithFormat(
+        0, ATLAS_PAGE_W, pageUsedH[p], 32, SDL_PIXELFORMAT_RGBA32);
+    if (!pageSurf)
+      break;
+    for (int i = 0; i < n; i++) {
+      if (items[i].page != p)
+        continue;
+      SDL_Rect dst = items[i].rect;
+      SDL_BlitSurface(items[i].surf, nullptr, pageSurf, &dst);
+      if (strstr(items[i].name, "FlagPole.png") != nullptr)
+        g_flagPoleShaftX = computeFlagPoleShaftX(pageSurf, items[i].rect);
+    }
+    SDL_Texture *tex = rqCreateTextureFromSurface(
+        pageSurf, atlasPremultiplied ? premultipliedBlendMode()
+                                     : SDL_BLENDMODE_BLEND);
+    SDL_FreeSurface(pageSurf);
+    if (!tex)
+      break;
+    g_loadedTex++;
+    g_atlasPages[g_atlasPageCount++] = tex;
+    for (int i = 0; i < n; i++) {
+      if (items[i].page == p)
+        registerSprite(items[i].name, tex, items[i].rect);
+    }
+  }
+
+  for (int i = 0; i < n; i++) {
+    if (items[i].page < 0 || items[i].page >= g_atlasPageCount) {
+      SDL_Texture *tex = rqCreateTextureFromSurface(
+          items[i].surf, items[i].premultiplied ? premultipliedBlendMode()
+                                                : SDL_BLENDMODE_BLEND);
+      if (tex) {
+        g_loadedTex++;
+        registerSprite(items[i].name, tex,
+                       {0, 0, items[i].surf->w, items[i].surf->h});
+      }
+    }
+    SDL_FreeSurface(items[i].surf);
+  }
+}
+
 void destroyTex(SDL_Texture *&t) {
   if (t) {
-    SDL_DestroyTexture(t);
+    rqDestroyTexture(t);
     t = nullptr;
   }
 }
@@ -1205,17 +2560,136 @@ const char *themeName(LevelTheme t) {
 Mix_Music *loadBgmByName(const char *name) {
   if (!name)
     return nullptr;
-  const char *paths[] = {
-      "content/audio/bgm/%s.mp3",
-      "../content/audio/bgm/%s.mp3",
-      "fs:/vol/content/audio/bgm/%s.mp3"};
-  Mix_Music *m = nullptr;
-  for (int i = 0; i < 3 && !m; i++) {
-    char p[512];
-    snprintf(p, sizeof(p), paths[i], name);
-    m = Mix_LoadMUS(p);
+  char rel[256], path[512];
+  snprintf(rel, sizeof(rel), "audio/bgm/%s.mp3", name);
+  if (!resolveContentPath(rel, path, sizeof(path)))
+    return nullptr;
+  return Mix_LoadMUS(path);
+}
+
+static Mix_Chunk *loadSfx(const char *file) {
+  char rel[256], path[512];
+  snprintf(rel, sizeof(rel), "audio/sfx/%s", file);
+  if (!resolveContentPath(rel, path, sizeof(path)))
+    return nullptr;
+  return Mix_LoadWAV(path);
+}
+
+// Per-effect mixing policy. `priority` decides who may steal whose voice when
+// every SFX channel is busy; `maxVoices` caps how many copies of one effect
+// overlap, so a coin run or a shell chain restarts its own oldest copy instead
+// of crowding out everything else. `fallback` plays when the file is missing.
+struct SfxDef {
+  const char *file;
+  uint8_t priority;
+  uint8_t maxVoices;
+  int8_t fallback;
+};
+
+static const SfxDef kSfxDefs[SFX_COUNT] = {
+    {"SmallJump.wav", 2, 2, -1},              // SFX_JUMP
+    {"BigJump.wav", 2, 2, SFX_JUMP},          // SFX_BIG_JUMP
+    {"Stomp.wav", 2, 2, SFX_KICK},            // SFX_STOMP
+    {"Coin.wav", 1, 2, -1},                   // SFX_COIN
+    {"Powerup.wav", 3, 1, SFX_ITEM_APPEAR},   // SFX_POWERUP
+    {"Bump.wav", 1, 1, -1},                   // SFX_BUMP
+    {"BreakBlock.wav", 1, 3, -1},             // SFX_BREAK
+    {"ItemAppear.wav", 1, 1, -1},             // SFX_ITEM_APPEAR
+    {"Damage.wav", 3, 1, -1},                 // SFX_DAMAGE
+    {"Skid.wav", 0, 1, -1},                   // SFX_SKID
+    {"MenuNavigate.wav", 1, 1, -1},           // SFX_MENU_MOVE
+    {"FlagSlide.wav", 3, 1, -1},              // SFX_FLAG_SLIDE
+    {"CastleClear.wav", 3, 1, -1},            // SFX_CASTLE_CLEAR
+    {"Pipe.wav", 3, 1, -1},                   // SFX_PIPE
+    {"Kick.wav", 1, 2, -1},                   // SFX_KICK
+    {"Fireball.wav", 0, 2, -1},               // SFX_FIREBALL
+};
+
+// SFX channels; music mixes separately and never competes for these.
+constexpr int SFX_VOICES = 16;
+
+struct SfxVoice {
+  int sfx = -1;        // SfxId last started on this channel
+  uint32_t serial = 0; // start order, for oldest-first stealing
+};
+static SfxVoice g_sfxVoices[SFX_VOICES];
+static uint32_t g_sfxSerial = 0;
+
+// 1024 samples is ~23 ms at 44.1 kHz, so an effect starts within about a
+// frame and a half of the event; the old 4096-sample buffer added ~93 ms. The
+// large buffer stays as a fallback if the device rejects the small one.
+constexpr int AUDIO_RATE = 44100;
+constexpr int AUDIO_CHUNK_SAMPLES = 1024;
+constexpr int AUDIO_CHUNK_SAMPLES_SAFE = 4096;
+
+static void openAudio() {
+  if (Mix_OpenAudio(AUDIO_RATE, MIX_DEFAULT_FORMAT, 2, AUDIO_CHUNK_SAMPLES) < 0)
+    Mix_OpenAudio(AUDIO_RATE, MIX_DEFAULT_FORMAT, 2, AUDIO_CHUNK_SAMPLES_SAFE);
+}
+
+// Mix_LoadWAV decodes and converts to the opened device format up front, so
+// once the bank is loaded (after Mix_OpenAudio) playing an effect is only a
+// channel assignment; nothing is decoded or resampled at play time.
+static void loadSfxBank() {
+  for (int i = 0; i < SFX_COUNT; i++) {
+    g_sfxBank[i] = loadSfx(kSfxDefs[i].file);
+    if (g_sfxBank[i])
+      Mix_VolumeChunk(g_sfxBank[i], MIX_MAX_VOLUME);
+  }
+  Mix_AllocateChannels(SFX_VOICES);
+  for (SfxVoice &v : g_sfxVoices)
+    v = SfxVoice{};
+}
+
+// Playing on a busy channel cuts off whatever it was playing.
+static void startSfxVoice(int ch, int id) {
+  if (Mix_PlayChannel(ch, g_sfxBank[id], 0) < 0)
+    return;
+  g_sfxVoices[ch].sfx = id;
+  g_sfxVoices[ch].serial = ++g_sfxSerial;
+}
+
+void playSfx(SfxId id) {
+  int sfx = id;
+  if (!g_sfxBank[sfx] && kSfxDefs[sfx].fallback >= 0)
+    sfx = kSfxDefs[sfx].fallback;
+  if (!g_sfxBank[sfx])
+    return;
+  const SfxDef &def = kSfxDefs[sfx];
+
+  int instances = 0, oldestSame = -1, freeCh = -1, victim = -1;
+  for (int ch = 0; ch < SFX_VOICES; ch++) {
+    const SfxVoice &v = g_sfxVoices[ch];
+    if (!Mix_Playing(ch)) {
+      if (freeCh < 0)
+        freeCh = ch;
+      continue;
+    }
+    if (v.sfx == sfx) {
+      instances++;
+      if (oldestSame < 0 || v.serial < g_sfxVoices[oldestSame].serial)
+        oldestSame = ch;
+    }
+    // Steal the lowest-priority voice, oldest first, never one that outranks
+    // the new effect.
+    if (v.sfx >= 0 && kSfxDefs[v.sfx].priority <= def.priority) {
+      if (victim < 0)
+        victim = ch;
+      else {
+        const SfxVoice &w = g_sfxVoices[victim];
+        uint8_t vp = kSfxDefs[v.sfx].priority, wp = kSfxDefs[w.sfx].priority;
+        if (vp < wp || (vp == wp && v.serial < w.serial))
+          victim = ch;
+      }
+    }
   }
-  return m;
+
+  if (instances >= def.maxVoices && oldestSame >= 0)
+    startSfxVoice(oldestSame, sfx);
+  else if (freeCh >= 0)
+    startSfxVoice(freeCh, sfx);
+  else if (victim >= 0)
+    startSfxVoice(victim, sfx);
 }
 
 const char *bgHillsName(LevelTheme t) {
@@ -1303,77 +2777,131 @@ const char *bgBushesName(LevelTheme t) {
   }
 }
 
-void loadBackgroundArt() {
-  destroyTex(g_texBgHills);
-  destroyTex(g_texBgBushes);
-  destroyTex(g_texBgCloudOverlay);
-  destroyTex(g_texBgSky);
-  destroyTex(g_texBgSecondary);
+// Per-section art. The tileset slots depend only on the theme; the background
+// slots also on night mode and the secondary layer.
+enum SectionArtSlot {
+  SA_TERRAIN = 0,
+  SA_DECO,
+  SA_LIQUIDS,
+  SA_BG_HILLS,
+  SA_BG_BUSHES,
+  SA_BG_CLOUDS,
+  SA_BG_SKY,
+  SA_BG_SECONDARY,
+  SA_COUNT
+};
+constexpr int SA_TILESET_FIRST = SA_TERRAIN;
+constexpr int SA_TILESET_END = SA_BG_HILLS;
+constexpr int SA_BG_FIRST = SA_BG_HILLS;
+constexpr int SA_BG_END = SA_COUNT;
+
+struct SectionArtKey {
+  int theme = -1;
+  bool night = false;
+  int secondary = 0;
+};
+
+static bool sameArtKey(const SectionArtKey &a, const SectionArtKey &b) {
+  return a.theme == b.theme && a.night == b.night && a.secondary == b.secondary;
+}
+
+// One art slot as resolved by the loaders below: the content path that exists
+// (empty if none) and its decoded surface, unless the texture cache already
+// holds that path.
+struct ArtLoad {
+  char path[TEX_CACHE_PATH];
+  SDL_Surface *surf;
+};
+
+// Any thread. Returns false if `file` does not exist.
+static bool loadArt(const char *file, ArtLoad &out) {
+  int cached = probeTexCache(file);
+  if (cached == 0)
+    return false;
+  SDL_Surface *s = nullptr;
+  if (cached < 0) {
+    s = loadArtSurface(file);
+    if (!s) {
+      noteMissingTex(file);
+      return false;
+    }
+  }
+  snprintf(out.path, sizeof(out.path), "%s", file);
+  out.surf = s;
+  return true;
+}
+
+// Game thread: a referenced texture for a resolved slot.
+static SDL_Texture *acquireArt(ArtLoad &a) {
+  if (a.surf) {
+    g_texCacheStats.misses++;
+    SDL_Texture *t = uploadSurface(a.surf);
+    a.surf = nullptr;
+    return insertTexCache(a.path, t);
+  }
+  return a.path[0] ? acquireTex(a.path) : nullptr;
+}
 
-  auto tryLoadBg = [&](const char *dir, const char *file) -> SDL_Texture * {
+static void resolveBackgroundArt(LevelTheme theme, bool night, int secondary,
+                                 ArtLoad *out) {
+  auto tryLoadBg = [&](ArtLoad &slot, const char *dir, const char *file) {
     // Use separate buffers: `file` may itself be a temporary buffer, and we must
     // never snprintf() into the same buffer we're also reading from.
     char fullPath[512];
     snprintf(fullPath, sizeof(fullPath), "sprites/Backgrounds/%s/%.*s", dir, 400,
              file);
-    return loadTex(fullPath);
+    return loadArt(fullPath, slot);
   };
-  auto tryLoadBgName = [&](const char *dir, const char *base,
-                           bool nightMode) -> SDL_Texture * {
+  auto tryLoadBgName = [&](ArtLoad &slot, const char *dir, const char *base,
+                           bool nightMode) {
     // Prefer LL variants; many non-LL files are chroma-key sources (green).
     char fileBuf[512];
     if (nightMode) {
       // Some underwater assets use ...LLNight instead of ...NightLL.
       snprintf(fileBuf, sizeof(fileBuf), "%sNightLL.png", base);
-      if (auto *t = tryLoadBg(dir, fileBuf))
-        return t;
+      if (tryLoadBg(slot, dir, fileBuf))
+        return true;
       snprintf(fileBuf, sizeof(fileBuf), "%sLLNight.png", base);
-      if (auto *t = tryLoadBg(dir, fileBuf))
-        return t;
+      if (tryLoadBg(slot, dir, fileBuf))
+        return true;
       snprintf(fileBuf, sizeof(fileBuf), "%sNight.png", base);
-      if (auto *t = tryLoadBg(dir, fileBuf))
-        return t;
+      if (tryLoadBg(slot, dir, fileBuf))
+        return true;
     }
     snprintf(fileBuf, sizeof(fileBuf), "%sLL.png", base);
-    if (auto *t = tryLoadBg(dir, fileBuf))
-      return t;
+    if (tryLoadBg(slot, dir, fileBuf))
+      return true;
     snprintf(fileBuf, sizeof(fileBuf), "%s.png", base);
-    return tryLoadBg(dir, fileBuf);
+    return tryLoadBg(slot, dir, fileBuf);
   };
 
-  const char *hillsBase = bgHillsName(g_theme);
-  g_texBgHills = tryLoadBgName("Hills", hillsBase, g_nightMode);
-  if (!g_texBgHills) {
-    g_texBgHills = tryLoadBgName("Hills", themeName(g_theme), g_nightMode);
-  }
+  const char *hillsBase = bgHillsName(theme);
+  if (!tryLoadBgName(out[SA_BG_HILLS], "Hills", hillsBase, night))
+    tryLoadBgName(out[SA_BG_HILLS], "Hills", themeName(theme), night);
 
-  const char *bushBase = bgBushesName(g_theme);
-  g_texBgBushes = tryLoadBgName("Bushes", bushBase, g_nightMode);
-  if (!g_texBgBushes) {
-    g_texBgBushes = tryLoadBgName("Bushes", "Bush", g_nightMode);
-  }
+  const char *bushBase = bgBushesName(theme);
+  if (!tryLoadBgName(out[SA_BG_BUSHES], "Bushes", bushBase, night))
+    tryLoadBgName(out[SA_BG_BUSHES], "Bushes", "Bush", night);
 
   // Overlays: prefer LL; the non-LL overlay is a green chroma source.
-  g_texBgCloudOverlay =
-      loadTex("sprites/Backgrounds/CloudOverlays/CloudOverlayLL.png");
-  if (!g_texBgCloudOverlay) {
-    g_texBgCloudOverlay =
-        loadTex("sprites/Backgrounds/CloudOverlays/CloudOverlay.png");
-  }
+  if (!loadArt("sprites/Backgrounds/CloudOverlays/CloudOverlayLL.png",
+               out[SA_BG_CLOUDS]))
+    loadArt("sprites/Backgrounds/CloudOverlays/CloudOverlay.png",
+            out[SA_BG_CLOUDS]);
 
   // Sky texture (optional). The current game clears to a flat color, but
   // adding the subtle sky pass helps match the Godot project's look.
   const char *skyBase = nullptr;
-  if (g_nightMode) {
-    if (g_theme == THEME_SNOW)
+  if (night) {
+    if (theme == THEME_SNOW)
       skyBase = "SnowNightStars";
-    else if (g_theme == THEME_SPACE)
+    else if (theme == THEME_SPACE)
       skyBase = "SpaceStars";
     else
       skyBase = "NightStars";
-    g_texBgSky = tryLoadBgName("Skies", skyBase, false);
+    tryLoadBgName(out[SA_BG_SKY], "Skies", skyBase, false);
   } else {
-    switch (g_theme) {
+    switch (theme) {
     case THEME_BEACH:
       skyBase = "BeachSky";
       break;
@@ -1393,16 +2921,14 @@ void loadBackgroundArt() {
       skyBase = "DaySky";
       break;
     }
-    g_texBgSky = tryLoadBgName("Skies", skyBase, false);
+    tryLoadBgName(out[SA_BG_SKY], "Skies", skyBase, false);
   }
 
   // Foreground (behind player) themed layer: Trees/Mushrooms.
-  int secondary = effectiveBgSecondary();
-
   if (secondary == 1) {
     // Mushrooms use a suffix Night convention (e.g. BeachMushroomsNight).
     const char *base = nullptr;
-    switch (g_theme) {
+    switch (theme) {
     case THEME_BEACH:
       base = "BeachMushrooms";
       break;
@@ -1420,12 +2946,12 @@ void loadBackgroundArt() {
       base = "Mushrooms";
       break;
     }
-    g_texBgSecondary = tryLoadBgName("SecondaryMushrooms", base, g_nightMode);
+    tryLoadBgName(out[SA_BG_SECONDARY], "SecondaryMushrooms", base, night);
   } else if (secondary == 2) {
     // Trees mostly use an infix Night convention (e.g. JungleNightTrees).
     const char *day = nullptr;
     const char *night = nullptr;
-    switch (g_theme) {
+    switch (theme) {
     case THEME_UNDERWATER:
     case THEME_CASTLE_WATER:
       day = "UnderwaterTrees";
@@ -1473,405 +2999,1066 @@ void loadBackgroundArt() {
       night = "NightTrees";
       break;
     }
-    if (g_nightMode) {
-      g_texBgSecondary = tryLoadBgName("SecondaryTrees", night, false);
-      if (!g_texBgSecondary)
-        g_texBgSecondary = tryLoadBgName("SecondaryTrees", day, false);
+    if (night) {
+      if (!tryLoadBgName(out[SA_BG_SECONDARY], "SecondaryTrees", night, false))
+        tryLoadBgName(out[SA_BG_SECONDARY], "SecondaryTrees", day, false);
     } else {
-      g_texBgSecondary = tryLoadBgName("SecondaryTrees", day, false);
+      tryLoadBgName(out[SA_BG_SECONDARY], "SecondaryTrees", day, false);
     }
   }
 }
 
-void loadThemeTilesets() {
-  destroyTex(g_texTerrain);
-  destroyTex(g_texDeco);
-  destroyTex(g_texLiquids);
+static void resolveTilesetArt(LevelTheme theme, ArtLoad *out) {
   char path[256];
-  snprintf(path, sizeof(path), "tilesets/Terrain/%s.png", themeName(g_theme));
-  g_texTerrain = loadTex(path);
-  if (!g_texTerrain) {
+  snprintf(path, sizeof(path), "tilesets/Terrain/%s.png", themeName(theme));
+  if (!loadArt(path, out[SA_TERRAIN])) {
     // Backward-compat with older content layouts.
-    snprintf(path, sizeof(path), "sprites/tilesets/%s.png", themeName(g_theme));
-    g_texTerrain = loadTex(path);
+    snprintf(path, sizeof(path), "sprites/tilesets/%s.png", themeName(theme));
+    loadArt(path, out[SA_TERRAIN]);
   }
 
-  snprintf(path, sizeof(path), "tilesets/Deco/%sDeco.png", themeName(g_theme));
-  g_texDeco = loadTex(path);
-  if (!g_texDeco) {
-    snprintf(path, sizeof(path), "sprites/tilesets/Deco/%sDeco.png", themeName(g_theme));
-    g_texDeco = loadTex(path);
+  snprintf(path, sizeof(path), "tilesets/Deco/%sDeco.png", themeName(theme));
+  if (!loadArt(path, out[SA_DECO])) {
+    snprintf(path, sizeof(path), "sprites/tilesets/Deco/%sDeco.png", themeName(theme));
+    loadArt(path, out[SA_DECO]);
   }
 
-  g_texLiquids = loadTex("tilesets/Liquids.png");
-  if (!g_texLiquids)
-    g_texLiquids = loadTex("sprites/tilesets/Liquids.png");
+  if (!loadArt("tilesets/Liquids.png", out[SA_LIQUIDS]))
+    loadArt("sprites/tilesets/Liquids.png", out[SA_LIQUIDS]);
+}
+
+//------------------------------------------------------------------------------
+// Music streaming
+//------------------------------------------------------------------------------
+// Every theme has a normal and a *Hurry track. Opening one (Mix_LoadMUS parses
+// and seeks the MP3) runs on a worker thread, so entering a theme never stalls
+// a frame; SDL_mixer then decodes the playing track a buffer at a time in the
+// audio callback. requestMusic() queues a track ahead of use (section prefetch,
+// low timer), playThemeMusic() only records which track should play, and
+// pumpMusic() fades the old track out and the new one in once it is open. The
+// old track keeps playing until then. Opened tracks stay resident.
+enum MusicTrackState { MT_NONE = 0, MT_QUEUED, MT_LOADING, MT_READY };
+
+constexpr int MUSIC_TRACKS = 2 * THEME_COUNT;
+constexpr int MUSIC_HURRY_TIME = 100;          // g_time at which hurry plays
+constexpr int MUSIC_HURRY_PREFETCH_TIME = 130; // ...and when it is opened
+constexpr int MUSIC_FADE_OUT_MS = 400;
+constexpr int MUSIC_FADE_IN_MS = 250;
+
+struct MusicTrack {
+  MusicTrackState state = MT_NONE;
+  uint32_t order = 0;         // queue position while MT_QUEUED
+  Mix_Music *music = nullptr; // set with MT_READY; null if the file is missing
+};
+
+static SDL_Thread *g_musicThread = nullptr;
+static SDL_mutex *g_musicLock = nullptr;
+static SDL_cond *g_musicCond = nullptr;
+static bool g_musicQuit = false;                // guarded by g_musicLock
+static MusicTrack g_musicTracks[MUSIC_TRACKS];  // guarded by g_musicLock
+static uint32_t g_musicOrder = 0;               // guarded by g_musicLock
+static int g_musicPlaying = -1; // track started on the mixer, -1 for none
+static int g_musicWanted = -1;  // track that should be playing, -1 for silence
+
+static int musicTrack(LevelTheme t, bool hurry) {
+  return (int)t * 2 + (hurry ? 1 : 0);
+}
+
+static Mix_Music *openMusicTrack(int track) {
+  char name[64];
+  snprintf(name, sizeof(name), "%s%s", themeName((LevelTheme)(track / 2)),
+           (track & 1) ? "Hurry" : "");
+  return loadBgmByName(name);
 }
 
-Mix_Music *themeMusic(LevelTheme t) {
-  if (t >= 0 && t < THEME_COUNT) {
-    if (!g_bgmByTheme[t]) {
-      g_bgmByTheme[t] = loadBgmByName(themeName(t));
+static int musicStreamThread(void *) {
+  SDL_LockMutex(g_musicLock);
+  while (!g_musicQuit) {
+    int next = -1;
+    for (int i = 0; i < MUSIC_TRACKS; i++) {
+      const MusicTrack &t = g_musicTracks[i];
+      if (t.state == MT_QUEUED &&
+          (next < 0 || t.order < g_musicTracks[next].order))
+        next = i;
     }
-    if (g_bgmByTheme[t])
-      return g_bgmByTheme[t];
+    if (next < 0) {
+      SDL_CondWait(g_musicCond, g_musicLock);
+      continue;
+    }
+    g_musicTracks[next].state = MT_LOADING;
+    SDL_UnlockMutex(g_musicLock);
+    Mix_Music *m = openMusicTrack(next);
+    SDL_LockMutex(g_musicLock);
+    g_musicTracks[next].music = m;
+    g_musicTracks[next].state = MT_READY;
+  }
+  SDL_UnlockMutex(g_musicLock);
+  return 0;
+}
+
+static void startMusicStreaming() {
+  g_musicLock = SDL_CreateMutex();
+  g_musicCond = SDL_CreateCond();
+  if (g_musicLock && g_musicCond)
+    g_musicThread = SDL_CreateThread(musicStreamThread, "music-stream", nullptr);
+}
+
+static void stopMusicStreaming() {
+  if (g_musicThread) {
+    SDL_LockMutex(g_musicLock);
+    g_musicQuit = true;
+    SDL_CondBroadcast(g_musicCond);
+    SDL_UnlockMutex(g_musicLock);
+    SDL_WaitThread(g_musicThread, nullptr);
+    g_musicThread = nullptr;
+  }
+  Mix_HaltMusic();
+  g_musicPlaying = g_musicWanted = -1;
+  for (MusicTrack &t : g_musicTracks) {
+    if (t.music)
+      Mix_FreeMusic(t.music);
+    t = MusicTrack{};
+  }
+  if (g_musicCond)
+    SDL_DestroyCond(g_musicCond);
+  if (g_musicLock)
+    SDL_DestroyMutex(g_musicLock);
+  g_musicCond = nullptr;
+  g_musicLock = nullptr;
+}
+
+// Queues `track` for opening unless it is already open or on its way. Without
+// a worker it is opened on the spot.
+static void requestMusic(int track) {
+  if (!g_musicThread) {
+    MusicTrack &t = g_musicTracks[track];
+    if (t.state != MT_READY) {
+      t.music = openMusicTrack(track);
+      t.state = MT_READY;
+    }
+    return;
+  }
+  SDL_LockMutex(g_musicLock);
+  MusicTrack &t = g_musicTracks[track];
+  if (t.state == MT_NONE) {
+    t.state = MT_QUEUED;
+    t.order = ++g_musicOrder;
+    SDL_CondSignal(g_musicCond);
   }
-  return g_bgmOverworld;
+  SDL_UnlockMutex(g_musicLock);
+}
+
+static bool musicReady(int track, Mix_Music **out) {
+  if (g_musicLock)
+    SDL_LockMutex(g_musicLock);
+  bool ready = g_musicTracks[track].state == MT_READY;
+  if (ready)
+    *out = g_musicTracks[track].music;
+  if (g_musicLock)
+    SDL_UnlockMutex(g_musicLock);
+  return ready;
 }
 
 void playThemeMusic(LevelTheme t) {
-  Mix_Music *m = themeMusic(t);
-  if (m && m != g_bgm) {
-    Mix_HaltMusic();
-    g_bgm = m;
-    Mix_VolumeMusic(MIX_MAX_VOLUME);
-    Mix_PlayMusic(g_bgm, -1);
-  } else if (m && !Mix_PlayingMusic()) {
-    g_bgm = m;
+  bool hurry = g_state == GS_PLAYING && g_time <= MUSIC_HURRY_TIME;
+  g_musicWanted = musicTrack(t, hurry);
+  requestMusic(g_musicWanted);
+}
+
+// Cuts the music at once (death, flag, level end) and cancels any pending
+// switch.
+void stopMusic() {
+  Mix_HaltMusic();
+  g_musicPlaying = g_musicWanted = -1;
+}
+
+// Once per frame: moves the mixer toward g_musicWanted without blocking.
+static void pumpMusic() {
+  if (g_musicWanted == g_musicPlaying)
+    return;
+  Mix_Music *next = nullptr;
+  if (g_musicWanted >= 0) {
+    if (!musicReady(g_musicWanted, &next)) {
+      requestMusic(g_musicWanted);
+      return;
+    }
+    if (!next) {
+      // Missing file: a hurry track falls back to its normal one, anything
+      // else to Overworld.
+      int fallback = (g_musicWanted & 1) ? g_musicWanted - 1
+                                         : musicTrack(THEME_OVERWORLD, false);
+      g_musicWanted = fallback == g_musicWanted ? -1 : fallback;
+      if (g_musicWanted >= 0)
+        requestMusic(g_musicWanted);
+      return;
+    }
+  }
+  if (Mix_PlayingMusic()) {
+    if (Mix_FadingMusic() != MIX_FADING_OUT)
+      Mix_FadeOutMusic(MUSIC_FADE_OUT_MS);
+    return;
+  }
+  g_musicPlaying = g_musicWanted;
+  if (next) {
     Mix_VolumeMusic(MIX_MAX_VOLUME);
-    Mix_PlayMusic(g_bgm, -1);
+    Mix_FadeInMusic(next, -1, MUSIC_FADE_IN_MS);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Section art prefetch
+//------------------------------------------------------------------------------
+// When the leader nears a pipe or the flag, a worker thread peeks the target
+// section's header in levels.pak and decodes its tilesets and background layers
+// (skipping anything the texture cache already holds); once it is done the
+// music streamer opens the theme track. The game thread does no file I/O for
+// this. pumpSectionPrefetch() uploads the finished surfaces one per frame, and
+// loadThemeTilesets() / loadBackgroundArt() adopt those textures instead of
+// reading PNGs at the transition. Anything that doesn't match (random themes, a
+// different target) falls back to the synchronous load.
+enum PrefetchState { PF_IDLE = 0, PF_QUEUED, PF_LOADING, PF_READY };
+
+struct SectionPrefetch {
+  // The job, filled by requestSectionPrefetch(): the target and the art state
+  // it is compared against.
+  int level = -1;
+  int section = -1;
+  int themeOverride = -1;
+  bool night = false;
+  SectionArtKey haveTiles;
+  SectionArtKey haveBg;
+  // Filled by the worker: the target's art and what of it had to be loaded.
+  // key.theme stays -1 if the header could not be read.
+  SectionArtKey key;
+  bool loadTiles = false;
+  bool loadBg = false;
+  bool musicRequested = false;
+  // Written by the worker while PF_LOADING, owned by the game thread once
+  // PF_READY.
+  ArtLoad art[SA_COUNT] = {};
+  SDL_Texture *tex[SA_COUNT] = {}; // referenced through the texture cache
+};
+
+static SDL_Thread *g_prefetchThread = nullptr;
+static SDL_mutex *g_prefetchLock = nullptr;
+static SDL_cond *g_prefetchCond = nullptr;
+static PrefetchState g_prefetchState = PF_IDLE; // guarded by g_prefetchLock
+static bool g_prefetchQuit = false;             // guarded by g_prefetchLock
+static SectionPrefetch g_prefetch;
+// Last transition target asked for, so each target is queued once. If the
+// worker was busy, g_prefetchResubmit makes pumpSectionPrefetch() queue it as
+// soon as the worker is free.
+static int g_prefetchTargetLevel = -1;
+static int g_prefetchTargetSection = -1;
+static bool g_prefetchResubmit = false; // guarded by g_prefetchLock
+// Art currently uploaded for the active section.
+static SectionArtKey g_tilesetArt;
+static SectionArtKey g_bgArt;
+
+static int sectionPrefetchThread(void *) {
+  SDL_LockMutex(g_prefetchLock);
+  for (;;) {
+    while (!g_prefetchQuit && g_prefetchState != PF_QUEUED)
+      SDL_CondWait(g_prefetchCond, g_prefetchLock);
+    if (g_prefetchQuit)
+      break;
+    SectionPrefetch job = g_prefetch;
+    g_prefetchState = PF_LOADING;
+    SDL_UnlockMutex(g_prefetchLock);
+
+    SectionArtKey key;
+    bool loadTiles = false;
+    bool loadBg = false;
+    LevelSectionRuntime meta;
+    if (peekLevelSection(job.level, job.section, meta)) {
+      key.theme = job.themeOverride >= 0 ? job.themeOverride : (int)meta.theme;
+      key.night = job.night;
+      key.secondary = effectiveBgSecondary(meta.bgSecondary);
+      loadTiles = key.theme != job.haveTiles.theme;
+      loadBg = !sameArtKey(key, job.haveBg);
+    }
+    LevelTheme theme = (LevelTheme)key.theme;
+    ArtLoad art[SA_COUNT] = {};
+    if (loadTiles)
+      resolveTilesetArt(theme, art);
+    if (loadBg)
+      resolveBackgroundArt(theme, key.night, key.secondary, art);
+
+    SDL_LockMutex(g_prefetchLock);
+    g_prefetch.key = key;
+    g_prefetch.loadTiles = loadTiles;
+    g_prefetch.loadBg = loadBg;
+    memcpy(g_prefetch.art, art, sizeof(art));
+    g_prefetchState = PF_READY;
+    SDL_CondBroadcast(g_prefetchCond);
+  }
+  SDL_UnlockMutex(g_prefetchLock);
+  return 0;
+}
+
+static void discardPrefetchArt() {
+  for (int i = 0; i < SA_COUNT; i++) {
+    if (g_prefetch.art[i].surf)
+      SDL_FreeSurface(g_prefetch.art[i].surf);
+    g_prefetch.art[i] = {};
+    releaseTex(g_prefetch.tex[i]);
+  }
+  g_prefetch.key = SectionArtKey();
+  g_prefetch.loadTiles = false;
+  g_prefetch.loadBg = false;
+}
+
+static void startSectionPrefetch() {
+  g_texCacheLock = SDL_CreateMutex();
+  g_prefetchLock = SDL_CreateMutex();
+  g_prefetchCond = SDL_CreateCond();
+  if (g_prefetchLock && g_prefetchCond)
+    g_prefetchThread =
+        SDL_CreateThread(sectionPrefetchThread, "section-prefetch", nullptr);
+}
+
+static void stopSectionPrefetch() {
+  if (g_prefetchThread) {
+    SDL_LockMutex(g_prefetchLock);
+    g_prefetchQuit = true;
+    SDL_CondBroadcast(g_prefetchCond);
+    SDL_UnlockMutex(g_prefetchLock);
+    SDL_WaitThread(g_prefetchThread, nullptr);
+    g_prefetchThread = nullptr;
+    discardPrefetchArt();
+    g_prefetchState = PF_IDLE;
+  }
+  if (g_prefetchCond)
+    SDL_DestroyCond(g_prefetchCond);
+  if (g_prefetchLock)
+    SDL_DestroyMutex(g_prefetchLock);
+  if (g_texCacheLock)
+    SDL_DestroyMutex(g_texCacheLock);
+  g_prefetchCond = nullptr;
+  g_prefetchLock = nullptr;
+  g_texCacheLock = nullptr;
+}
+
+// Queues the recorded target for the worker, dropping an unclaimed result.
+// While the worker is busy it only flags the target for resubmission.
+static void submitSectionPrefetch() {
+  SDL_LockMutex(g_prefetchLock);
+  if (g_prefetchTargetLevel < 0) { // reset by a section change meanwhile
+    g_prefetchResubmit = false;
+    SDL_UnlockMutex(g_prefetchLock);
+    return;
+  }
+  if (g_prefetchState == PF_LOADING) {
+    g_prefetchResubmit = true;
+    SDL_UnlockMutex(g_prefetchLock);
+    return;
+  }
+  if (g_prefetchState == PF_READY)
+    discardPrefetchArt();
+  g_prefetchResubmit = false;
+  g_prefetch.level = g_prefetchTargetLevel;
+  g_prefetch.section = g_prefetchTargetSection;
+  g_prefetch.themeOverride = g_themeOverride;
+  g_prefetch.night = g_nightMode;
+  g_prefetch.haveTiles = g_tilesetArt;
+  g_prefetch.haveBg = g_bgArt;
+  g_prefetch.musicRequested = false;
+  g_prefetchState = PF_QUEUED;
+  SDL_CondSignal(g_prefetchCond);
+  SDL_UnlockMutex(g_prefetchLock);
+}
+
+static void requestSectionPrefetch(int level, int section) {
+  if (!g_prefetchThread || g_randomTheme)
+    return;
+  if (level == g_prefetchTargetLevel && section == g_prefetchTargetSection)
+    return;
+  g_prefetchTargetLevel = level;
+  g_prefetchTargetSection = section;
+  submitSectionPrefetch();
+}
+
+// Once per rendered frame: pins cached slots and uploads at most one finished
+// surface, so the texture creation cost is spread out ahead of the
+// transition.
+static void pumpSectionPrefetch() {
+  if (!g_prefetchThread)
+    return;
+  SDL_LockMutex(g_prefetchLock);
+  bool ready = g_prefetchState == PF_READY;
+  bool resubmit = g_prefetchResubmit && g_prefetchState != PF_LOADING;
+  SDL_UnlockMutex(g_prefetchLock);
+  if (resubmit) {
+    submitSectionPrefetch();
+    return;
+  }
+  if (!ready)
+    return;
+  if (!g_prefetch.musicRequested) {
+    g_prefetch.musicRequested = true;
+    if (g_prefetch.key.theme >= 0)
+      requestMusic(musicTrack((LevelTheme)g_prefetch.key.theme,
+                              g_time <= MUSIC_HURRY_TIME));
+  }
+  if (!g_prefetch.loadTiles && !g_prefetch.loadBg) {
+    SDL_LockMutex(g_prefetchLock);
+    g_prefetchState = PF_IDLE;
+    SDL_UnlockMutex(g_prefetchLock);
+    return;
+  }
+  for (int i = 0; i < SA_COUNT; i++) {
+    ArtLoad &a = g_prefetch.art[i];
+    if (g_prefetch.tex[i] || !a.path[0])
+      continue;
+    bool upload = a.surf != nullptr;
+    g_prefetch.tex[i] = acquireArt(a);
+    a.path[0] = '\0';
+    if (upload)
+      return;
+  }
+}
+
+// Moves the prefetched tileset or background textures for `key` into
+// tex[first..end). If the worker is still decoding exactly this art, waits for
+// it: finishing that is cheaper than starting the load over.
+static bool takePrefetchedArt(bool tilesets, const SectionArtKey &key,
+                              SDL_Texture **tex) {
+  if (!g_prefetchThread)
+    return false;
+  SDL_LockMutex(g_prefetchLock);
+  // A job for the section being entered is worth finishing; its art key is
+  // only known once the worker has read the header.
+  if (g_prefetch.level == g_levelIndex && g_prefetch.section == g_sectionIndex)
+    while (g_prefetchState == PF_QUEUED || g_prefetchState == PF_LOADING)
+      SDL_CondWait(g_prefetchCond, g_prefetchLock);
+  bool match = g_prefetchState == PF_READY &&
+               (tilesets ? g_prefetch.loadTiles && g_prefetch.key.theme == key.theme
+                         : g_prefetch.loadBg && sameArtKey(g_prefetch.key, key));
+  SDL_UnlockMutex(g_prefetchLock);
+  if (!match)
+    return false;
+
+  int first = tilesets ? SA_TILESET_FIRST : SA_BG_FIRST;
+  int end = tilesets ? SA_TILESET_END : SA_BG_END;
+  for (int i = first; i < end; i++) {
+    ArtLoad &a = g_prefetch.art[i];
+    if (!g_prefetch.tex[i] && a.path[0])
+      g_prefetch.tex[i] = acquireArt(a);
+    a = {};
+    tex[i] = g_prefetch.tex[i];
+    g_prefetch.tex[i] = nullptr;
+  }
+  (tilesets ? g_prefetch.loadTiles : g_prefetch.loadBg) = false;
+  if (!g_prefetch.loadTiles && !g_prefetch.loadBg) {
+    SDL_LockMutex(g_prefetchLock);
+    g_prefetchState = PF_IDLE;
+    SDL_UnlockMutex(g_prefetchLock);
+  }
+  return true;
+}
+
+// Looks ahead from the leader: the nearest pipe in range, or else the
+// approaching flag, queues the section it leads to.
+static void updateSectionPrefetch() {
+  constexpr float kPrefetchRange = 8.0f * TILE;
+  float midX = g_p.r.x + g_p.r.w * 0.5f;
+  const PipeLink *best = nullptr;
+  float bestDist = kPrefetchRange;
+  for (int i = 0; i < g_levelInfo.pipeCount; i++) {
+    const PipeLink &pipe = g_levelInfo.pipes[i];
+    float d = fabsf((pipe.x + 1) * TILE - midX);
+    if (d <= bestDist) {
+      best = &pipe;
+      bestDist = d;
+    }
+  }
+  if (best) {
+    requestSectionPrefetch(best->targetLevel, best->targetSection);
+  } else if (g_hasFlag && midX >= g_flagX * TILE - kPrefetchRange) {
+    int next = g_levelIndex + 1 < levelCount() ? g_levelIndex + 1 : 0;
+    requestSectionPrefetch(next, 0);
   }
 }
 
+void loadBackgroundArt() {
+  SectionArtKey key;
+  key.theme = g_theme;
+  key.night = g_nightMode;
+  key.secondary = effectiveBgSecondary();
+  if (sameArtKey(key, g_bgArt))
+    return;
+  releaseTex(g_texBgHills);
+  releaseTex(g_texBgBushes);
+  releaseTex(g_texBgCloudOverlay);
+  releaseTex(g_texBgSky);
+  releaseTex(g_texBgSecondary);
+
+  SDL_Texture *tex[SA_COUNT] = {};
+  if (!takePrefetchedArt(false, key, tex)) {
+    ArtLoad art[SA_COUNT] = {};
+    resolveBackgroundArt(g_theme, g_nightMode, key.secondary, art);
+    for (int i = SA_BG_FIRST; i < SA_BG_END; i++)
+      tex[i] = acquireArt(art[i]);
+  }
+  g_texBgHills = tex[SA_BG_HILLS];
+  g_texBgBushes = tex[SA_BG_BUSHES];
+  g_texBgCloudOverlay = tex[SA_BG_CLOUDS];
+  g_texBgSky = tex[SA_BG_SKY];
+  g_texBgSecondary = tex[SA_BG_SECONDARY];
+  g_bgArt = key;
+}
+
+void loadThemeTilesets() {
+  invalidateTileCache();
+  SectionArtKey key;
+  key.theme = g_theme;
+  if (key.theme == g_tilesetArt.theme)
+    return;
+  releaseTex(g_texTerrain);
+  releaseTex(g_texDeco);
+  releaseTex(g_texLiquids);
+
+  SDL_Texture *tex[SA_COUNT] = {};
+  if (!takePrefetchedArt(true, key, tex)) {
+    ArtLoad art[SA_COUNT] = {};
+    resolveTilesetArt(g_theme, art);
+    for (int i = SA_TILESET_FIRST; i < SA_TILESET_END; i++)
+      tex[i] = acquireArt(art[i]);
+  }
+  g_texTerrain = tex[SA_TERRAIN];
+  g_texDeco = tex[SA_DECO];
+  g_texLiquids = tex[SA_LIQUIDS];
+  g_tilesetArt = key;
+}
+
 void loadAssets() {
+  // Every sheet drawn by entities, items, blocks and the HUD goes into the
+  // sprite atlas; the g_spr* handles below are resolved from it once.
+  static const char *kAtlasSheets[] = {
+      "sprites/enemies/Goomba.png",        "sprites/enemies/KoopaTroopa.png",
+      "sprites/enemies/KoopaTroopaSheet.png", "sprites/enemies/CheepCheep.png",
+      "sprites/enemies/BulletBill.png",    "sprites/enemies/Blooper.png",
+      "sprites/enemies/BuzzyBeetle.png",   "sprites/enemies/Lakitu.png",
+      "sprites/enemies/LakituCloud.png",   "sprites/enemies/Spiny.png",
+      "sprites/enemies/HammerBro.png",     "sprites/items/Hammer.png",
+      "sprites/enemies/Bowser.png",        "sprites/tilesets/Platform.png",
+      "sprites/items/BridgeAxe.png",       "sprites/blocks/QuestionBlock.png",
+      "sprites/items/SuperMushroom.png",   "sprites/items/FireFlower.png",
+      "sprites/items/Fireball.png",        "sprites/items/SpinningCoin.png",
+      "sprites/tilesets/FlagPole.png",     "sprites/tilesets/Flag.png",
+      "sprites/tilesets/EndingCastleSprite.png",
+      "sprites/particles/Snow.png",        "sprites/particles/Leaves.png",
+      "sprites/particles/AutumnLeaves.png", "sprites/ui/Title2.png",
+      "sprites/ui/Cursor.png",             "sprites/ui/MenuBG.png",
+      "sprites/ui/CoinIcon.png"};
+  constexpr int kSheetCount = (int)(sizeof(kAtlasSheets) / sizeof(kAtlasSheets[0]));
+  char playerSheets[4][4][64];
+  const char *atlasFiles[ATLAS_MAX_SPRITES];
+  int atlasCount = 0;
+  for (int i = 0; i < g_charCount; i++) {
+    snprintf(playerSheets[i][0], sizeof(playerSheets[i][0]),
+             "sprites/players/%s/Small.png", g_charNames[i]);
+    snprintf(playerSheets[i][1], sizeof(playerSheets[i][1]),
+             "sprites/players/%s/Big.png", g_charNames[i]);
+    snprintf(playerSheets[i][2], sizeof(playerSheets[i][2]),
+             "sprites/players/%s/Fire.png", g_charNames[i]);
+    snprintf(playerSheets[i][3], sizeof(playerSheets[i][3]),
+             "sprites/players/%s/LifeIcon.png", g_charNames[i]);
+    for (int k = 0; k < 4; k++)
+      atlasFiles[atlasCount++] = playerSheets[i][k];
+  }
+  for (int i = 0; i < kSheetCount; i++)
+    atlasFiles[atlasCount++] = kAtlasSheets[i];
+  buildSpriteAtlas(atlasFiles, atlasCount);
+
   for (int i = 0; i < g_charCount; i++) {
-    char pSmall[256];
-    char pBig[256];
-    char pLife[256];
-    char pFire[256];
-    snprintf(pSmall, sizeof(pSmall), "sprites/players/%s/Small.png",
-             g_charNames[i]);
-    snprintf(pBig, sizeof(pBig), "sprites/players/%s/Big.png",
-             g_charNames[i]);
-    snprintf(pFire, sizeof(pFire), "sprites/players/%s/Fire.png",
-             g_charNames[i]);
-    snprintf(pLife, sizeof(pLife), "sprites/players/%s/LifeIcon.png",
-             g_charNames[i]);
-    g_texPlayerSmall[i] = loadTex(pSmall);
-    g_texPlayerBig[i] = loadTex(pBig);
-    g_texPlayerFire[i] = loadTex(pFire);
-    g_texLifeIcon[i] = loadTex(pLife);
+    g_sprPlayerSmall[i] = findSprite(playerSheets[i][0]);
+    g_sprPlayerBig[i] = findSprite(playerSheets[i][1]);
+    g_sprPlayerFire[i] = findSprite(playerSheets[i][2]);
+    g_sprLifeIcon[i] = findSprite(playerSheets[i][3]);
   }
   for (int i = 0; i < g_charCount; i++) {
-    if (!g_texPlayerSmall[i])
-      g_texPlayerSmall[i] = g_texPlayerSmall[0];
-    if (!g_texPlayerBig[i])
-      g_texPlayerBig[i] = g_texPlayerBig[0];
-    if (!g_texPlayerFire[i])
-      g_texPlayerFire[i] = g_texPlayerBig[i];
-    if (!g_texLifeIcon[i])
-      g_texLifeIcon[i] = g_texLifeIcon[0];
-  }
-
-  g_texGoomba = loadTex("sprites/enemies/Goomba.png");
-  g_texKoopa = loadTex("sprites/enemies/KoopaTroopa.png");
-  g_texKoopaSheet = loadTex("sprites/enemies/KoopaTroopaSheet.png");
-  g_texCheepCheep = loadTex("sprites/enemies/CheepCheep.png");
-  g_texBulletBill = loadTex("sprites/enemies/BulletBill.png");
-  g_texBlooper = loadTex("sprites/enemies/Blooper.png");
-  g_texBuzzy = loadTex("sprites/enemies/BuzzyBeetle.png");
-  g_texLakitu = loadTex("sprites/enemies/Lakitu.png");
-  g_texLakituCloud = loadTex("sprites/enemies/LakituCloud.png");
-  g_texSpiny = loadTex("sprites/enemies/Spiny.png");
-  g_texHammerBro = loadTex("sprites/enemies/HammerBro.png");
-  g_texHammer = loadTex("sprites/items/Hammer.png");
-  g_texBowser = loadTex("sprites/enemies/Bowser.png");
-  g_texPlatform = loadTex("sprites/tilesets/Platform.png");
-  g_texBridgeAxe = loadTex("sprites/items/BridgeAxe.png");
-  g_texQuestion = loadTex("sprites/blocks/QuestionBlock.png");
-  g_texMushroom = loadTex("sprites/items/SuperMushroom.png");
-  g_texFireFlower = loadTex("sprites/items/FireFlower.png");
-  g_texFireball = loadTex("sprites/items/Fireball.png");
-  g_texCoin = loadTex("sprites/items/SpinningCoin.png");
-  g_texFlagPole = loadTex("sprites/tilesets/FlagPole.png");
-  g_texFlag = loadTex("sprites/tilesets/Flag.png");
-  g_texCastle = loadTex("sprites/tilesets/EndingCastleSprite.png");
-  g_texParticleSnow = loadTex("sprites/particles/Snow.png");
-  g_texParticleLeaves = loadTex("sprites/particles/Leaves.png");
-  g_texParticleAutumnLeaves = loadTex("sprites/particles/AutumnLeaves.png");
-  g_flagPoleShaftX = computeFlagPoleShaftX();
+    if (!g_sprPlayerSmall[i])
+      g_sprPlayerSmall[i] = g_sprPlayerSmall[0];
+    if (!g_sprPlayerBig[i])
+      g_sprPlayerBig[i] = g_sprPlayerBig[0];
+    if (!g_sprPlayerFire[i])
+      g_sprPlayerFire[i] = g_sprPlayerBig[i];
+    if (!g_sprLifeIcon[i])
+      g_sprLifeIcon[i] = g_sprLifeIcon[0];
+  }
+
+  g_sprGoomba = findSprite("sprites/enemies/Goomba.png");
+  g_sprKoopa = findSprite("sprites/enemies/KoopaTroopa.png");
+  g_sprKoopaSheet = findSprite("sprites/enemies/KoopaTroopaSheet.png");
+  g_sprCheepCheep = findSprite("sprites/enemies/CheepCheep.png");
+  g_sprBulletBill = findSprite("sprites/enemies/BulletBill.png");
+  g_sprBlooper = findSprite("sprites/enemies/Blooper.png");
+  g_sprBuzzy = findSprite("sprites/enemies/BuzzyBeetle.png");
+  g_sprLakitu = findSprite("sprites/enemies/Lakitu.png");
+  g_sprLakituCloud = findSprite("sprites/enemies/LakituCloud.png");
+  g_sprSpiny = findSprite("sprites/enemies/Spiny.png");
+  g_sprHammerBro = findSprite("sprites/enemies/HammerBro.png");
+  g_sprHammer = findSprite("sprites/items/Hammer.png");
+  g_sprBowser = findSprite("sprites/enemies/Bowser.png");
+  g_sprPlatform = findSprite("sprites/tilesets/Platform.png");
+  g_sprBridgeAxe = findSprite("sprites/items/BridgeAxe.png");
+  g_sprQuestion = findSprite("sprites/blocks/QuestionBlock.png");
+  g_sprMushroom = findSprite("sprites/items/SuperMushroom.png");
+  g_sprFireFlower = findSprite("sprites/items/FireFlower.png");
+  g_sprFireball = findSprite("sprites/items/Fireball.png");
+  g_sprCoin = findSprite("sprites/items/SpinningCoin.png");
+  g_sprFlagPole = findSprite("sprites/tilesets/FlagPole.png");
+  g_sprFlag = findSprite("sprites/tilesets/Flag.png");
+  g_sprCastle = findSprite("sprites/tilesets/EndingCastleSprite.png");
+  g_sprParticleSnow = findSprite("sprites/particles/Snow.png");
+  g_sprParticleLeaves = findSprite("sprites/particles/Leaves.png");
+  g_sprParticleAutumnLeaves = findSprite("sprites/particles/AutumnLeaves.png");
+  g_sprTitle = findSprite("sprites/ui/Title2.png");
+  g_sprCursor = findSprite("sprites/ui/Cursor.png");
+  g_sprMenuBG = findSprite("sprites/ui/MenuBG.png");
+  g_sprCoinIcon = findSprite("sprites/ui/CoinIcon.png");
   loadThemeTilesets();
   loadBackgroundArt();
 
-  g_texTitle = loadTex("sprites/ui/Title2.png");
-  g_texCursor = loadTex("sprites/ui/Cursor.png");
-  g_texMenuBG = loadTex("sprites/ui/MenuBG.png");
-  g_texCoinIcon = loadTex("sprites/ui/CoinIcon.png");
-
-  const char *sfxPaths[] = {"content/audio/sfx/%s", "../content/audio/sfx/%s",
-                            "fs:/vol/content/audio/sfx/%s"};
-  for (int i = 0; i < 3 && !g_sfxJump; i++) {
-    char p[512];
-    snprintf(p, sizeof(p), sfxPaths[i], "SmallJump.wav");
-    g_sfxJump = Mix_LoadWAV(p);
-  }
-  for (int i = 0; i < 3 && !g_sfxBigJump; i++) {
-    char p[512];
-    snprintf(p, sizeof(p), sfxPaths[i], "BigJump.wav");
-    g_sfxBigJump = Mix_LoadWAV(p);
-  }
-  for (int i = 0; i < 3 && !g_sfxStomp; i++) {
-    char p[512];
-    snprintf(p, sizeof(p), sfxPaths[i], "Stomp.wav");
-    g_sfxStomp = Mix_LoadWAV(p);
-  }
-  for (int i = 0; i < 3 && !g_sfxCoin; i++) {
-    char p[512];
-    snprintf(p, sizeof(p), sfxPaths[i], "Coin.wav");
-    g_sfxCoin = Mix_LoadWAV(p);
-  }
-  for (int i = 0; i < 3 && !g_sfxPowerup; i++) {
-    char p[512];
-    snprintf(p, sizeof(p), sfxPaths[i], "Powerup.wav");
-    g_sfxPowerup = Mix_LoadWAV(p);
-  }
-  for (int i = 0; i < 3 && !g_sfxBump; i++) {
-    char p[512];
-    snprintf(p, sizeof(p), sfxPaths[i], "Bump.wav");
-    g_sfxBump = Mix_LoadWAV(p);
-  }
-  for (int i = 0; i < 3 && !g_sfxBreak; i++) {
-    char p[512];
-    snprintf(p, sizeof(p), sfxPaths[i], "BreakBlock.wav");
-    g_sfxBreak = Mix_LoadWAV(p);
-  }
-  for (int i = 0; i < 3 && !g_sfxItemAppear; i++) {
-    char p[512];
-    snprintf(p, sizeof(p), sfxPaths[i], "ItemAppear.wav");
-    g_sfxItemAppear = Mix_LoadWAV(p);
-  }
-  for (int i = 0; i < 3 && !g_sfxDamage; i++) {
-    char p[512];
-    snprintf(p, sizeof(p), sfxPaths[i], "Damage.wav");
-    g_sfxDamage = Mix_LoadWAV(p);
-  }
-  for (int i = 0; i < 3 && !g_sfxSkid; i++) {
-    char p[512];
-    snprintf(p, sizeof(p), sfxPaths[i], "Skid.wav");
-    g_sfxSkid = Mix_LoadWAV(p);
-  }
-  for (int i = 0; i < 3 && !g_sfxMenuMove; i++) {
-    char p[512];
-    snprintf(p, sizeof(p), sfxPaths[i], "MenuNavigate.wav");
-    g_sfxMenuMove = Mix_LoadWAV(p);
-  }
-
-  for (int i = 0; i < 3 && !g_sfxFlagSlide; i++) {
-    char p[512];
-    snprintf(p, sizeof(p), sfxPaths[i], "FlagSlide.wav");
-    g_sfxFlagSlide = Mix_LoadWAV(p);
-  }
-  for (int i = 0; i < 3 && !g_sfxCastleClear; i++) {
-    char p[512];
-    snprintf(p, sizeof(p), sfxPaths[i], "CastleClear.wav");
-    g_sfxCastleClear = Mix_LoadWAV(p);
-  }
-  for (int i = 0; i < 3 && !g_sfxPipe; i++) {
-    char p[512];
-    snprintf(p, sizeof(p), sfxPaths[i], "Pipe.wav");
-    g_sfxPipe = Mix_LoadWAV(p);
-  }
-  for (int i = 0; i < 3 && !g_sfxKick; i++) {
-    char p[512];
-    snprintf(p, sizeof(p), sfxPaths[i], "Kick.wav");
-    g_sfxKick = Mix_LoadWAV(p);
-  }
-  for (int i = 0; i < 3 && !g_sfxFireball; i++) {
-    char p[512];
-    snprintf(p, sizeof(p), sfxPaths[i], "Fireball.wav");
-    g_sfxFireball = Mix_LoadWAV(p);
-  }
-
-  const char *bgmPathsOver[] = {"content/audio/bgm/Overworld.mp3",
-                                "../content/audio/bgm/Overworld.mp3",
-                                "fs:/vol/content/audio/bgm/Overworld.mp3"};
-  const char *bgmPathsUnd[] = {"content/audio/bgm/Underground.mp3",
-                               "../content/audio/bgm/Underground.mp3",
-                               "fs:/vol/content/audio/bgm/Underground.mp3"};
-  const char *bgmPathsCast[] = {"content/audio/bgm/Castle.mp3",
-                                "../content/audio/bgm/Castle.mp3",
-                                "fs:/vol/content/audio/bgm/Castle.mp3"};
-  for (int i = 0; i < 3 && !g_bgmOverworld; i++)
-    g_bgmOverworld = Mix_LoadMUS(bgmPathsOver[i]);
-  for (int i = 0; i < 3 && !g_bgmUnderground; i++)
-    g_bgmUnderground = Mix_LoadMUS(bgmPathsUnd[i]);
-  for (int i = 0; i < 3 && !g_bgmCastle; i++)
-    g_bgmCastle = Mix_LoadMUS(bgmPathsCast[i]);
-
-  g_bgmByTheme[THEME_OVERWORLD] = g_bgmOverworld;
-  g_bgmByTheme[THEME_UNDERGROUND] = g_bgmUnderground;
-  g_bgmByTheme[THEME_CASTLE] = g_bgmCastle;
-
-  setSfxVolume(g_sfxJump);
-  setSfxVolume(g_sfxBigJump);
-  setSfxVolume(g_sfxStomp);
-  setSfxVolume(g_sfxCoin);
-  setSfxVolume(g_sfxPowerup);
-  setSfxVolume(g_sfxBump);
-  setSfxVolume(g_sfxBreak);
-  setSfxVolume(g_sfxItemAppear);
-  setSfxVolume(g_sfxDamage);
-  setSfxVolume(g_sfxSkid);
-  setSfxVolume(g_sfxMenuMove);
-  setSfxVolume(g_sfxFlagSlide);
-  setSfxVolume(g_sfxCastleClear);
-  setSfxVolume(g_sfxPipe);
-  setSfxVolume(g_sfxKick);
-  setSfxVolume(g_sfxFireball);
-
-  // Keep plenty of channels available so short SFX (like brick breaks) don't
-  // get dropped during busy scenes.
+  loadSfxBank();
+
+  requestMusic(musicTrack(THEME_OVERWORLD, false));
+  requestMusic(musicTrack(THEME_UNDERGROUND, false));
+  requestMusic(musicTrack(THEME_CASTLE, false));
 }
 
-void spawnEnemiesFromLevel() {
-  for (int i = 0; i < 64; i++)
-    g_ents[i].on = false;
-  int idx = 0;
-  for (int i = 0; i < g_levelInfo.enemyCount && idx < 64; i++) {
-    const EnemySpawn &s = g_levelInfo.enemies[i];
-    Entity &e = g_ents[idx];
-    e.on = true;
-    e.type = s.type;
-    e.vx = 0.0f;
-    e.vy = 0.0f;
-    e.dir = s.dir;
+static void initEntityFromSpawn(Entity &e, const EnemySpawn &s) {
+  e.on = true;
+  e.type = s.type;
+  e.vx = 0.0f;
+  e.vy = 0.0f;
+  e.dir = s.dir;
+  e.state = 0;
+  e.timer = 0.0f;
+  e.a = s.a;
+  e.b = s.b;
+  e.baseX = s.x;
+  e.baseY = s.y;
+  e.prevX = s.x;
+  e.prevY = s.y;
+  e.link = ENTITY_NONE;
+
+  switch (s.type) {
+  case E_GOOMBA:
+  case E_KOOPA:
+  case E_KOOPA_RED: {
+    float h = 16.0f;
+    float y = s.y - (h - 16.0f);
+    e.r = {s.x, y, 16.0f, h};
+    e.vx = -Physics::ENEMY_SPEED;
+    if (e.dir == 0)
+      e.dir = -1;
+    break;
+  }
+  case E_BUZZY_BEETLE: {
+    e.r = {s.x, s.y, 16.0f, 16.0f};
+    e.vx = -Physics::ENEMY_SPEED;
+    if (e.dir == 0)
+      e.dir = -1;
+    break;
+  }
+  case E_BLOOPER: {
+    // Blooper frames are 16x24; keep the hitbox aligned to that size.
+    e.r = {s.x, s.y, 16.0f, 24.0f};
+    if (e.dir == 0)
+      e.dir = -1;
+    break;
+  }
+  case E_LAKITU: {
+    // Lakitu floats; treat y as its top.
+    e.r = {s.x, s.y, 16.0f, 24.0f};
+    e.baseY = s.y;
+    if (e.dir == 0)
+      e.dir = -1;
+    break;
+  }
+  case E_HAMMER_BRO: {
+    // Hammer Bros are 16x24 sprites standing on blocks.
+    e.r = {s.x, s.y - 8.0f, 16.0f, 24.0f};
+    if (e.dir == 0)
+      e.dir = -1;
+    break;
+  }
+  case E_CHEEP_SWIM:
+  case E_CHEEP_LEAP:
+  case E_BULLET_BILL: {
+    e.r = {s.x, s.y, 16.0f, 16.0f};
+    if (e.type == E_BULLET_BILL && e.dir == 0)
+      e.dir = -1;
+    break;
+  }
+  case E_SPINY: {
+    e.r = {s.x, s.y, 16.0f, 16.0f};
+    if (e.dir == 0)
+      e.dir = -1;
+    break;
+  }
+  case E_BULLET_CANNON: {
+    // Cannon is a logic-only emitter; the visible cannon is part of the
+    // terrain tileset in the upstream levels.
+    e.r = {s.x, s.y, 0.0f, 0.0f};
     e.state = 0;
     e.timer = 0.0f;
-    e.a = s.a;
-    e.b = s.b;
+    break;
+  }
+  case E_PLATFORM_SIDEWAYS: {
+    float w = (float)((s.a > 0) ? s.a : 48);
+    e.r = {s.x, s.y, w, 8.0f};
     e.baseX = s.x;
     e.baseY = s.y;
-    e.prevX = s.x;
-    e.prevY = s.y;
-
-    switch (s.type) {
-    case E_GOOMBA:
-    case E_KOOPA:
-    case E_KOOPA_RED: {
-      float h = 16.0f;
-      float y = s.y - (h - 16.0f);
-      e.r = {s.x, y, 16.0f, h};
-      e.vx = -Physics::ENEMY_SPEED;
-      if (e.dir == 0)
-        e.dir = -1;
-      break;
-    }
-    case E_BUZZY_BEETLE: {
-      e.r = {s.x, s.y, 16.0f, 16.0f};
-      e.vx = -Physics::ENEMY_SPEED;
-      if (e.dir == 0)
-        e.dir = -1;
-      break;
-    }
-    case E_BLOOPER: {
-      // Blooper frames are 16x24; keep the hitbox aligned to that size.
-      e.r = {s.x, s.y, 16.0f, 24.0f};
-      if (e.dir == 0)
-        e.dir = -1;
-      break;
-    }
-    case E_LAKITU: {
-      // Lakitu floats; treat y as its top.
-      e.r = {s.x, s.y, 16.0f, 24.0f};
-      e.baseY = s.y;
-      if (e.dir == 0)
-        e.dir = -1;
-      break;
-    }
-    case E_HAMMER_BRO: {
-      // Hammer Bros are 16x24 sprites standing on blocks.
-      e.r = {s.x, s.y - 8.0f, 16.0f, 24.0f};
-      if (e.dir == 0)
-        e.dir = -1;
-      break;
-    }
-    case E_CHEEP_SWIM:
-    case E_CHEEP_LEAP:
-    case E_BULLET_BILL: {
-      e.r = {s.x, s.y, 16.0f, 16.0f};
-      if (e.type == E_BULLET_BILL && e.dir == 0)
-        e.dir = -1;
-      break;
+    break;
+  }
+  case E_PLATFORM_VERTICAL: {
+    // Two modes:
+    // - `dir == 0`: pingpong platform (width stored in `a`)
+    // - `dir != 0`: elevator wrap platform (top/bottom in `a/b`)
+    if (s.dir == 0) {
+      float w = (float)((s.a > 0) ? s.a : 48);
+      e.r = {s.x, s.y, w, 8.0f};
+    } else {
+      e.r = {s.x, s.y, 48.0f, 8.0f};
     }
-    case E_SPINY: {
-      e.r = {s.x, s.y, 16.0f, 16.0f};
-      if (e.dir == 0)
-        e.dir = -1;
-      break;
-    }
-    case E_BULLET_CANNON: {
-      // Cannon is a logic-only emitter; the visible cannon is part of the
-      // terrain tileset in the upstream levels.
-      e.r = {s.x, s.y, 0.0f, 0.0f};
-      e.state = 0;
-      e.timer = 0.0f;
-      break;
-    }
-    case E_PLATFORM_SIDEWAYS: {
-      float w = (float)((s.a > 0) ? s.a : 48);
-      e.r = {s.x, s.y, w, 8.0f};
-      e.baseX = s.x;
-      e.baseY = s.y;
-      break;
+    e.baseX = s.x;
+    e.baseY = s.y;
+    break;
+  }
+  case E_PLATFORM_ROPE: {
+    float w = (float)((s.a > 0) ? s.a : 48);
+    e.r = {s.x, s.y, w, 8.0f};
+    e.baseX = s.x;
+    e.baseY = s.y;
+    break;
+  }
+  case E_PLATFORM_FALLING: {
+    float w = (float)((s.a > 0) ? s.a : 48);
+    e.r = {s.x, s.y, w, 8.0f};
+    e.baseX = s.x;
+    e.baseY = s.y;
+    e.state = 0; // waiting
+    break;
+  }
+  case E_ENTITY_GENERATOR:
+  case E_ENTITY_GENERATOR_STOP: {
+    e.r = {s.x, s.y, 0.0f, 0.0f};
+    e.state = 0; // inactive
+    // Track the player's last X so activation matches Godot's
+    // PlayerDetection (crossing the trigger once, not "player is >= x").
+    e.prevX = g_p.r.x + g_p.r.w * 0.5f;
+    e.timer = 0.0f;
+    break;
+  }
+  case E_CASTLE_AXE: {
+    e.r = {s.x, s.y, 16.0f, 16.0f};
+    break;
+  }
+  case E_BOWSER: {
+    // Spawn centered-ish; Bowser is large visually, but keep a smaller
+    // gameplay rect for now.
+    e.r = {s.x - 24.0f, s.y - 48.0f, 48.0f, 48.0f};
+    if (e.dir == 0)
+      e.dir = -1;
+    break;
+  }
+  default: {
+    e.r = {s.x, s.y, 16.0f, 16.0f};
+    break;
+  }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Enemy spawner
+//------------------------------------------------------------------------------
+// Platforms, generators, cannons and the axe are resident: they spawn with the
+// section. Everything else is streamed in the way SMB1 does it. The section's
+// spawns are sorted by X into g_spawnRecords, and two cursors keep
+// [g_spawnLo, g_spawnHi) on the records whose X lies within SPAWN_MARGIN of
+// the screen. A pending record in that window is spawned; a streamed entity
+// that falls more than SPAWN_RETIRE_MARGIN off either side is retired.
+// Live enemy counts therefore follow what is near the screen, not how long the
+// section is. A record whose pool is full stays pending and is retried.
+//
+// A record is killed for good once its entity is defeated. An entity that
+// leaves the screen alive is only despawned: its record re-arms once the spawn
+// point has left the window, so it spawns again if backtracking brings the
+// point back into view. It does not reappear in place while the point is still
+// on screen.
+enum SpawnState : uint8_t {
+  SPAWN_PENDING,
+  SPAWN_ACTIVE,
+  SPAWN_DESPAWNED,
+  SPAWN_KILLED,
+};
+
+struct SpawnRecord {
+  float x;
+  uint16_t spawn; // index into g_levelInfo.enemies
+  SpawnState state;
+};
+
+constexpr float SPAWN_MARGIN = 32.0f;
+constexpr float SPAWN_RETIRE_MARGIN = 48.0f; // > SPAWN_MARGIN, no thrashing
+
+static std::vector<SpawnRecord> g_spawnRecords;
+static int g_spawnLo = 0;
+static int g_spawnHi = 0;
+
+static bool spawnIsResident(EType type) {
+  EntityPoolId pool = entityPoolFor(type);
+  return pool == POOL_PLATFORMS || pool == POOL_GENERATORS;
+}
+
+// Walkers that are squished or in their shell count as killed even if they
+// then leave the screen.
+static bool enemyDefeated(const Entity &e) {
+  switch (e.type) {
+  case E_GOOMBA:
+  case E_KOOPA:
+  case E_KOOPA_RED:
+  case E_BUZZY_BEETLE:
+    return e.state != 0;
+  default:
+    return false;
+  }
+}
+
+static bool entityOffScreen(const Entity &e, float margin) {
+  return e.r.x + e.r.w < g_camX - margin || e.r.x > g_camX + GAME_W + margin;
+}
+
+// Leaving the window re-arms a despawned record.
+static void rearmSpawn(SpawnRecord &rec) {
+  if (rec.state == SPAWN_DESPAWNED)
+    rec.state = SPAWN_PENDING;
+}
+
+// Despawn hook for streamed entities: gone off the side alive (retired by
+// retireStreamedEnemies or by its own culling) versus stomped, shot, or fallen
+// into a pit.
+static void spawnRecordEntityGone(int rec, const Entity &e) {
+  bool alive =
+      entityOffScreen(e, 0.0f) && e.r.y <= GAME_H && !enemyDefeated(e);
+  g_spawnRecords[rec].state = alive ? SPAWN_DESPAWNED : SPAWN_KILLED;
+}
+
+// Retires streamed entities that drifted off screen; compaction then settles
+// their records.
+static void retireStreamedEnemies() {
+  for (const EntityPool &pool : g_entityPools) {
+    for (int k = 0; k < pool.count; k++) {
+      uint16_t slot = g_entityActive[pool.first + k];
+      Entity &e = g_ents[slot];
+      if (g_entitySpawn[slot] >= 0 && e.on &&
+          entityOffScreen(e, SPAWN_RETIRE_MARGIN))
+        e.on = false;
     }
-    case E_PLATFORM_VERTICAL: {
-      // Two modes:
-      // - `dir == 0`: pingpong platform (width stored in `a`)
-      // - `dir != 0`: elevator wrap platform (top/bottom in `a/b`)
-      if (s.dir == 0) {
-        float w = (float)((s.a > 0) ? s.a : 48);
-        e.r = {s.x, s.y, w, 8.0f};
-      } else {
-        e.r = {s.x, s.y, 48.0f, 8.0f};
+  }
+}
+
+static void activateEnemySpawns() {
+  const int n = (int)g_spawnRecords.size();
+  const float left = g_camX - SPAWN_MARGIN;
+  const float right = g_camX + GAME_W + SPAWN_MARGIN;
+  while (g_spawnHi < n && g_spawnRecords[g_spawnHi].x <= right)
+    g_spawnHi++;
+  while (g_spawnHi > 0 && g_spawnRecords[g_spawnHi - 1].x > right)
+    rearmSpawn(g_spawnRecords[--g_spawnHi]);
+  while (g_spawnLo < n && g_spawnRecords[g_spawnLo].x < left)
+    rearmSpawn(g_spawnRecords[g_spawnLo++]);
+  while (g_spawnLo > 0 && g_spawnRecords[g_spawnLo - 1].x >= left)
+    g_spawnLo--;
+
+  for (int i = g_spawnLo; i < g_spawnHi; i++) {
+    SpawnRecord &rec = g_spawnRecords[i];
+    if (rec.state != SPAWN_PENDING)
+      continue;
+    const EnemySpawn &s = g_levelInfo.enemies[rec.spawn];
+    int slot = allocEntitySlot(s.type);
+    if (slot < 0)
+      continue;
+    initEntityFromSpawn(g_ents[slot], s);
+    g_entitySpawn[slot] = (int16_t)i;
+    rec.state = SPAWN_ACTIVE;
+  }
+}
+
+// Rope platforms share a pair id in `dir`; pair each with the next one listed.
+static void linkRopePlatforms() {
+  const EntityPool &platforms = g_entityPools[POOL_PLATFORMS];
+  for (int i = 0; i < platforms.count; i++) {
+    Entity &a = poolEntity(platforms, i);
+    if (a.type != E_PLATFORM_ROPE || a.link != ENTITY_NONE)
+      continue;
+    for (int j = i + 1; j < platforms.count; j++) {
+      Entity &b = poolEntity(platforms, j);
+      if (b.type == E_PLATFORM_ROPE && b.link == ENTITY_NONE && b.dir == a.dir) {
+        a.link = entityHandle(g_entityActive[platforms.first + j]);
+        b.link = entityHandle(g_entityActive[platforms.first + i]);
+        break;
       }
-      e.baseX = s.x;
-      e.baseY = s.y;
-      break;
     }
-    case E_PLATFORM_ROPE: {
-      float w = (float)((s.a > 0) ? s.a : 48);
-      e.r = {s.x, s.y, w, 8.0f};
-      e.baseX = s.x;
-      e.baseY = s.y;
-      break;
+  }
+}
+
+void spawnEnemiesFromLevel() {
+  clearEntityPools();
+  g_spawnRecords.clear();
+  g_spawnLo = 0;
+  g_spawnHi = 0;
+  for (int i = 0; i < g_levelInfo.enemyCount; i++) {
+    const EnemySpawn &s = g_levelInfo.enemies[i];
+    if (!spawnIsResident(s.type)) {
+      g_spawnRecords.push_back({s.x, (uint16_t)i, SPAWN_PENDING});
+      continue;
     }
-    case E_PLATFORM_FALLING: {
-      float w = (float)((s.a > 0) ? s.a : 48);
-      e.r = {s.x, s.y, w, 8.0f};
-      e.baseX = s.x;
-      e.baseY = s.y;
-      e.state = 0; // waiting
-      break;
+    int slot = allocEntitySlot(s.type);
+    if (slot >= 0)
+      initEntityFromSpawn(g_ents[slot], s);
+  }
+  linkRopePlatforms();
+  std::stable_sort(
+      g_spawnRecords.begin(), g_spawnRecords.end(),
+      [](const SpawnRecord &a, const SpawnRecord &b) { return a.x < b.x; });
+  // Streamed spawns appear on the first step, once the camera has caught up
+  // with the players.
+}
+
+//------------------------------------------------------------------------------
+// Foreground deco generation
+//------------------------------------------------------------------------------
+// Decos are sampled from the section's own placed deco components. Everything
+// the generator needs lives in one static scratch block reused by every
+// section, so entering a section does no heap allocation: the BFS queue holds
+// at most one entry per map cell, patterns are deduplicated by a 64-bit hash
+// in an open-addressing table, and pipe clearance is read from Chebyshev
+// distance grids instead of rescanning the neighbourhood per candidate.
+struct DecoPattern {
+  uint8_t w;
+  uint8_t h;
+  uint8_t cellCount;
+  ForegroundDeco::Cell cells[16];
+};
+
+constexpr int DECO_MAX_PATTERNS = 128;
+constexpr int DECO_PATTERN_SLOTS = 256; // power of two, > 2x patterns
+constexpr int kPipeMargin = 3;          // tiles kept clear around pipes
+
+struct DecoScratch {
+  uint8_t visited[MAP_H][MAP_W];
+  uint16_t queue[MAP_H * MAP_W]; // ty * MAP_W + tx
+  // Chebyshev distance in tiles (saturating) to the nearest T_PIPE tile and to
+  // the nearest warp-pipe mouth cell.
+  uint8_t pipeDist[MAP_H][MAP_W];
+  uint8_t mouthDist[MAP_H][MAP_W];
+  DecoPattern patterns[DECO_MAX_PATTERNS];
+  int patternCount;
+  uint64_t patternHash[DECO_PATTERN_SLOTS];
+  uint8_t patternSlots[DECO_PATTERN_SLOTS]; // pattern index + 1; 0 = empty
+};
+static DecoScratch g_decoScratch;
+
+// Two-pass distance transform over the 8-neighbourhood; with unit steps that
+// is the exact Chebyshev distance. Sources must already be 0, the rest 255.
+static void chebyshevTransform(uint8_t (*d)[MAP_W], int w) {
+  auto relax = [&](int x, int y, int nx, int ny) {
+    if (nx < 0 || nx >= w || ny < 0 || ny >= MAP_H)
+      return;
+    uint8_t v = d[ny][nx];
+    if (v < 255 && v + 1 < d[y][x])
+      d[y][x] = (uint8_t)(v + 1);
+  };
+  for (int y = 0; y < MAP_H; y++) {
+    for (int x = 0; x < w; x++) {
+      relax(x, y, x - 1, y);
+      relax(x, y, x - 1, y - 1);
+      relax(x, y, x, y - 1);
+      relax(x, y, x + 1, y - 1);
     }
-    case E_ENTITY_GENERATOR:
-    case E_ENTITY_GENERATOR_STOP: {
-      e.r = {s.x, s.y, 0.0f, 0.0f};
-      e.state = 0; // inactive
-      // Track the player's last X so activation matches Godot's
-      // PlayerDetection (crossing the trigger once, not "player is >= x").
-      e.prevX = g_p.r.x + g_p.r.w * 0.5f;
-      e.timer = 0.0f;
-      break;
+  }
+  for (int y = MAP_H - 1; y >= 0; y--) {
+    for (int x = w - 1; x >= 0; x--) {
+      relax(x, y, x + 1, y);
+      relax(x, y, x + 1, y + 1);
+      relax(x, y, x, y + 1);
+      relax(x, y, x - 1, y + 1);
     }
-    case E_CASTLE_AXE: {
-      e.r = {s.x, s.y, 16.0f, 16.0f};
-      break;
+  }
+}
+
+static void bakeDecoPipeDistance(DecoScratch &sc) {
+  int w = mapWidth();
+  memset(sc.pipeDist, 255, sizeof(sc.pipeDist));
+  memset(sc.mouthDist, 255, sizeof(sc.mouthDist));
+  for (int x = 0; x < w; x++) {
+    uint16_t rows = g_bake.pipeRows[x];
+    for (int y = 0; y < MAP_H; y++) {
+      if (rows & (1u << y))
+        sc.pipeDist[y][x] = 0;
     }
-    case E_BOWSER: {
-      // Spawn centered-ish; Bowser is large visually, but keep a smaller
-      // gameplay rect for now.
-      e.r = {s.x - 24.0f, s.y - 48.0f, 48.0f, 48.0f};
-      if (e.dir == 0)
-        e.dir = -1;
-      break;
+  }
+  // Mouths are 2x2 tiles at the PipeLink position.
+  for (int i = 0; g_levelInfo.pipes && i < g_levelInfo.pipeCount; i++) {
+    const PipeLink &p = g_levelInfo.pipes[i];
+    for (int y = p.y; y < p.y + 2; y++) {
+      for (int x = p.x; x < p.x + 2; x++) {
+        if (x >= 0 && x < w && y >= 0 && y < MAP_H)
+          sc.mouthDist[y][x] = 0;
+      }
     }
-    default: {
-      e.r = {s.x, s.y, 16.0f, 16.0f};
+  }
+  chebyshevTransform(sc.pipeDist, w);
+  chebyshevTransform(sc.mouthDist, w);
+}
+
+static uint64_t hashDecoPattern(const DecoPattern &p) {
+  // FNV-1a over the size and cells, in BFS order.
+  uint64_t h = 1469598103934665603ull;
+  auto mix = [&](uint8_t b) {
+    h ^= b;
+    h *= 1099511628211ull;
+  };
+  mix(p.w);
+  mix(p.h);
+  mix(p.cellCount);
+  for (int i = 0; i < p.cellCount; i++) {
+    const ForegroundDeco::Cell &c = p.cells[i];
+    mix((uint8_t)c.dx);
+    mix((uint8_t)c.dy);
+    mix(c.ax);
+    mix(c.ay);
+  }
+  return h;
+}
+
+static bool sameDecoPattern(const DecoPattern &a, const DecoPattern &b) {
+  return a.w == b.w && a.h == b.h && a.cellCount == b.cellCount &&
+         memcmp(a.cells, b.cells, sizeof(a.cells[0]) * a.cellCount) == 0;
+}
+
+// Adds `pat` unless an identical one is already interned. Patterns beyond
+// DECO_MAX_PATTERNS are dropped; a section never has nearly that many.
+static void internDecoPattern(DecoScratch &sc, const DecoPattern &pat) {
+  uint64_t h = hashDecoPattern(pat);
+  unsigned slot = (unsigned)h & (DECO_PATTERN_SLOTS - 1);
+  for (;;) {
+    uint8_t idx = sc.patternSlots[slot];
+    if (idx == 0)
       break;
-    }
-    }
-    idx++;
+    if (sc.patternHash[slot] == h && sameDecoPattern(sc.patterns[idx - 1], pat))
+      return;
+    slot = (slot + 1) & (DECO_PATTERN_SLOTS - 1);
   }
+  if (sc.patternCount >= DECO_MAX_PATTERNS)
+    return;
+  sc.patterns[sc.patternCount++] = pat;
+  sc.patternHash[slot] = h;
+  sc.patternSlots[slot] = (uint8_t)sc.patternCount;
 }
 
 static void generateForegroundDecos() {
@@ -1881,40 +4068,29 @@ static void generateForegroundDecos() {
 
   int w = mapWidth();
 
-  // Avoid overlapping pipes and other key objects. PipeLink metadata only
-  // exists for warp pipes, but we want to avoid *any* pipe tiles.
-	  auto decoNearPipe = [&](int tx, int ty, int wTiles, int hTiles) -> bool {
-    constexpr int kMarginX = 3;
-    constexpr int kMarginY = 3;
-    int left = tx - kMarginX;
-    int right = tx + wTiles - 1 + kMarginX;
-    int top = (ty - (hTiles - 1)) - kMarginY;
-    int bottom = (ty + 1) + kMarginY; // include support row
-	    for (int y = top; y <= bottom; y++) {
-	      if (y < 0 || y >= MAP_H)
-	        continue;
-	      for (int x = left; x <= right; x++) {
-	        if (x < 0 || x >= w)
-	          continue;
-	        if (g_map[y][x] == T_PIPE)
-	          return true;
-	      }
-	    }
-	    // Also avoid known pipe mouths from metadata (covers atlas-rendered pipes).
-	    if (g_levelInfo.pipes && g_levelInfo.pipeCount > 0) {
-	      SDL_Rect decoRect = {tx * TILE, (ty - (hTiles - 1)) * TILE, wTiles * TILE,
-	                           hTiles * TILE};
-	      for (int i = 0; i < g_levelInfo.pipeCount; i++) {
-	        const PipeLink &p = g_levelInfo.pipes[i];
-	        SDL_Rect mouth = {p.x * TILE, p.y * TILE, 2 * TILE, 2 * TILE};
-	        SDL_Rect expanded = {mouth.x - 3 * TILE, mouth.y - 3 * TILE,
-	                             mouth.w + 6 * TILE, mouth.h + 6 * TILE};
-	        if (SDL_HasIntersection(&decoRect, &expanded))
-	          return true;
-	      }
-	    }
-	    return false;
-	  };
+  DecoScratch &sc = g_decoScratch;
+  bakeDecoPipeDistance(sc);
+
+  // Avoid overlapping pipes and other key objects: no pipe tile within
+  // kPipeMargin of the footprint or its support row, and no warp-pipe mouth
+  // (PipeLink metadata, which covers atlas-rendered pipes) within kPipeMargin
+  // of the footprint.
+  auto decoNearPipe = [&](int tx, int ty, int wTiles, int hTiles) -> bool {
+    int top = ty - (hTiles - 1);
+    for (int y = top; y <= ty + 1; y++) {
+      if (y < 0 || y >= MAP_H)
+        continue;
+      for (int x = tx; x < tx + wTiles; x++) {
+        if (x < 0 || x >= w)
+          continue;
+        if (sc.pipeDist[y][x] <= kPipeMargin)
+          return true;
+        if (y <= ty && sc.mouthDist[y][x] <= kPipeMargin)
+          return true;
+      }
+    }
+    return false;
+  };
 
   // Local RNG: stable per-load and doesn't affect gameplay RNG.
   uint32_t rng = (uint32_t)SDL_GetTicks();
@@ -1961,135 +4137,83 @@ static void generateForegroundDecos() {
     return col == COL_SOLID || col == COL_ONEWAY;
   };
 
-	  struct Pattern {
-	    uint8_t w;
-	    uint8_t h;
-	    uint8_t cellCount;
-	    ForegroundDeco::Cell cells[16];
-	  };
-
-	  // Extract patterns from the level's *placed* deco tiles. In the remastered
-	  // project, a single "deco object" is made of multiple connected tiles, but
-	  // the atlas itself is densely packed and can't be segmented reliably.
-	  std::vector<Pattern> patterns;
-	  {
-	    if (!g_levelInfo.atlasT || !g_levelInfo.atlasX || !g_levelInfo.atlasY)
-	      return;
-	    int mw = mapWidth();
-	    std::vector<uint8_t> vis(mw * MAP_H, 0);
-	    auto vidx = [&](int tx, int ty) { return ty * mw + tx; };
-	    auto isDeco = [&](int tx, int ty) -> bool {
-	      if (tx < 0 || tx >= mw || ty < 0 || ty >= MAP_H)
-	        return false;
-	      uint8_t ax = g_levelInfo.atlasX[ty][tx];
-	      uint8_t ay = g_levelInfo.atlasY[ty][tx];
-	      if (ax == 255 || ay == 255)
-	        return false;
-	      return g_levelInfo.atlasT[ty][tx] == ATLAS_DECO;
-	    };
-	    auto keyFor = [&](Pattern &p) -> std::string {
-	      // Sort cells for stable key
-	      for (int i = 0; i < p.cellCount; i++) {
-	        for (int j = i + 1; j < p.cellCount; j++) {
-	          const auto &a = p.cells[i];
-	          const auto &b = p.cells[j];
-	          if (a.dy != b.dy)
-	            continue;
-	          if (a.dx != b.dx)
-	            continue;
-	        }
-	      }
-	      // Simple string key
-	      std::string k;
-	      k.reserve(64);
-	      k += std::to_string(p.w) + "x" + std::to_string(p.h) + ":";
-	      for (int i = 0; i < p.cellCount; i++) {
-	        const auto &c = p.cells[i];
-	        k += std::to_string((int)c.dx) + "," + std::to_string((int)c.dy) +
-	             "," + std::to_string((int)c.ax) + "," +
-	             std::to_string((int)c.ay) + ";";
-	      }
-	      return k;
-	    };
-
-	    std::vector<std::string> keys;
-	    keys.reserve(64);
-
-	    const int dirs[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
-	    for (int ty = 0; ty < MAP_H; ty++) {
-	      for (int tx = 0; tx < mw; tx++) {
-	        if (!isDeco(tx, ty) || vis[vidx(tx, ty)])
-	          continue;
-	        std::vector<std::pair<int, int>> q;
-	        q.push_back({tx, ty});
-	        vis[vidx(tx, ty)] = 1;
-	        int minTx = tx, maxTx = tx, minTy = ty, maxTy = ty;
-	        for (size_t qi = 0; qi < q.size(); qi++) {
-	          auto [cx, cy] = q[qi];
-	          if (cx < minTx)
-	            minTx = cx;
-	          if (cx > maxTx)
-	            maxTx = cx;
-	          if (cy < minTy)
-	            minTy = cy;
-	          if (cy > maxTy)
-	            maxTy = cy;
-	          for (auto &d : dirs) {
-	            int nx = cx + d[0];
-	            int ny = cy + d[1];
-	            if (nx < 0 || nx >= mw || ny < 0 || ny >= MAP_H)
-	              continue;
-	            if (!isDeco(nx, ny) || vis[vidx(nx, ny)])
-	              continue;
-	            vis[vidx(nx, ny)] = 1;
-	            q.push_back({nx, ny});
-	          }
-	        }
+  // Extract patterns from the level's *placed* deco tiles. In the remastered
+  // project, a single "deco object" is made of multiple connected tiles, but
+  // the atlas itself is densely packed and can't be segmented reliably.
+  if (!g_levelInfo.atlasT || !g_levelInfo.atlasX || !g_levelInfo.atlasY)
+    return;
+  auto isDeco = [&](int tx, int ty) -> bool {
+    if (tx < 0 || tx >= w || ty < 0 || ty >= MAP_H)
+      return false;
+    uint8_t ax = g_levelInfo.atlasX[ty][tx];
+    uint8_t ay = g_levelInfo.atlasY[ty][tx];
+    if (ax == 255 || ay == 255)
+      return false;
+    return g_levelInfo.atlasT[ty][tx] == ATLAS_DECO;
+  };
 
-	        int pw = maxTx - minTx + 1;
-	        int ph = maxTy - minTy + 1;
-	        if (pw <= 0 || ph <= 0)
-	          continue;
-	        // Skip huge components (these are usually decorative backgrounds baked
-	        // into the tilemap, not "placeable" foreground objects).
-	        if (pw > 6 || ph > 4 || (int)q.size() > 16)
-	          continue;
+  memset(sc.visited, 0, sizeof(sc.visited));
+  memset(sc.patternSlots, 0, sizeof(sc.patternSlots));
+  sc.patternCount = 0;
+  const int dirs[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+  for (int ty = 0; ty < MAP_H; ty++) {
+    for (int tx = 0; tx < w; tx++) {
+      if (!isDeco(tx, ty) || sc.visited[ty][tx])
+        continue;
+      // Breadth-first over the component; every cell is queued at most once,
+      // so the queue never outgrows the map.
+      int qn = 0;
+      sc.queue[qn++] = (uint16_t)(ty * MAP_W + tx);
+      sc.visited[ty][tx] = 1;
+      int minTx = tx, maxTx = tx, minTy = ty, maxTy = ty;
+      for (int qi = 0; qi < qn; qi++) {
+        int cx = sc.queue[qi] % MAP_W;
+        int cy = sc.queue[qi] / MAP_W;
+        if (cx < minTx)
+          minTx = cx;
+        if (cx > maxTx)
+          maxTx = cx;
+        if (cy < minTy)
+          minTy = cy;
+        if (cy > maxTy)
+          maxTy = cy;
+        for (auto &d : dirs) {
+          int nx = cx + d[0];
+          int ny = cy + d[1];
+          if (!isDeco(nx, ny) || sc.visited[ny][nx])
+            continue;
+          sc.visited[ny][nx] = 1;
+          sc.queue[qn++] = (uint16_t)(ny * MAP_W + nx);
+        }
+      }
 
-	        Pattern pat = {};
-	        pat.w = (uint8_t)pw;
-	        pat.h = (uint8_t)ph;
-	        int bottomTy = maxTy;
-	        for (auto &cell : q) {
-	          if (pat.cellCount >=
-	              (uint8_t)(sizeof(pat.cells) / sizeof(pat.cells[0])))
-	            break;
-	          int cx = cell.first;
-	          int cy = cell.second;
-	          pat.cells[pat.cellCount++] = {
-	              (int8_t)(cx - minTx),
-	              (int8_t)(cy - bottomTy),
-	              g_levelInfo.atlasX[cy][cx],
-	              g_levelInfo.atlasY[cy][cx],
-	          };
-	        }
+      int pw = maxTx - minTx + 1;
+      int ph = maxTy - minTy + 1;
+      // Skip huge components (these are usually decorative backgrounds baked
+      // into the tilemap, not "placeable" foreground objects).
+      if (pw > 6 || ph > 4 || qn > 16)
+        continue;
 
-	        std::string k = keyFor(pat);
-	        bool dup = false;
-	        for (auto &existing : keys) {
-	          if (existing == k) {
-	            dup = true;
-	            break;
-	          }
-	        }
-	        if (!dup) {
-	          keys.push_back(std::move(k));
-	          patterns.push_back(pat);
-	        }
-	      }
-	    }
-	  }
-	  if (patterns.empty())
-	    return;
+      DecoPattern pat = {};
+      pat.w = (uint8_t)pw;
+      pat.h = (uint8_t)ph;
+      for (int qi = 0; qi < qn; qi++) {
+        int cx = sc.queue[qi] % MAP_W;
+        int cy = sc.queue[qi] / MAP_W;
+        pat.cells[pat.cellCount++] = {
+            (int8_t)(cx - minTx),
+            (int8_t)(cy - maxTy),
+            g_levelInfo.atlasX[cy][cx],
+            g_levelInfo.atlasY[cy][cx],
+        };
+      }
+      internDecoPattern(sc, pat);
+    }
+  }
+  const DecoPattern *patterns = sc.patterns;
+  const int patternCount = sc.patternCount;
+  if (patternCount == 0)
+    return;
 
   // Extra clearance so larger decos don't clip into nearby objects.
   constexpr int kPadX = 3;
@@ -2101,7 +4225,7 @@ static void generateForegroundDecos() {
 
 	  int attempts = 0;
 	  while (g_fgDecoCount < desired && attempts++ < 800) {
-	    const Pattern &pat = patterns[(int)(nextU32() % (uint32_t)patterns.size())];
+	    const DecoPattern &pat = patterns[(int)(nextU32() % (uint32_t)patternCount)];
 
     if (w <= pat.w + kPadX * 2)
       continue;
@@ -2160,6 +4284,8 @@ static void generateForegroundDecos() {
 }
 
 void applySection(bool resetTimer, int spawnX, int spawnY) {
+  g_prefetchTargetLevel = -1;
+  g_prefetchTargetSection = -1;
   LevelTheme chosen = g_levelInfo.theme;
   if (g_randomTheme) {
     static bool seeded = false;
@@ -2172,8 +4298,11 @@ void applySection(bool resetTimer, int spawnX, int spawnY) {
     chosen = (LevelTheme)g_themeOverride;
   }
   g_theme = chosen;
+  bakeCollisionGrid();
+  invalidateTileCache();
   g_flagX = g_levelInfo.flagX;
   g_hasFlag = g_levelInfo.hasFlag;
+  bakeSection();
   loadThemeTilesets();
   loadBackgroundArt();
   resetAmbientParticles();
@@ -2317,50 +4446,46 @@ static bool anyWiimoteConnected() {
   return false;
 }
 
-void input() {
-  // Default to "no input" so a dropped VPAD read doesn't leave stale buttons.
-  g_pressed = 0;
-  g_held = 0;
-
-  VPADStatus vpad;
-  VPADReadError err;
-  VPADRead(VPAD_CHAN_0, &vpad, 1, &err);
-  if (err == VPAD_READ_SUCCESS) {
-    g_pressed = vpad.trigger;
-    g_held = vpad.hold;
-    if (vpad.leftStick.x > 0.3f)
-      g_held |= VPAD_BUTTON_RIGHT;
-    else if (vpad.leftStick.x < -0.3f)
-      g_held |= VPAD_BUTTON_LEFT;
-  }
+// Controller state rebuilt from input service events. input() drains the
+// queue once per rendered frame into g_frameInput for menus and overlay
+// toggles, and keeps the events in g_inputPending so that each simulation step
+// (consumeInputUntil()) sees only the edges that happened before it ends. A tap
+// shorter than a frame still reaches exactly one step.
+struct InputSourceView {
+  bool connected = false;
+  uint32_t hold = 0;    // raw WPAD bits for remotes
+  uint32_t pressed = 0; // accumulated since the view was last consumed
+};
+
+constexpr int INPUT_PENDING_MAX = 128;
+
+static InputSourceView g_frameInput[INPUT_SOURCE_COUNT];
+static InputSourceView g_stepInput[INPUT_SOURCE_COUNT];
+static InputEvent g_inputPending[INPUT_PENDING_MAX];
+static int g_inputPendingCount = 0;
+
+static void applyInputEvent(InputSourceView *views, const InputEvent &ev) {
+  InputSourceView &v = views[ev.source];
+  v.connected = ev.connected;
+  v.hold = ev.hold;
+  v.pressed |= ev.pressed;
+}
+
+// Publishes a set of views into the button globals the game reads. Remote
+// buttons are mapped for the current context (menus vs. gameplay).
+static void publishInput(InputSourceView *views) {
+  const InputSourceView &pad = views[INPUT_GAMEPAD];
+  g_held = pad.hold;
+  g_pressed = pad.pressed;
 
   // Wii Remotes (Players 2-4). Map inputs into VPAD-like bits so existing
   // logic can be reused.
   bool menuContext = (g_state == GS_TITLE) || (g_state == GS_PAUSE);
   for (int chan = 0; chan < 4; chan++) {
-    WPADExtensionType ext = WPAD_EXT_DEV_NOT_FOUND;
-    WPADError werr = WPADProbe((WPADChan)chan, &ext);
-    bool connected = (werr != WPAD_ERROR_NO_CONTROLLER);
-    g_remoteConnected[chan] = connected;
-    if (!connected) {
-      g_remoteHoldRaw[chan] = 0;
-      g_remoteHeld[chan] = 0;
-      g_remotePressed[chan] = 0;
-      continue;
-    }
-
-    KPADStatus st;
-    KPADError kerr = KPAD_ERROR_OK;
-    uint32_t n = KPADReadEx((KPADChan)chan, &st, 1, &kerr);
-    uint32_t rawHold = g_remoteHoldRaw[chan];
-    uint32_t rawTrig = 0;
-    if (n > 0 && kerr == KPAD_ERROR_OK) {
-      rawHold = st.hold;
-      rawTrig = st.trigger;
-      g_remoteHoldRaw[chan] = rawHold;
-    }
-    g_remoteHeld[chan] = mapWiimoteButtonsToVpad(rawHold, menuContext);
-    g_remotePressed[chan] = mapWiimoteButtonsToVpad(rawTrig, menuContext);
+    const InputSourceView &r = views[INPUT_REMOTE_FIRST + chan];
+    g_remoteConnected[chan] = r.connected;
+    g_remoteHeld[chan] = mapWiimoteButtonsToVpad(r.hold, menuContext);
+    g_remotePressed[chan] = mapWiimoteButtonsToVpad(r.pressed, menuContext);
   }
 
   // Publish per-player button sets (player indices map to GamePad + assigned remotes).
@@ -2376,17 +4501,60 @@ void input() {
       g_playerPressed[i] = 0;
     }
   }
+}
+
+// Before a simulation step: applies the pending events stamped at or before
+// `until` (a performance-counter time) and publishes the result.
+static void consumeInputUntil(Uint64 until) {
+  int n = 0;
+  while (n < g_inputPendingCount && g_inputPending[n].time <= until)
+    applyInputEvent(g_stepInput, g_inputPending[n++]);
+  g_inputPendingCount -= n;
+  memmove(g_inputPending, g_inputPending + n,
+          sizeof(InputEvent) * (size_t)g_inputPendingCount);
+  publishInput(g_stepInput);
+  for (InputSourceView &v : g_stepInput)
+    v.pressed = 0;
+}
+
+void input() {
+  if (!inputServiceRunning())
+    inputServicePoll();
+  for (InputSourceView &v : g_frameInput)
+    v.pressed = 0;
+  InputEvent ev;
+  while (inputServicePop(&ev)) {
+    applyInputEvent(g_frameInput, ev);
+    if (g_inputPendingCount == INPUT_PENDING_MAX) {
+      // Steps have fallen far behind; fold the oldest event in early so its
+      // press still reaches the next step.
+      applyInputEvent(g_stepInput, g_inputPending[0]);
+      g_inputPendingCount--;
+      memmove(g_inputPending, g_inputPending + 1,
+              sizeof(InputEvent) * (size_t)g_inputPendingCount);
+    }
+    g_inputPending[g_inputPendingCount++] = ev;
+  }
+  publishInput(g_frameInput);
 
   SDL_Event e;
-  while (SDL_PollEvent(&e))
+  while (SDL_PollEvent(&e)) {
     if (e.type == SDL_QUIT)
       WHBProcStopRunning();
+    else if (e.type == SDL_RENDER_TARGETS_RESET)
+      invalidateTileCache();
+    else if (e.type == SDL_RENDER_DEVICE_RESET)
+      dropTileCacheTextures();
+  }
 
   // Quick debug toggle (GamePad right-stick click). Useful on hardware where
   // some renderers behave differently than Cemu.
   if (g_pressed & VPAD_BUTTON_STICK_R) {
     g_showDebugOverlay = !g_showDebugOverlay;
   }
+  // With the overlay up, left-stick click saves the profiler history.
+  if (g_showDebugOverlay && (g_pressed & VPAD_BUTTON_STICK_L))
+    g_profDumpResult = profDumpCsv(PROFILE_CSV_PATH) ? 1 : -1;
 }
 
 void updateTitle() {
@@ -2395,12 +4563,10 @@ void updateTitle() {
     constexpr int kCount = 3; // PLAY, SETTINGS, EXTRAS
     if (g_pressed & VPAD_BUTTON_UP) {
       g_mainMenuIndex = (g_mainMenuIndex + kCount - 1) % kCount;
-      if (g_sfxMenuMove)
-        Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+      playSfx(SFX_MENU_MOVE);
     } else if (g_pressed & VPAD_BUTTON_DOWN) {
       g_mainMenuIndex = (g_mainMenuIndex + 1) % kCount;
-      if (g_sfxMenuMove)
-        Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+      playSfx(SFX_MENU_MOVE);
     }
     if (g_pressed & VPAD_BUTTON_A) {
       if (g_mainMenuIndex == 0) {
@@ -2440,33 +4606,28 @@ void updateTitle() {
       } else {
         g_titleMode = TITLE_EXTRAS;
       }
-      if (g_sfxMenuMove)
-        Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+      playSfx(SFX_MENU_MOVE);
     }
     break;
   }
   case TITLE_CHAR_SELECT: {
     if (g_pressed & VPAD_BUTTON_LEFT) {
       g_menuIndex = (g_menuIndex + g_charCount - 1) % g_charCount;
-      if (g_sfxMenuMove)
-        Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+      playSfx(SFX_MENU_MOVE);
     } else if (g_pressed & VPAD_BUTTON_RIGHT) {
       g_menuIndex = (g_menuIndex + 1) % g_charCount;
-      if (g_sfxMenuMove)
-        Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+      playSfx(SFX_MENU_MOVE);
     }
 
     if (g_pressed & VPAD_BUTTON_Y) {
       g_titleMode = TITLE_OPTIONS;
       g_optionsIndex = 0;
-      if (g_sfxMenuMove)
-        Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+      playSfx(SFX_MENU_MOVE);
     }
 
     if (g_pressed & VPAD_BUTTON_B) {
       g_titleMode = TITLE_MAIN;
-      if (g_sfxMenuMove)
-        Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+      playSfx(SFX_MENU_MOVE);
     }
 
     if (g_pressed & VPAD_BUTTON_A) {
@@ -2493,24 +4654,20 @@ void updateTitle() {
         if (pressed & VPAD_BUTTON_LEFT) {
           g_playerMenuIndex[i] =
               (g_playerMenuIndex[i] + g_charCount - 1) % g_charCount;
-          if (g_sfxMenuMove)
-            Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+          playSfx(SFX_MENU_MOVE);
         } else if (pressed & VPAD_BUTTON_RIGHT) {
           g_playerMenuIndex[i] = (g_playerMenuIndex[i] + 1) % g_charCount;
-          if (g_sfxMenuMove)
-            Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+          playSfx(SFX_MENU_MOVE);
         }
         if (pressed & VPAD_BUTTON_A) {
           g_playerReady[i] = true;
-          if (g_sfxMenuMove)
-            Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+          playSfx(SFX_MENU_MOVE);
         }
       } else {
         // Un-ready with back.
         if (pressed & VPAD_BUTTON_B) {
           g_playerReady[i] = false;
-          if (g_sfxMenuMove)
-            Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+          playSfx(SFX_MENU_MOVE);
         }
       }
     }
@@ -2518,8 +4675,7 @@ void updateTitle() {
     // Back out to main menu (only GamePad can do this).
     if (g_playerPressed[0] & VPAD_BUTTON_B) {
       g_titleMode = TITLE_MAIN;
-      if (g_sfxMenuMove)
-        Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+      playSfx(SFX_MENU_MOVE);
     }
 
     // Start once everyone is ready; allow A or PLUS on GamePad.
@@ -2538,15 +4694,13 @@ void updateTitle() {
     break;
   }
   case TITLE_OPTIONS: {
-    constexpr int kOptCount = 4; // random theme, night mode, backtrack, cheats
+    constexpr int kOptCount = 5; // random theme, night mode, backtrack, shadows, cheats
     if (g_pressed & VPAD_BUTTON_UP) {
       g_optionsIndex = (g_optionsIndex + kOptCount - 1) % kOptCount;
-      if (g_sfxMenuMove)
-        Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+      playSfx(SFX_MENU_MOVE);
     } else if (g_pressed & VPAD_BUTTON_DOWN) {
       g_optionsIndex = (g_optionsIndex + 1) % kOptCount;
-      if (g_sfxMenuMove)
-        Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+      playSfx(SFX_MENU_MOVE);
     }
 
     if (g_pressed & VPAD_BUTTON_A) {
@@ -2561,17 +4715,19 @@ void updateTitle() {
         if (!forcedBacktrack)
           g_allowCameraBacktrack = !g_allowCameraBacktrack;
       } else if (g_optionsIndex == 3) {
+        g_spriteShadows = !g_spriteShadows;
+        // Cached tile chunks have the old shadow setting baked in.
+        invalidateTileCache();
+      } else if (g_optionsIndex == 4) {
         g_titleMode = TITLE_CHEATS;
         g_cheatsIndex = 0;
       }
-      if (g_sfxMenuMove)
-        Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+      playSfx(SFX_MENU_MOVE);
     }
 
     if (g_pressed & VPAD_BUTTON_B) {
       g_titleMode = TITLE_MAIN;
-      if (g_sfxMenuMove)
-        Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+      playSfx(SFX_MENU_MOVE);
     }
     break;
   }
@@ -2579,12 +4735,10 @@ void updateTitle() {
     constexpr int kCheatCount = 2; // moonjump, godmode
     if (g_pressed & VPAD_BUTTON_UP) {
       g_cheatsIndex = (g_cheatsIndex + kCheatCount - 1) % kCheatCount;
-      if (g_sfxMenuMove)
-        Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+      playSfx(SFX_MENU_MOVE);
     } else if (g_pressed & VPAD_BUTTON_DOWN) {
       g_cheatsIndex = (g_cheatsIndex + 1) % kCheatCount;
-      if (g_sfxMenuMove)
-        Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+      playSfx(SFX_MENU_MOVE);
     }
 
     if (g_pressed & VPAD_BUTTON_A) {
@@ -2593,22 +4747,19 @@ void updateTitle() {
       } else if (g_cheatsIndex == 1) {
         g_cheatGodMode = !g_cheatGodMode;
       }
-      if (g_sfxMenuMove)
-        Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+      playSfx(SFX_MENU_MOVE);
     }
 
     if (g_pressed & VPAD_BUTTON_B) {
       g_titleMode = TITLE_OPTIONS;
-      if (g_sfxMenuMove)
-        Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+      playSfx(SFX_MENU_MOVE);
     }
     break;
   }
   case TITLE_EXTRAS: {
     if (g_pressed & VPAD_BUTTON_B) {
       g_titleMode = TITLE_MAIN;
-      if (g_sfxMenuMove)
-        Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+      playSfx(SFX_MENU_MOVE);
     }
     break;
   }
@@ -2621,12 +4772,10 @@ void updateTitle() {
 void updatePauseMenu() {
   if (g_pressed & VPAD_BUTTON_UP) {
     g_pauseIndex = (g_pauseIndex + g_pauseOptionCount - 1) % g_pauseOptionCount;
-    if (g_sfxMenuMove)
-      Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+    playSfx(SFX_MENU_MOVE);
   } else if (g_pressed & VPAD_BUTTON_DOWN) {
     g_pauseIndex = (g_pauseIndex + 1) % g_pauseOptionCount;
-    if (g_sfxMenuMove)
-      Mix_PlayChannel(-1, g_sfxMenuMove, 0);
+    playSfx(SFX_MENU_MOVE);
   }
 
   if (g_pressed & VPAD_BUTTON_A) {
@@ -2664,7 +4813,7 @@ void updatePauseMenu() {
       g_playerRemoteChan[0] = -1;
       for (int i = 1; i < 4; i++)
         g_playerRemoteChan[i] = -1;
-      Mix_HaltMusic();
+      stopMusic();
       break;
     default:
       break;
@@ -2673,85 +4822,54 @@ void updatePauseMenu() {
 }
 
 void spawnCoinPopup(float x, float y) {
-  for (int i = 0; i < 64; i++) {
-    if (!g_ents[i].on) {
-      g_ents[i] = {true, E_COIN_POPUP, {x, y - 16, 16, 16}, 0, -200, 1, 0, 0};
-      if (g_sfxCoin)
-        Mix_PlayChannel(-1, g_sfxCoin, 0);
-      break;
-    }
+  int i = allocEntitySlot(E_COIN_POPUP);
+  if (i >= 0) {
+    g_ents[i] = {true, E_COIN_POPUP, {x, y - 16, 16, 16}, 0, -200, 1, 0, 0};
+    playSfx(SFX_COIN);
   }
 }
 
 void spawnMushroom(int tx, int ty) {
-  for (int i = 0; i < 64; i++) {
-    if (!g_ents[i].on) {
-      g_ents[i] = {
-          true, E_MUSHROOM, {(float)tx * TILE, (float)(ty - 1) * TILE, 16, 16},
-          48,   0,          1,
-          0,    0};
-      if (g_sfxItemAppear)
-        Mix_PlayChannel(-1, g_sfxItemAppear, 0);
-      break;
-    }
+  int i = allocEntitySlot(E_MUSHROOM);
+  if (i >= 0) {
+    g_ents[i] = {
+        true, E_MUSHROOM, {(float)tx * TILE, (float)(ty - 1) * TILE, 16, 16},
+        48,   0,          1,
+        0,    0};
+    playSfx(SFX_ITEM_APPEAR);
   }
 }
 
 void spawnFireFlower(int tx, int ty) {
-  for (int i = 0; i < 64; i++) {
-    if (!g_ents[i].on) {
-      g_ents[i] = {true,
-                   E_FIRE_FLOWER,
-                   {(float)tx * TILE, (float)(ty - 1) * TILE, 16, 16},
-                   0,
-                   0,
-                   0,
-                   0,
-                   0};
-      if (g_sfxItemAppear)
-        Mix_PlayChannel(-1, g_sfxItemAppear, 0);
-      break;
-    }
+  int i = allocEntitySlot(E_FIRE_FLOWER);
+  if (i >= 0) {
+    g_ents[i] = {true,
+                 E_FIRE_FLOWER,
+                 {(float)tx * TILE, (float)(ty - 1) * TILE, 16, 16},
+                 0,
+                 0,
+                 0,
+                 0,
+                 0};
+    playSfx(SFX_ITEM_APPEAR);
   }
 }
 
 void spawnFireball(Player &p) {
   if (p.fireCooldown > 0.0f)
     return;
-  for (int i = 0; i < 64; i++) {
-    if (!g_ents[i].on) {
-      float x = p.r.x + (p.right ? p.r.w - 4 : -4);
-      float y = p.r.y + (p.r.h * 0.5f);
-      g_ents[i] = {true, E_FIREBALL, {x, y, 16, 16}, 0, -90, p.right ? 1 : -1,
-                   0,    0};
-      p.fireCooldown = 0.35f;
-      p.throwT = 0.15f;
-      if (g_sfxFireball)
-        Mix_PlayChannel(-1, g_sfxFireball, 0);
-      break;
-    }
-  }
-}
-
-static int findFreeEntitySlot() {
-  for (int i = 0; i < 64; i++) {
-    if (!g_ents[i].on)
-      return i;
+  int i = allocEntitySlot(E_FIREBALL);
+  if (i >= 0) {
+    float x = p.r.x + (p.right ? p.r.w - 4 : -4);
+    float y = p.r.y + (p.r.h * 0.5f);
+    g_ents[i] = {true, E_FIREBALL, {x, y, 16, 16}, 0, -90, p.right ? 1 : -1,
+                 0,    0};
+    p.fireCooldown = 0.35f;
+    p.throwT = 0.15f;
+    playSfx(SFX_FIREBALL);
   }
-  return -1;
 }
 
-static bool isLiquidAt(int tx, int ty) {
-  if (!g_levelInfo.atlasT || !g_levelInfo.atlasX || !g_levelInfo.atlasY)
-    return false;
-  if (tx < 0 || tx >= mapWidth() || ty < 0 || ty >= MAP_H)
-    return false;
-  uint8_t ax = g_levelInfo.atlasX[ty][tx];
-  uint8_t ay = g_levelInfo.atlasY[ty][tx];
-  if (ax == 255 || ay == 255)
-    return false;
-  return g_levelInfo.atlasT[ty][tx] == ATLAS_LIQUID;
-}
 
 static bool rectTouchesLiquid(const Rect &r) {
   // Underwater themes are "fully submerged" even if the tilemap doesn't
@@ -2774,28 +4892,18 @@ static bool rectTouchesLiquid(const Rect &r) {
 
 static float liquidSurfaceYAtWorldX(float worldX) {
   int tx = (int)floorf(worldX / (float)TILE);
-  if (tx < 0)
-    tx = 0;
   if (tx >= mapWidth())
     tx = mapWidth() - 1;
-
-  // Find the topmost liquid tile in this column.
-  for (int ty = 0; ty < MAP_H; ty++) {
-    if (!isLiquidAt(tx, ty))
-      continue;
-    // Consider this the surface only if the tile above isn't liquid.
-    if (ty == 0 || !isLiquidAt(tx, ty - 1))
-      return (float)(ty * TILE);
-  }
-
-  // No liquid in this column; fall back to near-bottom.
-  return (float)((MAP_H - 2) * TILE);
+  if (tx < 0)
+    tx = 0;
+  return (float)g_bake.liquidSurfaceY[tx];
 }
 
 static void updatePlatformsAndGenerators(float dt) {
+  const EntityPool &platforms = g_entityPools[POOL_PLATFORMS];
   // Update simple moving platforms first and carry players riding them.
-  for (int i = 0; i < 64; i++) {
-    Entity &e = g_ents[i];
+  for (int i = 0; i < platforms.count; i++) {
+    Entity &e = poolEntity(platforms, i);
     if (!e.on)
       continue;
 
@@ -2900,7 +5008,7 @@ static void updatePlatformsAndGenerators(float dt) {
           pl.dead = true;
           pl.lives--;
           g_state = GS_DEAD;
-          Mix_HaltMusic();
+          stopMusic();
         } else {
           pl.vx = 0;
           pl.vy = 0;
@@ -2916,22 +5024,15 @@ static void updatePlatformsAndGenerators(float dt) {
   // - `dir`: pair id
   // - `a`: platform width
   // - `b`: rope_top (world y)
-  for (int i = 0; i < 64; i++) {
-    Entity &a = g_ents[i];
+  for (int i = 0; i < platforms.count; i++) {
+    Entity &a = poolEntity(platforms, i);
     if (!a.on || a.type != E_PLATFORM_ROPE)
       continue;
-    // Find partner.
-    int partnerIndex = -1;
-    for (int j = i + 1; j < 64; j++) {
-      if (g_ents[j].on && g_ents[j].type == E_PLATFORM_ROPE &&
-          g_ents[j].dir == a.dir) {
-        partnerIndex = j;
-        break;
-      }
-    }
-    if (partnerIndex < 0)
+    // Each pair once, from the platform in the lower slot.
+    Entity *partner = entityFromHandle(a.link);
+    if (!partner || partner < &a)
       continue;
-    Entity &b = g_ents[partnerIndex];
+    Entity &b = *partner;
 
     if (a.state != 0 || b.state != 0) {
       // Dropped: both platforms fall away.
@@ -3027,8 +5128,9 @@ static void updatePlatformsAndGenerators(float dt) {
   }
 
   // Entity generators / stoppers.
-  for (int i = 0; i < 64; i++) {
-    Entity &g = g_ents[i];
+  const EntityPool &generators = g_entityPools[POOL_GENERATORS];
+  for (int i = 0; i < generators.count; i++) {
+    Entity &g = poolEntity(generators, i);
     if (!g.on)
       continue;
     if (g.type != E_ENTITY_GENERATOR && g.type != E_ENTITY_GENERATOR_STOP)
@@ -3048,12 +5150,13 @@ static void updatePlatformsAndGenerators(float dt) {
         // Deactivate all generators, but allow those further right to be
         // activated again when the player reaches them (matches Godot's
         // `deactivate_all_generators()` behavior).
-        for (int j = 0; j < 64; j++) {
-          if (!g_ents[j].on || g_ents[j].type != E_ENTITY_GENERATOR)
+        for (int j = 0; j < generators.count; j++) {
+          Entity &other = poolEntity(generators, j);
+          if (!other.on || other.type != E_ENTITY_GENERATOR)
             continue;
-          g_ents[j].state = 0;
-          g_ents[j].timer = 0.0f;
-          g_ents[j].prevX = playerX;
+          other.state = 0;
+          other.timer = 0.0f;
+          other.prevX = playerX;
         }
       }
       continue;
@@ -3070,7 +5173,7 @@ static void updatePlatformsAndGenerators(float dt) {
     float threshold = (g.b > 0) ? ((float)g.b / 1000.0f) : 2.0f;
     if (g.timer == 0.0f) {
       // First spawn.
-      int slot = findFreeEntitySlot();
+      int slot = allocEntitySlot((EType)g.a);
       if (slot >= 0) {
         Entity &e = g_ents[slot];
         e = {};
@@ -3082,8 +5185,8 @@ static void updatePlatformsAndGenerators(float dt) {
         e.vy = 0.0f;
         e.baseX = 0.0f;
         e.baseY = 0.0f;
-        e.prevX = 0.0f;
-        e.prevY = 0.0f;
+        e.prevX = e.r.x;
+        e.prevY = e.r.y;
 
         if (e.type == E_BULLET_BILL) {
           float y = g_p.r.y + (float)((rand() % 9) - 4);
@@ -3113,7 +5216,7 @@ static void updatePlatformsAndGenerators(float dt) {
       // Stagger subsequent spawns like the upstream randf_range(-2, 0).
       g.timer = -((float)(rand() % 2000) / 1000.0f);
     } else if (g.timer >= threshold) {
-      int slot = findFreeEntitySlot();
+      int slot = allocEntitySlot((EType)g.a);
       if (slot >= 0) {
         Entity &e = g_ents[slot];
         e = {};
@@ -3149,8 +5252,7 @@ static void updatePlatformsAndGenerators(float dt) {
 }
 
 bool tryPipeEnter(const PipeLink &p) {
-  if (g_sfxPipe)
-    Mix_PlayChannel(-1, g_sfxPipe, 0);
+  playSfx(SFX_PIPE);
   g_levelIndex = p.targetLevel;
   g_sectionIndex = p.targetSection;
   if (!loadLevelSection(g_levelIndex, g_sectionIndex, g_map, g_levelInfo))
@@ -3392,16 +5494,14 @@ static void updateOnePlayer(int playerIndex, float dt) {
     pl.ground = false;
     pl.swimCooldown = 0.28f;
     pl.swimAnimT = 0.0f;
-    if (g_sfxJump)
-      Mix_PlayChannel(-1, g_sfxJump, 0);
+    playSfx(SFX_JUMP);
   } else if (g_cheatMoonJump && jumpPressed(pressed) && !pl.ground && !inWater) {
     // Moonjump cheat: allow mid-air jumps (useful for testing unimplemented
     // sections). This intentionally does not bypass pit death.
     pl.vy = -Physics::JUMP_HEIGHT;
     pl.jumping = true;
     pl.ground = false;
-    if (g_sfxJump)
-      Mix_PlayChannel(-1, g_sfxJump, 0);
+    playSfx(SFX_JUMP);
   } else if (jumpPressed(pressed) && pl.ground) {
     float jumpHeight = Physics::JUMP_HEIGHT;
     if (fabsf(pl.vx) > Physics::WALK_SPEED * 0.9f)
@@ -3409,15 +5509,7 @@ static void updateOnePlayer(int playerIndex, float dt) {
     pl.vy = -jumpHeight;
     pl.jumping = true;
     pl.ground = false;
-    if (pl.power >= P_BIG) {
-      if (g_sfxBigJump)
-        Mix_PlayChannel(-1, g_sfxBigJump, 0);
-      else if (g_sfxJump)
-        Mix_PlayChannel(-1, g_sfxJump, 0);
-    } else {
-      if (g_sfxJump)
-        Mix_PlayChannel(-1, g_sfxJump, 0);
-    }
+    playSfx(pl.power >= P_BIG ? SFX_BIG_JUMP : SFX_JUMP);
   }
   if (!jumpHeld(held) && pl.vy < (inWater ? -80.0f : -100.0f))
     pl.vy = inWater ? -80.0f : -100.0f;
@@ -3435,193 +5527,131 @@ static void updateOnePlayer(int playerIndex, float dt) {
     pl.vy = maxFall;
 
   float moveX = pl.vx * dt;
-  int stepsX = (int)ceilf(fabsf(moveX) / 6.0f);
-  if (stepsX < 1)
-    stepsX = 1;
-  float stepX = moveX / stepsX;
   float minWorldX = cameraBacktrackEnabled() ? 0.0f : g_camX;
-  for (int i = 0; i < stepsX; i++) {
-    pl.r.x += stepX;
-    if (pl.r.x < minWorldX)
-      pl.r.x = minWorldX;
-
-    int ty1 = (int)(pl.r.y / TILE);
-    int ty2 = (int)((pl.r.y + pl.r.h - 1) / TILE);
-    int tx1 = (int)(pl.r.x / TILE);
-    int tx2 = (int)((pl.r.x + pl.r.w) / TILE);
-    bool hit = false;
-    for (int ty = ty1; ty <= ty2; ty++) {
-      for (int tx = tx1; tx <= tx2; tx++) {
-        if (solidAt(tx, ty)) {
-          if (stepX > 0)
-            pl.r.x = tx * TILE - pl.r.w;
-          else if (stepX < 0)
-            pl.r.x = (tx + 1) * TILE;
-          pl.vx = 0;
-          hit = true;
-          break;
+  if (pl.r.x + moveX < minWorldX)
+    moveX = minWorldX - pl.r.x;
+  float moveY = pl.vy * dt;
+  float prevBottom = pl.r.y + pl.r.h;
+  BodyContacts contacts = moveBody(pl.r, moveX, moveY);
+  if (contacts.hits & CONTACT_WALL)
+    pl.vx = 0;
+  pl.ground = false;
+  if (contacts.hits & CONTACT_FLOOR) {
+    pl.vy = 0;
+    pl.ground = true;
+    pl.jumping = false;
+  } else if (contacts.hits & CONTACT_CEILING) {
+    int hitTy = contacts.ceilTy;
+    pl.vy = 45;
+
+    auto hitBlockAt = [&](int bx, int by) {
+      if (bx < 0 || bx >= mapWidth() || by < 0 || by >= MAP_H)
+        return;
+      if (collisionAt(bx, by) != COL_SOLID)
+        return;
+      uint8_t t = g_map[by][bx];
+      if (t == T_QUESTION) {
+        setMapTile(bx, by, T_USED);
+        uint8_t meta = questionMetaAt(bx, by);
+        if (meta == QMETA_POWERUP || meta == QMETA_STAR) {
+          if (pl.power == P_SMALL)
+            spawnMushroom(bx, by);
+          else
+            spawnFireFlower(bx, by);
+        } else if (meta == QMETA_ONEUP) {
+          pl.lives++;
+          pl.score += 1000;
+          playSfx(SFX_POWERUP);
+        } else {
+          pl.coins++;
+          pl.score += 200;
+          spawnCoinPopup(bx * TILE, by * TILE);
         }
+        playSfx(SFX_BUMP);
+        return;
       }
-      if (hit)
-        break;
+      if (t == T_BRICK && pl.power > P_SMALL) {
+        setMapTile(bx, by, T_EMPTY);
+        pl.score += 50;
+        playSfx(SFX_BREAK);
+        return;
+      }
+      if (t == T_BRICK) {
+        playSfx(SFX_BUMP);
+        addTileBump(bx, by);
+        return;
+      }
+    };
+
+    int leftTx = (int)((pl.r.x + 1) / TILE);
+    int rightTx = (int)((pl.r.x + pl.r.w - 2) / TILE);
+    float midX = pl.r.x + pl.r.w * 0.5f;
+    float seamX = (leftTx + 1) * (float)TILE;
+    bool spansTwo = rightTx > leftTx;
+    bool inSeam = spansTwo && fabsf(midX - seamX) <= 2.0f;
+    if (inSeam) {
+      hitBlockAt(leftTx, hitTy);
+      hitBlockAt(rightTx, hitTy);
+    } else if (!spansTwo) {
+      hitBlockAt(leftTx, hitTy);
+    } else {
+      int pick = (midX < seamX) ? leftTx : rightTx;
+      hitBlockAt(pick, hitTy);
     }
-    if (hit)
-      break;
   }
 
-  float moveY = pl.vy * dt;
-  int stepsY = (int)ceilf(fabsf(moveY) / 6.0f);
-  if (stepsY < 1)
-    stepsY = 1;
-  float stepY = moveY / stepsY;
-  pl.ground = false;
-  for (int i = 0; i < stepsY; i++) {
-    pl.r.y += stepY;
-    int ty1 = (int)(pl.r.y / TILE);
-    int ty2 = (stepY >= 0) ? (int)((pl.r.y + pl.r.h) / TILE)
-                           : (int)((pl.r.y + pl.r.h - 1) / TILE);
+  // Moving platforms: allow landing from above (one-way). A platform whose
+  // top the feet crossed this step wins over a tile floor further down; the
+  // highest one is the first the player reached.
+  if (moveY > 0) {
+    float newBottom = pl.r.y + pl.r.h;
+    float landTop = 0.0f;
+    bool landed = false;
+    const EntityPool &platforms = g_entityPools[POOL_PLATFORMS];
+    for (int ei = 0; ei < platforms.count; ei++) {
+      const Entity &pf = poolEntity(platforms, ei);
+      if (!pf.on)
+        continue;
+      if (pf.type != E_PLATFORM_SIDEWAYS && pf.type != E_PLATFORM_VERTICAL &&
+          pf.type != E_PLATFORM_ROPE && pf.type != E_PLATFORM_FALLING)
+        continue;
+      float platTop = pf.r.y;
+      if (prevBottom > platTop + 0.1f)
+        continue;
+      if (newBottom < platTop - 0.1f)
+        continue;
+      if (pl.r.x + pl.r.w <= pf.r.x + 0.5f)
+        continue;
+      if (pl.r.x >= pf.r.x + pf.r.w - 0.5f)
+        continue;
+      if (!landed || platTop < landTop) {
+        landTop = platTop;
+        landed = true;
+      }
+    }
+    if (landed) {
+      pl.r.y = landTop - pl.r.h;
+      pl.vy = 0;
+      pl.ground = true;
+      pl.jumping = false;
+    }
+  }
+
+  // Collect coins embedded in the tilemap.
+  {
     int tx1 = (int)(pl.r.x / TILE);
     int tx2 = (int)((pl.r.x + pl.r.w - 1) / TILE);
-    bool hit = false;
+    int ty1 = (int)(pl.r.y / TILE);
+    int ty2 = (int)((pl.r.y + pl.r.h - 1) / TILE);
     for (int ty = ty1; ty <= ty2; ty++) {
       for (int tx = tx1; tx <= tx2; tx++) {
-        uint8_t col = collisionAt(tx, ty);
-        if (col == COL_NONE)
-          continue;
-        if (pl.vy > 0) {
-          if (col == COL_ONEWAY) {
-            float prevBottom = (pl.r.y - stepY) + pl.r.h;
-            float tileTop = ty * TILE;
-            if (prevBottom > tileTop + 0.1f)
-              continue;
-          }
-          pl.r.y = ty * TILE - pl.r.h;
-          pl.vy = 0;
-          pl.ground = true;
-          pl.jumping = false;
-          hit = true;
-        } else if (pl.vy < 0) {
-          if (col != COL_SOLID)
-            continue;
-          int hitTy = ty;
-          pl.r.y = (hitTy + 1) * TILE;
-          pl.vy = 45;
-
-          auto hitBlockAt = [&](int bx, int by) {
-            if (bx < 0 || bx >= mapWidth() || by < 0 || by >= MAP_H)
-              return;
-            if (collisionAt(bx, by) != COL_SOLID)
-              return;
-            uint8_t t = g_map[by][bx];
-            if (t == T_QUESTION) {
-              g_map[by][bx] = T_USED;
-              uint8_t meta = questionMetaAt(bx, by);
-              if (meta == QMETA_POWERUP || meta == QMETA_STAR) {
-                if (pl.power == P_SMALL)
-                  spawnMushroom(bx, by);
-                else
-                  spawnFireFlower(bx, by);
-              } else if (meta == QMETA_ONEUP) {
-                pl.lives++;
-                pl.score += 1000;
-                if (g_sfxPowerup)
-                  Mix_PlayChannel(-1, g_sfxPowerup, 0);
-              } else {
-                pl.coins++;
-                pl.score += 200;
-                spawnCoinPopup(bx * TILE, by * TILE);
-              }
-              if (g_sfxBump)
-                Mix_PlayChannel(-1, g_sfxBump, 0);
-              return;
-            }
-            if (t == T_BRICK && pl.power > P_SMALL) {
-              g_map[by][bx] = T_EMPTY;
-              pl.score += 50;
-              if (g_sfxBreak)
-                Mix_PlayChannel(-1, g_sfxBreak, 0);
-              return;
-            }
-            if (t == T_BRICK) {
-              if (g_sfxBump)
-                Mix_PlayChannel(-1, g_sfxBump, 0);
-              addTileBump(bx, by);
-              return;
-            }
-          };
-
-          int leftTx = (int)((pl.r.x + 1) / TILE);
-          int rightTx = (int)((pl.r.x + pl.r.w - 2) / TILE);
-          float midX = pl.r.x + pl.r.w * 0.5f;
-          float seamX = (leftTx + 1) * (float)TILE;
-          bool spansTwo = rightTx > leftTx;
-          bool inSeam = spansTwo && fabsf(midX - seamX) <= 2.0f;
-          if (inSeam) {
-            hitBlockAt(leftTx, hitTy);
-            hitBlockAt(rightTx, hitTy);
-          } else if (!spansTwo) {
-            hitBlockAt(leftTx, hitTy);
-          } else {
-            int pick = (midX < seamX) ? leftTx : rightTx;
-            hitBlockAt(pick, hitTy);
-          }
-          hit = true;
-        }
-        if (hit)
-          break;
-      }
-      if (hit)
-        break;
-    }
-
-    // Moving platforms: allow landing from above (one-way).
-    if (!hit && stepY > 0) {
-      float prevBottom = (pl.r.y - stepY) + pl.r.h;
-      float newBottom = pl.r.y + pl.r.h;
-      for (int ei = 0; ei < 64; ei++) {
-        const Entity &pf = g_ents[ei];
-        if (!pf.on)
-          continue;
-        if (pf.type != E_PLATFORM_SIDEWAYS && pf.type != E_PLATFORM_VERTICAL &&
-            pf.type != E_PLATFORM_ROPE && pf.type != E_PLATFORM_FALLING)
-          continue;
-        float platTop = pf.r.y;
-        if (prevBottom > platTop + 0.1f)
-          continue;
-        if (newBottom < platTop - 0.1f)
-          continue;
-        if (pl.r.x + pl.r.w <= pf.r.x + 0.5f)
-          continue;
-        if (pl.r.x >= pf.r.x + pf.r.w - 0.5f)
-          continue;
-        pl.r.y = platTop - pl.r.h;
-        pl.vy = 0;
-        pl.ground = true;
-        pl.jumping = false;
-        hit = true;
-        break;
-      }
-    }
-    if (hit)
-      break;
-  }
-
-  // Collect coins embedded in the tilemap.
-  {
-    int tx1 = (int)(pl.r.x / TILE);
-    int tx2 = (int)((pl.r.x + pl.r.w - 1) / TILE);
-    int ty1 = (int)(pl.r.y / TILE);
-    int ty2 = (int)((pl.r.y + pl.r.h - 1) / TILE);
-    for (int ty = ty1; ty <= ty2; ty++) {
-      for (int tx = tx1; tx <= tx2; tx++) {
-        if (tx < 0 || tx >= mapWidth() || ty < 0 || ty >= MAP_H)
+        if (tx < 0 || tx >= mapWidth() || ty < 0 || ty >= MAP_H)
           continue;
         if (g_map[ty][tx] == T_COIN) {
-          g_map[ty][tx] = T_EMPTY;
+          setMapTile(tx, ty, T_EMPTY);
           pl.coins++;
           pl.score += 200;
-          if (g_sfxCoin)
-            Mix_PlayChannel(-1, g_sfxCoin, 0);
+          playSfx(SFX_COIN);
         }
       }
     }
@@ -3636,11 +5666,11 @@ static void updateOnePlayer(int playerIndex, float dt) {
       pl.vy = 0;
       int height = 12 - (int)(pl.r.y / TILE);
       pl.score += height * 100;
-      if (!g_flagSfxPlayed && g_sfxFlagSlide) {
-        Mix_PlayChannel(-1, g_sfxFlagSlide, 0);
+      if (!g_flagSfxPlayed && g_sfxBank[SFX_FLAG_SLIDE]) {
+        playSfx(SFX_FLAG_SLIDE);
         g_flagSfxPlayed = true;
       }
-      Mix_HaltMusic();
+      stopMusic();
     }
   }
 
@@ -3650,7 +5680,7 @@ static void updateOnePlayer(int playerIndex, float dt) {
       pl.dead = true;
       pl.lives--;
       g_state = GS_DEAD;
-      Mix_HaltMusic();
+      stopMusic();
     } else {
       pl.vx = 0;
       pl.vy = 0;
@@ -3665,8 +5695,10 @@ void updatePlayers(float dt) {
   for (auto &b : g_tileBumps) {
     if (b.t > 0.0f) {
       b.t -= dt;
-      if (b.t < 0.0f)
+      if (b.t <= 0.0f) {
         b.t = 0.0f;
+        invalidateTileChunkAt(b.tx);
+      }
     }
   }
   if (g_skidCooldown > 0)
@@ -3680,8 +5712,8 @@ void updatePlayers(float dt) {
 }
 
 void updateFlagSequence(float dt) {
-  if (!g_flagSfxPlayed && g_sfxFlagSlide) {
-    Mix_PlayChannel(-1, g_sfxFlagSlide, 0);
+  if (!g_flagSfxPlayed && g_sfxBank[SFX_FLAG_SLIDE]) {
+    playSfx(SFX_FLAG_SLIDE);
     g_flagSfxPlayed = true;
   }
   g_p.animT += dt;
@@ -3721,8 +5753,8 @@ void updateFlagSequence(float dt) {
       g_state = GS_WIN;
       g_p.score += g_time * 50;
       g_levelTimer = 0.0f;
-      if (!g_castleSfxPlayed && g_sfxCastleClear) {
-        Mix_PlayChannel(-1, g_sfxCastleClear, 0);
+      if (!g_castleSfxPlayed && g_sfxBank[SFX_CASTLE_CLEAR]) {
+        playSfx(SFX_CASTLE_CLEAR);
         g_castleSfxPlayed = true;
       }
     }
@@ -3732,1125 +5764,1026 @@ void updateFlagSequence(float dt) {
     g_flagY += 100 * dt;
 }
 
-void updateEntities(float dt) {
-  for (int i = 0; i < 64; i++) {
-    Entity &e = g_ents[i];
-    if (!e.on)
-      continue;
-    e.timer += dt;
-
-    if (e.type == E_GOOMBA) {
-      if (e.state == 0) {
-        e.r.x += e.dir * Physics::ENEMY_SPEED * dt;
-        e.vy += 15.0f;
-        e.r.y += e.vy * dt;
-
-        int midTx = (int)((e.r.x + e.r.w * 0.5f) / TILE);
-        int bottomTy = (int)((e.r.y + e.r.h) / TILE);
-        {
-          uint8_t col = collisionAt(midTx, bottomTy);
-          if (col == COL_SOLID || col == COL_ONEWAY) {
-            if (col == COL_ONEWAY) {
-              float prevBottom = (e.r.y - (e.vy * dt)) + e.r.h;
-              float tileTop = bottomTy * TILE;
-              if (prevBottom > tileTop + 0.1f)
-                col = COL_NONE;
-            }
-            if (col != COL_NONE) {
-              e.r.y = bottomTy * TILE - e.r.h;
-              e.vy = 0;
-            }
-          }
-        }
+static void updateGoomba(Entity &e, float dt) {
+  if (e.state == 0) {
+    moveWalker(e, Physics::ENEMY_SPEED, dt);
 
-        int frontTx =
-            e.dir > 0 ? (int)((e.r.x + e.r.w) / TILE) : (int)(e.r.x / TILE);
-        int frontTy = (int)((e.r.y + e.r.h - 1) / TILE);
-        if (solidAt(frontTx, frontTy))
-          e.dir = -e.dir;
+    if (e.r.x < g_camX - 64 || e.r.y > GAME_H + 32) {
+      e.on = false;
+      return;
+    }
 
-        if (e.r.x < g_camX - 64 || e.r.y > GAME_H + 32) {
-          e.on = false;
+    if (e.r.x > g_camX - 32 && e.r.x < g_camX + GAME_W + 32) {
+      Rect er = enemyHitRect(e);
+      unsigned nearPlayers = bpPlayersNear(er);
+      for (int pi = 0; pi < g_playerCount; pi++) {
+        Player &pl = g_players[pi];
+        if (!(nearPlayers & (1u << pi)) || pl.dead ||
+            !bpOverlap(pl.r, er))
           continue;
-        }
 
-        if (e.r.x > g_camX - 32 && e.r.x < g_camX + GAME_W + 32) {
-          Rect er = enemyHitRect(e);
-          for (int pi = 0; pi < g_playerCount; pi++) {
-            Player &pl = g_players[pi];
-            if (pl.dead || !overlap(pl.r, er))
-              continue;
-
-            if (playerStomp(pl)) {
-              e.state = 1;
-              e.timer = 0;
-              pl.vy = jumpHeld(g_playerHeld[pi]) ? -Physics::BOUNCE_HEIGHT * 1.5f
-                                                 : -Physics::BOUNCE_HEIGHT;
-              pl.score += 100;
-              if (g_sfxStomp)
-                Mix_PlayChannel(-1, g_sfxStomp, 0);
-              else if (g_sfxKick)
-                Mix_PlayChannel(-1, g_sfxKick, 0);
-            } else if (!playerIsInvulnerable(pl)) {
-              if (pl.power > P_SMALL) {
-                pl.power = P_SMALL;
-                pl.crouch = false;
-                setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
-                pl.invT = 2.0f;
-                if (g_sfxDamage)
-                  Mix_PlayChannel(-1, g_sfxDamage, 0);
-              } else if (pi == 0) {
-                pl.dead = true;
-                pl.lives--;
-                g_state = GS_DEAD;
-                Mix_HaltMusic();
-              } else {
-                // Helpers don't end the run; just grant brief i-frames.
-                pl.invT = 2.0f;
-                pl.vy = -Physics::BOUNCE_HEIGHT * 0.75f;
-              }
-            }
-            break;
-          }
-        }
-      } else if (e.timer > 0.5f)
-        e.on = false;
-    } else if (e.type == E_KOOPA || e.type == E_KOOPA_RED) {
-      float moveSpeed = 0.0f;
-      if (e.state == 0)
-        moveSpeed = Physics::ENEMY_SPEED;
-      else if (e.state == 2)
-        moveSpeed = Physics::RUN_SPEED;
-
-      e.r.x += e.dir * moveSpeed * dt;
-      e.vy += 15.0f;
-      e.r.y += e.vy * dt;
-
-      int midTx = (int)((e.r.x + e.r.w * 0.5f) / TILE);
-      int bottomTy = (int)((e.r.y + e.r.h) / TILE);
-      {
-        uint8_t col = collisionAt(midTx, bottomTy);
-        if (col == COL_SOLID || col == COL_ONEWAY) {
-          if (col == COL_ONEWAY) {
-            float prevBottom = (e.r.y - (e.vy * dt)) + e.r.h;
-            float tileTop = bottomTy * TILE;
-            if (prevBottom > tileTop + 0.1f)
-              col = COL_NONE;
-          }
-          if (col != COL_NONE) {
-            e.r.y = bottomTy * TILE - e.r.h;
-            e.vy = 0;
+        if (playerStomp(pl)) {
+          e.state = 1;
+          e.timer = 0;
+          pl.vy = jumpHeld(g_playerHeld[pi]) ? -Physics::BOUNCE_HEIGHT * 1.5f
+                                             : -Physics::BOUNCE_HEIGHT;
+          pl.score += 100;
+          playSfx(SFX_STOMP);
+        } else if (!playerIsInvulnerable(pl)) {
+          if (pl.power > P_SMALL) {
+            pl.power = P_SMALL;
+            pl.crouch = false;
+            setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
+            pl.invT = 2.0f;
+            playSfx(SFX_DAMAGE);
+          } else if (pi == 0) {
+            pl.dead = true;
+            pl.lives--;
+            g_state = GS_DEAD;
+            stopMusic();
+          } else {
+            // Helpers don't end the run; just grant brief i-frames.
+            pl.invT = 2.0f;
+            pl.vy = -Physics::BOUNCE_HEIGHT * 0.75f;
           }
         }
+        break;
       }
+    }
+  } else if (e.timer > 0.5f)
+    e.on = false;
+}
 
-      int frontTx =
-          e.dir > 0 ? (int)((e.r.x + e.r.w) / TILE) : (int)(e.r.x / TILE);
-      int frontTy = (int)((e.r.y + e.r.h - 1) / TILE);
-      if (solidAt(frontTx, frontTy))
-        e.dir = -e.dir;
+static void updateKoopa(Entity &e, float dt) {
+  float moveSpeed = 0.0f;
+  if (e.state == 0)
+    moveSpeed = Physics::ENEMY_SPEED;
+  else if (e.state == 2)
+    moveSpeed = Physics::RUN_SPEED;
 
-      if (e.r.x < g_camX - 64 || e.r.y > GAME_H + 32) {
-        e.on = false;
+  moveWalker(e, moveSpeed, dt);
+
+  if (e.r.x < g_camX - 64 || e.r.y > GAME_H + 32) {
+    e.on = false;
+    return;
+  }
+
+  if (e.r.x > g_camX - 32 && e.r.x < g_camX + GAME_W + 32) {
+    Rect er = enemyHitRect(e);
+    unsigned nearPlayers = bpPlayersNear(er);
+    for (int pi = 0; pi < g_playerCount; pi++) {
+      Player &pl = g_players[pi];
+      if (!(nearPlayers & (1u << pi)) || pl.dead ||
+          !bpOverlap(pl.r, er))
         continue;
-      }
 
-      if (e.r.x > g_camX - 32 && e.r.x < g_camX + GAME_W + 32) {
-        Rect er = enemyHitRect(e);
-        for (int pi = 0; pi < g_playerCount; pi++) {
-          Player &pl = g_players[pi];
-          if (pl.dead || !overlap(pl.r, er))
-            continue;
+      bool stomp = playerStomp(pl);
+      if (stomp) {
+        pl.vy = jumpHeld(g_playerHeld[pi]) ? -Physics::BOUNCE_HEIGHT * 1.5f
+                                           : -Physics::BOUNCE_HEIGHT;
+        playSfx(SFX_STOMP);
 
-          bool stomp = playerStomp(pl);
-          if (stomp) {
-            pl.vy = jumpHeld(g_playerHeld[pi]) ? -Physics::BOUNCE_HEIGHT * 1.5f
-                                               : -Physics::BOUNCE_HEIGHT;
-            if (g_sfxStomp)
-              Mix_PlayChannel(-1, g_sfxStomp, 0);
-            else if (g_sfxKick)
-              Mix_PlayChannel(-1, g_sfxKick, 0);
-
-            if (e.state == 0) {
-              e.state = 1;
-              e.timer = 0;
-              e.r.y += 8;
-              e.r.h = 16;
-              e.dir = 0;
-            } else if (e.state == 2) {
-              e.state = 1;
-              e.timer = 0;
-              e.dir = 0;
-            }
-          } else if (!playerIsInvulnerable(pl)) {
-            if (e.state == 1) {
-              e.state = 2;
-              e.timer = 0;
-              e.dir = (pl.r.x < e.r.x) ? 1 : -1;
-              if (g_sfxKick)
-                Mix_PlayChannel(-1, g_sfxKick, 0);
-            } else if (pl.power > P_SMALL) {
-              pl.power = P_SMALL;
-              pl.crouch = false;
-              setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
-              pl.invT = 2.0f;
-              if (g_sfxDamage)
-                Mix_PlayChannel(-1, g_sfxDamage, 0);
-            } else if (pi == 0) {
-              pl.dead = true;
-              pl.lives--;
-              g_state = GS_DEAD;
-              Mix_HaltMusic();
-            } else {
-              pl.invT = 2.0f;
-              pl.vy = -Physics::BOUNCE_HEIGHT * 0.75f;
-            }
-          }
-          break;
+        if (e.state == 0) {
+          e.state = 1;
+          e.timer = 0;
+          e.r.y += 8;
+          e.r.h = 16;
+          e.dir = 0;
+        } else if (e.state == 2) {
+          e.state = 1;
+          e.timer = 0;
+          e.dir = 0;
         }
-      }
-    } else if (e.type == E_BUZZY_BEETLE) {
-      // Buzzy Beetle: Koopa-like behavior, but uses a 16x16 body. State:
-      // 0=walk, 1=shell idle, 2=shell moving.
-      float moveSpeed = 0.0f;
-      if (e.state == 0)
-        moveSpeed = Physics::ENEMY_SPEED;
-      else if (e.state == 2)
-        moveSpeed = Physics::RUN_SPEED;
-
-      e.r.x += e.dir * moveSpeed * dt;
-      e.vy += 15.0f;
-      e.r.y += e.vy * dt;
-
-      int midTx = (int)((e.r.x + e.r.w * 0.5f) / TILE);
-      int bottomTy = (int)((e.r.y + e.r.h) / TILE);
-      {
-        uint8_t col = collisionAt(midTx, bottomTy);
-        if (col == COL_SOLID || col == COL_ONEWAY) {
-          if (col == COL_ONEWAY) {
-            float prevBottom = (e.r.y - (e.vy * dt)) + e.r.h;
-            float tileTop = bottomTy * TILE;
-            if (prevBottom > tileTop + 0.1f)
-              col = COL_NONE;
-          }
-          if (col != COL_NONE) {
-            e.r.y = bottomTy * TILE - e.r.h;
-            e.vy = 0;
-          }
+      } else if (!playerIsInvulnerable(pl)) {
+        if (e.state == 1) {
+          e.state = 2;
+          e.timer = 0;
+          e.dir = (pl.r.x < e.r.x) ? 1 : -1;
+          playSfx(SFX_KICK);
+        } else if (pl.power > P_SMALL) {
+          pl.power = P_SMALL;
+          pl.crouch = false;
+          setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
+          pl.invT = 2.0f;
+          playSfx(SFX_DAMAGE);
+        } else if (pi == 0) {
+          pl.dead = true;
+          pl.lives--;
+          g_state = GS_DEAD;
+          stopMusic();
+        } else {
+          pl.invT = 2.0f;
+          pl.vy = -Physics::BOUNCE_HEIGHT * 0.75f;
         }
       }
+      break;
+    }
+  }
+}
 
-      int frontTx =
-          e.dir > 0 ? (int)((e.r.x + e.r.w) / TILE) : (int)(e.r.x / TILE);
-      int frontTy = (int)((e.r.y + e.r.h - 1) / TILE);
-      if (solidAt(frontTx, frontTy))
-        e.dir = -e.dir;
+static void updateBuzzyBeetle(Entity &e, float dt) {
+  // Buzzy Beetle: Koopa-like behavior, but uses a 16x16 body. State:
+  // 0=walk, 1=shell idle, 2=shell moving.
+  float moveSpeed = 0.0f;
+  if (e.state == 0)
+    moveSpeed = Physics::ENEMY_SPEED;
+  else if (e.state == 2)
+    moveSpeed = Physics::RUN_SPEED;
 
-      if (e.r.x < g_camX - 64 || e.r.y > GAME_H + 32) {
-        e.on = false;
-        continue;
-      }
+  moveWalker(e, moveSpeed, dt);
 
-      if (e.r.x > g_camX - 32 && e.r.x < g_camX + GAME_W + 32) {
-        Rect er = enemyHitRect(e);
-        for (int pi = 0; pi < g_playerCount; pi++) {
-          Player &pl = g_players[pi];
-          if (pl.dead || !overlap(pl.r, er))
-            continue;
+  if (e.r.x < g_camX - 64 || e.r.y > GAME_H + 32) {
+    e.on = false;
+    return;
+  }
 
-          bool stomp = playerStomp(pl);
-          if (stomp) {
-            pl.vy = jumpHeld(g_playerHeld[pi]) ? -Physics::BOUNCE_HEIGHT * 1.5f
-                                               : -Physics::BOUNCE_HEIGHT;
-            if (g_sfxStomp)
-              Mix_PlayChannel(-1, g_sfxStomp, 0);
-
-            if (e.state == 0) {
-              e.state = 1;
-              e.timer = 0.0f;
-              e.dir = 0;
-            } else if (e.state == 2) {
-              e.state = 1;
-              e.timer = 0.0f;
-              e.dir = 0;
-            }
-          } else if (!playerIsInvulnerable(pl)) {
-            if (e.state == 1) {
-              e.state = 2;
-              e.timer = 0.0f;
-              e.dir = (pl.r.x < e.r.x) ? 1 : -1;
-              if (g_sfxKick)
-                Mix_PlayChannel(-1, g_sfxKick, 0);
-            } else if (pl.power > P_SMALL) {
-              pl.power = P_SMALL;
-              pl.crouch = false;
-              setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
-              pl.invT = 2.0f;
-              if (g_sfxDamage)
-                Mix_PlayChannel(-1, g_sfxDamage, 0);
-            } else if (pi == 0) {
-              pl.dead = true;
-              pl.lives--;
-              g_state = GS_DEAD;
-              Mix_HaltMusic();
-            } else {
-              pl.invT = 2.0f;
-              pl.vy = -Physics::BOUNCE_HEIGHT * 0.75f;
-            }
-          }
-          break;
-        }
-      }
-    } else if (e.type == E_BULLET_CANNON) {
-      // BulletBillCannon (Godot: BulletBillCannon.gd): periodic emitter with a
-      // limit on active bullets.
-      if (e.a <= 0)
-        e.a = 15; // countdown "ticks"
-      if ((rand() % 9) == 8)
-        e.a -= 1;
-      if (e.a > 0)
+  if (e.r.x > g_camX - 32 && e.r.x < g_camX + GAME_W + 32) {
+    Rect er = enemyHitRect(e);
+    unsigned nearPlayers = bpPlayersNear(er);
+    for (int pi = 0; pi < g_playerCount; pi++) {
+      Player &pl = g_players[pi];
+      if (!(nearPlayers & (1u << pi)) || pl.dead ||
+          !bpOverlap(pl.r, er))
         continue;
 
-      // Reset timer (hard-mode cadence isn't modeled here).
-      e.a = 15;
+      bool stomp = playerStomp(pl);
+      if (stomp) {
+        pl.vy = jumpHeld(g_playerHeld[pi]) ? -Physics::BOUNCE_HEIGHT * 1.5f
+                                           : -Physics::BOUNCE_HEIGHT;
+        playSfx(SFX_STOMP);
 
-      // Only shoot when player isn't inside the cannon's detect box.
-      if (fabsf((g_p.r.x + g_p.r.w * 0.5f) - e.baseX) < 24.0f &&
-          fabsf((g_p.r.y + g_p.r.h * 0.5f) - e.baseY) < 24.0f) {
-        continue;
-      }
-
-      // Keep at most 3 active bullet bills.
-      int activeBills = 0;
-      for (int j = 0; j < 64; j++) {
-        if (g_ents[j].on && g_ents[j].type == E_BULLET_BILL)
-          activeBills++;
+        if (e.state == 0) {
+          e.state = 1;
+          e.timer = 0.0f;
+          e.dir = 0;
+        } else if (e.state == 2) {
+          e.state = 1;
+          e.timer = 0.0f;
+          e.dir = 0;
+        }
+      } else if (!playerIsInvulnerable(pl)) {
+        if (e.state == 1) {
+          e.state = 2;
+          e.timer = 0.0f;
+          e.dir = (pl.r.x < e.r.x) ? 1 : -1;
+          playSfx(SFX_KICK);
+        } else if (pl.power > P_SMALL) {
+          pl.power = P_SMALL;
+          pl.crouch = false;
+          setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
+          pl.invT = 2.0f;
+          playSfx(SFX_DAMAGE);
+        } else if (pi == 0) {
+          pl.dead = true;
+          pl.lives--;
+          g_state = GS_DEAD;
+          stopMusic();
+        } else {
+          pl.invT = 2.0f;
+          pl.vy = -Physics::BOUNCE_HEIGHT * 0.75f;
+        }
       }
-      if (activeBills >= 3)
-        continue;
+      break;
+    }
+  }
+}
 
-      int dir = (int)copysignf(1.0f, (g_p.r.x + g_p.r.w * 0.5f) - e.baseX);
-      if (dir == 0)
-        dir = 1;
+static void updateBulletCannon(Entity &e, float dt) {
+  // BulletBillCannon (Godot: BulletBillCannon.gd): periodic emitter with a
+  // limit on active bullets.
+  if (e.a <= 0)
+    e.a = 15; // countdown "ticks"
+  if ((rand() % 9) == 8)
+    e.a -= 1;
+  if (e.a > 0)
+    return;
 
-      // Simple block check: don't shoot if a solid tile is directly in front.
-      int tx = (int)(e.baseX / TILE);
-      int ty = (int)((e.baseY + 8.0f) / TILE);
-      if (solidAt(tx + dir, ty))
-        continue;
+  // Reset timer (hard-mode cadence isn't modeled here).
+  e.a = 15;
 
-      int slot = findFreeEntitySlot();
-      if (slot >= 0) {
-        Entity &b = g_ents[slot];
-        b = {};
-        b.on = true;
-        b.type = E_BULLET_BILL;
-        b.dir = dir;
-        b.vx = 100.0f * (float)dir;
-        b.r = {e.baseX + (float)(8 * dir), e.baseY + 8.0f, 16.0f, 16.0f};
-      }
-    } else if (e.type == E_HAMMER_BRO) {
-      // Hammer Bro: patrols a bit, jumps between nearby platforms, and throws hammers.
-      // State: 0=idle/walk anim, 1=throw anim (short).
-      if (e.dir == 0)
-        e.dir = (rand() & 1) ? 1 : -1;
-      if (e.vx == 0.0f)
-        e.vx = 18.0f + (float)(rand() % 10);
-
-      // Gentle horizontal drift so it can walk off / reach ledges.
-      e.r.x += (float)e.dir * e.vx * dt;
-
-      // Bounce off walls.
-      int midTy = (int)((e.r.y + e.r.h * 0.5f) / TILE);
-      int frontTx =
-          (e.dir > 0) ? (int)((e.r.x + e.r.w) / TILE) : (int)(e.r.x / TILE);
-      if (solidAt(frontTx, midTy)) {
-        e.dir = -e.dir;
-        e.r.x += (float)e.dir * e.vx * dt;
-      }
+  // Only shoot when player isn't inside the cannon's detect box.
+  if (fabsf((g_p.r.x + g_p.r.w * 0.5f) - e.baseX) < 24.0f &&
+      fabsf((g_p.r.y + g_p.r.h * 0.5f) - e.baseY) < 24.0f) {
+    return;
+  }
 
-      e.vy += 15.0f;
-      e.r.y += e.vy * dt;
-      int midTx = (int)((e.r.x + e.r.w * 0.5f) / TILE);
-      int bottomTy = (int)((e.r.y + e.r.h) / TILE);
-      uint8_t landedOn = COL_NONE;
-      {
-        uint8_t col = collisionAt(midTx, bottomTy);
-        if (col == COL_SOLID || col == COL_ONEWAY) {
-          if (col == COL_ONEWAY) {
-            float prevBottom = (e.r.y - (e.vy * dt)) + e.r.h;
-            float tileTop = bottomTy * TILE;
-            if (prevBottom > tileTop + 0.1f)
-              col = COL_NONE;
-          }
-          if (col != COL_NONE) {
-            e.r.y = bottomTy * TILE - e.r.h;
-            e.vy = 0.0f;
-            landedOn = col;
-          }
-        }
-      }
+  // Keep at most 3 active bullet bills.
+  int activeBills = 0;
+  const EntityPool &projectiles = g_entityPools[POOL_PROJECTILES];
+  for (int j = 0; j < projectiles.count; j++) {
+    const Entity &b = poolEntity(projectiles, j);
+    if (b.on && b.type == E_BULLET_BILL)
+      activeBills++;
+  }
+  if (activeBills >= 3)
+    return;
 
-      // Occasional jump when on "ground".
-      bool onGround = (e.vy == 0.0f);
-      if (onGround) {
-        // Edge behavior: usually reverse at the edge, but sometimes keep going so the
-        // bro can fall down to a lower platform (requested "jump down" behavior).
-        int footTy = (int)((e.r.y + e.r.h + 1.0f) / TILE);
-        int aheadTx =
-            (e.dir > 0) ? (int)((e.r.x + e.r.w + 1.0f) / TILE) : (int)((e.r.x - 1.0f) / TILE);
-        uint8_t under = collisionAt(aheadTx, footTy);
-        if (under == COL_NONE) {
-          if ((rand() % 5) != 0) {
-            e.dir = -e.dir;
-          }
-        }
+  int dir = (int)copysignf(1.0f, (g_p.r.x + g_p.r.w * 0.5f) - e.baseX);
+  if (dir == 0)
+    dir = 1;
 
-        // Small horizontal randomness while grounded.
-        if ((rand() % 240) == 0) {
-          e.dir = (rand() & 1) ? 1 : -1;
-          e.vx = 16.0f + (float)(rand() % 14);
-        }
+  // Simple block check: don't shoot if a solid tile is directly in front.
+  int tx = (int)(e.baseX / TILE);
+  int ty = (int)((e.baseY + 8.0f) / TILE);
+  if (solidAt(tx + dir, ty))
+    return;
 
-        // Jump logic: prefer a "high" jump if there is a platform above within a few tiles.
-        bool hasAbove = false;
-        for (int dy = 2; dy <= 4; dy++) {
-          uint8_t above = collisionAt(midTx, bottomTy - dy);
-          if (above == COL_SOLID || above == COL_ONEWAY) {
-            hasAbove = true;
-            break;
-          }
-        }
+  int slot = allocEntitySlot(E_BULLET_BILL);
+  if (slot >= 0) {
+    Entity &b = g_ents[slot];
+    b = {};
+    b.on = true;
+    b.type = E_BULLET_BILL;
+    b.dir = dir;
+    b.vx = 100.0f * (float)dir;
+    b.r = {e.baseX + (float)(8 * dir), e.baseY + 8.0f, 16.0f, 16.0f};
+  }
+}
 
-        if ((rand() % 220) == 0) {
-          e.vy = hasAbove ? -310.0f : ((rand() & 1) ? -240.0f : -150.0f);
-        } else if (landedOn == COL_ONEWAY && (rand() % 360) == 0) {
-          // Short hop with a bit more speed to help it leave a one-way platform.
-          e.vy = -120.0f;
-          e.vx = 40.0f + (float)(rand() % 25);
-        }
+static void updateHammerBro(Entity &e, float dt) {
+  // Hammer Bro: patrols a bit, jumps between nearby platforms, and throws hammers.
+  // State: 0=idle/walk anim, 1=throw anim (short).
+  if (e.dir == 0)
+    e.dir = (rand() & 1) ? 1 : -1;
+  if (e.vx == 0.0f)
+    e.vx = 18.0f + (float)(rand() % 10);
+
+  // Gentle horizontal drift so it can walk off / reach ledges, bouncing off
+  // walls. Jumps pass up through blocks to reach the platform above.
+  e.vy += 15.0f;
+  BodyContacts c =
+      moveBody(e.r, (float)e.dir * e.vx * dt, e.vy * dt, BODY_NO_CEILING);
+  if (c.hits & CONTACT_WALL)
+    e.dir = -e.dir;
+  int midTx = (int)((e.r.x + e.r.w * 0.5f) / TILE);
+  int bottomTy = (int)((e.r.y + e.r.h) / TILE);
+  uint8_t landedOn = COL_NONE;
+  if (c.hits & CONTACT_FLOOR) {
+    e.vy = 0.0f;
+    landedOn = collisionAt(c.floorTx, c.floorTy);
+  }
+
+  // Occasional jump when on "ground".
+  bool onGround = (e.vy == 0.0f);
+  if (onGround) {
+    // Edge behavior: usually reverse at the edge, but sometimes keep going so the
+    // bro can fall down to a lower platform (requested "jump down" behavior).
+    int footTy = (int)((e.r.y + e.r.h + 1.0f) / TILE);
+    int aheadTx =
+        (e.dir > 0) ? (int)((e.r.x + e.r.w + 1.0f) / TILE) : (int)((e.r.x - 1.0f) / TILE);
+    uint8_t under = collisionAt(aheadTx, footTy);
+    if (under == COL_NONE) {
+      if ((rand() % 5) != 0) {
+        e.dir = -e.dir;
       }
+    }
 
-      // Throw cadence: burst a few hammers, then wait.
-      if (e.b <= 0)
-        e.b = 60 + (rand() % 120); // frames-ish until next burst
-      e.b -= 1;
-      if (e.b == 0) {
-        e.a = 2 + (rand() % 5); // throw count remaining
-      }
-      if (e.a > 0) {
-        // Throw one hammer every ~0.25s.
-        if (e.timer >= 0.25f) {
-          e.timer = 0.0f;
-          int slot = findFreeEntitySlot();
-          if (slot >= 0) {
-            int dir = (g_p.r.x + g_p.r.w * 0.5f >= e.r.x) ? 1 : -1;
-            Entity &h = g_ents[slot];
-            h = {};
-            h.on = true;
-            h.type = E_HAMMER;
-            h.dir = dir;
-            h.r = {e.r.x + 8.0f, e.r.y + 8.0f, 16.0f, 16.0f};
-            h.vx = 110.0f * (float)dir;
-            h.vy = -260.0f;
-          }
-          e.state = 1;
-          e.a -= 1;
-        }
-      } else if (e.state == 1 && e.timer >= 0.2f) {
-        // Return to idle visuals after the throw frame.
-        e.state = 0;
+    // Small horizontal randomness while grounded.
+    if ((rand() % 240) == 0) {
+      e.dir = (rand() & 1) ? 1 : -1;
+      e.vx = 16.0f + (float)(rand() % 14);
+    }
+
+    // Jump logic: prefer a "high" jump if there is a platform above within a few tiles.
+    bool hasAbove = false;
+    for (int dy = 2; dy <= 4; dy++) {
+      uint8_t above = collisionAt(midTx, bottomTy - dy);
+      if (above == COL_SOLID || above == COL_ONEWAY) {
+        hasAbove = true;
+        break;
       }
+    }
 
-      if (e.r.x > g_camX - 32 && e.r.x < g_camX + GAME_W + 32) {
-        Rect er = enemyHitRect(e);
-        for (int pi = 0; pi < g_playerCount; pi++) {
-          Player &pl = g_players[pi];
-          if (pl.dead || !overlap(pl.r, er))
-            continue;
-          if (playerStomp(pl)) {
-            e.on = false;
-            pl.vy = jumpHeld(g_playerHeld[pi]) ? -Physics::BOUNCE_HEIGHT * 1.5f
-                                               : -Physics::BOUNCE_HEIGHT;
-            pl.score += 200;
-            if (g_sfxStomp)
-              Mix_PlayChannel(-1, g_sfxStomp, 0);
-          } else if (!playerIsInvulnerable(pl)) {
-            if (pl.power > P_SMALL) {
-              pl.power = P_SMALL;
-              pl.crouch = false;
-              setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
-              pl.invT = 2.0f;
-              if (g_sfxDamage)
-                Mix_PlayChannel(-1, g_sfxDamage, 0);
-            } else if (pi == 0) {
-              pl.dead = true;
-              pl.lives--;
-              g_state = GS_DEAD;
-              Mix_HaltMusic();
-            } else {
-              pl.invT = 2.0f;
-              pl.vy = -Physics::BOUNCE_HEIGHT * 0.75f;
-            }
-          }
-          break;
-        }
+    if ((rand() % 220) == 0) {
+      e.vy = hasAbove ? -310.0f : ((rand() & 1) ? -240.0f : -150.0f);
+    } else if (landedOn == COL_ONEWAY && (rand() % 360) == 0) {
+      // Short hop with a bit more speed to help it leave a one-way platform.
+      e.vy = -120.0f;
+      e.vx = 40.0f + (float)(rand() % 25);
+    }
+  }
+
+  // Throw cadence: burst a few hammers, then wait.
+  if (e.b <= 0)
+    e.b = 60 + (rand() % 120); // frames-ish until next burst
+  e.b -= 1;
+  if (e.b == 0) {
+    e.a = 2 + (rand() % 5); // throw count remaining
+  }
+  if (e.a > 0) {
+    // Throw one hammer every ~0.25s.
+    if (e.timer >= 0.25f) {
+      e.timer = 0.0f;
+      int slot = allocEntitySlot(E_HAMMER);
+      if (slot >= 0) {
+        int dir = (g_p.r.x + g_p.r.w * 0.5f >= e.r.x) ? 1 : -1;
+        Entity &h = g_ents[slot];
+        h = {};
+        h.on = true;
+        h.type = E_HAMMER;
+        h.dir = dir;
+        h.r = {e.r.x + 8.0f, e.r.y + 8.0f, 16.0f, 16.0f};
+        h.vx = 110.0f * (float)dir;
+        h.vy = -260.0f;
       }
-    } else if (e.type == E_HAMMER) {
-      // Hammer projectile: arc, die on collision, hurts players.
-      constexpr float kGravity = 450.0f;
-      e.r.x += e.vx * dt;
-      e.vy += kGravity * dt;
-      e.r.y += e.vy * dt;
-
-      int midTx = (int)((e.r.x + e.r.w * 0.5f) / TILE);
-      int midTy = (int)((e.r.y + e.r.h * 0.5f) / TILE);
-      if (solidAt(midTx, midTy)) {
-        e.on = false;
+      e.state = 1;
+      e.a -= 1;
+    }
+  } else if (e.state == 1 && e.timer >= 0.2f) {
+    // Return to idle visuals after the throw frame.
+    e.state = 0;
+  }
+
+  if (e.r.x > g_camX - 32 && e.r.x < g_camX + GAME_W + 32) {
+    Rect er = enemyHitRect(e);
+    unsigned nearPlayers = bpPlayersNear(er);
+    for (int pi = 0; pi < g_playerCount; pi++) {
+      Player &pl = g_players[pi];
+      if (!(nearPlayers & (1u << pi)) || pl.dead ||
+          !bpOverlap(pl.r, er))
         continue;
-      }
-      if (e.r.x < g_camX - 96 || e.r.x > g_camX + GAME_W + 96 ||
-          e.r.y > GAME_H + 64) {
+      if (playerStomp(pl)) {
         e.on = false;
-        continue;
-      }
-      for (int pi = 0; pi < g_playerCount; pi++) {
-        Player &pl = g_players[pi];
-        if (pl.dead || !overlap(pl.r, e.r))
-          continue;
-        if (playerIsInvulnerable(pl))
-          break;
+        pl.vy = jumpHeld(g_playerHeld[pi]) ? -Physics::BOUNCE_HEIGHT * 1.5f
+                                           : -Physics::BOUNCE_HEIGHT;
+        pl.score += 200;
+        playSfx(SFX_STOMP);
+      } else if (!playerIsInvulnerable(pl)) {
         if (pl.power > P_SMALL) {
           pl.power = P_SMALL;
           pl.crouch = false;
           setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
           pl.invT = 2.0f;
-          if (g_sfxDamage)
-            Mix_PlayChannel(-1, g_sfxDamage, 0);
+          playSfx(SFX_DAMAGE);
         } else if (pi == 0) {
           pl.dead = true;
           pl.lives--;
           g_state = GS_DEAD;
-          Mix_HaltMusic();
+          stopMusic();
         } else {
           pl.invT = 2.0f;
-        }
-        break;
-      }
-    } else if (e.type == E_LAKITU) {
-      // Lakitu hovers near the top and tosses spinies.
-      // `state` is used only for visuals: 0=idle, 1=throw (brief).
-      if (e.state == 1 && e.timer >= 0.25f) {
-        e.state = 0;
-      }
-      float playerX = g_p.r.x + g_p.r.w * 0.5f;
-      float targetX = playerX + 64.0f;
-      float dx = targetX - (e.r.x + 8.0f);
-      float speed = 0.0f;
-      if (fabsf(dx) > 16.0f) {
-        speed = fmaxf(48.0f, fabsf(dx) * 2.0f);
-        if (speed > 160.0f)
-          speed = 160.0f;
-        e.dir = (dx > 0.0f) ? 1 : -1;
-      }
-      e.r.x += (float)e.dir * speed * dt;
-      e.r.y = e.baseY;
-
-      // Throw spiny if under cap.
-      int spinyCount = 0;
-      for (int j = 0; j < 64; j++) {
-        if (g_ents[j].on && g_ents[j].type == E_SPINY)
-          spinyCount++;
-      }
-      if (spinyCount < 3) {
-        if (e.a <= 0)
-          e.a = 120 + (rand() % 180);
-        e.a -= 1;
-        if (e.a == 0) {
-          int slot = findFreeEntitySlot();
-          if (slot >= 0) {
-            Entity &s = g_ents[slot];
-            s = {};
-            s.on = true;
-            s.type = E_SPINY;
-            s.state = 0; // egg
-            s.dir = 0;
-            s.r = {e.r.x + 8.0f, e.r.y + 16.0f, 16.0f, 16.0f};
-            s.vx = 0.0f;
-            s.vy = -150.0f;
-          }
-          // Show the throw frame for a moment.
-          e.state = 1;
-          e.timer = 0.0f;
+          pl.vy = -Physics::BOUNCE_HEIGHT * 0.75f;
         }
       }
+      break;
+    }
+  }
+}
 
-      if (e.r.x > g_camX - 64 && e.r.x < g_camX + GAME_W + 64) {
-        Rect er = enemyHitRect(e);
-        for (int pi = 0; pi < g_playerCount; pi++) {
-          Player &pl = g_players[pi];
-          if (pl.dead || !overlap(pl.r, er))
-            continue;
-          if (playerStomp(pl)) {
-            e.on = false;
-            pl.vy = jumpHeld(g_playerHeld[pi]) ? -Physics::BOUNCE_HEIGHT * 1.5f
-                                               : -Physics::BOUNCE_HEIGHT;
-            pl.score += 200;
-            if (g_sfxStomp)
-              Mix_PlayChannel(-1, g_sfxStomp, 0);
-          } else if (!playerIsInvulnerable(pl)) {
-            if (pl.power > P_SMALL) {
-              pl.power = P_SMALL;
-              pl.crouch = false;
-              setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
-              pl.invT = 2.0f;
-              if (g_sfxDamage)
-                Mix_PlayChannel(-1, g_sfxDamage, 0);
-            } else if (pi == 0) {
-              pl.dead = true;
-              pl.lives--;
-              g_state = GS_DEAD;
-              Mix_HaltMusic();
-            } else {
-              pl.invT = 2.0f;
-              pl.vy = -Physics::BOUNCE_HEIGHT * 0.75f;
-            }
-          }
-          break;
-        }
-      }
-    } else if (e.type == E_SPINY) {
-      // Spiny: egg falls, then walks. Can't be stomped.
-      constexpr float kGravity = 15.0f;
-      e.vy += kGravity;
-      e.r.y += e.vy * dt;
-      if (e.state == 0) {
-        // Egg: no horizontal motion.
-        int midTx = (int)((e.r.x + 8.0f) / TILE);
-        int bottomTy = (int)((e.r.y + e.r.h) / TILE);
-        uint8_t col = collisionAt(midTx, bottomTy);
-        if (col == COL_SOLID || col == COL_ONEWAY) {
-          e.r.y = bottomTy * TILE - e.r.h;
-          e.vy = 0.0f;
-          e.state = 1;
-          e.dir = (g_p.r.x + g_p.r.w * 0.5f >= e.r.x) ? 1 : -1;
-          e.vx = 32.0f;
-        }
-      } else {
-        if (e.dir == 0)
-          e.dir = -1;
-        if (e.vx == 0.0f)
-          e.vx = 32.0f;
-        e.r.x += e.dir * e.vx * dt;
-        int frontTx =
-            e.dir > 0 ? (int)((e.r.x + e.r.w) / TILE) : (int)(e.r.x / TILE);
-        int frontTy = (int)((e.r.y + e.r.h - 1) / TILE);
-        if (solidAt(frontTx, frontTy))
-          e.dir = -e.dir;
-      }
+static void updateHammer(Entity &e, float dt) {
+  // Hammer projectile: arc, die on collision, hurts players.
+  constexpr float kGravity = 450.0f;
+  e.r.x += e.vx * dt;
+  e.vy += kGravity * dt;
+  e.r.y += e.vy * dt;
+
+  int midTx = (int)((e.r.x + e.r.w * 0.5f) / TILE);
+  int midTy = (int)((e.r.y + e.r.h * 0.5f) / TILE);
+  if (solidAt(midTx, midTy)) {
+    e.on = false;
+    return;
+  }
+  if (e.r.x < g_camX - 96 || e.r.x > g_camX + GAME_W + 96 ||
+      e.r.y > GAME_H + 64) {
+    e.on = false;
+    return;
+  }
+  unsigned nearPlayers = bpPlayersNear(e.r);
+  for (int pi = 0; pi < g_playerCount; pi++) {
+    Player &pl = g_players[pi];
+    if (!(nearPlayers & (1u << pi)) || pl.dead ||
+        !bpOverlap(pl.r, e.r))
+      continue;
+    if (playerIsInvulnerable(pl))
+      break;
+    if (pl.power > P_SMALL) {
+      pl.power = P_SMALL;
+      pl.crouch = false;
+      setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
+      pl.invT = 2.0f;
+      playSfx(SFX_DAMAGE);
+    } else if (pi == 0) {
+      pl.dead = true;
+      pl.lives--;
+      g_state = GS_DEAD;
+      stopMusic();
+    } else {
+      pl.invT = 2.0f;
+    }
+    break;
+  }
+}
 
-      if (e.r.x < g_camX - 96 || e.r.x > g_camX + GAME_W + 96 ||
-          e.r.y > GAME_H + 64) {
-        e.on = false;
-        continue;
+static void updateLakitu(Entity &e, float dt) {
+  // Lakitu hovers near the top and tosses spinies.
+  // `state` is used only for visuals: 0=idle, 1=throw (brief).
+  if (e.state == 1 && e.timer >= 0.25f) {
+    e.state = 0;
+  }
+  float playerX = g_p.r.x + g_p.r.w * 0.5f;
+  float targetX = playerX + 64.0f;
+  float dx = targetX - (e.r.x + 8.0f);
+  float speed = 0.0f;
+  if (fabsf(dx) > 16.0f) {
+    speed = fmaxf(48.0f, fabsf(dx) * 2.0f);
+    if (speed > 160.0f)
+      speed = 160.0f;
+    e.dir = (dx > 0.0f) ? 1 : -1;
+  }
+  e.r.x += (float)e.dir * speed * dt;
+  e.r.y = e.baseY;
+
+  // Throw spiny if under cap.
+  if (g_entityTypeCount[E_SPINY] < 3) {
+    if (e.a <= 0)
+      e.a = 120 + (rand() % 180);
+    e.a -= 1;
+    if (e.a == 0) {
+      int slot = allocEntitySlot(E_SPINY);
+      if (slot >= 0) {
+        Entity &s = g_ents[slot];
+        s = {};
+        s.on = true;
+        s.type = E_SPINY;
+        s.state = 0; // egg
+        s.dir = 0;
+        s.r = {e.r.x + 8.0f, e.r.y + 16.0f, 16.0f, 16.0f};
+        s.vx = 0.0f;
+        s.vy = -150.0f;
       }
+      // Show the throw frame for a moment.
+      e.state = 1;
+      e.timer = 0.0f;
+    }
+  }
 
-      if (e.r.x > g_camX - 32 && e.r.x < g_camX + GAME_W + 32) {
-        Rect er = enemyHitRect(e);
-        for (int pi = 0; pi < g_playerCount; pi++) {
-          Player &pl = g_players[pi];
-          if (pl.dead || !overlap(pl.r, er))
-            continue;
-          if (!playerIsInvulnerable(pl)) {
-            if (pl.power > P_SMALL) {
-              pl.power = P_SMALL;
-              pl.crouch = false;
-              setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
-              pl.invT = 2.0f;
-              if (g_sfxDamage)
-                Mix_PlayChannel(-1, g_sfxDamage, 0);
-            } else if (pi == 0) {
-              pl.dead = true;
-              pl.lives--;
-              g_state = GS_DEAD;
-              Mix_HaltMusic();
-            } else {
-              pl.invT = 2.0f;
-              pl.vy = -Physics::BOUNCE_HEIGHT * 0.75f;
-            }
-          }
-          break;
-        }
-      }
-    } else if (e.type == E_BLOOPER) {
-      // Blooper (Godot: Blooper.gd): drift down until near player, then rise.
-      if (g_theme != THEME_UNDERWATER && g_theme != THEME_CASTLE_WATER) {
-        // Only meaningful in underwater sections; keep it out of non-water themes.
-        e.on = false;
+  if (e.r.x > g_camX - 64 && e.r.x < g_camX + GAME_W + 64) {
+    Rect er = enemyHitRect(e);
+    unsigned nearPlayers = bpPlayersNear(er);
+    for (int pi = 0; pi < g_playerCount; pi++) {
+      Player &pl = g_players[pi];
+      if (!(nearPlayers & (1u << pi)) || pl.dead ||
+          !bpOverlap(pl.r, er))
         continue;
-      }
-
-      float playerY = g_p.r.y;
-      if (e.state == 0) {
-        e.r.y += 32.0f * dt;
-        if (e.r.y >= playerY - 24.0f && e.a == 0) {
-          // Begin rise.
-          int dir = (g_p.r.x + g_p.r.w * 0.5f >= e.r.x) ? 1 : -1;
-          e.dir = dir;
-          e.vx = 32.0f * (float)dir / 0.75f;
-          e.vy = -32.0f / 0.75f;
-          // Add a little side drift so bloopers don't feel too rigid (requested).
-          e.b = (rand() % 3) - 1; // -1,0,1
-          e.state = 1;
-          e.timer = 0.0f;
-          e.a = 1;
-        }
-      } else if (e.state == 1) {
-        // Occasionally tweak drift direction during the rise.
-        if ((rand() % 40) == 0)
-          e.b = (rand() % 3) - 1;
-        float drift = (float)e.b * 14.0f * dt;
-        e.r.x += e.vx * dt;
-        e.r.x += drift;
-        e.r.y += e.vy * dt;
-        if (e.r.y < 0.0f)
-          e.r.y = 0.0f;
-        if (e.r.y > 64.0f)
-          e.r.y = 64.0f;
-        if (e.timer >= 0.75f) {
-          e.state = 2;
-          e.timer = 0.0f;
-          e.vx = 0.0f;
-          e.vy = 0.0f;
-        }
-      } else {
-        if (e.timer >= 0.25f) {
-          e.state = 0;
-          e.timer = 0.0f;
-          e.a = 0;
+      if (playerStomp(pl)) {
+        e.on = false;
+        pl.vy = jumpHeld(g_playerHeld[pi]) ? -Physics::BOUNCE_HEIGHT * 1.5f
+                                           : -Physics::BOUNCE_HEIGHT;
+        pl.score += 200;
+        playSfx(SFX_STOMP);
+      } else if (!playerIsInvulnerable(pl)) {
+        if (pl.power > P_SMALL) {
+          pl.power = P_SMALL;
+          pl.crouch = false;
+          setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
+          pl.invT = 2.0f;
+          playSfx(SFX_DAMAGE);
+        } else if (pi == 0) {
+          pl.dead = true;
+          pl.lives--;
+          g_state = GS_DEAD;
+          stopMusic();
+        } else {
+          pl.invT = 2.0f;
+          pl.vy = -Physics::BOUNCE_HEIGHT * 0.75f;
         }
       }
+      break;
+    }
+  }
+}
 
-      if (e.r.x < g_camX - 96 || e.r.x > g_camX + GAME_W + 96 ||
-          e.r.y > GAME_H + 64) {
-        e.on = false;
-        continue;
-      }
+static void updateSpiny(Entity &e, float dt) {
+  // Spiny: egg falls, then walks. Can't be stomped.
+  if (e.state == 0) {
+    // Egg: no horizontal motion; hatches on landing.
+    if (moveWalker(e, 0.0f, dt).hits & CONTACT_FLOOR) {
+      e.state = 1;
+      e.dir = (g_p.r.x + g_p.r.w * 0.5f >= e.r.x) ? 1 : -1;
+      e.vx = 32.0f;
+    }
+  } else {
+    if (e.dir == 0)
+      e.dir = -1;
+    if (e.vx == 0.0f)
+      e.vx = 32.0f;
+    moveWalker(e, e.vx, dt);
+  }
 
-      if (e.r.x > g_camX - 32 && e.r.x < g_camX + GAME_W + 32) {
-        Rect er = enemyHitRect(e);
-        for (int pi = 0; pi < g_playerCount; pi++) {
-          Player &pl = g_players[pi];
-          if (pl.dead || !overlap(pl.r, er))
-            continue;
-          // Blooper can't be stomped (underwater hazard).
-          if (!playerIsInvulnerable(pl)) {
-            if (pl.power > P_SMALL) {
-              pl.power = P_SMALL;
-              pl.crouch = false;
-              setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
-              pl.invT = 2.0f;
-              if (g_sfxDamage)
-                Mix_PlayChannel(-1, g_sfxDamage, 0);
-            } else if (pi == 0) {
-              pl.dead = true;
-              pl.lives--;
-              g_state = GS_DEAD;
-              Mix_HaltMusic();
-            } else {
-              pl.invT = 2.0f;
-            }
-          }
-          break;
-        }
-      }
-    } else if (e.type == E_BULLET_BILL) {
-      float speed = (e.vx != 0.0f) ? fabsf(e.vx) : 90.0f;
-      if (e.dir == 0)
-        e.dir = -1;
-      e.r.x += e.dir * speed * dt;
+  if (e.r.x < g_camX - 96 || e.r.x > g_camX + GAME_W + 96 ||
+      e.r.y > GAME_H + 64) {
+    e.on = false;
+    return;
+  }
 
-      if (e.r.x < g_camX - 96 || e.r.x > g_camX + GAME_W + 96) {
-        e.on = false;
+  if (e.r.x > g_camX - 32 && e.r.x < g_camX + GAME_W + 32) {
+    Rect er = enemyHitRect(e);
+    unsigned nearPlayers = bpPlayersNear(er);
+    for (int pi = 0; pi < g_playerCount; pi++) {
+      Player &pl = g_players[pi];
+      if (!(nearPlayers & (1u << pi)) || pl.dead ||
+          !bpOverlap(pl.r, er))
         continue;
-      }
-
-      if (e.r.x > g_camX - 32 && e.r.x < g_camX + GAME_W + 32) {
-        Rect er = enemyHitRect(e);
-        for (int pi = 0; pi < g_playerCount; pi++) {
-          Player &pl = g_players[pi];
-          if (pl.dead || !overlap(pl.r, er))
-            continue;
-          if (playerStomp(pl)) {
-            e.on = false;
-            pl.vy = jumpHeld(g_playerHeld[pi]) ? -Physics::BOUNCE_HEIGHT * 1.5f
-                                               : -Physics::BOUNCE_HEIGHT;
-            pl.score += 200;
-            if (g_sfxStomp)
-              Mix_PlayChannel(-1, g_sfxStomp, 0);
-          } else if (!playerIsInvulnerable(pl)) {
-            if (pl.power > P_SMALL) {
-              pl.power = P_SMALL;
-              pl.crouch = false;
-              setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
-              pl.invT = 2.0f;
-              if (g_sfxDamage)
-                Mix_PlayChannel(-1, g_sfxDamage, 0);
-            } else if (pi == 0) {
-              pl.dead = true;
-              pl.lives--;
-              g_state = GS_DEAD;
-              Mix_HaltMusic();
-            } else {
-              pl.invT = 2.0f;
-              pl.vy = -Physics::BOUNCE_HEIGHT * 0.75f;
-            }
-          }
-          break;
+      if (!playerIsInvulnerable(pl)) {
+        if (pl.power > P_SMALL) {
+          pl.power = P_SMALL;
+          pl.crouch = false;
+          setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
+          pl.invT = 2.0f;
+          playSfx(SFX_DAMAGE);
+        } else if (pi == 0) {
+          pl.dead = true;
+          pl.lives--;
+          g_state = GS_DEAD;
+          stopMusic();
+        } else {
+          pl.invT = 2.0f;
+          pl.vy = -Physics::BOUNCE_HEIGHT * 0.75f;
         }
       }
-    } else if (e.type == E_CHEEP_LEAP) {
-      // If this cheep wasn't initialized by a generator, give it a sane default.
-      if (e.vx == 0.0f && e.timer < 0.05f) {
-        e.dir = (rand() & 1) ? -1 : 1;
-        e.vx = (50.0f + (float)(rand() % 151)) * (float)e.dir;
-        e.vy = -(250.0f + (float)(rand() % 101));
-        e.b = (int)liquidSurfaceYAtWorldX(e.r.x + 8.0f);
-      }
+      break;
+    }
+  }
+}
 
-      constexpr float kGravity = 300.0f;
-      e.r.x += e.vx * dt;
-      e.vy += kGravity * dt;
-      e.r.y += e.vy * dt;
-
-      float surface = (e.b > 0) ? (float)e.b : liquidSurfaceYAtWorldX(e.r.x + 8.0f);
-      if (e.b <= 0)
-        e.b = (int)surface;
-      if (e.vy > 0.0f && e.r.y > surface + 16.0f) {
-        e.on = false;
-        continue;
-      }
+static void updateBlooper(Entity &e, float dt) {
+  // Blooper (Godot: Blooper.gd): drift down until near player, then rise.
+  if (g_theme != THEME_UNDERWATER && g_theme != THEME_CASTLE_WATER) {
+    // Only meaningful in underwater sections; keep it out of non-water themes.
+    e.on = false;
+    return;
+  }
 
-      if (e.r.x < g_camX - 96 || e.r.x > g_camX + GAME_W + 96) {
-        e.on = false;
-        continue;
-      }
+  float playerY = g_p.r.y;
+  if (e.state == 0) {
+    e.r.y += 32.0f * dt;
+    if (e.r.y >= playerY - 24.0f && e.a == 0) {
+      // Begin rise.
+      int dir = (g_p.r.x + g_p.r.w * 0.5f >= e.r.x) ? 1 : -1;
+      e.dir = dir;
+      e.vx = 32.0f * (float)dir / 0.75f;
+      e.vy = -32.0f / 0.75f;
+      // Add a little side drift so bloopers don't feel too rigid (requested).
+      e.b = (rand() % 3) - 1; // -1,0,1
+      e.state = 1;
+      e.timer = 0.0f;
+      e.a = 1;
+    }
+  } else if (e.state == 1) {
+    // Occasionally tweak drift direction during the rise.
+    if ((rand() % 40) == 0)
+      e.b = (rand() % 3) - 1;
+    float drift = (float)e.b * 14.0f * dt;
+    e.r.x += e.vx * dt;
+    e.r.x += drift;
+    e.r.y += e.vy * dt;
+    if (e.r.y < 0.0f)
+      e.r.y = 0.0f;
+    if (e.r.y > 64.0f)
+      e.r.y = 64.0f;
+    if (e.timer >= 0.75f) {
+      e.state = 2;
+      e.timer = 0.0f;
+      e.vx = 0.0f;
+      e.vy = 0.0f;
+    }
+  } else {
+    if (e.timer >= 0.25f) {
+      e.state = 0;
+      e.timer = 0.0f;
+      e.a = 0;
+    }
+  }
 
-      if (e.r.x > g_camX - 32 && e.r.x < g_camX + GAME_W + 32) {
-        Rect er = enemyHitRect(e);
-        for (int pi = 0; pi < g_playerCount; pi++) {
-          Player &pl = g_players[pi];
-          if (pl.dead || !overlap(pl.r, er))
-            continue;
-          if (playerStomp(pl)) {
-            e.on = false;
-            pl.vy = jumpHeld(g_playerHeld[pi]) ? -Physics::BOUNCE_HEIGHT * 1.5f
-                                               : -Physics::BOUNCE_HEIGHT;
-            pl.score += 200;
-            if (g_sfxStomp)
-              Mix_PlayChannel(-1, g_sfxStomp, 0);
-          } else if (!playerIsInvulnerable(pl)) {
-            if (pl.power > P_SMALL) {
-              pl.power = P_SMALL;
-              pl.crouch = false;
-              setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
-              pl.invT = 2.0f;
-              if (g_sfxDamage)
-                Mix_PlayChannel(-1, g_sfxDamage, 0);
-            } else if (pi == 0) {
-              pl.dead = true;
-              pl.lives--;
-              g_state = GS_DEAD;
-              Mix_HaltMusic();
-            } else {
-              pl.invT = 2.0f;
-              pl.vy = -Physics::BOUNCE_HEIGHT * 0.75f;
-            }
-          }
-          break;
-        }
-      }
-    } else if (e.type == E_CHEEP_SWIM) {
-      if (e.vx == 0.0f)
-        e.vx = 20.0f;
-      if (e.dir == 0)
-        e.dir = -1;
-
-      e.r.x += e.dir * e.vx * dt;
-      e.r.y = e.baseY + sinf(e.timer * 2.0f) * 4.0f;
-
-      int frontTx =
-          e.dir > 0 ? (int)((e.r.x + e.r.w) / TILE) : (int)(e.r.x / TILE);
-      int frontTy = (int)((e.r.y + e.r.h * 0.5f) / TILE);
-      if (solidAt(frontTx, frontTy))
-        e.dir = -e.dir;
+  if (e.r.x < g_camX - 96 || e.r.x > g_camX + GAME_W + 96 ||
+      e.r.y > GAME_H + 64) {
+    e.on = false;
+    return;
+  }
 
-      if (e.r.x < g_camX - 96 || e.r.x > g_camX + GAME_W + 96) {
-        e.on = false;
+  if (e.r.x > g_camX - 32 && e.r.x < g_camX + GAME_W + 32) {
+    Rect er = enemyHitRect(e);
+    unsigned nearPlayers = bpPlayersNear(er);
+    for (int pi = 0; pi < g_playerCount; pi++) {
+      Player &pl = g_players[pi];
+      if (!(nearPlayers & (1u << pi)) || pl.dead ||
+          !bpOverlap(pl.r, er))
         continue;
-      }
-
-      if (e.r.x > g_camX - 32 && e.r.x < g_camX + GAME_W + 32) {
-        Rect er = enemyHitRect(e);
-        for (int pi = 0; pi < g_playerCount; pi++) {
-          Player &pl = g_players[pi];
-          if (pl.dead || !overlap(pl.r, er))
-            continue;
-          if (playerStomp(pl)) {
-            e.on = false;
-            pl.vy = jumpHeld(g_playerHeld[pi]) ? -Physics::BOUNCE_HEIGHT * 1.5f
-                                               : -Physics::BOUNCE_HEIGHT;
-            pl.score += 200;
-            if (g_sfxStomp)
-              Mix_PlayChannel(-1, g_sfxStomp, 0);
-          } else if (!playerIsInvulnerable(pl)) {
-            if (pl.power > P_SMALL) {
-              pl.power = P_SMALL;
-              pl.crouch = false;
-              setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
-              pl.invT = 2.0f;
-              if (g_sfxDamage)
-                Mix_PlayChannel(-1, g_sfxDamage, 0);
-            } else if (pi == 0) {
-              pl.dead = true;
-              pl.lives--;
-              g_state = GS_DEAD;
-              Mix_HaltMusic();
-            } else {
-              pl.invT = 2.0f;
-              pl.vy = -Physics::BOUNCE_HEIGHT * 0.75f;
-            }
-          }
-          break;
+      // Blooper can't be stomped (underwater hazard).
+      if (!playerIsInvulnerable(pl)) {
+        if (pl.power > P_SMALL) {
+          pl.power = P_SMALL;
+          pl.crouch = false;
+          setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
+          pl.invT = 2.0f;
+          playSfx(SFX_DAMAGE);
+        } else if (pi == 0) {
+          pl.dead = true;
+          pl.lives--;
+          g_state = GS_DEAD;
+          stopMusic();
+        } else {
+          pl.invT = 2.0f;
         }
       }
-    } else if (e.type == E_CASTLE_AXE) {
-      // Touching the axe ends the castle section (like SMB1 bridge axe).
-      if (g_state == GS_PLAYING && overlap(g_p.r, e.r)) {
+      break;
+    }
+  }
+}
+
+static void updateBulletBill(Entity &e, float dt) {
+  float speed = (e.vx != 0.0f) ? fabsf(e.vx) : 90.0f;
+  if (e.dir == 0)
+    e.dir = -1;
+  e.r.x += e.dir * speed * dt;
+
+  if (e.r.x < g_camX - 96 || e.r.x > g_camX + GAME_W + 96) {
+    e.on = false;
+    return;
+  }
+
+  if (e.r.x > g_camX - 32 && e.r.x < g_camX + GAME_W + 32) {
+    Rect er = enemyHitRect(e);
+    unsigned nearPlayers = bpPlayersNear(er);
+    for (int pi = 0; pi < g_playerCount; pi++) {
+      Player &pl = g_players[pi];
+      if (!(nearPlayers & (1u << pi)) || pl.dead ||
+          !bpOverlap(pl.r, er))
+        continue;
+      if (playerStomp(pl)) {
         e.on = false;
-        g_state = GS_WIN;
-        g_levelTimer = 0.0f;
-        if (!g_castleSfxPlayed && g_sfxCastleClear) {
-          Mix_PlayChannel(-1, g_sfxCastleClear, 0);
-          g_castleSfxPlayed = true;
-        }
-      }
-    } else if (e.type == E_BOWSER) {
-      // Minimal Bowser: patrol + gravity + damage on contact. Fireballs can
-      // "wear him down" to keep the section beatable even without the axe.
-      if (e.dir == 0)
-        e.dir = -1;
-      float speed = 18.0f;
-      e.r.x += e.dir * speed * dt;
-      e.vy += 15.0f;
-      e.r.y += e.vy * dt;
-
-      int midTx = (int)((e.r.x + e.r.w * 0.5f) / TILE);
-      int bottomTy = (int)((e.r.y + e.r.h) / TILE);
-      {
-        uint8_t col = collisionAt(midTx, bottomTy);
-        if (col == COL_SOLID || col == COL_ONEWAY) {
-          if (col == COL_ONEWAY) {
-            float prevBottom = (e.r.y - (e.vy * dt)) + e.r.h;
-            float tileTop = bottomTy * TILE;
-            if (prevBottom > tileTop + 0.1f)
-              col = COL_NONE;
-          }
-          if (col != COL_NONE) {
-            e.r.y = bottomTy * TILE - e.r.h;
-            e.vy = 0;
-          }
+        pl.vy = jumpHeld(g_playerHeld[pi]) ? -Physics::BOUNCE_HEIGHT * 1.5f
+                                           : -Physics::BOUNCE_HEIGHT;
+        pl.score += 200;
+        playSfx(SFX_STOMP);
+      } else if (!playerIsInvulnerable(pl)) {
+        if (pl.power > P_SMALL) {
+          pl.power = P_SMALL;
+          pl.crouch = false;
+          setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
+          pl.invT = 2.0f;
+          playSfx(SFX_DAMAGE);
+        } else if (pi == 0) {
+          pl.dead = true;
+          pl.lives--;
+          g_state = GS_DEAD;
+          stopMusic();
+        } else {
+          pl.invT = 2.0f;
+          pl.vy = -Physics::BOUNCE_HEIGHT * 0.75f;
         }
       }
+      break;
+    }
+  }
+}
 
-      int frontTx =
-          e.dir > 0 ? (int)((e.r.x + e.r.w) / TILE) : (int)(e.r.x / TILE);
-      int frontTy = (int)((e.r.y + e.r.h - 1) / TILE);
-      if (solidAt(frontTx, frontTy))
-        e.dir = -e.dir;
+static void updateCheepLeap(Entity &e, float dt) {
+  // If this cheep wasn't initialized by a generator, give it a sane default.
+  if (e.vx == 0.0f && e.timer < 0.05f) {
+    e.dir = (rand() & 1) ? -1 : 1;
+    e.vx = (50.0f + (float)(rand() % 151)) * (float)e.dir;
+    e.vy = -(250.0f + (float)(rand() % 101));
+    e.b = (int)liquidSurfaceYAtWorldX(e.r.x + 8.0f);
+  }
+
+  constexpr float kGravity = 300.0f;
+  e.r.x += e.vx * dt;
+  e.vy += kGravity * dt;
+  e.r.y += e.vy * dt;
+
+  float surface = (e.b > 0) ? (float)e.b : liquidSurfaceYAtWorldX(e.r.x + 8.0f);
+  if (e.b <= 0)
+    e.b = (int)surface;
+  if (e.vy > 0.0f && e.r.y > surface + 16.0f) {
+    e.on = false;
+    return;
+  }
 
-      if (e.r.x < g_camX - 128 || e.r.y > GAME_H + 96) {
-        e.on = false;
-        continue;
-      }
+  if (e.r.x < g_camX - 96 || e.r.x > g_camX + GAME_W + 96) {
+    e.on = false;
+    return;
+  }
 
-      if (e.r.x > g_camX - 64 && e.r.x < g_camX + GAME_W + 64) {
-        for (int pi = 0; pi < g_playerCount; pi++) {
-          Player &pl = g_players[pi];
-          if (pl.dead || !overlap(pl.r, e.r))
-            continue;
-          if (!playerIsInvulnerable(pl)) {
-            if (pl.power > P_SMALL) {
-              pl.power = P_SMALL;
-              pl.crouch = false;
-              setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
-              pl.invT = 2.0f;
-              if (g_sfxDamage)
-                Mix_PlayChannel(-1, g_sfxDamage, 0);
-            } else if (pi == 0) {
-              pl.dead = true;
-              pl.lives--;
-              g_state = GS_DEAD;
-              Mix_HaltMusic();
-            } else {
-              pl.invT = 2.0f;
-              pl.vy = -Physics::BOUNCE_HEIGHT * 0.75f;
-            }
-          }
-          break;
-        }
-      }
-    } else if (e.type == E_MUSHROOM) {
-      e.vy += 15.0f;
-      e.r.x += e.vx * dt * e.dir;
-      e.r.y += e.vy * dt;
-      int ty = (int)((e.r.y + e.r.h) / TILE);
-      {
-        int midTx = (int)((e.r.x + 8) / TILE);
-        uint8_t col = collisionAt(midTx, ty);
-        if (col == COL_SOLID || col == COL_ONEWAY) {
-          if (col == COL_ONEWAY) {
-            float prevBottom = (e.r.y - (e.vy * dt)) + e.r.h;
-            float tileTop = ty * TILE;
-            if (prevBottom > tileTop + 0.1f)
-              col = COL_NONE;
-          }
-          if (col != COL_NONE) {
-            e.r.y = ty * TILE - e.r.h;
-            e.vy = 0;
-          }
-        }
-      }
-      int tx = e.dir > 0 ? (int)((e.r.x + e.r.w) / TILE) : (int)(e.r.x / TILE);
-      if (solidAt(tx, (int)(e.r.y / TILE)))
-        e.dir = -e.dir;
-      for (int pi = 0; pi < g_playerCount; pi++) {
-        Player &pl = g_players[pi];
-        if (pl.dead || !overlap(pl.r, e.r))
-          continue;
+  if (e.r.x > g_camX - 32 && e.r.x < g_camX + GAME_W + 32) {
+    Rect er = enemyHitRect(e);
+    unsigned nearPlayers = bpPlayersNear(er);
+    for (int pi = 0; pi < g_playerCount; pi++) {
+      Player &pl = g_players[pi];
+      if (!(nearPlayers & (1u << pi)) || pl.dead ||
+          !bpOverlap(pl.r, er))
+        continue;
+      if (playerStomp(pl)) {
         e.on = false;
-        if (pl.power == P_SMALL) {
-          pl.power = P_BIG;
+        pl.vy = jumpHeld(g_playerHeld[pi]) ? -Physics::BOUNCE_HEIGHT * 1.5f
+                                           : -Physics::BOUNCE_HEIGHT;
+        pl.score += 200;
+        playSfx(SFX_STOMP);
+      } else if (!playerIsInvulnerable(pl)) {
+        if (pl.power > P_SMALL) {
+          pl.power = P_SMALL;
           pl.crouch = false;
-          setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_BIG, PLAYER_HIT_H_BIG);
-        }
-        pl.score += 1000;
-        if (g_sfxPowerup)
-          Mix_PlayChannel(-1, g_sfxPowerup, 0);
-        else if (g_sfxItemAppear)
-          Mix_PlayChannel(-1, g_sfxItemAppear, 0);
-        break;
-      }
-    } else if (e.type == E_FIRE_FLOWER) {
-      e.vy += 15.0f;
-      e.r.y += e.vy * dt;
-      int ty = (int)((e.r.y + e.r.h) / TILE);
-      int midTx = (int)((e.r.x + e.r.w * 0.5f) / TILE);
-      {
-        uint8_t col = collisionAt(midTx, ty);
-        if (col == COL_SOLID || col == COL_ONEWAY) {
-          if (col == COL_ONEWAY) {
-            float prevBottom = (e.r.y - (e.vy * dt)) + e.r.h;
-            float tileTop = ty * TILE;
-            if (prevBottom > tileTop + 0.1f)
-              col = COL_NONE;
-          }
-          if (col != COL_NONE) {
-            e.r.y = ty * TILE - e.r.h;
-            e.vy = 0;
-          }
+          setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
+          pl.invT = 2.0f;
+          playSfx(SFX_DAMAGE);
+        } else if (pi == 0) {
+          pl.dead = true;
+          pl.lives--;
+          g_state = GS_DEAD;
+          stopMusic();
+        } else {
+          pl.invT = 2.0f;
+          pl.vy = -Physics::BOUNCE_HEIGHT * 0.75f;
         }
       }
-      for (int pi = 0; pi < g_playerCount; pi++) {
-        Player &pl = g_players[pi];
-        if (pl.dead || !overlap(pl.r, e.r))
-          continue;
+      break;
+    }
+  }
+}
+
+static void updateCheepSwim(Entity &e, float dt) {
+  if (e.vx == 0.0f)
+    e.vx = 20.0f;
+  if (e.dir == 0)
+    e.dir = -1;
+
+  float bobY = e.baseY + sinf(e.timer * 2.0f) * 4.0f;
+  if (moveBody(e.r, e.dir * e.vx * dt, bobY - e.r.y).hits & CONTACT_WALL)
+    e.dir = -e.dir;
+
+  if (e.r.x < g_camX - 96 || e.r.x > g_camX + GAME_W + 96) {
+    e.on = false;
+    return;
+  }
+
+  if (e.r.x > g_camX - 32 && e.r.x < g_camX + GAME_W + 32) {
+    Rect er = enemyHitRect(e);
+    unsigned nearPlayers = bpPlayersNear(er);
+    for (int pi = 0; pi < g_playerCount; pi++) {
+      Player &pl = g_players[pi];
+      if (!(nearPlayers & (1u << pi)) || pl.dead ||
+          !bpOverlap(pl.r, er))
+        continue;
+      if (playerStomp(pl)) {
         e.on = false;
-        if (pl.power == P_SMALL) {
-          pl.power = P_BIG;
+        pl.vy = jumpHeld(g_playerHeld[pi]) ? -Physics::BOUNCE_HEIGHT * 1.5f
+                                           : -Physics::BOUNCE_HEIGHT;
+        pl.score += 200;
+        playSfx(SFX_STOMP);
+      } else if (!playerIsInvulnerable(pl)) {
+        if (pl.power > P_SMALL) {
+          pl.power = P_SMALL;
           pl.crouch = false;
-          setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_BIG, PLAYER_HIT_H_BIG);
+          setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
+          pl.invT = 2.0f;
+          playSfx(SFX_DAMAGE);
+        } else if (pi == 0) {
+          pl.dead = true;
+          pl.lives--;
+          g_state = GS_DEAD;
+          stopMusic();
         } else {
-          pl.power = P_FIRE;
-        }
-        pl.score += 1000;
-        if (g_sfxPowerup)
-          Mix_PlayChannel(-1, g_sfxPowerup, 0);
-        else if (g_sfxItemAppear)
-          Mix_PlayChannel(-1, g_sfxItemAppear, 0);
-        break;
-      }
-    } else if (e.type == E_FIREBALL) {
-      // A little faster with smaller hops for better feel.
-      const float speed = 240.0f;
-      e.r.x += e.dir * speed * dt;
-      e.vy += 420.0f * dt;
-      e.r.y += e.vy * dt;
-
-      int midTx = (int)((e.r.x + e.r.w * 0.5f) / TILE);
-      int bottomTy = (int)((e.r.y + e.r.h) / TILE);
-      {
-        uint8_t col = collisionAt(midTx, bottomTy);
-        if (col == COL_SOLID || col == COL_ONEWAY) {
-          if (col == COL_ONEWAY) {
-            float prevBottom = (e.r.y - (e.vy * dt)) + e.r.h;
-            float tileTop = bottomTy * TILE;
-            if (prevBottom > tileTop + 0.1f)
-              col = COL_NONE;
-          }
-          if (col != COL_NONE) {
-            e.r.y = bottomTy * TILE - e.r.h;
-            e.vy = -55.0f;
-          }
+          pl.invT = 2.0f;
+          pl.vy = -Physics::BOUNCE_HEIGHT * 0.75f;
         }
       }
+      break;
+    }
+  }
+}
 
-      int frontTx =
-          e.dir > 0 ? (int)((e.r.x + e.r.w) / TILE) : (int)(e.r.x / TILE);
-      int frontTy = (int)((e.r.y + e.r.h * 0.5f) / TILE);
-      if (solidAt(frontTx, frontTy)) {
-        e.on = false;
-        continue;
-      }
+static void updateCastleAxe(Entity &e, float dt) {
+  // Touching the axe ends the castle section (like SMB1 bridge axe).
+  if (g_state == GS_PLAYING && overlap(g_p.r, e.r)) {
+    e.on = false;
+    g_state = GS_WIN;
+    g_levelTimer = 0.0f;
+    if (!g_castleSfxPlayed && g_sfxBank[SFX_CASTLE_CLEAR]) {
+      playSfx(SFX_CASTLE_CLEAR);
+      g_castleSfxPlayed = true;
+    }
+  }
+}
 
-      if (e.r.x < g_camX - 64 || e.r.x > g_camX + GAME_W + 64)
-        e.on = false;
+static void updateBowser(Entity &e, float dt) {
+  // Minimal Bowser: patrol + gravity + damage on contact. Fireballs can
+  // "wear him down" to keep the section beatable even without the axe.
+  if (e.dir == 0)
+    e.dir = -1;
+  moveWalker(e, 18.0f, dt);
 
-      for (int j = 0; j < 64 && e.on; j++) {
-        Entity &t = g_ents[j];
-        if (!t.on)
-          continue;
-        if (t.type != E_GOOMBA && t.type != E_KOOPA && t.type != E_KOOPA_RED &&
-            t.type != E_BUZZY_BEETLE && t.type != E_BLOOPER &&
-            t.type != E_LAKITU && t.type != E_SPINY && t.type != E_HAMMER_BRO &&
-            t.type != E_CHEEP_LEAP && t.type != E_CHEEP_SWIM &&
-            t.type != E_BULLET_BILL && t.type != E_BOWSER)
-          continue;
-        if (!overlap(e.r, enemyHitRect(t)))
-          continue;
-        bool awardPoints = true;
-        if (t.type == E_BOWSER) {
-          t.state += 1;
-          if (t.state >= 8)
-            t.on = false;
-        } else if (t.type == E_BUZZY_BEETLE) {
-          // Classic behavior: Buzzy Beetles shrug off fireballs.
-          awardPoints = false;
+  if (e.r.x < g_camX - 128 || e.r.y > GAME_H + 96) {
+    e.on = false;
+    return;
+  }
+
+  if (e.r.x > g_camX - 64 && e.r.x < g_camX + GAME_W + 64) {
+    unsigned nearPlayers = bpPlayersNear(e.r);
+    for (int pi = 0; pi < g_playerCount; pi++) {
+      Player &pl = g_players[pi];
+      if (!(nearPlayers & (1u << pi)) || pl.dead ||
+          !bpOverlap(pl.r, e.r))
+        continue;
+      if (!playerIsInvulnerable(pl)) {
+        if (pl.power > P_SMALL) {
+          pl.power = P_SMALL;
+          pl.crouch = false;
+          setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_SMALL, PLAYER_HIT_H_SMALL);
+          pl.invT = 2.0f;
+          playSfx(SFX_DAMAGE);
+        } else if (pi == 0) {
+          pl.dead = true;
+          pl.lives--;
+          g_state = GS_DEAD;
+          stopMusic();
         } else {
-          t.on = false;
+          pl.invT = 2.0f;
+          pl.vy = -Physics::BOUNCE_HEIGHT * 0.75f;
         }
-        e.on = false;
-        if (awardPoints)
-          g_p.score += 200;
-        break;
       }
-    } else if (e.type == E_COIN_POPUP) {
-      e.vy += 400 * dt;
-      e.r.y += e.vy * dt;
-      if (e.timer > 0.5f)
-        e.on = false;
+      break;
+    }
+  }
+}
+
+static void updateMushroom(Entity &e, float dt) {
+  moveWalker(e, e.vx, dt);
+  unsigned nearPlayers = bpPlayersNear(e.r);
+  for (int pi = 0; pi < g_playerCount; pi++) {
+    Player &pl = g_players[pi];
+    if (!(nearPlayers & (1u << pi)) || pl.dead ||
+        !bpOverlap(pl.r, e.r))
+      continue;
+    e.on = false;
+    if (pl.power == P_SMALL) {
+      pl.power = P_BIG;
+      pl.crouch = false;
+      setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_BIG, PLAYER_HIT_H_BIG);
+    }
+    pl.score += 1000;
+    playSfx(SFX_POWERUP);
+    break;
+  }
+}
+
+static void updateFireFlower(Entity &e, float dt) {
+  moveWalker(e, 0.0f, dt);
+  unsigned nearPlayers = bpPlayersNear(e.r);
+  for (int pi = 0; pi < g_playerCount; pi++) {
+    Player &pl = g_players[pi];
+    if (!(nearPlayers & (1u << pi)) || pl.dead ||
+        !bpOverlap(pl.r, e.r))
+      continue;
+    e.on = false;
+    if (pl.power == P_SMALL) {
+      pl.power = P_BIG;
+      pl.crouch = false;
+      setPlayerSizePreserveFeet(pl, PLAYER_HIT_W_BIG, PLAYER_HIT_H_BIG);
+    } else {
+      pl.power = P_FIRE;
+    }
+    pl.score += 1000;
+    playSfx(SFX_POWERUP);
+    break;
+  }
+}
+
+static void updateFireball(Entity &e, float dt) {
+  // A little faster with smaller hops for better feel.
+  const float speed = 240.0f;
+  e.vy += 420.0f * dt;
+  BodyContacts c = moveBody(e.r, e.dir * speed * dt, e.vy * dt);
+  if (c.hits & CONTACT_WALL) {
+    e.on = false;
+    return;
+  }
+  if (c.hits & CONTACT_FLOOR)
+    e.vy = -55.0f;
+  else if (c.hits & CONTACT_CEILING)
+    e.vy = 0.0f;
+
+  if (e.r.x < g_camX - 64 || e.r.x > g_camX + GAME_W + 64)
+    e.on = false;
+
+  uint16_t near[BP_MAX_RESULTS];
+  int nearCount = e.on ? bpQueryEntities(e.r, near, BP_MAX_RESULTS) : 0;
+  for (int j = 0; j < nearCount && e.on; j++) {
+    Entity &t = g_ents[near[j]];
+    if (!t.on)
+      continue;
+    if (t.type != E_GOOMBA && t.type != E_KOOPA && t.type != E_KOOPA_RED &&
+        t.type != E_BUZZY_BEETLE && t.type != E_BLOOPER &&
+        t.type != E_LAKITU && t.type != E_SPINY && t.type != E_HAMMER_BRO &&
+        t.type != E_CHEEP_LEAP && t.type != E_CHEEP_SWIM &&
+        t.type != E_BULLET_BILL && t.type != E_BOWSER)
+      continue;
+    if (!bpOverlap(e.r, enemyHitRect(t)))
+      continue;
+    bool awardPoints = true;
+    if (t.type == E_BOWSER) {
+      t.state += 1;
+      if (t.state >= 8)
+        t.on = false;
+    } else if (t.type == E_BUZZY_BEETLE) {
+      // Classic behavior: Buzzy Beetles shrug off fireballs.
+      awardPoints = false;
+    } else {
+      t.on = false;
+    }
+    e.on = false;
+    if (awardPoints)
+      g_p.score += 200;
+    break;
+  }
+}
+
+static void updateCoinPopup(Entity &e, float dt) {
+  e.vy += 400 * dt;
+  e.r.y += e.vy * dt;
+  if (e.timer > 0.5f)
+    e.on = false;
+}
+
+// Runs the type-specialized update for every live entity in `pool`. Entities
+// spawned into the pool during the pass are appended and updated in it too.
+static void updateEntityPool(const EntityPool &pool, float dt) {
+  for (int k = 0; k < pool.count; k++) {
+    Entity &e = poolEntity(pool, k);
+    if (!e.on)
+      continue;
+    e.timer += dt;
+
+    switch (e.type) {
+    case E_GOOMBA:
+      updateGoomba(e, dt);
+      break;
+    case E_KOOPA:
+    case E_KOOPA_RED:
+      updateKoopa(e, dt);
+      break;
+    case E_BUZZY_BEETLE:
+      updateBuzzyBeetle(e, dt);
+      break;
+    case E_BULLET_CANNON:
+      updateBulletCannon(e, dt);
+      break;
+    case E_HAMMER_BRO:
+      updateHammerBro(e, dt);
+      break;
+    case E_HAMMER:
+      updateHammer(e, dt);
+      break;
+    case E_LAKITU:
+      updateLakitu(e, dt);
+      break;
+    case E_SPINY:
+      updateSpiny(e, dt);
+      break;
+    case E_BLOOPER:
+      updateBlooper(e, dt);
+      break;
+    case E_BULLET_BILL:
+      updateBulletBill(e, dt);
+      break;
+    case E_CHEEP_LEAP:
+      updateCheepLeap(e, dt);
+      break;
+    case E_CHEEP_SWIM:
+      updateCheepSwim(e, dt);
+      break;
+    case E_CASTLE_AXE:
+      updateCastleAxe(e, dt);
+      break;
+    case E_BOWSER:
+      updateBowser(e, dt);
+      break;
+    case E_MUSHROOM:
+      updateMushroom(e, dt);
+      break;
+    case E_FIRE_FLOWER:
+      updateFireFlower(e, dt);
+      break;
+    case E_FIREBALL:
+      updateFireball(e, dt);
+      break;
+    case E_COIN_POPUP:
+      updateCoinPopup(e, dt);
+      break;
+    default:
+      break;
     }
   }
+}
+
+void updateEntities(float dt) {
+  g_bpStats = {0, 0};
+  buildBroadphase();
+  // Pool by pool, each in listing order. Hammer Bros, Lakitus, Bloopers and
+  // friends draw from the shared rand() stream, so this order is part of the
+  // deterministic bench result: changing it moves deaths/clears even when no
+  // behavior changes.
+  for (const auto &pool : g_entityPools)
+    updateEntityPool(pool, dt);
 
   auto enemyActive = [](const Entity &e) {
     if (!e.on)
@@ -4866,15 +6799,24 @@ void updateEntities(float dt) {
     return false;
   };
 
-  for (int i = 0; i < 64; i++) {
-    Entity &a = g_ents[i];
+  if (g_bpStale)
+    buildBroadphase();
+  const EntityPool &enemies = g_entityPools[POOL_ENEMIES];
+  for (int i = 0; i < enemies.count; i++) {
+    uint16_t slotA = g_entityActive[enemies.first + i];
+    Entity &a = g_ents[slotA];
     if (!enemyActive(a))
       continue;
-    for (int j = i + 1; j < 64; j++) {
-      Entity &b = g_ents[j];
+    uint16_t near[BP_MAX_RESULTS];
+    int nearCount = bpQueryEntities(a.r, near, BP_MAX_RESULTS);
+    for (int j = 0; j < nearCount; j++) {
+      // Each pair once: only look at partners with a higher slot.
+      if (near[j] <= slotA)
+        continue;
+      Entity &b = g_ents[near[j]];
       if (!enemyActive(b))
         continue;
-      if (!overlap(enemyHitRect(a), enemyHitRect(b)))
+      if (!bpOverlap(enemyHitRect(a), enemyHitRect(b)))
         continue;
       auto isShell = [](const Entity &e) {
         if (e.type == E_KOOPA || e.type == E_KOOPA_RED)
@@ -4889,15 +6831,13 @@ void updateEntities(float dt) {
       if (aShell && !bShell) {
         b.on = false;
         g_p.score += 200;
-        if (g_sfxKick)
-          Mix_PlayChannel(-1, g_sfxKick, 0);
+        playSfx(SFX_KICK);
         continue;
       }
       if (bShell && !aShell) {
         a.on = false;
         g_p.score += 200;
-        if (g_sfxKick)
-          Mix_PlayChannel(-1, g_sfxKick, 0);
+        playSfx(SFX_KICK);
         continue;
       }
 
@@ -4907,10 +6847,108 @@ void updateEntities(float dt) {
         b.dir = -b.dir;
     }
   }
+
+  retireStreamedEnemies();
+  compactEntityPools();
+  activateEnemySpawns();
+}
+
+// Tile layer batching. drawTile() does not submit anything itself: each tile
+// appends a shadow quad and a color quad to the batch of the texture it samples
+// (a tileset, or the atlas page for coin/question blocks), and
+// flushTileBatches() sends every batch as one SDL_RenderGeometry call with its
+// shadow quads ahead of its color quads. The shadow tint is carried by vertex
+// colors, so texture color/alpha mod is never touched. Untextured fallback
+// tiles go into a nullptr batch.
+constexpr int TILE_BATCH_MAX = 8;
+
+struct TileBatch {
+  SDL_Texture *tex = nullptr;
+  float invW = 1.0f;
+  float invH = 1.0f;
+  std::vector<SDL_Vertex> shadow;
+  std::vector<SDL_Vertex> color;
+};
+
+static TileBatch g_tileBatches[TILE_BATCH_MAX];
+static int g_tileBatchCount = 0;
+
+static void flushTileBatches() {
+  for (int i = 0; i < g_tileBatchCount; i++) {
+    TileBatch &b = g_tileBatches[i];
+    b.shadow.insert(b.shadow.end(), b.color.begin(), b.color.end());
+    int quads = (int)b.shadow.size() / 4;
+    if (quads > 0)
+      rqGeometry(b.tex, b.shadow.data(), quads * 4, quadIndices(quads),
+                 quads * 6);
+    b.shadow.clear();
+    b.color.clear();
+  }
+  g_tileBatchCount = 0;
+}
+
+static TileBatch &tileBatchFor(SDL_Texture *tex) {
+  for (int i = 0; i < g_tileBatchCount; i++) {
+    if (g_tileBatches[i].tex == tex)
+      return g_tileBatches[i];
+  }
+  if (g_tileBatchCount == TILE_BATCH_MAX)
+    flushTileBatches();
+  TileBatch &b = g_tileBatches[g_tileBatchCount++];
+  b.tex = tex;
+  b.invW = 1.0f;
+  b.invH = 1.0f;
+  int w = 0, h = 0;
+  if (rqTextureInfo(tex, &w, &h) && w > 0 && h > 0) {
+    b.invW = 1.0f / (float)w;
+    b.invH = 1.0f / (float)h;
+  }
+  return b;
+}
+
+static void pushTileQuad(std::vector<SDL_Vertex> &out, const TileBatch &b,
+                         const SDL_Rect &src, int x, int y, int w, int h,
+                         SDL_Color c) {
+  float x0 = (float)x, y0 = (float)y;
+  float x1 = (float)(x + w), y1 = (float)(y + h);
+  float u0 = src.x * b.invW, v0 = src.y * b.invH;
+  float u1 = (src.x + src.w) * b.invW, v1 = (src.y + src.h) * b.invH;
+  out.push_back({{x0, y0}, c, {u0, v0}});
+  out.push_back({{x1, y0}, c, {u1, v0}});
+  out.push_back({{x0, y1}, c, {u0, v1}});
+  out.push_back({{x1, y1}, c, {u1, v1}});
+}
+
+// Batched counterpart of renderCopyWithShadow() for the tile layer.
+static void batchTileWithShadow(SDL_Texture *tex, const SDL_Rect &src,
+                                const SDL_Rect &dst) {
+  if (!tex)
+    return;
+  TileBatch &b = tileBatchFor(tex);
+  if (g_spriteShadows)
+    pushTileQuad(b.shadow, b, src, dst.x + SPRITE_SHADOW_OFS,
+                 dst.y + SPRITE_SHADOW_OFS, dst.w, dst.h,
+                 {0, 0, 0, SPRITE_SHADOW_ALPHA});
+  pushTileQuad(b.color, b, src, dst.x, dst.y, dst.w, dst.h,
+               {255, 255, 255, 255});
+}
+
+static void batchTileWithShadow(const Sprite &spr, const SDL_Rect &src,
+                                const SDL_Rect &dst) {
+  SDL_Rect s, d;
+  if (spriteRects(spr, &src, &dst, s, d))
+    batchTileWithShadow(spr.tex, s, d);
+}
+
+static void batchTileFill(const SDL_Rect &dst, SDL_Color c) {
+  TileBatch &b = tileBatchFor(nullptr);
+  pushTileQuad(b.color, b, {0, 0, 0, 0}, dst.x, dst.y, dst.w, dst.h, c);
 }
 
-void drawTile(int tx, int ty, uint8_t tile) {
-  int x = tx * TILE - (int)g_camX;
+// Draws one tile into the current tile batches, at screen x = tx * TILE -
+// originX (the camera, or a cache chunk's left edge).
+void drawTile(int tx, int ty, uint8_t tile, int originX) {
+  int x = tx * TILE - originX;
   if (x < -TILE || x > GAME_W)
     return;
   SDL_Rect dst = {x, ty * TILE, TILE, TILE};
@@ -4931,29 +6969,28 @@ void drawTile(int tx, int ty, uint8_t tile) {
   }
 
   if (tile == T_COIN) {
-    if (g_texCoin) {
+    if (g_sprCoin) {
       // Frame 0 of SpinningCoin.png is a solid green placeholder in the current
       // asset set, so skip it.
       int frame = 1 + ((SDL_GetTicks() / 120) % 3);
       SDL_Rect src = {frame * 16, 0, 16, 16};
-      renderCopyWithShadow(g_texCoin, &src, &dst);
+      batchTileWithShadow(g_sprCoin, src, dst);
     } else {
-      SDL_SetRenderDrawColor(g_ren, 255, 200, 0, 255);
-      SDL_RenderFillRect(g_ren, &dst);
+      batchTileFill(dst, {255, 200, 0, 255});
     }
     return;
   }
 
-  if (tile == T_QUESTION && g_texQuestion) {
+  if (tile == T_QUESTION && g_sprQuestion) {
     int frame = ((SDL_GetTicks() / 200) % 3);
     SDL_Rect src = {frame * 16, questionRowForTheme(g_theme), 16, 16};
-    renderCopyWithShadow(g_texQuestion, &src, &dst);
+    batchTileWithShadow(g_sprQuestion, src, dst);
     return;
   }
-  if (tile == T_USED && g_texQuestion) {
+  if (tile == T_USED && g_sprQuestion) {
     // Use the dedicated "used" tile (check-mark) in the QuestionBlock sheet.
     SDL_Rect src = {2 * 16, questionRowForTheme(g_theme), 16, 16};
-    renderCopyWithShadow(g_texQuestion, &src, &dst);
+    batchTileWithShadow(g_sprQuestion, src, dst);
     return;
   }
 
@@ -4971,7 +7008,7 @@ void drawTile(int tx, int ty, uint8_t tile) {
       else if (at == ATLAS_LIQUID)
         atlasTex = g_texLiquids ? g_texLiquids : g_texTerrain;
       if (atlasTex)
-        renderCopyWithShadow(atlasTex, &src, &dst);
+        batchTileWithShadow(atlasTex, src, dst);
       return;
     }
 
@@ -5013,117 +7050,366 @@ void drawTile(int tx, int ty, uint8_t tile) {
       break;
     }
     if (use) {
-      renderCopyWithShadow(g_texTerrain, &src, &dst);
+      batchTileWithShadow(g_texTerrain, src, dst);
       return;
     }
   }
 
+  SDL_Color fill;
   switch (tile) {
   case T_GROUND:
-    SDL_SetRenderDrawColor(g_ren, 200, 76, 12, 255);
+    fill = {200, 76, 12, 255};
     break;
   case T_BRICK:
-    SDL_SetRenderDrawColor(g_ren, 180, 80, 20, 255);
+    fill = {180, 80, 20, 255};
     break;
   case T_USED:
-    SDL_SetRenderDrawColor(g_ren, 180, 80, 20, 255);
+    fill = {180, 80, 20, 255};
     break;
   case T_QUESTION:
-    SDL_SetRenderDrawColor(g_ren, tile == T_QUESTION ? 252 : 120,
-                           tile == T_QUESTION ? 184 : 76, 0, 255);
+    fill = {252, 184, 0, 255};
     break;
   case T_PIPE:
-    SDL_SetRenderDrawColor(g_ren, 0, 168, 0, 255);
+    fill = {0, 168, 0, 255};
     break;
   case T_FLAG:
-    SDL_SetRenderDrawColor(g_ren, 100, 100, 100, 255);
+    fill = {100, 100, 100, 255};
     break;
   case T_CASTLE:
-    SDL_SetRenderDrawColor(g_ren, 100, 100, 100, 255);
+    fill = {100, 100, 100, 255};
     break;
   case T_COIN:
-    SDL_SetRenderDrawColor(g_ren, 255, 200, 0, 255);
+    fill = {255, 200, 0, 255};
     break;
   default:
     return;
   }
-  SDL_RenderFillRect(g_ren, &dst);
+  batchTileFill(dst, fill);
+}
 
+// Static tile-layer cache. The map is split into TILE_CHUNK_W-wide columns;
+// each one the camera approaches is rendered once (deco pass, then gameplay
+// pass, through the tile batches) into a render-target texture, and every
+// frame the visible chunks are drawn as plain blits. Animated tiles (coins,
+// `?` blocks) and tiles with an active bump are left out of the texture and
+// recorded in the chunk's dynamic list, which is drawn on top each frame.
+// Chunks are rebuilt only when invalidateTileChunkAt() hits them (setMapTile,
+// bump start/end), or all at once when the section, tileset or render targets
+// change. If render targets are unavailable the layer is drawn directly.
+constexpr int TILE_CHUNK_TILES = 16;
+constexpr int TILE_CHUNK_W = TILE_CHUNK_TILES * TILE;
+// Visible span plus one chunk of lookahead on each side.
+constexpr int TILE_CHUNK_SLOTS = GAME_W / TILE_CHUNK_W + 2 + 2;
+
+struct TileChunk {
+  SDL_Texture *tex = nullptr;
+  int index = -1; // chunk column, -1 = slot unused
+  bool valid = false;
+  // Packed (deco << 15 | ty << 10 | tx - firstTx) for tiles drawn per frame.
+  std::vector<uint16_t> dynamic;
+};
+
+static TileChunk g_tileChunks[TILE_CHUNK_SLOTS];
+static bool g_tileCacheDisabled = false;
+static int g_tileChunkBuilds = 0;
+
+static void invalidateTileCache() {
+  for (auto &c : g_tileChunks)
+    c.valid = false;
 }
 
-static bool computeCastleDst(SDL_Rect &outMainDst, SDL_Rect &outOverlayDst) {
-  if (!g_texCastle)
+static void invalidateTileChunkAt(int tx) {
+  if (tx < 0)
+    return;
+  int idx = tx / TILE_CHUNK_TILES;
+  // The last column's shadow spills into the next chunk.
+  bool spill = (tx % TILE_CHUNK_TILES) == TILE_CHUNK_TILES - 1;
+  for (auto &c : g_tileChunks) {
+    if (c.index == idx || (spill && c.index == idx + 1))
+      c.valid = false;
+  }
+}
+
+// SDL_RENDER_DEVICE_RESET loses the textures themselves; they are recreated on
+// the next build.
+static void dropTileCacheTextures() {
+  for (auto &c : g_tileChunks) {
+    if (c.tex)
+      rqDestroyTexture(c.tex);
+    c.tex = nullptr;
+    c.index = -1;
+    c.valid = false;
+  }
+}
+
+static bool tileBumpActive(int tx, int ty) {
+  for (auto &b : g_tileBumps) {
+    if (b.t > 0.0f && b.tx == tx && b.ty == ty)
+      return true;
+  }
+  return false;
+}
+
+static bool tileIsDynamic(int tx, int ty, uint8_t tile) {
+  if (tile == T_COIN || (tile == T_QUESTION && g_sprQuestion))
+    return true;
+  return tileBumpActive(tx, ty);
+}
+
+static bool isDecoTile(int tx, int ty) {
+  if (!g_levelInfo.atlasT || !g_levelInfo.atlasX || !g_levelInfo.atlasY)
     return false;
-  int minX = mapWidth();
-  int maxY = -1;
-  for (int y = 0; y < MAP_H; y++) {
-    for (int x = 0; x < mapWidth(); x++) {
-      if (g_map[y][x] == T_CASTLE) {
-        if (x < minX)
-          minX = x;
-        if (y > maxY)
-          maxY = y;
+  if (g_levelInfo.atlasX[ty][tx] == 255 || g_levelInfo.atlasY[ty][tx] == 255)
+    return false;
+  return g_levelInfo.atlasT[ty][tx] == ATLAS_DECO;
+}
+
+static bool buildTileChunk(TileChunk &c, int index) {
+  int h = MAP_H * TILE;
+  if (!c.tex) {
+    c.tex = rqCreateTexture(SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                            TILE_CHUNK_W, h, SDL_BLENDMODE_BLEND);
+    if (!c.tex)
+      return false;
+  }
+  SDL_Texture *prevTarget = rqTarget();
+  if (rqSetTarget(c.tex) != 0)
+    return false;
+  rqSetDrawColor(0, 0, 0, 0);
+  rqClear();
+
+  int firstTx = index * TILE_CHUNK_TILES;
+  int originX = firstTx * TILE;
+  c.dynamic.clear();
+  for (int pass = 0; pass < 2; pass++) {
+    bool decoPass = (pass == 0);
+    for (int ty = 0; ty < MAP_H; ty++) {
+      // Start one column early so the left neighbour's shadow lands here too.
+      for (int tx = firstTx - 1; tx < firstTx + TILE_CHUNK_TILES; tx++) {
+        if (tx < 0 || tx >= mapWidth())
+          continue;
+        if (decoPass != isDecoTile(tx, ty))
+          continue;
+        uint8_t tile = g_map[ty][tx];
+        if (tileIsDynamic(tx, ty, tile)) {
+          if (tx >= firstTx)
+            c.dynamic.push_back(
+                (uint16_t)((pass << 15) | (ty << 10) | (tx - firstTx)));
+          continue;
+        }
+        drawTile(tx, ty, tile, originX);
       }
     }
+    flushTileBatches();
   }
-  if (maxY < 0 || minX >= mapWidth())
-    return false;
-  int texW = 0, texH = 0;
-  SDL_QueryTexture(g_texCastle, nullptr, nullptr, &texW, &texH);
 
-  // Determine the ground line under the castle by scanning for the *surface*
-  // collision (ignore T_CASTLE marker tiles, which may be stamped in the map).
-  int castleTilesW = (texW + TILE - 1) / TILE;
-  int surfaceTy = -1;
-  for (int x = minX; x < minX + castleTilesW && x < mapWidth(); x++) {
-    for (int y = MAP_H - 1; y >= 0; y--) {
-      if (g_map[y][x] == T_CASTLE)
-        continue;
-      uint8_t col = collisionAt(x, y);
-      if (!(col == COL_SOLID || col == COL_ONEWAY))
+  rqSetTarget(prevTarget);
+  c.index = index;
+  c.valid = true;
+  g_tileChunkBuilds++;
+  return true;
+}
+
+// Returns the slot caching chunk `index`, or recycles an unused slot / the one
+// farthest outside [firstVisible, lastVisible] for it.
+static TileChunk *tileChunkSlot(int index, int firstVisible, int lastVisible) {
+  TileChunk *victim = nullptr;
+  int victimDist = 0;
+  for (auto &c : g_tileChunks) {
+    if (c.index == index)
+      return &c;
+    int dist = 1 << 30;
+    if (c.index >= 0)
+      dist = c.index < firstVisible ? firstVisible - c.index
+                                    : c.index - lastVisible;
+    if (dist > victimDist) {
+      victim = &c;
+      victimDist = dist;
+    }
+  }
+  if (victim) {
+    victim->index = -1;
+    victim->valid = false;
+  }
+  return victim;
+}
+
+// Draws the tile layer from cached chunks. Returns false if the cache can't be
+// used, in which case the caller draws the tiles directly.
+static bool renderCachedTileLayer() {
+  if (g_tileCacheDisabled)
+    return false;
+  if (!rqTargetSupported()) {
+    g_tileCacheDisabled = true;
+    return false;
+  }
+  int camX = (int)g_camX;
+  int chunkCount = (mapWidth() + TILE_CHUNK_TILES - 1) / TILE_CHUNK_TILES;
+  int firstVisible = std::max(0, camX / TILE_CHUNK_W);
+  int lastVisible =
+      std::min(chunkCount - 1, (camX + GAME_W - 1) / TILE_CHUNK_W);
+
+  TileChunk *visible[TILE_CHUNK_SLOTS] = {};
+  int visibleCount = 0;
+  bool built = false;
+  for (int i = firstVisible; i <= lastVisible; i++) {
+    TileChunk *c = tileChunkSlot(i, firstVisible, lastVisible);
+    if (!c)
+      return false;
+    if (!c->valid) {
+      if (!buildTileChunk(*c, i)) {
+        g_tileCacheDisabled = true;
+        return false;
+      }
+      built = true;
+    }
+    visible[visibleCount++] = c;
+  }
+  // Warm at most one neighbour per frame, and only on frames that didn't
+  // already have to build a visible chunk.
+  if (!built) {
+    for (int i : {lastVisible + 1, firstVisible - 1}) {
+      if (i < 0 || i >= chunkCount)
         continue;
-      uint8_t above = (y > 0) ? collisionAt(x, y - 1) : COL_NONE;
-      if (above == COL_NONE) {
-        if (surfaceTy < 0 || y < surfaceTy)
-          surfaceTy = y;
+      TileChunk *c = tileChunkSlot(i, firstVisible - 1, lastVisible + 1);
+      if (c && !c->valid) {
+        if (!buildTileChunk(*c, i)) {
+          g_tileCacheDisabled = true;
+          return false;
+        }
+        break;
       }
-      // Keep scanning upward in case this column has thick ground.
     }
   }
-  if (surfaceTy < 0)
-    surfaceTy = maxY;
-  // The castle/overlay art is authored to sit *on* the ground tiles. The
-  // surface tile we find here is the first solid tile; align the sprite to the
-  // top of that tile and then lift by one tile to match the reference.
-  int groundY = surfaceTy * TILE;
-  groundY -= TILE;
-  if (groundY < 0)
-    groundY = 0;
-
-  // EndingCastleSprite.png layout:
-  // - Main castle sprite in the top 80px (y=0..79).
-  // - A separate "front overlay" piece in the bottom 40px (y=120..159),
-  //   positioned on the right half of the texture, used to hide the player as
-  //   they enter the door.
-  constexpr int kCastleMainH = 80;
-  constexpr int kOverlayY = 120;
-  constexpr int kOverlayX = 32;
 
-  int mainH = (texH < kCastleMainH) ? texH : kCastleMainH;
-  outMainDst = {minX * TILE - (int)g_camX, groundY - mainH, texW, mainH};
+  int h = MAP_H * TILE;
+  for (int i = 0; i < visibleCount; i++) {
+    SDL_Rect dst = {visible[i]->index * TILE_CHUNK_W - camX, 0, TILE_CHUNK_W,
+                    h};
+    rqCopy(visible[i]->tex, nullptr, &dst);
+  }
+  for (int pass = 0; pass < 2; pass++) {
+    for (int i = 0; i < visibleCount; i++) {
+      int firstTx = visible[i]->index * TILE_CHUNK_TILES;
+      for (uint16_t d : visible[i]->dynamic) {
+        if ((d >> 15) != pass)
+          continue;
+        int ty = (d >> 10) & 31;
+        int tx = firstTx + (d & 1023);
+        drawTile(tx, ty, g_map[ty][tx], camX);
+      }
+    }
+    flushTileBatches();
+  }
+  return true;
+}
 
-  int overlayH = (texH > kOverlayY) ? (texH - kOverlayY) : 0;
-  int overlayW = (texW > kOverlayX) ? (texW - kOverlayX) : 0;
-  outOverlayDst = {outMainDst.x + kOverlayX, groundY - overlayH, overlayW,
-                   overlayH};
+static bool computeCastleDst(SDL_Rect &outMainDst, SDL_Rect &outOverlayDst) {
+  if (!g_bake.castleOn)
+    return false;
+  outMainDst = g_bake.castleMain;
+  outMainDst.x -= (int)g_camX;
+  outOverlayDst = g_bake.castleOverlay;
+  outOverlayDst.x -= (int)g_camX;
   return true;
 }
 
+// Position between the previous and current sim step. Big jumps (spawns, pipe
+// warps, respawns, section loads) snap instead of sweeping across the screen.
+static float lerpRenderPos(float prev, float cur) {
+  if (fabsf(cur - prev) > 48.0f)
+    return cur;
+  return prev + (cur - prev) * g_renderAlpha;
+}
+
+// Debug overlay profiler: one stacked bar per frame (newest on the right,
+// 2px per ms) with a line at the 60Hz budget, and zone averages beside it.
+static std::vector<SDL_Vertex> g_profGraphVerts;
+
+static void pushProfQuad(float x, float y, float w, float h, SDL_Color c) {
+  g_profGraphVerts.push_back({{x, y}, c, {0, 0}});
+  g_profGraphVerts.push_back({{x + w, y}, c, {0, 0}});
+  g_profGraphVerts.push_back({{x, y + h}, c, {0, 0}});
+  g_profGraphVerts.push_back({{x + w, y + h}, c, {0, 0}});
+}
+
+static void drawProfilerGraph() {
+  static ProfFrame frames[PROF_HISTORY];
+  int n = profCopyHistory(frames, PROF_HISTORY);
+  constexpr int kGraphW = PROF_HISTORY - 1;
+  constexpr float kGraphH = 64.0f;
+  constexpr float kPxPerUs = 2.0f / 1000.0f;
+  const float left = 4.0f, base = (float)GAME_H - 4.0f;
+
+  g_profGraphVerts.clear();
+  pushProfQuad(left - 2, base - kGraphH - 2, kGraphW + 4, kGraphH + 4,
+               {0, 0, 0, 160});
+  uint64_t sumUs[PROF_ZONE_COUNT] = {};
+  uint64_t sumFrameUs = 0;
+  for (int i = 0; i < n; i++) {
+    float x = left + (float)(kGraphW - n + i);
+    float y = base;
+    for (int z = 0; z < PROF_ZONE_COUNT; z++) {
+      sumUs[z] += frames[i].zoneUs[z];
+      float h = frames[i].zoneUs[z] * kPxPerUs;
+      if (y - h < base - kGraphH)
+        h = y - (base - kGraphH);
+      if (h <= 0.0f)
+        continue;
+      ProfColor c = profZoneColor((ProfZone)z);
+      y -= h;
+      pushProfQuad(x, y, 1.0f, h, {c.r, c.g, c.b, 255});
+    }
+    sumFrameUs += frames[i].frameUs;
+  }
+  pushProfQuad(left, base - 16667.0f * kPxPerUs, kGraphW, 1.0f,
+               {255, 0, 0, 255});
+
+  float legendX = left + kGraphW + 8;
+  float legendY = base - 12 * 9;
+  for (int z = 0; z < PROF_ZONE_COUNT; z++) {
+    ProfColor c = profZoneColor((ProfZone)z);
+    pushProfQuad(legendX, legendY + (z + 1) * 9 + 1, 5, 5, {c.r, c.g, c.b, 255});
+  }
+  int quads = (int)g_profGraphVerts.size() / 4;
+  rqSetDrawBlendMode(SDL_BLENDMODE_BLEND);
+  rqGeometry(nullptr, g_profGraphVerts.data(), quads * 4, quadIndices(quads),
+             quads * 6);
+  rqSetDrawBlendMode(SDL_BLENDMODE_NONE);
+
+  char buf[32];
+  int div = n > 0 ? n : 1;
+  snprintf(buf, sizeof(buf), "FRAME %.1f", sumFrameUs / 1000.0 / div);
+  drawTextShadow((int)legendX + 7, (int)legendY, buf, 1, {255, 255, 255, 255});
+  for (int z = 0; z < PROF_ZONE_COUNT; z++) {
+    snprintf(buf, sizeof(buf), "%s %.1f", profZoneName((ProfZone)z),
+             sumUs[z] / 1000.0 / div);
+    drawTextShadow((int)legendX + 7, (int)(legendY + (z + 1) * 9), buf, 1,
+                   {255, 255, 255, 255});
+  }
+  if (g_profDumpResult != 0)
+    drawTextShadow((int)left, (int)(base - kGraphH - 12),
+                   g_profDumpResult > 0 ? "CSV SAVED" : "CSV FAILED", 1,
+                   {255, 255, 0, 255});
+}
+
+static void renderFrame();
+
 void render() {
+  // Draw with the blended camera, then restore the simulated one so gameplay
+  // code never observes the interpolated value.
+  float simCamX = g_camX;
+  g_camX = lerpRenderPos(g_camPrevX, g_camX);
+  renderFrame();
+  g_camX = simCamX;
+}
+
+static void renderFrame() {
+  ProfScope prof(PROF_RENDER_BG);
   if (g_state == GS_TITLE) {
     // Sky backdrop.
-    SDL_SetRenderDrawColor(g_ren, 92, 148, 252, 255);
-    SDL_RenderClear(g_ren);
+    rqSetDrawColor(92, 148, 252, 255);
+    rqClear();
 
     // Decorative background layers.
     {
@@ -5132,7 +7418,7 @@ void render() {
         SDL_Rect dst = {0, 0, 512, GAME_H};
         for (int x = dst.x; x < GAME_W; x += 512) {
           SDL_Rect d = {x, dst.y, dst.w, dst.h};
-          SDL_RenderCopy(g_ren, g_texBgSky, &src, &d);
+          rqCopy(g_texBgSky, &src, &d);
         }
       }
       int y = GAME_H - 64;
@@ -5141,7 +7427,7 @@ void render() {
         SDL_Rect dst = {0, y - 32, 512, 96};
         for (int x = dst.x; x < GAME_W; x += 512) {
           SDL_Rect d = {x, dst.y, dst.w, dst.h};
-          SDL_RenderCopy(g_ren, g_texBgHills, &src, &d);
+          rqCopy(g_texBgHills, &src, &d);
         }
       }
       if (g_texBgBushes) {
@@ -5149,18 +7435,18 @@ void render() {
         SDL_Rect dst = {0, y, 512, 64};
         for (int x = dst.x; x < GAME_W; x += 512) {
           SDL_Rect d = {x, dst.y, dst.w, dst.h};
-          SDL_RenderCopy(g_ren, g_texBgBushes, &src, &d);
+          rqCopy(g_texBgBushes, &src, &d);
         }
       }
       if (g_texBgCloudOverlay) {
-        SDL_SetTextureAlphaMod(g_texBgCloudOverlay, 200);
+        setTextureFade(g_texBgCloudOverlay, 200);
         SDL_Rect src = {0, 0, 512, 512};
         SDL_Rect dst = {0, -40, 512, 512};
         for (int x = dst.x; x < GAME_W; x += 512) {
           SDL_Rect d = {x, dst.y, dst.w, dst.h};
-          SDL_RenderCopy(g_ren, g_texBgCloudOverlay, &src, &d);
+          rqCopy(g_texBgCloudOverlay, &src, &d);
         }
-        SDL_SetTextureAlphaMod(g_texBgCloudOverlay, 255);
+        setTextureFade(g_texBgCloudOverlay, 255);
       }
     }
 
@@ -5174,8 +7460,8 @@ void render() {
           if (g_texTerrain)
             renderCopyWithShadow(g_texTerrain, &src, &dst);
           else {
-            SDL_SetRenderDrawColor(g_ren, 200, 76, 12, 255);
-            SDL_RenderFillRect(g_ren, &dst);
+            rqSetDrawColor(200, 76, 12, 255);
+            rqFillRect(&dst);
           }
         }
       }
@@ -5183,12 +7469,12 @@ void render() {
 
     // Title banner.
     // Title2.png is a 3x7 grid of 176x40 "REMSTERED" variants; render one cell.
-    if (g_texTitle) {
+    if (g_sprTitle) {
       SDL_Rect src = {0, 0, 176, 40};
       int w = 320;
       int h = (w * src.h) / src.w;
       SDL_Rect dst = {(GAME_W - w) / 2, 18, w, h};
-      SDL_RenderCopy(g_ren, g_texTitle, &src, &dst);
+      drawSprite(g_sprTitle, &src, &dst);
     }
 
     if (g_titleMode == TITLE_MAIN) {
@@ -5201,20 +7487,20 @@ void render() {
         int x = (GAME_W - textWidth(items[i], 2)) / 2;
         int y = baseY + i * 20;
         drawTextShadow(x, y, items[i], 2, c);
-        if (i == g_mainMenuIndex && g_texMushroom) {
+        if (i == g_mainMenuIndex && g_sprMushroom) {
           SDL_Rect src = {0, 0, 16, 16};
           SDL_Rect dst = {x - 26, y + 2, 16, 16};
-          renderCopyWithShadow(g_texMushroom, &src, &dst);
+          renderCopyWithShadow(g_sprMushroom, &src, &dst);
         }
       }
       drawTextShadow(8, GAME_H - 18, "V1.0.1", 1, {255, 255, 255, 255});
     } else if (g_titleMode == TITLE_CHAR_SELECT) {
-      SDL_SetRenderDrawBlendMode(g_ren, SDL_BLENDMODE_BLEND);
-      SDL_SetRenderDrawColor(g_ren, 0, 0, 0, 170);
+      rqSetDrawBlendMode(SDL_BLENDMODE_BLEND);
+      rqSetDrawColor(0, 0, 0, 170);
       SDL_Rect panel = {24, 82, GAME_W - 48, 108};
-      SDL_RenderFillRect(g_ren, &panel);
-      SDL_SetRenderDrawColor(g_ren, 255, 255, 255, 255);
-      SDL_RenderDrawRect(g_ren, &panel);
+      rqFillRect(&panel);
+      rqSetDrawColor(255, 255, 255, 255);
+      rqDrawRect(&panel);
 
       const char *selText = "SELECT CHARACTER";
       drawTextShadow((GAME_W - textWidth(selText, 2)) / 2, 90, selText, 2,
@@ -5229,15 +7515,15 @@ void render() {
         SDL_Rect dst = {x + (24 - iconW) / 2, y + (24 - iconH) / 2, iconW,
                         iconH};
         SDL_Rect src = {0, 0, 16, 16};
-        if (g_texPlayerSmall[i])
-          renderCopyWithShadow(g_texPlayerSmall[i], &src, &dst);
+        if (g_sprPlayerSmall[i])
+          renderCopyWithShadow(g_sprPlayerSmall[i], &src, &dst);
 
         SDL_Rect box = {x - 6, y - 6, 36, 36};
-        SDL_SetRenderDrawColor(g_ren, 255, 255, 255, 255);
+        rqSetDrawColor(255, 255, 255, 255);
         if (i == g_menuIndex) {
-          SDL_RenderDrawRect(g_ren, &box);
+          rqDrawRect(&box);
           SDL_Rect inner = {box.x + 2, box.y + 2, box.w - 4, box.h - 4};
-          SDL_RenderDrawRect(g_ren, &inner);
+          rqDrawRect(&inner);
         }
       }
 
@@ -5250,14 +7536,14 @@ void render() {
                      {220, 220, 220, 255});
       drawTextShadow((GAME_W - textWidth("Y OPTIONS", 1)) / 2, y + 86,
                      "Y OPTIONS", 1, {220, 220, 220, 255});
-      SDL_SetRenderDrawBlendMode(g_ren, SDL_BLENDMODE_NONE);
+      rqSetDrawBlendMode(SDL_BLENDMODE_NONE);
     } else if (g_titleMode == TITLE_MULTI_SELECT) {
-      SDL_SetRenderDrawBlendMode(g_ren, SDL_BLENDMODE_BLEND);
-      SDL_SetRenderDrawColor(g_ren, 0, 0, 0, 170);
+      rqSetDrawBlendMode(SDL_BLENDMODE_BLEND);
+      rqSetDrawColor(0, 0, 0, 170);
       SDL_Rect panel = {20, 64, GAME_W - 40, 140};
-      SDL_RenderFillRect(g_ren, &panel);
-      SDL_SetRenderDrawColor(g_ren, 255, 255, 255, 255);
-      SDL_RenderDrawRect(g_ren, &panel);
+      rqFillRect(&panel);
+      rqSetDrawColor(255, 255, 255, 255);
+      rqDrawRect(&panel);
 
       const char *selText = "SELECT PLAYERS";
       drawTextShadow((GAME_W - textWidth(selText, 2)) / 2, 72, selText, 2,
@@ -5281,13 +7567,13 @@ void render() {
         int ci = g_playerMenuIndex[i] % g_charCount;
         SDL_Rect src = {0, 0, 16, 16};
         SDL_Rect dst = {x + 18, baseY + 10, 32, 32};
-        if (g_texPlayerSmall[ci])
-          renderCopyWithShadow(g_texPlayerSmall[ci], &src, &dst);
+        if (g_sprPlayerSmall[ci])
+          renderCopyWithShadow(g_sprPlayerSmall[ci], &src, &dst);
 
         SDL_Rect box = {x + 10, baseY + 2, 48, 48};
-        SDL_SetRenderDrawColor(g_ren, slotCols[i].r, slotCols[i].g,
+        rqSetDrawColor(slotCols[i].r, slotCols[i].g,
                                slotCols[i].b, 255);
-        SDL_RenderDrawRect(g_ren, &box);
+        rqDrawRect(&box);
 
         const char *name = g_charDisplayNames[ci];
         drawTextShadow(x + (slotW - textWidth(name, 1)) / 2, baseY + 56, name,
@@ -5306,14 +7592,14 @@ void render() {
       drawTextShadow((GAME_W - textWidth("P2-4: 2 READY  1 BACK", 1)) / 2,
                      panel.y + panel.h - 10, "P2-4: 2 READY  1 BACK", 1,
                      {220, 220, 220, 255});
-      SDL_SetRenderDrawBlendMode(g_ren, SDL_BLENDMODE_NONE);
+      rqSetDrawBlendMode(SDL_BLENDMODE_NONE);
     } else if (g_titleMode == TITLE_OPTIONS) {
-      SDL_SetRenderDrawBlendMode(g_ren, SDL_BLENDMODE_BLEND);
-      SDL_SetRenderDrawColor(g_ren, 0, 0, 0, 190);
+      rqSetDrawBlendMode(SDL_BLENDMODE_BLEND);
+      rqSetDrawColor(0, 0, 0, 190);
       SDL_Rect oPanel = {52, 58, GAME_W - 104, 146};
-      SDL_RenderFillRect(g_ren, &oPanel);
-      SDL_SetRenderDrawColor(g_ren, 255, 255, 255, 255);
-      SDL_RenderDrawRect(g_ren, &oPanel);
+      rqFillRect(&oPanel);
+      rqSetDrawColor(255, 255, 255, 255);
+      rqDrawRect(&oPanel);
 
       const char *title = "SETTINGS";
       drawTextShadow((GAME_W - textWidth(title, 2)) / 2, 66, title, 2,
@@ -5335,17 +7621,20 @@ void render() {
       SDL_Color camCol = forcedBacktrack ? SDL_Color{160, 160, 160, 255}
                                          : (g_optionsIndex == 2 ? hi : norm);
       drawTextShadow(70, baseY + 32, line3, 1, camCol);
-      drawTextShadow(70, baseY + 48, "CHEATS", 1,
+      drawTextShadow(70, baseY + 48,
+                     g_spriteShadows ? "SHADOWS: ON" : "SHADOWS: OFF", 1,
                      g_optionsIndex == 3 ? hi : norm);
-      drawTextShadow(70, baseY + 72, "B BACK", 1, {220, 220, 220, 255});
-      SDL_SetRenderDrawBlendMode(g_ren, SDL_BLENDMODE_NONE);
+      drawTextShadow(70, baseY + 64, "CHEATS", 1,
+                     g_optionsIndex == 4 ? hi : norm);
+      drawTextShadow(70, baseY + 88, "B BACK", 1, {220, 220, 220, 255});
+      rqSetDrawBlendMode(SDL_BLENDMODE_NONE);
     } else if (g_titleMode == TITLE_CHEATS) {
-      SDL_SetRenderDrawBlendMode(g_ren, SDL_BLENDMODE_BLEND);
-      SDL_SetRenderDrawColor(g_ren, 0, 0, 0, 190);
+      rqSetDrawBlendMode(SDL_BLENDMODE_BLEND);
+      rqSetDrawColor(0, 0, 0, 190);
       SDL_Rect cPanel = {52, 58, GAME_W - 104, 146};
-      SDL_RenderFillRect(g_ren, &cPanel);
-      SDL_SetRenderDrawColor(g_ren, 255, 255, 255, 255);
-      SDL_RenderDrawRect(g_ren, &cPanel);
+      rqFillRect(&cPanel);
+      rqSetDrawColor(255, 255, 255, 255);
+      rqDrawRect(&cPanel);
 
       const char *title = "CHEATS";
       drawTextShadow((GAME_W - textWidth(title, 2)) / 2, 66, title, 2,
@@ -5362,40 +7651,41 @@ void render() {
       drawTextShadow(70, baseY + 40, "NOTE: PITS STILL KILL", 1,
                      {200, 200, 200, 255});
       drawTextShadow(70, baseY + 72, "B BACK", 1, {220, 220, 220, 255});
-      SDL_SetRenderDrawBlendMode(g_ren, SDL_BLENDMODE_NONE);
+      rqSetDrawBlendMode(SDL_BLENDMODE_NONE);
     } else if (g_titleMode == TITLE_EXTRAS) {
-      SDL_SetRenderDrawBlendMode(g_ren, SDL_BLENDMODE_BLEND);
-      SDL_SetRenderDrawColor(g_ren, 0, 0, 0, 190);
+      rqSetDrawBlendMode(SDL_BLENDMODE_BLEND);
+      rqSetDrawColor(0, 0, 0, 190);
       SDL_Rect ePanel = {52, 70, GAME_W - 104, 110};
-      SDL_RenderFillRect(g_ren, &ePanel);
-      SDL_SetRenderDrawColor(g_ren, 255, 255, 255, 255);
-      SDL_RenderDrawRect(g_ren, &ePanel);
+      rqFillRect(&ePanel);
+      rqSetDrawColor(255, 255, 255, 255);
+      rqDrawRect(&ePanel);
       drawTextShadow((GAME_W - textWidth("EXTRAS", 2)) / 2, 78, "EXTRAS", 2,
                      {255, 255, 255, 255});
       drawTextShadow((GAME_W - textWidth("COMING SOON", 2)) / 2, 114,
                      "COMING SOON", 2, {255, 255, 255, 255});
       drawTextShadow((GAME_W - textWidth("B BACK", 1)) / 2, 150, "B BACK", 1,
                      {220, 220, 220, 255});
-      SDL_SetRenderDrawBlendMode(g_ren, SDL_BLENDMODE_NONE);
+      rqSetDrawBlendMode(SDL_BLENDMODE_NONE);
     }
 
-    SDL_RenderPresent(g_ren);
+    prof.next(PROF_PRESENT);
+    rqPresent();
     return;
   }
 
   switch (g_theme) {
   case THEME_UNDERGROUND:
-    SDL_SetRenderDrawColor(g_ren, 0, 0, 0, 255);
+    rqSetDrawColor(0, 0, 0, 255);
     break;
   case THEME_CASTLE:
-    SDL_SetRenderDrawColor(g_ren, 40, 40, 40, 255);
+    rqSetDrawColor(40, 40, 40, 255);
     break;
   case THEME_OVERWORLD:
   default:
-    SDL_SetRenderDrawColor(g_ren, 92, 148, 252, 255);
+    rqSetDrawColor(92, 148, 252, 255);
     break;
   }
-  SDL_RenderClear(g_ren);
+  rqClear();
 
   // Background layers (decorative only).
   {
@@ -5404,7 +7694,7 @@ void render() {
       SDL_Rect dst = {-(int)(g_camX * 0.03f) % 512, 0, 512, GAME_H};
       for (int x = dst.x; x < GAME_W; x += 512) {
         SDL_Rect d = {x, dst.y, dst.w, dst.h};
-        SDL_RenderCopy(g_ren, g_texBgSky, &src, &d);
+        rqCopy(g_texBgSky, &src, &d);
       }
     }
 
@@ -5433,6 +7723,7 @@ void render() {
   // Foreground decorations (still behind the player). Draw these *before*
   // gameplay tiles so pipes/blocks correctly occlude them.
   if (g_texDeco && g_fgDecoCount > 0) {
+    beginSpriteLayer();
     for (int i = 0; i < g_fgDecoCount; i++) {
       const ForegroundDeco &d = g_fgDecos[i];
       int baseX = d.tx * TILE - (int)g_camX;
@@ -5446,6 +7737,7 @@ void render() {
         renderCopyWithShadow(g_texDeco, &src, &dst);
       }
     }
+    flushSpriteLayer();
   }
 
   if (g_showDebugOverlay) {
@@ -5466,15 +7758,14 @@ void render() {
 
 	    snprintf(buf, sizeof(buf), "PARTICLES %d->%d  TEX snow:%s leaves:%s",
 	             g_levelInfo.bgParticles, effectiveBgParticles(),
-	             g_texParticleSnow ? "OK" : "NULL",
-	             (g_texParticleLeaves && g_texParticleAutumnLeaves) ? "OK" : "NULL");
+	             g_sprParticleSnow ? "OK" : "NULL",
+	             (g_sprParticleLeaves && g_sprParticleAutumnLeaves) ? "OK" : "NULL");
 	    drawTextShadow(2, y, buf, 1, {255, 255, 255, 255});
 	    y += 10;
 
     auto texLine = [&](const char *name, SDL_Texture *t) {
       int w = 0, h = 0;
-      if (t)
-        SDL_QueryTexture(t, nullptr, nullptr, &w, &h);
+      rqTextureInfo(t, &w, &h);
       snprintf(buf, sizeof(buf), "%s %s %dx%d", name, t ? "OK" : "NULL", w, h);
       drawTextShadow(2, y, buf, 1, t ? SDL_Color{120, 255, 120, 255}
                                      : SDL_Color{255, 120, 120, 255});
@@ -5487,6 +7778,43 @@ void render() {
     texLine("SEC", g_texBgSecondary);
     texLine("CLOUD", g_texBgCloudOverlay);
 
+    int texEntries = 0;
+    size_t texBytes = texCacheBytes(&texEntries);
+    snprintf(buf, sizeof(buf), "TEX CACHE %d  %uKB  HIT %d MISS %d EVICT %d",
+             texEntries, (unsigned)(texBytes >> 10), g_texCacheStats.hits,
+             g_texCacheStats.misses, g_texCacheStats.evictions);
+    drawTextShadow(2, y, buf, 1, {255, 255, 255, 255});
+    y += 10;
+
+    snprintf(buf, sizeof(buf), "SPRITE ATLAS %d PAGES  %d SHEETS",
+             g_atlasPageCount, g_atlasEntryCount);
+    drawTextShadow(2, y, buf, 1, {255, 255, 255, 255});
+    y += 10;
+
+    snprintf(buf, sizeof(buf), "BROADPHASE PAIRS %u  HITS %u",
+             (unsigned)g_bpStats.tested, (unsigned)g_bpStats.hits);
+    drawTextShadow(2, y, buf, 1, {255, 255, 255, 255});
+    y += 10;
+
+    // Listed/peak per pool, then refused spawns across all pools.
+    {
+      int len = snprintf(buf, sizeof(buf), "POOLS");
+      int failures = 0;
+      for (const EntityPool &pool : g_entityPools) {
+        len += snprintf(buf + len, sizeof(buf) - len, " %d/%d", pool.count,
+                        pool.peak);
+        failures += pool.failures;
+      }
+      snprintf(buf + len, sizeof(buf) - len, "  FULL %d", failures);
+    }
+    drawTextShadow(2, y, buf, 1, {255, 255, 255, 255});
+    y += 10;
+
+    snprintf(buf, sizeof(buf), "TILE CHUNKS %s  BUILDS %d",
+             g_tileCacheDisabled ? "OFF" : "ON", g_tileChunkBuilds);
+    drawTextShadow(2, y, buf, 1, {255, 255, 255, 255});
+    y += 10;
+
     snprintf(buf, sizeof(buf), "FGDECO TEX %s  COUNT %d",
              g_texDeco ? "OK" : "NULL", g_fgDecoCount);
     drawTextShadow(2, y, buf, 1, {255, 255, 255, 255});
@@ -5512,67 +7840,41 @@ void render() {
   }
 
   // Tiles
-  int startTx = (int)(g_camX / TILE) - 1;
-	  int viewTiles = (GAME_W + TILE - 1) / TILE + 2;
-	  auto isDecoTile = [&](int tx, int ty) -> bool {
-    if (!g_levelInfo.atlasT || !g_levelInfo.atlasX || !g_levelInfo.atlasY)
-      return false;
-    if (g_levelInfo.atlasX[ty][tx] == 255 || g_levelInfo.atlasY[ty][tx] == 255)
-      return false;
-    return g_levelInfo.atlasT[ty][tx] == ATLAS_DECO;
-  };
-  // Draw decorations first (background), then gameplay terrain/blocks.
-  for (int pass = 0; pass < 2; pass++) {
-    bool decoPass = (pass == 0);
-    for (int ty = 0; ty < MAP_H; ty++) {
-      for (int tx = startTx; tx < startTx + viewTiles && tx < mapWidth(); tx++) {
-        if (tx < 0)
-          continue;
-        bool deco = isDecoTile(tx, ty);
-        if (decoPass != deco)
-          continue;
-        drawTile(tx, ty, g_map[ty][tx]);
+  prof.next(PROF_RENDER_TILES);
+  if (!renderCachedTileLayer()) {
+    int startTx = (int)(g_camX / TILE) - 1;
+    int viewTiles = (GAME_W + TILE - 1) / TILE + 2;
+    // Draw decorations first (background), then gameplay terrain/blocks.
+    for (int pass = 0; pass < 2; pass++) {
+      bool decoPass = (pass == 0);
+      for (int ty = 0; ty < MAP_H; ty++) {
+        for (int tx = startTx; tx < startTx + viewTiles && tx < mapWidth();
+             tx++) {
+          if (tx < 0)
+            continue;
+          if (decoPass != isDecoTile(tx, ty))
+            continue;
+          drawTile(tx, ty, g_map[ty][tx], (int)g_camX);
+        }
       }
-	    }
-	  }
+      flushTileBatches();
+    }
+  }
+
+	    prof.next(PROF_RENDER_SPRITES);
+	    beginSpriteLayer();
 
 	    // Flagpole + flag
 	    if (g_hasFlag) {
-	      // Find the local ground under/near the pole. Some level data may place
-	      // collision markers in the pole columns, so scan a small range.
-	      int groundTy = MAP_H - 1;
-	      int foundX = g_flagX;
-	      bool found = false;
-	      for (int y = MAP_H - 1; y >= 0 && !found; y--) {
-	        for (int x = g_flagX - 2; x <= g_flagX + 2; x++) {
-	          if (x < 0 || x >= mapWidth())
-	            continue;
-	          if (collisionAt(x, y) == COL_SOLID || collisionAt(x, y) == COL_ONEWAY) {
-	            groundTy = y;
-	            foundX = x;
-	            found = true;
-	            break;
-	          }
-	        }
-	      }
-	      // The ground is often 2 tiles thick; align the pole base to the *top*
-	      // of that stack so it doesn't sink a tile into the floor.
-	      while (groundTy > 0) {
-	        uint8_t above = collisionAt(foundX, groundTy - 1);
-	        if (above == COL_SOLID || above == COL_ONEWAY)
-	          groundTy--;
-	        else
-	          break;
-	      }
 	      int poleX = g_flagX * TILE - (int)g_camX;
 	      // Align the pole base to the top of the ground tile.
-	      int poleBottom = groundTy * TILE;
+	      int poleBottom = g_bake.flagPoleBaseTy * TILE;
 
 	      // Draw the flag first, then the pole so the pole sits in front of the
 	      // flag and its shadow never overlays the pole.
-	      if (g_texFlag) {
-	        int texW = 0, texH = 0;
-	        SDL_QueryTexture(g_texFlag, nullptr, nullptr, &texW, &texH);
+	      if (g_sprFlag) {
+	        int texW = g_sprFlag.rect.w;
+	        int texH = g_sprFlag.rect.h;
 	        int idx = flagPaletteIndexForTheme(g_theme);
 	        int cols = (texW / 16);
 	        if (cols <= 0)
@@ -5585,11 +7887,11 @@ void render() {
 	        SDL_Rect src = {(idx % cols) * 16, (idx / cols) * 16, 16, 16};
 	        int attachX = poleX + g_flagPoleShaftX;
 	        SDL_Rect dst = {attachX - 16, (int)g_flagY, 16, 16};
-	        renderCopyWithShadow(g_texFlag, &src, &dst);
+	        renderCopyWithShadow(g_sprFlag, &src, &dst);
 	      }
-	      if (g_texFlagPole) {
-	        int texW = 0, texH = 0;
-	        SDL_QueryTexture(g_texFlagPole, nullptr, nullptr, &texW, &texH);
+	      if (g_sprFlagPole) {
+	        int texW = g_sprFlagPole.rect.w;
+	        int texH = g_sprFlagPole.rect.h;
 	        int idx = flagPolePaletteIndexForTheme(g_theme);
 	        int maxIdx = (texW / 16) - 1;
 	        if (maxIdx < 0)
@@ -5598,7 +7900,7 @@ void render() {
 	          idx = maxIdx;
 	        SDL_Rect src = {idx * 16, 0, 16, texH};
 	        SDL_Rect dst = {poleX, poleBottom - texH, 16, texH};
-	        renderCopyWithShadow(g_texFlagPole, &src, &dst);
+	        renderCopyWithShadow(g_sprFlagPole, &src, &dst);
 	      }
 	    }
 
@@ -5606,48 +7908,59 @@ void render() {
 	    g_castleDrawOn = computeCastleDst(g_castleDrawDst, g_castleOverlayDst);
 	    if (g_castleDrawOn) {
 	      SDL_Rect srcTop = {0, 0, g_castleDrawDst.w, g_castleDrawDst.h};
-	      renderCopyWithShadow(g_texCastle, &srcTop, &g_castleDrawDst);
+	      renderCopyWithShadow(g_sprCastle, &srcTop, &g_castleDrawDst);
 	    }
 
-    // Entities
-    for (int i = 0; i < 64; i++) {
-      Entity &e = g_ents[i];
+    // Entities, drawn pool by pool: platforms and level objects at the back,
+    // projectiles in front.
+    static const EntityPoolId kDrawOrder[POOL_COUNT] = {
+        POOL_PLATFORMS, POOL_GENERATORS, POOL_ITEMS, POOL_ENEMIES,
+        POOL_PROJECTILES};
+    uint16_t drawList[ENTITY_CAPACITY];
+    int drawCount = 0;
+    for (EntityPoolId id : kDrawOrder) {
+      const EntityPool &pool = g_entityPools[id];
+      for (int k = 0; k < pool.count; k++)
+        drawList[drawCount++] = g_entityActive[pool.first + k];
+    }
+    for (int i = 0; i < drawCount; i++) {
+      Entity &e = g_ents[drawList[i]];
       if (!e.on)
         continue;
-      int ex = (int)(e.r.x - g_camX);
+      int ex = (int)(lerpRenderPos(e.prevX, e.r.x) - g_camX);
       if (ex < -32 || ex > GAME_W + 32)
         continue;
-      SDL_Rect dst = {ex, (int)e.r.y, (int)e.r.w, (int)e.r.h};
+      SDL_Rect dst = {ex, (int)lerpRenderPos(e.prevY, e.r.y), (int)e.r.w,
+                      (int)e.r.h};
 
       if (e.type == E_GOOMBA) {
-        if (g_texGoomba) {
+        if (g_sprGoomba) {
           int frame = (e.state == 1) ? 2 : ((int)(e.timer * 8) % 2);
           SDL_Rect src = {frame * 16, 0, 16, 16};
           if (e.state == 1) {
             dst.h = 8;
             dst.y += 8;
           }
-          renderCopyWithShadow(g_texGoomba, &src, &dst);
+          renderCopyWithShadow(g_sprGoomba, &src, &dst);
         } else {
-          SDL_SetRenderDrawColor(g_ren, 172, 100, 40, 255);
-          SDL_RenderFillRect(g_ren, &dst);
+          queueSpriteFill(dst, {172, 100, 40, 255});
         }
       } else if (e.type == E_KOOPA || e.type == E_KOOPA_RED) {
-        if (g_texKoopa || g_texKoopaSheet) {
+        if (g_sprKoopa || g_sprKoopaSheet) {
           if (e.state >= 1) {
             dst.h = 16;
             dst.w = 16;
-            if (g_texKoopaSheet) {
+            if (g_sprKoopaSheet) {
               SDL_Rect src = {0, 16, 16, 16};
               if (e.state == 2) {
                 static const int kSpinX[4] = {16, 32, 48, 0};
                 int frame = ((int)(e.timer * 12) % 4);
                 src.x = kSpinX[frame];
               }
-              renderCopyWithShadow(g_texKoopaSheet, &src, &dst);
-            } else if (g_texKoopa) {
+              renderCopyWithShadow(g_sprKoopaSheet, &src, &dst);
+            } else if (g_sprKoopa) {
               SDL_Rect src = {0, 8, 16, 16};
-              renderCopyWithShadow(g_texKoopa, &src, &dst);
+              renderCopyWithShadow(g_sprKoopa, &src, &dst);
             }
           } else {
             SDL_Rect src = {((int)(e.timer * 8) % 2) * 16, 0, 16, 24};
@@ -5656,14 +7969,13 @@ void render() {
             SDL_Rect drawDst = dst;
             drawDst.h = 24;
             drawDst.y -= 8;
-            renderCopyExWithShadow(g_texKoopa, &src, &drawDst, flip);
+            renderCopyExWithShadow(g_sprKoopa, &src, &drawDst, flip);
           }
         } else {
-          SDL_SetRenderDrawColor(g_ren, 0, 160, 0, 255);
-          SDL_RenderFillRect(g_ren, &dst);
+          queueSpriteFill(dst, {0, 160, 0, 255});
         }
       } else if (e.type == E_BUZZY_BEETLE) {
-        if (g_texBuzzy) {
+        if (g_sprBuzzy) {
           // BuzzyBeetle.png contains both walk frames (x=0..31) and shell
           // frames starting at x=32 (see BuzzyBeetleShell.json).
           SDL_Rect src = {0, 0, 16, 16};
@@ -5681,58 +7993,54 @@ void render() {
           }
           SDL_RendererFlip flip =
               (e.dir > 0) ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
-          renderCopyExWithShadow(g_texBuzzy, &src, &dst, flip);
+          renderCopyExWithShadow(g_sprBuzzy, &src, &dst, flip);
         } else {
-          SDL_SetRenderDrawColor(g_ren, 60, 60, 60, 255);
-          SDL_RenderFillRect(g_ren, &dst);
+          queueSpriteFill(dst, {60, 60, 60, 255});
         }
       } else if (e.type == E_BLOOPER) {
-        if (g_texBlooper) {
+        if (g_sprBlooper) {
           // Blooper.png: 2 frames in a 32x24 strip (Rise at x=0, Fall at x=16).
           SDL_Rect src = {(e.state == 1) ? 0 : 16, 0, 16, 24};
           SDL_Rect drawDst = dst;
           drawDst.h = 24;
-          renderCopyWithShadow(g_texBlooper, &src, &drawDst);
+          renderCopyWithShadow(g_sprBlooper, &src, &drawDst);
         } else {
-          SDL_SetRenderDrawColor(g_ren, 240, 240, 240, 255);
           SDL_Rect drawDst = dst;
           drawDst.h = 24;
-          SDL_RenderFillRect(g_ren, &drawDst);
+          queueSpriteFill(drawDst, {240, 240, 240, 255});
         }
       } else if (e.type == E_LAKITU) {
         // Lakitu rides a 32x32 cloud with a 16x24 body sprite.
-        if (g_texLakituCloud) {
+        if (g_sprLakituCloud) {
           SDL_Rect cloudSrc = {0, 0, 32, 32};
           SDL_Rect cloudDst = {dst.x - 8, dst.y + 8, 32, 32};
-          renderCopyWithShadow(g_texLakituCloud, &cloudSrc, &cloudDst);
+          renderCopyWithShadow(g_sprLakituCloud, &cloudSrc, &cloudDst);
         }
-        if (g_texLakitu) {
+        if (g_sprLakitu) {
           SDL_Rect src = {(e.state == 1) ? 16 : 0, 0, 16, 24};
           SDL_Rect drawDst = dst;
           drawDst.h = 24;
           SDL_RendererFlip flip =
               (e.dir > 0) ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
-          renderCopyExWithShadow(g_texLakitu, &src, &drawDst, flip);
+          renderCopyExWithShadow(g_sprLakitu, &src, &drawDst, flip);
         } else {
-          SDL_SetRenderDrawColor(g_ren, 250, 250, 250, 255);
           SDL_Rect drawDst = dst;
           drawDst.h = 24;
-          SDL_RenderFillRect(g_ren, &drawDst);
+          queueSpriteFill(drawDst, {250, 250, 250, 255});
         }
       } else if (e.type == E_SPINY) {
-        if (g_texSpiny) {
+        if (g_sprSpiny) {
           // Spiny.png: egg frames at y=0, walk frames at y=16.
           int frame = ((int)(e.timer * ((e.state == 0) ? 14 : 8)) % 2);
           SDL_Rect src = {frame * 16, (e.state == 0) ? 0 : 16, 16, 16};
           SDL_RendererFlip flip =
               (e.dir > 0) ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
-          renderCopyExWithShadow(g_texSpiny, &src, &dst, flip);
+          renderCopyExWithShadow(g_sprSpiny, &src, &dst, flip);
         } else {
-          SDL_SetRenderDrawColor(g_ren, 220, 40, 40, 255);
-          SDL_RenderFillRect(g_ren, &dst);
+          queueSpriteFill(dst, {220, 40, 40, 255});
         }
       } else if (e.type == E_HAMMER_BRO) {
-        if (g_texHammerBro) {
+        if (g_sprHammerBro) {
           // HammerBro.png: Idle (x=0..31), Hammer (x=32..63).
           bool throwing = (e.a > 0);
           int baseX = throwing ? 32 : 0;
@@ -5742,38 +8050,36 @@ void render() {
           drawDst.h = 24;
           SDL_RendererFlip flip =
               (e.dir > 0) ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
-          renderCopyExWithShadow(g_texHammerBro, &src, &drawDst, flip);
+          renderCopyExWithShadow(g_sprHammerBro, &src, &drawDst, flip);
         } else {
-          SDL_SetRenderDrawColor(g_ren, 240, 240, 240, 255);
           SDL_Rect drawDst = dst;
           drawDst.h = 24;
-          SDL_RenderFillRect(g_ren, &drawDst);
+          queueSpriteFill(drawDst, {240, 240, 240, 255});
         }
       } else if (e.type == E_HAMMER) {
-        if (g_texHammer) {
+        if (g_sprHammer) {
           SDL_Rect src = {0, 0, 16, 16};
           SDL_Point center = {8, 8};
           double angle = fmod(e.timer * 720.0, 360.0);
-          renderCopyExWithShadowAngle(g_texHammer, &src, &dst, angle,
+          renderCopyExWithShadowAngle(g_sprHammer, &src, &dst, angle,
                                       SDL_FLIP_NONE, &center);
         } else {
-          SDL_SetRenderDrawColor(g_ren, 200, 200, 200, 255);
-          SDL_RenderFillRect(g_ren, &dst);
+          queueSpriteFill(dst, {200, 200, 200, 255});
         }
       } else if (e.type == E_PLATFORM_SIDEWAYS || e.type == E_PLATFORM_VERTICAL ||
                  e.type == E_PLATFORM_ROPE || e.type == E_PLATFORM_FALLING) {
-        if (g_texPlatform) {
+        if (g_sprPlatform) {
           SDL_Rect srcL = {0, 0, 8, 8};
           SDL_Rect srcM = {8, 0, 8, 8};
           SDL_Rect srcR = {16, 0, 8, 8};
 
           SDL_Rect dstL = dst;
           dstL.w = 8;
-          renderCopyWithShadow(g_texPlatform, &srcL, &dstL);
+          renderCopyWithShadow(g_sprPlatform, &srcL, &dstL);
           SDL_Rect dstR = dst;
           dstR.w = 8;
           dstR.x = dst.x + dst.w - 8;
-          renderCopyWithShadow(g_texPlatform, &srcR, &dstR);
+          renderCopyWithShadow(g_sprPlatform, &srcR, &dstR);
 
           int midStart = dst.x + 8;
           int midEnd = dst.x + dst.w - 8;
@@ -5783,73 +8089,66 @@ void render() {
               dstM.w = midEnd - x;
             SDL_Rect src = srcM;
             src.w = dstM.w;
-            renderCopyWithShadow(g_texPlatform, &src, &dstM);
+            renderCopyWithShadow(g_sprPlatform, &src, &dstM);
           }
         } else {
-          SDL_SetRenderDrawColor(g_ren, 200, 200, 200, 255);
-          SDL_RenderFillRect(g_ren, &dst);
+          queueSpriteFill(dst, {200, 200, 200, 255});
         }
       } else if (e.type == E_CHEEP_SWIM || e.type == E_CHEEP_LEAP) {
-        if (g_texCheepCheep) {
+        if (g_sprCheepCheep) {
           int frame = ((int)(e.timer * 8) % 2);
           SDL_Rect src = {frame * 16, 0, 16, 16};
           SDL_RendererFlip flip =
               ((e.vx > 0.0f) || (e.dir > 0)) ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
-          renderCopyExWithShadow(g_texCheepCheep, &src, &dst, flip);
+          renderCopyExWithShadow(g_sprCheepCheep, &src, &dst, flip);
         } else {
-          SDL_SetRenderDrawColor(g_ren, 240, 80, 80, 255);
-          SDL_RenderFillRect(g_ren, &dst);
+          queueSpriteFill(dst, {240, 80, 80, 255});
         }
       } else if (e.type == E_BULLET_BILL) {
-        if (g_texBulletBill) {
+        if (g_sprBulletBill) {
           SDL_Rect src = {0, 0, 16, 16};
           SDL_RendererFlip flip =
               (e.dir > 0) ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
-          renderCopyExWithShadow(g_texBulletBill, &src, &dst, flip);
+          renderCopyExWithShadow(g_sprBulletBill, &src, &dst, flip);
         } else {
-          SDL_SetRenderDrawColor(g_ren, 40, 40, 40, 255);
-          SDL_RenderFillRect(g_ren, &dst);
+          queueSpriteFill(dst, {40, 40, 40, 255});
         }
       } else if (e.type == E_CASTLE_AXE) {
-        if (g_texBridgeAxe) {
+        if (g_sprBridgeAxe) {
           SDL_Rect src = {0, 0, 16, 16};
-          renderCopyWithShadow(g_texBridgeAxe, &src, &dst);
+          renderCopyWithShadow(g_sprBridgeAxe, &src, &dst);
         } else {
-          SDL_SetRenderDrawColor(g_ren, 220, 220, 220, 255);
-          SDL_RenderFillRect(g_ren, &dst);
+          queueSpriteFill(dst, {220, 220, 220, 255});
         }
       } else if (e.type == E_BOWSER) {
-        if (g_texBowser) {
+        if (g_sprBowser) {
           SDL_Rect src = {0, 0, 48, 48};
           SDL_Rect drawDst = dst;
           drawDst.w = 48;
           drawDst.h = 48;
           SDL_RendererFlip flip =
               (e.dir > 0) ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
-          renderCopyExWithShadow(g_texBowser, &src, &drawDst, flip);
+          renderCopyExWithShadow(g_sprBowser, &src, &drawDst, flip);
         } else {
-          SDL_SetRenderDrawColor(g_ren, 120, 60, 20, 255);
-          SDL_RenderFillRect(g_ren, &dst);
+          queueSpriteFill(dst, {120, 60, 20, 255});
         }
       } else if (e.type == E_MUSHROOM) {
-        if (g_texMushroom) {
+        if (g_sprMushroom) {
           SDL_Rect src = {0, 0, 16, 16};
-          renderCopyWithShadow(g_texMushroom, &src, &dst);
+          renderCopyWithShadow(g_sprMushroom, &src, &dst);
         } else {
-          SDL_SetRenderDrawColor(g_ren, 220, 60, 60, 255);
-          SDL_RenderFillRect(g_ren, &dst);
+          queueSpriteFill(dst, {220, 60, 60, 255});
         }
       } else if (e.type == E_FIRE_FLOWER) {
-        if (g_texFireFlower) {
+        if (g_sprFireFlower) {
           int frame = ((int)(e.timer * 12) % 4);
           SDL_Rect src = {frame * 16, fireFlowerRowForTheme(g_theme), 16, 16};
-          renderCopyWithShadow(g_texFireFlower, &src, &dst);
+          renderCopyWithShadow(g_sprFireFlower, &src, &dst);
         } else {
-          SDL_SetRenderDrawColor(g_ren, 220, 140, 40, 255);
-          SDL_RenderFillRect(g_ren, &dst);
+          queueSpriteFill(dst, {220, 140, 40, 255});
         }
       } else if (e.type == E_FIREBALL) {
-        if (g_texFireball) {
+        if (g_sprFireball) {
           // Fireball art is an 8x8 sprite packed into the top-left of a 16x16
           // sheet. Draw it centered so rotation doesn't "orbit" around (0,0).
           SDL_Rect src = {0, 0, 8, 8};
@@ -5857,20 +8156,18 @@ void render() {
                               8, 8};
           SDL_Point center = {4, 4};
           double angle = fmod(e.timer * 720.0, 360.0);
-          renderCopyExWithShadowAngle(g_texFireball, &src, &drawDst, angle,
+          renderCopyExWithShadowAngle(g_sprFireball, &src, &drawDst, angle,
                                       SDL_FLIP_NONE, &center);
         } else {
-          SDL_SetRenderDrawColor(g_ren, 255, 120, 40, 255);
-          SDL_RenderFillRect(g_ren, &dst);
+          queueSpriteFill(dst, {255, 120, 40, 255});
         }
       } else if (e.type == E_COIN_POPUP) {
-        if (g_texCoin) {
+        if (g_sprCoin) {
           int frame = 1 + ((int)(e.timer * 12) % 3);
           SDL_Rect src = {frame * 16, 0, 16, 16};
-          renderCopyWithShadow(g_texCoin, &src, &dst);
+          renderCopyWithShadow(g_sprCoin, &src, &dst);
         } else {
-          SDL_SetRenderDrawColor(g_ren, 255, 200, 0, 255);
-          SDL_RenderFillRect(g_ren, &dst);
+          queueSpriteFill(dst, {255, 200, 0, 255});
         }
       }
     }
@@ -5882,21 +8179,21 @@ void render() {
       if (pl.dead || !showPlayer)
         continue;
 
-      int px = (int)(pl.r.x - g_camX);
+      int px = (int)(lerpRenderPos(pl.prevX, pl.r.x) - g_camX);
       int pw = (pl.power == P_SMALL) ? PLAYER_DRAW_W_SMALL : PLAYER_DRAW_W_BIG;
       int ph = (pl.power == P_SMALL) ? 16 : 32;
       int drawX = px + (int)((pl.r.w - pw) / 2);
-      int drawY = (int)pl.r.y;
+      int drawY = (int)lerpRenderPos(pl.prevY, pl.r.y);
       if (pl.crouch && pl.power >= P_BIG)
         drawY -= 16;
       SDL_Rect dst = {drawX, drawY, pw, ph};
 
       int ci = g_playerCharIndex[pi] % g_charCount;
-      SDL_Texture *tex = g_texPlayerSmall[ci];
+      Sprite tex = g_sprPlayerSmall[ci];
       if (pl.power == P_FIRE)
-        tex = g_texPlayerFire[ci];
+        tex = g_sprPlayerFire[ci];
       else if (pl.power >= P_BIG)
-        tex = g_texPlayerBig[ci];
+        tex = g_sprPlayerBig[ci];
 
       if (tex) {
         uint32_t held = g_playerHeld[pi];
@@ -5905,8 +8202,9 @@ void render() {
         bool skidding =
             pl.ground && (((held & VPAD_BUTTON_LEFT) && pl.vx > 20) ||
                           ((held & VPAD_BUTTON_RIGHT) && pl.vx < -20));
-        if (pi == 0 && skidding && g_sfxSkid && g_skidCooldown <= 0.0f) {
-          Mix_PlayChannel(-1, g_sfxSkid, 0);
+        if (pi == 0 && skidding && g_sfxBank[SFX_SKID] &&
+            g_skidCooldown <= 0.0f) {
+          playSfx(SFX_SKID);
           g_skidCooldown = 0.35f;
         }
 
@@ -5973,27 +8271,28 @@ void render() {
           renderTall16x32WithShadow(tex, frame * 16, dst, flip);
         }
       } else {
-        SDL_SetRenderDrawColor(g_ren, 228, 52, 52, 255);
-        SDL_RenderFillRect(g_ren, &dst);
+        queueSpriteFill(dst, {228, 52, 52, 255});
       }
     }
+    flushSpriteLayer();
 	    // Castle overlay: hides the player as they enter the door.
-	    if (g_castleDrawOn && g_texCastle && g_castleOverlayDst.w > 0 &&
+	    if (g_castleDrawOn && g_sprCastle && g_castleOverlayDst.w > 0 &&
 	        g_castleOverlayDst.h > 0) {
 	      constexpr int kOverlayY = 120;
 	      constexpr int kOverlayX = 32;
 	      SDL_Rect src = {kOverlayX, kOverlayY, g_castleOverlayDst.w,
 	                      g_castleOverlayDst.h};
-	      SDL_RenderCopy(g_ren, g_texCastle, &src, &g_castleOverlayDst);
+	      drawSprite(g_sprCastle, &src, &g_castleOverlayDst);
 	    }
 	    if (g_nightMode) {
-	    SDL_SetRenderDrawBlendMode(g_ren, SDL_BLENDMODE_BLEND);
-	    SDL_SetRenderDrawColor(g_ren, 0, 0, 40, 100);
+	    rqSetDrawBlendMode(SDL_BLENDMODE_BLEND);
+	    rqSetDrawColor(0, 0, 40, 100);
 	    SDL_Rect night = {0, 0, GAME_W, GAME_H};
-    SDL_RenderFillRect(g_ren, &night);
+    rqFillRect(&night);
   }
 
   // Ambient particles: drawn above gameplay, below the cloud overlay + HUD.
+  prof.next(PROF_RENDER_HUD);
   renderAmbientParticles();
 
   // Cloud overlay: should sit in front of everything except the HUD.
@@ -6001,7 +8300,7 @@ void render() {
   {
     bool wantsClouds = g_levelInfo.bgClouds || (g_theme == THEME_OVERWORLD);
     if (wantsClouds && g_texBgCloudOverlay) {
-      SDL_SetTextureAlphaMod(g_texBgCloudOverlay, 110);
+      setTextureFade(g_texBgCloudOverlay, 110);
       // Render only a visible slice of the overlay so it stays aligned to the
       // viewport and doesn't clip into ground. Shift the sample down so the
       // clouds read higher in the view.
@@ -6017,9 +8316,9 @@ void render() {
       SDL_Rect dst = {x0, 0, 512, GAME_H};
       for (int x = dst.x; x < GAME_W; x += 512) {
         SDL_Rect d = {x, dst.y, dst.w, dst.h};
-        SDL_RenderCopy(g_ren, g_texBgCloudOverlay, &src, &d);
+        rqCopy(g_texBgCloudOverlay, &src, &d);
       }
-      SDL_SetTextureAlphaMod(g_texBgCloudOverlay, 255);
+      setTextureFade(g_texBgCloudOverlay, 255);
     }
   }
 
@@ -6040,10 +8339,10 @@ void render() {
 
 	    // Coin count (upper middle-left)
 	    int coinX = margin + 110;
-	    if (g_texCoinIcon) {
+	    if (g_sprCoinIcon) {
 	      SDL_Rect src = {0, 0, 8, 8};
 	      SDL_Rect dst = {coinX, y1 - 1, 12, 12};
-	      SDL_RenderCopy(g_ren, g_texCoinIcon, &src, &dst);
+	      drawSprite(g_sprCoinIcon, &src, &dst);
 	    }
     snprintf(buf, sizeof(buf), "x%02d", g_p.coins % 100);
     drawTextShadow(coinX + 14, y1, buf, scale, yellow);
@@ -6082,9 +8381,9 @@ void render() {
       drawTextShadow(baseX, rowY + 1, pLabel, scale, white);
 
       int ci = g_playerCharIndex[pi] % g_charCount;
-      if (g_texLifeIcon[ci]) {
+      if (g_sprLifeIcon[ci]) {
         SDL_Rect dst = {baseX + pLabelW + 2, rowY, lifeSize, lifeSize};
-        SDL_RenderCopy(g_ren, g_texLifeIcon[ci], nullptr, &dst);
+        drawSprite(g_sprLifeIcon[ci], nullptr, &dst);
       }
       char livesBuf[16];
       snprintf(livesBuf, sizeof(livesBuf), "x%02d", pl.lives < 0 ? 0 : pl.lives);
@@ -6094,9 +8393,9 @@ void render() {
   }
 
   if (g_state == GS_DEAD || g_state == GS_GAMEOVER) {
-    SDL_SetRenderDrawColor(g_ren, 0, 0, 0, 200);
+    rqSetDrawColor(0, 0, 0, 200);
     SDL_Rect overlay = {GAME_W / 4, GAME_H / 3, GAME_W / 2, GAME_H / 3};
-    SDL_RenderFillRect(g_ren, &overlay);
+    rqFillRect(&overlay);
 
     const char *title = (g_state == GS_GAMEOVER) ? "GAME OVER" : "YOU DIED";
     drawTextShadow((GAME_W - textWidth(title, 2)) / 2, overlay.y + 22, title, 2,
@@ -6106,9 +8405,9 @@ void render() {
                    hint, 1, {200, 200, 200, 255});
   }
   if (g_state == GS_WIN) {
-    SDL_SetRenderDrawColor(g_ren, 0, 100, 0, 200);
+    rqSetDrawColor(0, 100, 0, 200);
     SDL_Rect overlay = {GAME_W / 4, GAME_H / 3, GAME_W / 2, GAME_H / 3};
-    SDL_RenderFillRect(g_ren, &overlay);
+    rqFillRect(&overlay);
 
     const char *title = "COURSE CLEAR";
     drawTextShadow((GAME_W - textWidth(title, 2)) / 2, overlay.y + 22, title, 2,
@@ -6119,13 +8418,13 @@ void render() {
                    {255, 255, 255, 255});
   }
   if (g_state == GS_PAUSE) {
-    SDL_SetRenderDrawBlendMode(g_ren, SDL_BLENDMODE_BLEND);
-    SDL_SetRenderDrawColor(g_ren, 0, 0, 0, 200);
+    rqSetDrawBlendMode(SDL_BLENDMODE_BLEND);
+    rqSetDrawColor(0, 0, 0, 200);
     SDL_Rect panel = {GAME_W / 2 - 140, GAME_H / 2 - 70, 280, 140};
-    SDL_RenderFillRect(g_ren, &panel);
-    SDL_SetRenderDrawBlendMode(g_ren, SDL_BLENDMODE_NONE);
-    SDL_SetRenderDrawColor(g_ren, 255, 255, 255, 255);
-    SDL_RenderDrawRect(g_ren, &panel);
+    rqFillRect(&panel);
+    rqSetDrawBlendMode(SDL_BLENDMODE_NONE);
+    rqSetDrawColor(255, 255, 255, 255);
+    rqDrawRect(&panel);
 
     const char *title = "PAUSED";
     int titleY = panel.y + 16;
@@ -6144,9 +8443,390 @@ void render() {
                    {200, 200, 200, 255});
   }
 
-  SDL_RenderPresent(g_ren);
+  if (g_showDebugOverlay)
+    drawProfilerGraph();
+
+  prof.next(PROF_PRESENT);
+  rqPresent();
+}
+
+// Remember where everything was before a sim step so render() can blend
+// between the last two steps. Generators keep the player's X in prevX for
+// crossing checks, and platforms refresh prevX/prevY themselves.
+static void snapshotRenderState() {
+  g_camPrevX = g_camX;
+  for (int i = 0; i < g_playerCount; i++) {
+    g_players[i].prevX = g_players[i].r.x;
+    g_players[i].prevY = g_players[i].r.y;
+  }
+  for (const auto &pool : g_entityPools) {
+    for (int k = 0; k < pool.count; k++) {
+      Entity &e = poolEntity(pool, k);
+      if (!e.on || e.type == E_ENTITY_GENERATOR ||
+          e.type == E_ENTITY_GENERATOR_STOP)
+        continue;
+      e.prevX = e.r.x;
+      e.prevY = e.r.y;
+    }
+  }
+}
+
+// One fixed simulation step of the game state machine.
+static void simulateStep(float dt) {
+  if (g_pressed & VPAD_BUTTON_PLUS) {
+    if (g_state == GS_PLAYING)
+      g_state = GS_PAUSE;
+    else if (g_state == GS_PAUSE)
+      g_state = GS_PLAYING;
+    if (g_state == GS_PAUSE)
+      g_pauseIndex = 0;
+  }
+
+  // Cycle theme/level (demo): press MINUS to switch tilesets.
+  if (g_pressed & VPAD_BUTTON_MINUS) {
+    g_theme = (LevelTheme)(((int)g_theme + 1) % 3);
+    loadThemeTilesets();
+    setupLevel();
+  }
+
+  if (g_state == GS_TITLE) {
+    updateTitle();
+  } else if (g_state == GS_PAUSE) {
+    updatePauseMenu();
+  } else if (g_state == GS_PLAYING) {
+    ProfScope prof(PROF_PLATFORMS);
+    updatePlatformsAndGenerators(dt);
+    prof.next(PROF_PLAYERS);
+    updatePlayers(dt);
+    prof.next(PROF_ENTITIES);
+    updateEntities(dt);
+    prof.next(PROF_SIM);
+    updateAmbientParticles(dt);
+    updateSectionPrefetch();
+    g_timeAcc += dt;
+    if (g_timeAcc >= 1.0f) {
+      g_timeAcc -= 1.0f;
+      g_time--;
+      if (g_time == MUSIC_HURRY_PREFETCH_TIME)
+        requestMusic(musicTrack(g_theme, true));
+      else if (g_time == MUSIC_HURRY_TIME)
+        playThemeMusic(g_theme);
+      if (g_time <= 0) {
+        g_p.dead = true;
+        g_p.lives--;
+        g_state = GS_DEAD;
+      }
+    }
+  } else if (g_state == GS_FLAG) {
+    updateFlagSequence(dt);
+    updateAmbientParticles(dt);
+    updateCameraFromLeader();
+    enforceNonLeaderPlayersInView();
+  } else if (g_state == GS_DEAD) {
+    if (g_pressed & VPAD_BUTTON_A) {
+      if (g_p.lives > 0)
+        restartLevel();
+      else
+        g_state = GS_GAMEOVER;
+    }
+  } else if (g_state == GS_WIN) {
+    g_levelTimer += dt;
+    if (g_levelTimer > 2.0f) {
+      nextLevel();
+    }
+  } else if (g_state == GS_GAMEOVER) {
+    if (g_pressed & VPAD_BUTTON_A)
+      startNewGame();
+  }
+}
+
+#ifdef SMB_HOST
+//------------------------------------------------------------------------------
+// Host checks (host build only): `make check` or `./smb_host -t` runs each
+// check below on scratch state and exits non-zero if any fails. They are kept
+// out of the benchmark, which only measures.
+//------------------------------------------------------------------------------
+
+// A Hammer Bro walking under a brick row jumps up through it: with
+// BODY_NO_CEILING it must keep its course (no wall hit, no X snap) while
+// embedded in the bricks, then land on top of them.
+static bool checkBroThroughBricks() {
+  memset(g_colGrid, 0, sizeof(g_colGrid));
+  constexpr int kFloorTy = 12, kBrickTy = 9;
+  for (int tx = 0; tx < 24; tx++) {
+    uint64_t &column = g_colGrid[tx + COLGRID_PAD_X];
+    column |= (uint64_t)COL_SOLID << ((kFloorTy + COLGRID_PAD_Y) * 2);
+    column |= (uint64_t)COL_SOLID << ((kBrickTy + COLGRID_PAD_Y) * 2);
+  }
+  const float dt = 1.0f / (float)g_simHz;
+  bool ok = true;
+  for (int dir = -1; dir <= 1 && ok; dir += 2) {
+    Rect r = {10.0f * TILE + 3.0f, kFloorTy * TILE - 24.0f, 16.0f, 24.0f};
+    float dx = dir * 30.0f * dt;
+    float vy = -310.0f;
+    bool landed = false;
+    for (int i = 0; i < 120 && ok && !landed; i++) {
+      vy += 15.0f;
+      float x0 = r.x;
+      BodyContacts c = moveBody(r, dx, vy * dt, BODY_NO_CEILING);
+      if ((c.hits & CONTACT_WALL) || fabsf(r.x - (x0 + dx)) > 1e-3f)
+        ok = false;
+      if (c.hits & CONTACT_FLOOR) {
+        landed = true;
+        ok = ok && c.floorTy == kBrickTy;
+      }
+    }
+    ok = ok && landed;
+  }
+  memset(g_colGrid, 0, sizeof(g_colGrid));
+  return ok;
+}
+
+static int runHostChecks() {
+  static const struct {
+    const char *name;
+    bool (*fn)();
+  } kChecks[] = {
+      {"hammer bro jumps through a brick row", checkBroThroughBricks},
+  };
+  int failed = 0;
+  for (const auto &c : kChecks) {
+    bool ok = c.fn();
+    printf("%-4s %s\n", ok ? "ok" : "FAIL", c.name);
+    failed += ok ? 0 : 1;
+  }
+  return failed > 0 ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+// Headless benchmark (host build only): steps every level at a fixed dt under
+// scripted input and reports the average cost of each simulation subsystem.
+// Run from smb_wiiu/ so content/ resolves: `make bench` or
+//   ./smb_host [-f frames] [-l level] [-r]
+// -r also builds each frame's render pass (against the counting stub renderer).
+//------------------------------------------------------------------------------
+
+struct BenchTimes {
+  double platforms = 0.0;
+  double players = 0.0;
+  double entities = 0.0;
+  double particles = 0.0;
+  double render = 0.0;
+  int frames = 0;
+  int deaths = 0;
+  int clears = 0;
+  uint64_t copies = 0;
+  uint64_t fills = 0;
+  uint64_t textureSwitches = 0;
+  uint64_t pairsTested = 0;
+  uint64_t pairsHit = 0;
+};
+
+template <typename F> static void benchTime(double &accNs, F &&fn) {
+  auto t0 = std::chrono::steady_clock::now();
+  fn();
+  auto t1 = std::chrono::steady_clock::now();
+  accNs += (double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0)
+               .count();
+}
+
+// Deterministic "speedrunner" script: run right, jump regularly (with a
+// pseudo-random extra hop), tap fire, and occasionally back off a little.
+static uint32_t benchScriptedHold(int frame, uint32_t &rng) {
+  rng = rng * 1664525u + 1013904223u;
+  uint32_t hold = VPAD_BUTTON_Y;
+  int phase = frame % 240;
+  hold |= (phase >= 200 && phase < 212) ? VPAD_BUTTON_LEFT : VPAD_BUTTON_RIGHT;
+  if ((frame % 40) < 18 || ((rng >> 24) < 6))
+    hold |= VPAD_BUTTON_A;
+  if ((frame % 20) == 0)
+    hold |= VPAD_BUTTON_X;
+  return hold;
+}
+
+static void benchStartLevel(int level) {
+  startNewGame();
+  if (level != 0) {
+    g_levelIndex = level;
+    g_sectionIndex = 0;
+    setupLevel();
+  }
+}
+
+static void benchPrintRow(const char *label, const BenchTimes &t, bool withRender) {
+  double n = t.frames > 0 ? (double)t.frames : 1.0;
+  double total = t.platforms + t.players + t.entities + t.particles;
+  printf("%-10s %7d %10.0f %10.0f %10.0f %10.0f %10.0f", label, t.frames,
+         t.platforms / n, t.players / n, t.entities / n, t.particles / n,
+         total / n);
+  if (withRender)
+    printf(" %10.0f %7.1f %7.1f %7.1f", t.render / n, t.copies / n, t.fills / n,
+           t.textureSwitches / n);
+  printf(" %7.1f %6.1f %6d %6d\n", t.pairsTested / n, t.pairsHit / n, t.deaths,
+         t.clears);
+}
+
+static int runHostBench(int argc, char **argv) {
+  int frames = 5000;
+  int onlyLevel = -1;
+  bool withRender = false;
+  const char *profilePath = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+      frames = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+      onlyLevel = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-r") == 0)
+      withRender = true;
+    else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+      profilePath = argv[++i];
+    else {
+      fprintf(stderr, "usage: %s [-f frames] [-l level] [-r] [-p csv]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  contentIndexInit();
+  if (frames <= 0 || levelCount() <= 0) {
+    fprintf(stderr, "nothing to run (frames=%d, levels=%d)\n", frames,
+            levelCount());
+    return 1;
+  }
+
+  SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
+  openAudio();
+  startMusicStreaming();
+  if (!rqInit("SMB", TV_W, TV_H, SDL_WINDOW_FULLSCREEN,
+              SDL_RENDERER_ACCELERATED, 0, 0)) {
+    fprintf(stderr, "could not create the renderer\n");
+    return 1;
+  }
+  loadAssets();
+  startSectionPrefetch();
+  g_playerCount = 1;
+
+  const float dt = 1.0f / (float)g_simHz;
+  printf("smb bench: %d frames/level at dt=%.4f, ns/frame per subsystem\n",
+         frames, dt);
+  printf("%-10s %7s %10s %10s %10s %10s %10s", "level", "frames", "platforms",
+         "players", "entities", "particles", "sim");
+  if (withRender)
+    printf(" %10s %7s %7s %7s", "render", "copies", "fills", "texsw");
+  printf(" %7s %6s %6s %6s\n", "bp.test", "bp.hit", "deaths", "clears");
+
+  BenchTimes all;
+  int first = onlyLevel >= 0 ? onlyLevel : 0;
+  int last = onlyLevel >= 0 ? onlyLevel + 1 : levelCount();
+  for (int level = first; level < last && level < levelCount(); level++) {
+    srand(1234u + (unsigned)level);
+    uint32_t rng = 0x5EED0000u + (uint32_t)level;
+    g_hostTicks = 0;
+    g_hostVpad = {};
+    benchStartLevel(level);
+    char label[32];
+    snprintf(label, sizeof(label), "%d-%d", g_levelInfo.world, g_levelInfo.stage);
+
+    BenchTimes t;
+    uint32_t prevHold = 0;
+    for (int f = 0; f < frames; f++) {
+      g_hostTicks = (Uint32)(((uint64_t)f * 1000u) / 60u);
+      uint32_t hold = benchScriptedHold(f, rng);
+      g_hostVpad.hold = hold;
+      g_hostVpad.trigger = hold & ~prevHold;
+      prevHold = hold;
+      input();
+      consumeInputUntil(~(Uint64)0);
+      snapshotRenderState();
+
+      if (g_state == GS_PLAYING) {
+        benchTime(t.platforms, [&] { updatePlatformsAndGenerators(dt); });
+        benchTime(t.players, [&] { updatePlayers(dt); });
+        benchTime(t.entities, [&] { updateEntities(dt); });
+        t.pairsTested += g_bpStats.tested;
+        t.pairsHit += g_bpStats.hits;
+        benchTime(t.particles, [&] { updateAmbientParticles(dt); });
+        updateSectionPrefetch();
+        g_timeAcc += dt;
+        if (g_timeAcc >= 1.0f) {
+          g_timeAcc -= 1.0f;
+          if (--g_time <= 0) {
+            g_p.dead = true;
+            g_state = GS_DEAD;
+          }
+        }
+      } else if (g_state == GS_FLAG) {
+        simulateStep(dt);
+      } else if (g_state == GS_DEAD) {
+        t.deaths++;
+        g_p.lives = 3;
+        restartLevel();
+      } else if (g_state == GS_WIN) {
+        t.clears++;
+        benchStartLevel(level);
+      } else {
+        benchStartLevel(level);
+      }
+
+      pumpSectionPrefetch();
+      pumpMusic();
+      if (withRender) {
+        // Timed through replay, so the stats below belong to this frame.
+        HostRenderStats before = rqHostStats();
+        benchTime(t.render, [&] {
+          render();
+          rqFinish();
+        });
+        HostRenderStats after = rqHostStats();
+        t.copies += after.copies - before.copies;
+        t.fills += after.fills - before.fills;
+        t.textureSwitches += after.textureSwitches - before.textureSwitches;
+      } else {
+        rqSubmit(); // texture frees queued by level changes
+      }
+      profEndFrame();
+      t.frames++;
+    }
+
+    benchPrintRow(label, t, withRender);
+    all.platforms += t.platforms;
+    all.players += t.players;
+    all.entities += t.entities;
+    all.particles += t.particles;
+    all.render += t.render;
+    all.frames += t.frames;
+    all.deaths += t.deaths;
+    all.clears += t.clears;
+    all.copies += t.copies;
+    all.fills += t.fills;
+    all.textureSwitches += t.textureSwitches;
+    all.pairsTested += t.pairsTested;
+    all.pairsHit += t.pairsHit;
+  }
+  benchPrintRow("all", all, withRender);
+  static const char *const kPoolNames[POOL_COUNT] = {
+      "enemies", "projectiles", "items", "platforms", "generators"};
+  printf("%-12s %5s %5s %8s\n", "pool", "cap", "peak", "full");
+  for (int i = 0; i < POOL_COUNT; i++) {
+    const EntityPool &pool = g_entityPools[i];
+    printf("%-12s %5d %5d %8d\n", kPoolNames[i], pool.cap, pool.peak,
+           pool.failures);
+  }
+  if (profilePath && !profDumpCsv(profilePath))
+    fprintf(stderr, "could not write %s\n", profilePath);
+
+  stopSectionPrefetch();
+  stopMusicStreaming();
+  rqShutdown();
+  SDL_Quit();
+  return 0;
 }
 
+int main(int argc, char **argv) {
+  if (argc == 2 && strcmp(argv[1], "-t") == 0)
+    return runHostChecks();
+  return runHostBench(argc, argv);
+}
+#else
 int main(int argc, char **argv) {
   WHBProcInit();
   VPADInit();
@@ -6154,98 +8834,71 @@ int main(int argc, char **argv) {
   WPADEnableURCC(TRUE);
   SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
   IMG_Init(IMG_INIT_PNG);
-  Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 4096);
-  Mix_AllocateChannels(32);
-  Mix_ReserveChannels(0);
+  openAudio();
+  startMusicStreaming();
+  inputServiceStart();
   srand((unsigned)SDL_GetTicks());
+  contentIndexInit();
 
-  g_win = SDL_CreateWindow("SMB", 0, 0, TV_W, TV_H, SDL_WINDOW_FULLSCREEN);
-  g_ren = SDL_CreateRenderer(
-      g_win, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-  SDL_RenderSetLogicalSize(g_ren, GAME_W, GAME_H);
+  rqInit("SMB", TV_W, TV_H, SDL_WINDOW_FULLSCREEN,
+         SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC, GAME_W, GAME_H);
 
   loadAssets();
+  startSectionPrefetch();
   g_state = GS_TITLE;
   g_titleMode = TITLE_MAIN;
   g_mainMenuIndex = 0;
   g_menuIndex = g_charIndex;
 
-  Uint32 lastTick = SDL_GetTicks();
+  const Uint64 perfFreq = SDL_GetPerformanceFrequency();
+  Uint64 lastCounter = SDL_GetPerformanceCounter();
+  double simAcc = 0.0;
   while (WHBProcIsRunning()) {
-    Uint32 now = SDL_GetTicks();
-    float dt = (now - lastTick) / 1000.0f;
-    lastTick = now;
-    if (dt > 0.1f)
-      dt = 0.1f;
+    profEndFrame();
+    ProfScope prof(PROF_INPUT);
+    Uint64 nowCounter = SDL_GetPerformanceCounter();
+    double frameSec = (double)(nowCounter - lastCounter) / (double)perfFreq;
+    lastCounter = nowCounter;
+    if (frameSec > 0.25)
+      frameSec = 0.25;
+    simAcc += frameSec;
 
     input();
 
-    if (g_pressed & VPAD_BUTTON_PLUS) {
-      if (g_state == GS_PLAYING)
-        g_state = GS_PAUSE;
-      else if (g_state == GS_PAUSE)
-        g_state = GS_PLAYING;
-      if (g_state == GS_PAUSE)
-        g_pauseIndex = 0;
-    }
-
-    // Cycle theme/level (demo): press MINUS to switch tilesets.
-    if (g_pressed & VPAD_BUTTON_MINUS) {
-      g_theme = (LevelTheme)(((int)g_theme + 1) % 3);
-      loadThemeTilesets();
-      setupLevel();
-    }
-
-    if (g_state == GS_TITLE) {
-      updateTitle();
-    } else if (g_state == GS_PAUSE) {
-      updatePauseMenu();
-    } else if (g_state == GS_PLAYING) {
-      updatePlatformsAndGenerators(dt);
-      updatePlayers(dt);
-      updateEntities(dt);
-      updateAmbientParticles(dt);
-      g_timeAcc += dt;
-      if (g_timeAcc >= 1.0f) {
-        g_timeAcc -= 1.0f;
-        g_time--;
-        if (g_time <= 0) {
-          g_p.dead = true;
-          g_p.lives--;
-          g_state = GS_DEAD;
-        }
-      }
-    } else if (g_state == GS_FLAG) {
-      updateFlagSequence(dt);
-      updateAmbientParticles(dt);
-      updateCameraFromLeader();
-      enforceNonLeaderPlayersInView();
-    } else if (g_state == GS_DEAD) {
-      if (g_pressed & VPAD_BUTTON_A) {
-        if (g_p.lives > 0)
-          restartLevel();
-        else
-          g_state = GS_GAMEOVER;
-      }
-    } else if (g_state == GS_WIN) {
-      g_levelTimer += dt;
-      if (g_levelTimer > 2.0f) {
-        nextLevel();
-      }
-    } else if (g_state == GS_GAMEOVER) {
-      if (g_pressed & VPAD_BUTTON_A)
-        startNewGame();
+    prof.next(PROF_SIM);
+    const double step = 1.0 / (double)g_simHz;
+    int steps = 0;
+    while (simAcc >= step && steps < SIM_MAX_STEPS_PER_FRAME) {
+      // The step covers simulated time up to `simAcc - step` seconds before
+      // now; it gets the input events from before that point. Later events
+      // wait for the next step, even if that is next frame.
+      double lag = simAcc - step;
+      consumeInputUntil(nowCounter - (Uint64)(lag * (double)perfFreq));
+      snapshotRenderState();
+      simulateStep((float)step);
+      simAcc -= step;
+      steps++;
     }
-
+    // After a long hitch, drop the backlog instead of spiralling.
+    if (simAcc >= step)
+      simAcc = fmod(simAcc, step);
+    g_renderAlpha = (float)(simAcc / step);
+
+    prof.next(PROF_STREAM);
+    pumpSectionPrefetch();
+    pumpMusic();
     render();
   }
 
+  stopSectionPrefetch();
+  stopMusicStreaming();
+  inputServiceStop();
+  rqShutdown();
   Mix_CloseAudio();
-  SDL_DestroyRenderer(g_ren);
-  SDL_DestroyWindow(g_win);
   IMG_Quit();
   SDL_Quit();
   KPADShutdown();
   WHBProcShutdown();
   return 0;
 }
+#endif
@@ -0,0 +1,127 @@
+#include "profiler.h"
+
+#ifdef SMB_HOST
+#include "host_platform.h"
+#else
+#include <SDL2/SDL.h>
+#endif
+
+#include <atomic>
+#include <cstdio>
+
+static const char *const kZoneNames[PROF_ZONE_COUNT] = {
+    "INPUT", "SIM",   "PLATFORMS", "PLAYERS", "ENTITIES", "STREAM",
+    "BG",    "TILES", "SPRITES",   "HUD",     "PRESENT"};
+
+static const ProfColor kZoneColors[PROF_ZONE_COUNT] = {
+    {255, 255, 255}, {120, 120, 255}, {80, 200, 255}, {80, 255, 160},
+    {255, 230, 80},  {200, 120, 255}, {60, 140, 60},  {200, 140, 80},
+    {255, 120, 60},  {255, 80, 160},  {140, 140, 140}};
+
+// Ticks charged to each zone since the last profEndFrame(). 32 bits of
+// performance-counter ticks cover far more than one frame on every target.
+static std::atomic<uint32_t> g_profAccum[PROF_ZONE_COUNT];
+
+// Frame k lives in slot k % PROF_HISTORY; g_profHead counts committed frames.
+static ProfFrame g_profRing[PROF_HISTORY];
+static std::atomic<uint32_t> g_profHead{0};
+static uint64_t g_profLastEnd = 0;
+
+static thread_local ProfScope *t_profTop = nullptr;
+
+const char *profZoneName(ProfZone zone) { return kZoneNames[zone]; }
+
+ProfColor profZoneColor(ProfZone zone) { return kZoneColors[zone]; }
+
+ProfScope::ProfScope(ProfZone zone)
+    : zone_(zone), begin_(SDL_GetPerformanceCounter()), lapStart_(begin_),
+      parent_(t_profTop) {
+  t_profTop = this;
+}
+
+ProfScope::~ProfScope() {
+  uint64_t now = SDL_GetPerformanceCounter();
+  charge(now);
+  t_profTop = parent_;
+  if (parent_)
+    parent_->childTicks_ += now - begin_;
+}
+
+void ProfScope::next(ProfZone zone) {
+  uint64_t now = SDL_GetPerformanceCounter();
+  charge(now);
+  zone_ = zone;
+  lapStart_ = now;
+  childTicks_ = 0;
+}
+
+void ProfScope::charge(uint64_t now) {
+  uint64_t elapsed = now - lapStart_;
+  uint64_t self = elapsed > childTicks_ ? elapsed - childTicks_ : 0;
+  g_profAccum[zone_].fetch_add((uint32_t)self, std::memory_order_relaxed);
+}
+
+static uint32_t ticksToUs(uint64_t ticks, uint64_t freq) {
+  return freq ? (uint32_t)(ticks * 1000000u / freq) : 0;
+}
+
+void profEndFrame() {
+  uint64_t freq = SDL_GetPerformanceFrequency();
+  uint64_t now = SDL_GetPerformanceCounter();
+  uint32_t head = g_profHead.load(std::memory_order_relaxed);
+  ProfFrame &f = g_profRing[head % PROF_HISTORY];
+  for (int z = 0; z < PROF_ZONE_COUNT; z++)
+    f.zoneUs[z] = ticksToUs(
+        g_profAccum[z].exchange(0, std::memory_order_relaxed), freq);
+  f.frameUs = g_profLastEnd ? ticksToUs(now - g_profLastEnd, freq) : 0;
+  g_profLastEnd = now;
+  g_profHead.store(head + 1, std::memory_order_release);
+}
+
+int profCopyHistory(ProfFrame *out, int max) {
+  // The slot after the newest frame is the one the writer fills next, so at
+  // most PROF_HISTORY - 1 frames are stable.
+  uint32_t head = g_profHead.load(std::memory_order_acquire);
+  uint32_t n = head < (uint32_t)PROF_HISTORY - 1 ? head
+                                                 : (uint32_t)PROF_HISTORY - 1;
+  if (max < 0)
+    max = 0;
+  if (n > (uint32_t)max)
+    n = (uint32_t)max;
+  uint32_t first = head - n;
+  for (uint32_t i = 0; i < n; i++)
+    out[i] = g_profRing[(first + i) % PROF_HISTORY];
+
+  // If the writer committed frames meanwhile it may have lapped the oldest
+  // copies; drop every frame whose slot it has reached.
+  uint32_t after = g_profHead.load(std::memory_order_acquire);
+  uint32_t valid = after - (uint32_t)PROF_HISTORY + 1;
+  if (after >= (uint32_t)PROF_HISTORY && (int32_t)(valid - first) > 0) {
+    uint32_t drop = valid - first;
+    if (drop > n)
+      drop = n;
+    for (uint32_t i = drop; i < n; i++)
+      out[i - drop] = out[i];
+    n -= drop;
+  }
+  return (int)n;
+}
+
+bool profDumpCsv(const char *path) {
+  static ProfFrame frames[PROF_HISTORY];
+  int n = profCopyHistory(frames, PROF_HISTORY);
+  FILE *f = fopen(path, "w");
+  if (!f)
+    return false;
+  fprintf(f, "frame_us");
+  for (int z = 0; z < PROF_ZONE_COUNT; z++)
+    fprintf(f, ",%s", kZoneNames[z]);
+  fprintf(f, "\n");
+  for (int i = 0; i < n; i++) {
+    fprintf(f, "%u", (unsigned)frames[i].frameUs);
+    for (int z = 0; z < PROF_ZONE_COUNT; z++)
+      fprintf(f, ",%u", (unsigned)frames[i].zoneUs[z]);
+    fprintf(f, "\n");
+  }
+  return fclose(f) == 0;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+
+// Per-frame CPU timing by phase. ProfScope charges the time it is open to a
+// zone, minus any nested scopes (which charge their own zones), so the zones
+// of a frame stack up to the frame time without double counting. profEndFrame()
+// commits the frame into a PROF_HISTORY ring that the overlay graph and the CSV
+// dump read. Scopes may be opened on any thread; the ring has a single writer
+// (whoever calls profEndFrame) and readers never block it.
+enum ProfZone {
+  PROF_INPUT,
+  PROF_SIM,
+  PROF_PLATFORMS,
+  PROF_PLAYERS,
+  PROF_ENTITIES,
+  PROF_STREAM,
+  PROF_RENDER_BG,
+  PROF_RENDER_TILES,
+  PROF_RENDER_SPRITES,
+  PROF_RENDER_HUD,
+  PROF_PRESENT,
+  PROF_ZONE_COUNT
+};
+
+constexpr int PROF_HISTORY = 256;
+
+struct ProfFrame {
+  uint32_t zoneUs[PROF_ZONE_COUNT];
+  uint32_t frameUs; // wall time since the previous profEndFrame()
+};
+
+struct ProfColor {
+  uint8_t r, g, b;
+};
+
+const char *profZoneName(ProfZone zone);
+ProfColor profZoneColor(ProfZone zone);
+
+class ProfScope {
+public:
+  explicit ProfScope(ProfZone zone);
+  ~ProfScope();
+  ProfScope(const ProfScope &) = delete;
+  ProfScope &operator=(const ProfScope &) = delete;
+
+  // Charges the time so far to the current zone and continues in `zone`, for
+  // functions that run several phases back to back.
+  void next(ProfZone zone);
+
+private:
+  void charge(uint64_t now);
+
+  ProfZone zone_;
+  uint64_t begin_;
+  uint64_t lapStart_;
+  uint64_t childTicks_ = 0;
+  ProfScope *parent_;
+};
+
+void profEndFrame();
+
+// Copies up to `max` (at most PROF_HISTORY - 1) of the most recent frames,
+// oldest first, into `out`. Returns how many were copied.
+int profCopyHistory(ProfFrame *out, int max);
+
+// Writes the whole history as CSV (one row per frame, one column per zone,
+// microseconds). Returns false if the file could not be written.
+bool profDumpCsv(const char *path);
@@ -0,0 +1,474 @@
+#include "render_queue.h"
+
+#ifndef SMB_HOST
+#include <coreinit/thread.h>
+#endif
+
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
+enum RenderCmdType : uint8_t {
+  RC_DRAW_COLOR,
+  RC_DRAW_BLEND,
+  RC_CLEAR,
+  RC_FILL_RECT,
+  RC_DRAW_RECT,
+  RC_COPY,
+  RC_COPY_EX,
+  RC_GEOMETRY,
+  RC_TARGET,
+  RC_TEX_COLOR_MOD,
+  RC_TEX_ALPHA_MOD,
+  RC_DESTROY,
+  RC_PRESENT
+};
+
+constexpr uint8_t RC_HAS_SRC = 1;
+constexpr uint8_t RC_HAS_DST = 2;
+constexpr uint8_t RC_HAS_CENTER = 4;
+constexpr uint8_t RC_HAS_INDICES = 8;
+
+struct RenderCmd {
+  RenderCmdType type;
+  uint8_t flags;
+  SDL_Color color; // draw color, texture mods
+  int mode;        // blend mode or flip
+  SDL_Texture *tex;
+  SDL_Rect src, dst;
+  SDL_Point center;
+  double angle;
+  int first, count;           // vertex range
+  int indexFirst, indexCount; // index range
+};
+
+// One frame's commands plus the vertex/index data they point into. Both lists
+// keep their capacity, so steady-state recording does not allocate.
+struct RenderList {
+  std::vector<RenderCmd> cmds;
+  std::vector<SDL_Vertex> verts;
+  std::vector<int> indices;
+
+  void clear() {
+    cmds.clear();
+    verts.clear();
+    indices.clear();
+  }
+};
+
+struct TextureRequest {
+  SDL_Surface *surf; // nullptr: blank texture of format/access/w/h
+  Uint32 format;
+  int access, w, h;
+  SDL_BlendMode mode;
+  SDL_Texture *result;
+  bool done;
+};
+
+struct TextureInfo {
+  int w, h;
+  SDL_BlendMode mode;
+};
+
+struct WindowRequest {
+  const char *title;
+  int w, h;
+  Uint32 windowFlags, rendererFlags;
+  int logicalW, logicalH;
+};
+
+static SDL_Window *g_rqWin = nullptr;
+static SDL_Renderer *g_rqRen = nullptr;
+static RenderList g_rqLists[2];
+static int g_rqBuild = 0; // list the game thread records into
+static SDL_Texture *g_rqTarget = nullptr;
+static bool g_rqTargetSupported = false;
+// Game thread only, like the build list.
+static std::unordered_map<SDL_Texture *, TextureInfo> g_rqTextures;
+
+// Handoff state, guarded by g_rqLock. A queued list is replayed in full before
+// the next one is accepted, which keeps the game thread one frame ahead at most.
+static SDL_Thread *g_rqThread = nullptr;
+static SDL_mutex *g_rqLock = nullptr;
+static SDL_cond *g_rqCond = nullptr;
+static RenderList *g_rqQueued = nullptr;
+static bool g_rqBusy = false;
+static bool g_rqQuit = false;
+static bool g_rqStarted = false; // window and renderer attempted
+// Polled between replayed commands so a texture request never waits for a
+// whole frame (a pending present still has to finish first).
+static std::atomic<TextureRequest *> g_rqRequest{nullptr};
+
+static RenderList &buildList() { return g_rqLists[g_rqBuild]; }
+
+static RenderCmd &pushCmd(RenderCmdType type) {
+  RenderList &l = buildList();
+  l.cmds.emplace_back();
+  RenderCmd &c = l.cmds.back();
+  c.type = type;
+  c.flags = 0;
+  return c;
+}
+
+static SDL_Texture *createRequested(const TextureRequest &req) {
+  SDL_Texture *t =
+      req.surf ? SDL_CreateTextureFromSurface(g_rqRen, req.surf)
+               : SDL_CreateTexture(g_rqRen, req.format, req.access, req.w,
+                                   req.h);
+  if (t)
+    SDL_SetTextureBlendMode(t, req.mode);
+  return t;
+}
+
+static void serviceRequest() {
+  TextureRequest *req = g_rqRequest.load(std::memory_order_acquire);
+  if (!req)
+    return;
+  SDL_Texture *t = createRequested(*req);
+  SDL_LockMutex(g_rqLock);
+  req->result = t;
+  req->done = true;
+  g_rqRequest.store(nullptr, std::memory_order_relaxed);
+  SDL_CondBroadcast(g_rqCond);
+  SDL_UnlockMutex(g_rqLock);
+}
+
+static void replay(const RenderList &l) {
+  for (const RenderCmd &c : l.cmds) {
+    if (g_rqThread && g_rqRequest.load(std::memory_order_relaxed))
+      serviceRequest();
+    const SDL_Rect *src = (c.flags & RC_HAS_SRC) ? &c.src : nullptr;
+    const SDL_Rect *dst = (c.flags & RC_HAS_DST) ? &c.dst : nullptr;
+    switch (c.type) {
+    case RC_DRAW_COLOR:
+      SDL_SetRenderDrawColor(g_rqRen, c.color.r, c.color.g, c.color.b,
+                             c.color.a);
+      break;
+    case RC_DRAW_BLEND:
+      SDL_SetRenderDrawBlendMode(g_rqRen, (SDL_BlendMode)c.mode);
+      break;
+    case RC_CLEAR:
+      SDL_RenderClear(g_rqRen);
+      break;
+    case RC_FILL_RECT:
+      SDL_RenderFillRect(g_rqRen, dst);
+      break;
+    case RC_DRAW_RECT:
+      SDL_RenderDrawRect(g_rqRen, dst);
+      break;
+    case RC_COPY:
+      SDL_RenderCopy(g_rqRen, c.tex, src, dst);
+      break;
+    case RC_COPY_EX:
+      SDL_RenderCopyEx(g_rqRen, c.tex, src, dst, c.angle,
+                       (c.flags & RC_HAS_CENTER) ? &c.center : nullptr,
+                       (SDL_RendererFlip)c.mode);
+      break;
+    case RC_GEOMETRY:
+      SDL_RenderGeometry(g_rqRen, c.tex, l.verts.data() + c.first, c.count,
+                         (c.flags & RC_HAS_INDICES)
+                             ? l.indices.data() + c.indexFirst
+                             : nullptr,
+                         c.indexCount);
+      break;
+    case RC_TARGET:
+      SDL_SetRenderTarget(g_rqRen, c.tex);
+      break;
+    case RC_TEX_COLOR_MOD:
+      SDL_SetTextureColorMod(c.tex, c.color.r, c.color.g, c.color.b);
+      break;
+    case RC_TEX_ALPHA_MOD:
+      SDL_SetTextureAlphaMod(c.tex, c.color.a);
+      break;
+    case RC_DESTROY:
+      SDL_DestroyTexture(c.tex);
+      break;
+    case RC_PRESENT:
+      SDL_RenderPresent(g_rqRen);
+      break;
+    }
+  }
+}
+
+static bool openRenderer(const WindowRequest &req) {
+  g_rqWin = SDL_CreateWindow(req.title, 0, 0, req.w, req.h, req.windowFlags);
+  if (g_rqWin)
+    g_rqRen = SDL_CreateRenderer(g_rqWin, -1, req.rendererFlags);
+  if (!g_rqRen)
+    return false;
+  if (req.logicalW > 0 && req.logicalH > 0)
+    SDL_RenderSetLogicalSize(g_rqRen, req.logicalW, req.logicalH);
+  g_rqTargetSupported = SDL_RenderTargetSupported(g_rqRen);
+  return true;
+}
+
+static void closeRenderer() {
+  if (g_rqRen)
+    SDL_DestroyRenderer(g_rqRen);
+  if (g_rqWin)
+    SDL_DestroyWindow(g_rqWin);
+  g_rqRen = nullptr;
+  g_rqWin = nullptr;
+}
+
+static int renderThreadMain(void *arg) {
+#ifndef SMB_HOST
+  // The game thread keeps the main core; submission gets one of the others.
+  OSSetThreadAffinity(OSGetCurrentThread(), OS_THREAD_ATTRIB_AFFINITY_CPU2);
+#endif
+  bool opened = openRenderer(*(const WindowRequest *)arg);
+  SDL_LockMutex(g_rqLock);
+  g_rqStarted = true;
+  SDL_CondBroadcast(g_rqCond);
+  while (opened) {
+    while (!g_rqQuit && !g_rqQueued &&
+           !g_rqRequest.load(std::memory_order_relaxed))
+      SDL_CondWait(g_rqCond, g_rqLock);
+    if (g_rqRequest.load(std::memory_order_relaxed)) {
+      SDL_UnlockMutex(g_rqLock);
+      serviceRequest();
+      SDL_LockMutex(g_rqLock);
+      continue;
+    }
+    if (!g_rqQueued)
+      break; // quit, with nothing left to draw
+    RenderList *l = g_rqQueued;
+    g_rqQueued = nullptr;
+    g_rqBusy = true;
+    SDL_UnlockMutex(g_rqLock);
+    replay(*l);
+    SDL_LockMutex(g_rqLock);
+    g_rqBusy = false;
+    SDL_CondBroadcast(g_rqCond);
+  }
+  SDL_UnlockMutex(g_rqLock);
+  closeRenderer();
+  return 0;
+}
+
+bool rqInit(const char *title, int w, int h, Uint32 windowFlags,
+            Uint32 rendererFlags, int logicalW, int logicalH) {
+  WindowRequest req = {title,         w,        h,       windowFlags,
+                       rendererFlags, logicalW, logicalH};
+  g_rqLock = SDL_CreateMutex();
+  g_rqCond = SDL_CreateCond();
+  g_rqQuit = false;
+  g_rqStarted = false;
+  if (g_rqLock && g_rqCond)
+    g_rqThread = SDL_CreateThread(renderThreadMain, "smb_render", &req);
+  if (!g_rqThread) {
+    // Without a thread every rqPresent() replays inline.
+    if (!openRenderer(req)) {
+      closeRenderer();
+      return false;
+    }
+    return true;
+  }
+  SDL_LockMutex(g_rqLock);
+  while (!g_rqStarted)
+    SDL_CondWait(g_rqCond, g_rqLock);
+  SDL_UnlockMutex(g_rqLock);
+  if (!g_rqRen) {
+    // The thread has already given up; reap it.
+    SDL_WaitThread(g_rqThread, nullptr);
+    g_rqThread = nullptr;
+    return false;
+  }
+  return true;
+}
+
+void rqShutdown() {
+  if (g_rqThread) {
+    SDL_LockMutex(g_rqLock);
+    g_rqQuit = true;
+    SDL_CondBroadcast(g_rqCond);
+    SDL_UnlockMutex(g_rqLock);
+    SDL_WaitThread(g_rqThread, nullptr);
+    g_rqThread = nullptr;
+  } else {
+    closeRenderer();
+  }
+  SDL_DestroyCond(g_rqCond);
+  SDL_DestroyMutex(g_rqLock);
+  g_rqCond = nullptr;
+  g_rqLock = nullptr;
+}
+
+void rqFinish() {
+  if (!g_rqThread)
+    return;
+  SDL_LockMutex(g_rqLock);
+  while (g_rqQueued || g_rqBusy)
+    SDL_CondWait(g_rqCond, g_rqLock);
+  SDL_UnlockMutex(g_rqLock);
+}
+
+void rqSetDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+  pushCmd(RC_DRAW_COLOR).color = {r, g, b, a};
+}
+
+void rqSetDrawBlendMode(SDL_BlendMode mode) {
+  pushCmd(RC_DRAW_BLEND).mode = (int)mode;
+}
+
+void rqClear() { pushCmd(RC_CLEAR); }
+
+void rqFillRect(const SDL_Rect *rect) {
+  RenderCmd &c = pushCmd(RC_FILL_RECT);
+  if (rect) {
+    c.dst = *rect;
+    c.flags |= RC_HAS_DST;
+  }
+}
+
+void rqDrawRect(const SDL_Rect *rect) {
+  RenderCmd &c = pushCmd(RC_DRAW_RECT);
+  if (rect) {
+    c.dst = *rect;
+    c.flags |= RC_HAS_DST;
+  }
+}
+
+void rqCopy(SDL_Texture *tex, const SDL_Rect *src, const SDL_Rect *dst) {
+  RenderCmd &c = pushCmd(RC_COPY);
+  c.tex = tex;
+  if (src) {
+    c.src = *src;
+    c.flags |= RC_HAS_SRC;
+  }
+  if (dst) {
+    c.dst = *dst;
+    c.flags |= RC_HAS_DST;
+  }
+}
+
+void rqCopyEx(SDL_Texture *tex, const SDL_Rect *src, const SDL_Rect *dst,
+              double angle, const SDL_Point *center, SDL_RendererFlip flip) {
+  rqCopy(tex, src, dst);
+  RenderCmd &c = buildList().cmds.back();
+  c.type = RC_COPY_EX;
+  c.angle = angle;
+  c.mode = (int)flip;
+  if (center) {
+    c.center = *center;
+    c.flags |= RC_HAS_CENTER;
+  }
+}
+
+void rqGeometry(SDL_Texture *tex, const SDL_Vertex *verts, int numVerts,
+                const int *indices, int numIndices) {
+  if (numVerts <= 0)
+    return;
+  RenderList &l = buildList();
+  RenderCmd &c = pushCmd(RC_GEOMETRY);
+  c.tex = tex;
+  c.first = (int)l.verts.size();
+  c.count = numVerts;
+  l.verts.insert(l.verts.end(), verts, verts + numVerts);
+  c.indexFirst = (int)l.indices.size();
+  c.indexCount = 0;
+  if (indices && numIndices > 0) {
+    c.flags |= RC_HAS_INDICES;
+    c.indexCount = numIndices;
+    l.indices.insert(l.indices.end(), indices, indices + numIndices);
+  }
+}
+
+int rqSetTarget(SDL_Texture *tex) {
+  pushCmd(RC_TARGET).tex = tex;
+  g_rqTarget = tex;
+  return 0;
+}
+
+SDL_Texture *rqTarget() { return g_rqTarget; }
+
+void rqSetTextureColorMod(SDL_Texture *tex, Uint8 r, Uint8 g, Uint8 b) {
+  RenderCmd &c = pushCmd(RC_TEX_COLOR_MOD);
+  c.tex = tex;
+  c.color = {r, g, b, 255};
+}
+
+void rqSetTextureAlphaMod(SDL_Texture *tex, Uint8 a) {
+  RenderCmd &c = pushCmd(RC_TEX_ALPHA_MOD);
+  c.tex = tex;
+  c.color = {255, 255, 255, a};
+}
+
+void rqPresent() {
+  pushCmd(RC_PRESENT);
+  rqSubmit();
+}
+
+void rqSubmit() {
+  if (buildList().cmds.empty())
+    return;
+  if (!g_rqThread) {
+    replay(buildList());
+    buildList().clear();
+    return;
+  }
+  SDL_LockMutex(g_rqLock);
+  while (g_rqQueued || g_rqBusy)
+    SDL_CondWait(g_rqCond, g_rqLock);
+  g_rqQueued = &buildList();
+  g_rqBuild ^= 1;
+  SDL_CondBroadcast(g_rqCond);
+  SDL_UnlockMutex(g_rqLock);
+  buildList().clear();
+}
+
+static SDL_Texture *requestTexture(TextureRequest &req) {
+  if (!g_rqThread) {
+    req.result = createRequested(req);
+  } else {
+    SDL_LockMutex(g_rqLock);
+    g_rqRequest.store(&req, std::memory_order_release);
+    SDL_CondBroadcast(g_rqCond);
+    while (!req.done)
+      SDL_CondWait(g_rqCond, g_rqLock);
+    SDL_UnlockMutex(g_rqLock);
+  }
+  if (req.result)
+    g_rqTextures[req.result] = {req.w, req.h, req.mode};
+  return req.result;
+}
+
+SDL_Texture *rqCreateTextureFromSurface(SDL_Surface *surf, SDL_BlendMode mode) {
+  if (!surf)
+    return nullptr;
+  TextureRequest req = {surf, 0, 0, surf->w, surf->h, mode, nullptr, false};
+  return requestTexture(req);
+}
+
+SDL_Texture *rqCreateTexture(Uint32 format, int access, int w, int h,
+                             SDL_BlendMode mode) {
+  TextureRequest req = {nullptr, format, access, w, h, mode, nullptr, false};
+  return requestTexture(req);
+}
+
+void rqDestroyTexture(SDL_Texture *tex) {
+  if (!tex)
+    return;
+  g_rqTextures.erase(tex);
+  pushCmd(RC_DESTROY).tex = tex;
+}
+
+bool rqTextureInfo(SDL_Texture *tex, int *w, int *h, SDL_BlendMode *mode) {
+  auto it = tex ? g_rqTextures.find(tex) : g_rqTextures.end();
+  bool known = it != g_rqTextures.end();
+  if (w)
+    *w = known ? it->second.w : 0;
+  if (h)
+    *h = known ? it->second.h : 0;
+  if (mode)
+    *mode = known ? it->second.mode : SDL_BLENDMODE_NONE;
+  return known;
+}
+
+bool rqTargetSupported() { return g_rqTargetSupported; }
+
+#ifdef SMB_HOST
+HostRenderStats rqHostStats() {
+  return g_rqRen ? g_rqRen->stats : HostRenderStats{};
+}
+#endif
@@ -0,0 +1,69 @@
+#pragma once
+
+#ifdef SMB_HOST
+#include "host_platform.h"
+#else
+#include <SDL2/SDL.h>
+#endif
+
+// Render command queue. The game thread records a frame's draw calls with the
+// rq* functions below instead of calling SDL_Renderer directly; rqPresent()
+// hands the finished list to a render thread that replays it and presents,
+// while the game thread simulates and records the next frame into the other
+// of two lists. Only the render thread touches the renderer: it creates the
+// window and renderer in rqInit() and destroys them in rqShutdown(), textures
+// are created there on request (the game thread blocks until the texture
+// exists) and destroyed in command order, after every earlier use.
+//
+// Recorded calls copy their arguments (rects, vertices, indices), so callers
+// may reuse their buffers immediately. Calls that return an SDL status always
+// succeed at record time; a failure on replay only loses that draw.
+
+// Starts the render thread, which opens a `w` x `h` window and its renderer
+// (with a `logicalW` x `logicalH` logical size unless those are 0). Blocks
+// until both exist; false if either could not be created.
+bool rqInit(const char *title, int w, int h, Uint32 windowFlags,
+            Uint32 rendererFlags, int logicalW, int logicalH);
+void rqShutdown();
+
+// Blocks until every handed-off frame has been replayed and presented.
+void rqFinish();
+
+void rqSetDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+void rqSetDrawBlendMode(SDL_BlendMode mode);
+void rqClear();
+void rqFillRect(const SDL_Rect *rect);
+void rqDrawRect(const SDL_Rect *rect);
+void rqCopy(SDL_Texture *tex, const SDL_Rect *src, const SDL_Rect *dst);
+void rqCopyEx(SDL_Texture *tex, const SDL_Rect *src, const SDL_Rect *dst,
+              double angle, const SDL_Point *center, SDL_RendererFlip flip);
+void rqGeometry(SDL_Texture *tex, const SDL_Vertex *verts, int numVerts,
+                const int *indices, int numIndices);
+int rqSetTarget(SDL_Texture *tex);
+SDL_Texture *rqTarget(); // as recorded so far, not as replayed
+void rqSetTextureColorMod(SDL_Texture *tex, Uint8 r, Uint8 g, Uint8 b);
+void rqSetTextureAlphaMod(SDL_Texture *tex, Uint8 a);
+void rqPresent();
+// Hands off whatever was recorded without presenting, for frames that draw
+// nothing but still queued texture destruction.
+void rqSubmit();
+
+// Runs on the render thread; blocks the caller until the texture exists.
+SDL_Texture *rqCreateTextureFromSurface(SDL_Surface *surf, SDL_BlendMode mode);
+SDL_Texture *rqCreateTexture(Uint32 format, int access, int w, int h,
+                             SDL_BlendMode mode);
+void rqDestroyTexture(SDL_Texture *tex);
+
+// Size and blend mode recorded when the texture was created, so the game
+// thread never has to query the renderer. False (and zeros) for a texture the
+// queue didn't create or has already been asked to destroy.
+bool rqTextureInfo(SDL_Texture *tex, int *w, int *h,
+                   SDL_BlendMode *mode = nullptr);
+// Whether the renderer supports rqSetTarget() on a target texture; checked
+// once in rqInit().
+bool rqTargetSupported();
+
+#ifdef SMB_HOST
+// The stub renderer's counters; only stable after rqFinish().
+HostRenderStats rqHostStats();
+#endif
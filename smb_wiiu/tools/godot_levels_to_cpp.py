@@ -474,6 +474,180 @@ def to_world_px(pos: tuple[float, float], x_offset: int, y_offset: int) -> tuple
     return (pos[0] + x_offset * TILE, pos[1] + y_offset * TILE)
 
 
+def read_enum_values(path: Path) -> dict[str, int]:
+    """Enumerator name -> value for every plain enum in a C++ header."""
+    values: dict[str, int] = {}
+    text = re.sub(r"//[^\n]*", "", path.read_text())
+    for body in re.findall(r"\benum\b[^{;]*\{([^}]*)\}", text):
+        nxt = 0
+        for item in body.split(","):
+            item = item.strip()
+            if not item:
+                continue
+            name, _, val = item.partition("=")
+            name = name.strip()
+            if val.strip():
+                val = val.strip()
+                nxt = values[val] if val in values else int(val, 0)
+            values[name] = nxt
+            nxt += 1
+    return values
+
+
+# Level pack layout (all integers little-endian), read by src/levels.cpp:
+#   header   "SMBL" u32 version u32 levelCount u32 sectionCount
+#   levels   levelCount x { char name[8] i32 world i32 stage
+#                           u32 firstSection u32 sectionCount }
+#   sections sectionCount x { u32 offset u32 size }
+#   blobs    per section: LEVEL_PACK_SECTION fields, pipes, enemies, then the
+#            map/atlasT/atlasX/atlasY/collide/qmeta planes as
+#            { u8 fill u32 packedSize bytes[packedSize] }
+# Planes are stored as MAP_H rows of `cols` bytes, PackBits-style RLE: a
+# control byte c < 128 copies c+1 literal bytes, c >= 128 repeats the next
+# byte c-126 times. Columns >= cols hold `fill` in every row.
+LEVEL_PACK_MAGIC = b"SMBL"
+LEVEL_PACK_VERSION = 1
+LEVEL_PACK_HEADER = struct.Struct("<4sIII")
+LEVEL_PACK_LEVEL = struct.Struct("<8siiII")
+LEVEL_PACK_ENTRY = struct.Struct("<II")
+LEVEL_PACK_SECTION = struct.Struct("<HHHBBiiiiiiHH")
+LEVEL_PACK_PIPE = struct.Struct("<iiiiiii")
+LEVEL_PACK_ENEMY = struct.Struct("<iffiii")
+LEVEL_PACK_PLANES = ("grid", "atlas_t", "atlas_x", "atlas_y", "collide", "qmeta")
+
+
+def rle_encode(data: bytes) -> bytes:
+    out = bytearray()
+    lit = bytearray()
+    i = 0
+    n = len(data)
+    while i < n:
+        run = 1
+        while i + run < n and run < 129 and data[i + run] == data[i]:
+            run += 1
+        if run >= 2:
+            while lit:
+                chunk = lit[:128]
+                out.append(len(chunk) - 1)
+                out += chunk
+                del lit[:128]
+            out.append(run + 126)
+            out.append(data[i])
+            i += run
+        else:
+            lit.append(data[i])
+            i += 1
+    while lit:
+        chunk = lit[:128]
+        out.append(len(chunk) - 1)
+        out += chunk
+        del lit[:128]
+    return bytes(out)
+
+
+def used_columns(planes: list[list[list[int]]]) -> int:
+    """Smallest column count after which every plane is a constant fill."""
+    cols = 0
+    for plane in planes:
+        fill = plane[0][MAP_W - 1]
+        for row in plane:
+            c = MAP_W
+            while c > cols and row[c - 1] == fill:
+                c -= 1
+            cols = max(cols, c)
+    return cols
+
+
+def pack_section(
+    s: dict,
+    level_keys: list[tuple[int, int]],
+    section_index_map: dict[tuple[int, int], dict[int, int]],
+    enums: dict[str, int],
+) -> bytes:
+    pipes = []
+    for p in s["pipes_entry"]:
+        if "target_level_index" not in p or "target_section_number" not in p:
+            continue
+        tgt_key = level_keys[p["target_level_index"]]
+        tgt_section_idx = section_index_map[tgt_key].get(p["target_section_number"])
+        if tgt_section_idx is None:
+            continue
+        pipes.append(
+            LEVEL_PACK_PIPE.pack(
+                p["tx"], p["ty"], p["target_level_index"], tgt_section_idx,
+                p.get("target_x_px", 0), p.get("target_y_px", 0), p.get("enter_dir", 0),
+            )
+        )
+    enemies = []
+    for etype, ex, ey, edir, a, b in s["enemies"]:
+        # `a` may be an enum constant (string) for generator spawn types.
+        a_val = enums[a] if isinstance(a, str) else int(a)
+        enemies.append(LEVEL_PACK_ENEMY.pack(enums[etype], ex, ey, edir, a_val, int(b)))
+
+    planes = [s[name] for name in LEVEL_PACK_PLANES]
+    cols = used_columns(planes)
+    out = bytearray(
+        LEVEL_PACK_SECTION.pack(
+            s["map_width"], s["map_height"], cols, enums[s["theme"]],
+            (1 if s["has_flag"] else 0) | (2 if s.get("bg_clouds") else 0),
+            s["flag_x"], s["start_x"], s["start_y"],
+            s.get("bg_primary", 0), s.get("bg_secondary", 0), s.get("bg_particles", 0),
+            len(pipes), len(enemies),
+        )
+    )
+    for rec in pipes + enemies:
+        out += rec
+    for plane in planes:
+        raw = bytes(v for row in plane for v in row[:cols])
+        packed = rle_encode(raw)
+        out += struct.pack("<BI", plane[0][MAP_W - 1], len(packed))
+        out += packed
+    return bytes(out)
+
+
+def write_level_pack(
+    path: Path,
+    levels: list[tuple[str, int, int, list[dict]]],
+    level_keys: list[tuple[int, int]],
+    section_index_map: dict[tuple[int, int], dict[int, int]],
+    enums: dict[str, int],
+) -> None:
+    # Sections shared between levels (embedded special sections) are stored once.
+    blobs: list[bytes] = []
+    blob_index: dict[tuple[int, int, int], int] = {}
+    section_blobs: list[int] = []
+    table = bytearray()
+    for name, world, stage, sections in levels:
+        table += LEVEL_PACK_LEVEL.pack(
+            name.encode()[:7], world, stage, len(section_blobs), len(sections)
+        )
+        for s in sections:
+            key = (s["world"], s["stage"], s["section"])
+            if key not in blob_index:
+                blob_index[key] = len(blobs)
+                blobs.append(pack_section(s, level_keys, section_index_map, enums))
+            section_blobs.append(blob_index[key])
+
+    offset = LEVEL_PACK_HEADER.size + len(table) + LEVEL_PACK_ENTRY.size * len(section_blobs)
+    blob_offsets = []
+    for blob in blobs:
+        blob_offsets.append(offset)
+        offset += len(blob)
+    entries = bytearray()
+    for b in section_blobs:
+        entries += LEVEL_PACK_ENTRY.pack(blob_offsets[b], len(blobs[b]))
+
+    out = bytearray(
+        LEVEL_PACK_HEADER.pack(LEVEL_PACK_MAGIC, LEVEL_PACK_VERSION, len(levels), len(section_blobs))
+    )
+    out += table
+    out += entries
+    for blob in blobs:
+        out += blob
+    path.parent.mkdir(parents=True, exist_ok=True)
+    path.write_bytes(bytes(out))
+
+
 def build_levels():
     uid_map = parse_uid_map()
     scene_source_index, scene_map = parse_tileset_scene_map()
@@ -1229,141 +1403,15 @@ def build_levels():
         level_sections[k] = sec_list
         section_index_map[k] = {sec["section"]: i for i, sec in enumerate(sec_list)}
 
-    # emit C++
-    out = []
-    out.append('#include "levels.h"')
-    out.append("")
-
-    # maps (include any embedded special sections)
-    emit_sections = []
-    seen = set()
+    # emit the level pack (include any embedded special sections)
+    enums = read_enum_values(ROOT / "src/game_types.h")
+    levels = []
     for k in level_keys:
-        for s in level_sections[k]:
-            key = (s["world"], s["stage"], s["section"])
-            if key in seen:
-                continue
-            seen.add(key)
-            emit_sections.append(s)
-
-    for s in emit_sections:
-        name = f"map_{s['world']}_{s['stage']}_{s['section']}"
-        out.append(f"static const uint8_t {name}[MAP_H][MAP_W] = {{")
-        for row in s["grid"]:
-            out.append("  {" + ",".join(str(v) for v in row) + "},")
-        out.append("};")
-        out.append("")
-
-        at_name = f"atlast_{s['world']}_{s['stage']}_{s['section']}"
-        ax_name = f"atlasx_{s['world']}_{s['stage']}_{s['section']}"
-        ay_name = f"atlasy_{s['world']}_{s['stage']}_{s['section']}"
-        col_name = f"collide_{s['world']}_{s['stage']}_{s['section']}"
-        qm_name = f"qmeta_{s['world']}_{s['stage']}_{s['section']}"
-        out.append(f"static const uint8_t {at_name}[MAP_H][MAP_W] = {{")
-        for row in s['atlas_t']:
-            out.append('  {' + ','.join(str(v) for v in row) + '},')
-        out.append("};")
-        out.append("")
-        out.append(f"static const uint8_t {ax_name}[MAP_H][MAP_W] = {{")
-        for row in s["atlas_x"]:
-            out.append("  {" + ",".join(str(v) for v in row) + "},")
-        out.append("};")
-        out.append("")
-        out.append(f"static const uint8_t {ay_name}[MAP_H][MAP_W] = {{")
-        for row in s["atlas_y"]:
-            out.append("  {" + ",".join(str(v) for v in row) + "},")
-        out.append("};")
-        out.append("")
-        out.append(f"static const uint8_t {col_name}[MAP_H][MAP_W] = {{")
-        for row in s['collide']:
-            out.append('  {' + ','.join(str(v) for v in row) + '},')
-        out.append("};")
-        out.append("")
-        out.append(f"static const uint8_t {qm_name}[MAP_H][MAP_W] = {{")
-        for row in s["qmeta"]:
-            out.append("  {" + ",".join(str(v) for v in row) + "},")
-        out.append("};")
-        out.append("")
-
-    # pipes and enemies
-    for s in emit_sections:
-        pipes = [
-            e
-            for e in s["pipes_entry"]
-            if "target_level_index" in e and "target_section_number" in e
-        ]
-        pname = f"pipes_{s['world']}_{s['stage']}_{s['section']}"
-        out.append(f"static const PipeLink {pname}[] = {{")
-        for p in pipes:
-            tgt_key = level_keys[p["target_level_index"]]
-            tgt_section_idx = section_index_map[tgt_key].get(p["target_section_number"])
-            if tgt_section_idx is None:
-                continue
-            out.append(
-                f"  {{{p['tx']}, {p['ty']}, {p['target_level_index']}, {tgt_section_idx}, {p.get('target_x_px', 0)}, {p.get('target_y_px', 0)}, {p.get('enter_dir', 0)}}},"
-            )
-        out.append("};")
-        out.append("")
-
-        ename = f"enemies_{s['world']}_{s['stage']}_{s['section']}"
-        out.append(f"static const EnemySpawn {ename}[] = {{")
-        for etype, ex, ey, edir, a, b in s["enemies"]:
-            # `a` may be an enum constant (string) for generator spawn types.
-            a_text = a if isinstance(a, str) else str(int(a))
-            out.append(
-                f"  {{{etype}, {ex:.1f}f, {ey:.1f}f, {edir}, {a_text}, {int(b)}}},"
-            )
-        out.append("};")
-        out.append("")
-
-    # section defs
-    for key in level_keys:
-        world, stage = key
-        sec_list = sorted(level_sections[key], key=lambda s: s["section"])
-        sname = f"sections_{world}_{stage}"
-        out.append(f"static const LevelSectionData {sname}[] = {{")
-        for s in sec_list:
-            map_name = f"map_{s['world']}_{s['stage']}_{s['section']}"
-            at_name = f"atlast_{s['world']}_{s['stage']}_{s['section']}"
-            ax_name = f"atlasx_{s['world']}_{s['stage']}_{s['section']}"
-            ay_name = f"atlasy_{s['world']}_{s['stage']}_{s['section']}"
-            col_name = f"collide_{s['world']}_{s['stage']}_{s['section']}"
-            qm_name = f"qmeta_{s['world']}_{s['stage']}_{s['section']}"
-            pname = f"pipes_{s['world']}_{s['stage']}_{s['section']}"
-            ename = f"enemies_{s['world']}_{s['stage']}_{s['section']}"
-            pipe_count = len(
-                [
-                    e
-                    for e in s["pipes_entry"]
-                    if "target_level_index" in e and "target_section_number" in e
-                ]
-            )
-            enemy_count = len(s["enemies"])
-            out.append(
-                "  {"
-                f"{map_name}, {at_name}, {ax_name}, {ay_name}, {col_name}, {qm_name}, "
-                f"{s['map_width']}, {s['map_height']}, {s['theme']}, "
-                f"{s['flag_x']}, {str(s['has_flag']).lower()}, "
-                f"{s['start_x']}, {s['start_y']}, "
-                f"{s.get('bg_primary', 0)}, {s.get('bg_secondary', 0)}, {str(bool(s.get('bg_clouds'))).lower()}, {s.get('bg_particles', 0)}, "
-                f"{pname}, {pipe_count}, {ename}, {enemy_count}"
-                "},"
-            )
-        out.append("};")
-        out.append("")
-
-    out.append(f"extern const int g_levelCount = {len(level_keys)};")
-    out.append("extern const LevelData g_levels[] = {")
-    for world, stage in level_keys:
-        sname = f"sections_{world}_{stage}"
-        name = f"\"{world}-{stage}\""
-        out.append(
-            f"  {{{name}, {world}, {stage}, {sname}, (int)(sizeof({sname})/sizeof({sname}[0]))}},"
-        )
-    out.append("};")
-    out.append("")
+        world, stage = k
+        levels.append((f"{world}-{stage}", world, stage, level_sections[k]))
 
-    out_path = ROOT / "src/levels_generated.cpp"
-    out_path.write_text("\n".join(out))
+    out_path = ROOT / "content/levels.pak"
+    write_level_pack(out_path, levels, level_keys, section_index_map, enums)
     print(f"Generated: {out_path}")
 
 